@@ -37,6 +37,7 @@ There is still some work to be done:
 #include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #ifdef HAVE_ZLIB
 # include <zlib.h>
@@ -189,6 +190,8 @@ typedef struct FCI_Int
   cab_ULONG          folders_data_size;   /* total size of data contained in the current folders */
   TCOMP              compression;
   cab_UWORD        (*compress)(struct FCI_Int *);
+  struct lzx_encoder *lzx;        /* LZX state of the current folder */
+  struct mszip_batch *batch;      /* full blocks waiting to be compressed on worker threads */
 } FCI_Int;
 
 #define FCI_INT_MAGIC 0xfcfcfc05
@@ -309,14 +312,13 @@ static void free_file( FCI_Int *fci, struct file *file )
     fci->free( file );
 }
 
-/* create a new data block for the data in fci->data_in */
-static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+/* store a compressed data block in the temp file */
+static BOOL write_data_block( FCI_Int *fci, unsigned char *data, cab_UWORD compressed,
+                              cab_UWORD uncompressed, PFNFCISTATUS status_callback )
 {
     int err;
     struct data_block *block;
 
-    if (!fci->cdata_in) return TRUE;
-
     if (fci->data.handle == -1 && !create_temp_file( fci, &fci->data )) return FALSE;
 
     if (!(block = fci->alloc( sizeof(*block) )))
@@ -324,10 +326,10 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
         set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
         return FALSE;
     }
-    block->uncompressed = fci->cdata_in;
-    block->compressed   = fci->compress( fci );
+    block->uncompressed = uncompressed;
+    block->compressed   = compressed;
 
-    if (fci->write( fci->data.handle, fci->data_out,
+    if (fci->write( fci->data.handle, data,
                     block->compressed, &err, fci->pv ) != block->compressed)
     {
         set_error( fci, FCIERR_TEMP_FILE, err );
@@ -335,7 +337,6 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
         return FALSE;
     }
 
-    fci->cdata_in = 0;
     fci->pending_data_size += sizeof(CFDATA) + fci->ccab.cbReserveCFData + block->compressed;
     fci->cCompressedBytesInFolder += block->compressed;
     fci->cDataBlocks++;
@@ -349,6 +350,157 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
     return TRUE;
 }
 
+/* create a new data block for the data in fci->data_in */
+static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    cab_UWORD compressed, uncompressed = fci->cdata_in;
+
+    if (!fci->cdata_in) return TRUE;
+
+    compressed = fci->compress( fci );
+    fci->cdata_in = 0;
+    return write_data_block( fci, fci->data_out, compressed, uncompressed, status_callback );
+}
+
+#ifdef HAVE_ZLIB
+
+/* MSZIP blocks are compressed independently of each other, so full blocks
+ * of a file are collected into a batch and deflated on worker threads. They
+ * are then stored in their original order, which keeps the output identical
+ * to the one produced on the calling thread. */
+
+#define MSZIP_BATCH_BLOCKS 8
+
+struct mszip_job
+{
+    struct mszip_batch *batch;
+    cab_UWORD           uncompressed;
+    cab_UWORD           compressed;
+    unsigned char       data_in[CAB_BLOCKMAX];
+    unsigned char       data_out[2 * CAB_BLOCKMAX];
+};
+
+struct mszip_batch
+{
+    HANDLE           done;
+    LONG             remaining;
+    unsigned int     count;
+    struct mszip_job jobs[MSZIP_BATCH_BLOCKS];
+};
+
+static void *zalloc( void *opaque, unsigned int items, unsigned int size )
+{
+    FCI_Int *fci = opaque;
+    if (!fci) return HeapAlloc( GetProcessHeap(), 0, items * size );
+    return fci->alloc( items * size );
+}
+
+static void zfree( void *opaque, void *ptr )
+{
+    FCI_Int *fci = opaque;
+    if (!fci) HeapFree( GetProcessHeap(), 0, ptr );
+    else fci->free( ptr );
+}
+
+/* the application allocator is only used on the calling thread, fci is NULL on worker threads */
+static cab_UWORD deflate_block( FCI_Int *fci, const unsigned char *data_in, cab_UWORD size,
+                                unsigned char *data_out )
+{
+    z_stream stream;
+
+    stream.zalloc = zalloc;
+    stream.zfree  = zfree;
+    stream.opaque = fci;
+    if (deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY ) != Z_OK)
+        return 0;
+    stream.next_in   = (unsigned char *)data_in;
+    stream.avail_in  = size;
+    stream.next_out  = data_out + 2;
+    stream.avail_out = 2 * CAB_BLOCKMAX - 2;
+    /* insert the signature */
+    data_out[0] = 'C';
+    data_out[1] = 'K';
+    deflate( &stream, Z_FINISH );
+    deflateEnd( &stream );
+    return stream.total_out + 2;
+}
+
+static struct mszip_batch *create_mszip_batch( FCI_Int *fci )
+{
+    struct mszip_batch *batch;
+    SYSTEM_INFO info;
+    unsigned int i;
+
+    GetSystemInfo( &info );
+    if (info.dwNumberOfProcessors < 2) return NULL;
+
+    if (!(batch = fci->alloc( sizeof(*batch) ))) return NULL;
+    if (!(batch->done = CreateEventW( NULL, FALSE, FALSE, NULL )))
+    {
+        fci->free( batch );
+        return NULL;
+    }
+    batch->count = 0;
+    for (i = 0; i < MSZIP_BATCH_BLOCKS; i++) batch->jobs[i].batch = batch;
+    return batch;
+}
+
+static DWORD CALLBACK mszip_job_proc( void *arg )
+{
+    struct mszip_job *job = arg;
+
+    job->compressed = deflate_block( NULL, job->data_in, job->uncompressed, job->data_out );
+    if (!InterlockedDecrement( &job->batch->remaining )) SetEvent( job->batch->done );
+    return 0;
+}
+
+/* compress all queued blocks and store them in order */
+static BOOL flush_data_blocks( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    struct mszip_batch *batch = fci->batch;
+    unsigned int i, count = batch->count;
+
+    if (!count) return TRUE;
+
+    batch->count = 0;
+    batch->remaining = count;
+    for (i = 0; i < count; i++)
+        if (!QueueUserWorkItem( mszip_job_proc, &batch->jobs[i], WT_EXECUTEDEFAULT ))
+            mszip_job_proc( &batch->jobs[i] );
+    WaitForSingleObject( batch->done, INFINITE );
+
+    TRACE( "compressed %u blocks\n", count );
+
+    for (i = 0; i < count; i++)
+    {
+        struct mszip_job *job = &batch->jobs[i];
+
+        if (!job->compressed)
+        {
+            set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
+            return FALSE;
+        }
+        if (!write_data_block( fci, job->data_out, job->compressed, job->uncompressed, status_callback ))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* queue the full block in fci->data_in for compression */
+static BOOL queue_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    struct mszip_batch *batch = fci->batch;
+    struct mszip_job *job = &batch->jobs[batch->count++];
+
+    memcpy( job->data_in, fci->data_in, fci->cdata_in );
+    job->uncompressed = fci->cdata_in;
+    fci->cdata_in = 0;
+    if (batch->count < MSZIP_BATCH_BLOCKS) return TRUE;
+    return flush_data_blocks( fci, status_callback );
+}
+
+#endif  /* HAVE_ZLIB */
+
 /* add compressed blocks for all the data that can be read from the file */
 static BOOL add_file_data( FCI_Int *fci, char *sourcefile, char *filename, BOOL execute,
                            PFNFCIGETOPENINFO get_open_info, PFNFCISTATUS status_callback )
@@ -381,8 +533,19 @@ static BOOL add_file_data( FCI_Int *fci, char *sourcefile, char *filename, BOOL
         }
         file->size += len;
         fci->cdata_in += len;
-        if (fci->cdata_in == CAB_BLOCKMAX && !add_data_block( fci, status_callback )) return FALSE;
+        if (fci->cdata_in < CAB_BLOCKMAX) continue;
+#ifdef HAVE_ZLIB
+        if (fci->batch && fci->compression == tcompTYPE_MSZIP)
+        {
+            if (!queue_data_block( fci, status_callback )) return FALSE;
+            continue;
+        }
+#endif
+        if (!add_data_block( fci, status_callback )) return FALSE;
     }
+#ifdef HAVE_ZLIB
+    if (fci->batch && !flush_data_blocks( fci, status_callback )) return FALSE;
+#endif
     fci->close( handle, &err, fci->pv );
     return TRUE;
 }
@@ -911,43 +1074,469 @@ static cab_UWORD compress_NONE( FCI_Int *fci )
 
 #ifdef HAVE_ZLIB
 
-static void *zalloc( void *opaque, unsigned int items, unsigned int size )
+static cab_UWORD compress_MSZIP( FCI_Int *fci )
 {
-    FCI_Int *fci = opaque;
-    return fci->alloc( items * size );
+    cab_UWORD size = deflate_block( fci, fci->data_in, fci->cdata_in, fci->data_out );
+
+    if (!size) set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
+    return size;
 }
 
-static void zfree( void *opaque, void *ptr )
+#endif  /* HAVE_ZLIB */
+
+/* LZX compression
+ *
+ * Every CFDATA block is encoded as a single verbatim block (or an uncompressed
+ * one if that turns out smaller), matches are found through hash chains over
+ * the history of the folder and never use the repeated offsets. */
+
+#define LZX_HASH_BITS   15
+#define LZX_HASH_SIZE   (1 << LZX_HASH_BITS)
+#define LZX_MAX_CHAIN   32
+#define LZX_TOO_FAR     4096  /* 3-byte matches beyond that distance aren't worth it */
+
+static const cab_UBYTE lzx_extra_bits[] =
 {
-    FCI_Int *fci = opaque;
-    fci->free( ptr );
+     0,  0,  0,  0,  1,  1,  2,  2,  3,  3,  4,  4,  5,  5,  6,  6,
+     7,  7,  8,  8,  9,  9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14,
+    15, 15, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+    17, 17, 17
+};
+
+static const cab_ULONG lzx_position_base[] =
+{
+          0,       1,       2,       3,       4,       6,       8,      12,
+         16,      24,      32,      48,      64,      96,     128,     192,
+        256,     384,     512,     768,    1024,    1536,    2048,    3072,
+       4096,    6144,    8192,   12288,   16384,   24576,   32768,   49152,
+      65536,   98304,  131072,  196608,  262144,  393216,  524288,  655360,
+     786432,  917504, 1048576, 1179648, 1310720, 1441792, 1572864, 1703936,
+    1835008, 1966080, 2097152
+};
+
+struct lzx_token
+{
+    cab_UWORD length;    /* 0 for a literal */
+    cab_ULONG value;     /* literal byte or match distance */
+};
+
+struct lzx_encoder
+{
+    cab_ULONG        window_size;
+    cab_ULONG        main_elements;
+    cab_ULONG        pos;              /* position of the current block in data */
+    BOOL             header_written;
+    unsigned char   *data;             /* history, 2 * window_size bytes */
+    int             *prev;             /* hash chains, 2 * window_size entries */
+    int              head[LZX_HASH_SIZE];
+    cab_UBYTE        main_len[LZX_MAINTREE_MAXSYMBOLS];
+    cab_UBYTE        length_len[LZX_NUM_SECONDARY_LENGTHS];
+    cab_ULONG        main_freq[LZX_MAINTREE_MAXSYMBOLS];
+    cab_ULONG        length_freq[LZX_NUM_SECONDARY_LENGTHS];
+    struct lzx_token tokens[CAB_BLOCKMAX];
+};
+
+struct lzx_bits_out
+{
+    unsigned char *out;
+    cab_ULONG      pos;
+    cab_ULONG      size;
+    cab_ULONG      buf;
+    int            count;
+};
+
+static void lzx_put_bits( struct lzx_bits_out *bits, cab_ULONG value, int count )
+{
+    bits->buf = (bits->buf << count) | value;
+    bits->count += count;
+    while (bits->count >= 16)
+    {
+        cab_UWORD word = bits->buf >> (bits->count - 16);
+
+        bits->count -= 16;
+        if (bits->pos + 2 <= bits->size)
+        {
+            bits->out[bits->pos] = word & 0xff;
+            bits->out[bits->pos + 1] = word >> 8;
+        }
+        bits->pos += 2;
+    }
 }
 
-static cab_UWORD compress_MSZIP( FCI_Int *fci )
+/* pad the bitstream to the next 16-bit boundary */
+static void lzx_align_bits( struct lzx_bits_out *bits )
 {
-    z_stream stream;
+    if (bits->count) lzx_put_bits( bits, 0, 16 - bits->count );
+}
 
-    stream.zalloc = zalloc;
-    stream.zfree  = zfree;
-    stream.opaque = fci;
-    if (deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY ) != Z_OK)
+static int lzx_compare_keys( const void *a, const void *b )
+{
+    cab_ULONG key1 = *(const cab_ULONG *)a, key2 = *(const cab_ULONG *)b;
+    return key1 < key2 ? -1 : key1 > key2;
+}
+
+/* compute Huffman code lengths no longer than max_bits */
+static void lzx_build_lengths( const cab_ULONG *freq, unsigned int count, unsigned int max_bits,
+                               cab_UBYTE *lens )
+{
+    cab_ULONG keys[LZX_MAINTREE_MAXSYMBOLS], weight[2 * LZX_MAINTREE_MAXSYMBOLS];
+    unsigned int parent[2 * LZX_MAINTREE_MAXSYMBOLS], depth[2 * LZX_MAINTREE_MAXSYMBOLS];
+    unsigned int i, j, k, n, shift;
+
+    memset( lens, 0, count );
+    for (shift = 0; ; shift++)
+    {
+        for (i = n = 0; i < count; i++)
+        {
+            cab_ULONG w;
+            if (!freq[i]) continue;
+            if (!(w = freq[i] >> shift)) w = 1;
+            keys[n++] = (w << 16) | i;
+        }
+        if (!n) return;
+        if (n == 1)
+        {
+            /* a tree needs at least two codes */
+            i = keys[0] & 0xffff;
+            lens[i] = lens[i ? 0 : 1] = 1;
+            return;
+        }
+        qsort( keys, n, sizeof(keys[0]), lzx_compare_keys );
+
+        /* two queues: the sorted leaves and the internal nodes in creation order */
+        for (i = 0; i < n; i++) weight[i] = keys[i] >> 16;
+        for (i = 0, j = k = n; k < 2 * n - 1; k++)
+        {
+            unsigned int a, b;
+            a = (i < n && (j >= k || weight[i] <= weight[j])) ? i++ : j++;
+            b = (i < n && (j >= k || weight[i] <= weight[j])) ? i++ : j++;
+            weight[k] = weight[a] + weight[b];
+            parent[a] = parent[b] = k;
+        }
+        depth[2 * n - 2] = 0;
+        for (i = 2 * n - 2; i-- > 0; ) depth[i] = depth[parent[i]] + 1;
+
+        for (i = 0; i < n; i++) if (depth[i] > max_bits) break;
+        if (i < n) continue;
+
+        for (i = 0; i < n; i++) lens[keys[i] & 0xffff] = depth[i];
+        return;
+    }
+}
+
+/* assign canonical codes, in order of length then symbol */
+static void lzx_make_codes( const cab_UBYTE *lens, unsigned int count, cab_UWORD *codes )
+{
+    unsigned int i, code = 0, bl_count[17], next[17];
+
+    memset( bl_count, 0, sizeof(bl_count) );
+    for (i = 0; i < count; i++) bl_count[lens[i]]++;
+    bl_count[0] = 0;
+    for (i = 1; i <= 16; i++)
+    {
+        code = (code + bl_count[i - 1]) << 1;
+        next[i] = code;
+    }
+    for (i = 0; i < count; i++) if (lens[i]) codes[i] = next[lens[i]]++;
+}
+
+/* write lens[first..last] as deltas against prev[first..last] through a pretree */
+static void lzx_write_lengths( struct lzx_bits_out *bits, const cab_UBYTE *lens, const cab_UBYTE *prev,
+                               unsigned int first, unsigned int last )
+{
+    cab_UBYTE symbols[LZX_MAINTREE_MAXSYMBOLS], extra[LZX_MAINTREE_MAXSYMBOLS];
+    cab_UBYTE pre_len[LZX_PRETREE_NUM_ELEMENTS];
+    cab_UWORD pre_code[LZX_PRETREE_NUM_ELEMENTS];
+    cab_ULONG pre_freq[LZX_PRETREE_NUM_ELEMENTS];
+    unsigned int i, j, n = 0;
+
+    memset( pre_freq, 0, sizeof(pre_freq) );
+    for (i = first; i < last; n++)
+    {
+        for (j = i; j < last && j - i < 51 && !lens[j]; j++) ;
+        if (j - i >= 20)
+        {
+            symbols[n] = 18;
+            extra[n] = j - i - 20;
+            i = j;
+        }
+        else if (j - i >= 4)
+        {
+            symbols[n] = 17;
+            extra[n] = j - i - 4;
+            i = j;
+        }
+        else
+        {
+            symbols[n] = (prev[i] - lens[i] + 17) % 17;
+            i++;
+        }
+        pre_freq[symbols[n]]++;
+    }
+
+    lzx_build_lengths( pre_freq, LZX_PRETREE_NUM_ELEMENTS, 15, pre_len );
+    lzx_make_codes( pre_len, LZX_PRETREE_NUM_ELEMENTS, pre_code );
+
+    for (i = 0; i < LZX_PRETREE_NUM_ELEMENTS; i++) lzx_put_bits( bits, pre_len[i], 4 );
+    for (i = 0; i < n; i++)
+    {
+        lzx_put_bits( bits, pre_code[symbols[i]], pre_len[symbols[i]] );
+        if (symbols[i] == 17) lzx_put_bits( bits, extra[i], 4 );
+        else if (symbols[i] == 18) lzx_put_bits( bits, extra[i], 5 );
+    }
+}
+
+static inline unsigned int lzx_hash( const unsigned char *p )
+{
+    return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (LZX_HASH_SIZE - 1);
+}
+
+static inline void lzx_insert( struct lzx_encoder *lzx, cab_ULONG pos, cab_ULONG end )
+{
+    unsigned int hash;
+
+    if (pos + 2 >= end) return;
+    hash = lzx_hash( lzx->data + pos );
+    lzx->prev[pos] = lzx->head[hash];
+    lzx->head[hash] = pos;
+}
+
+/* find the position slot containing the formatted offset f */
+static cab_ULONG lzx_position_slot( cab_ULONG f )
+{
+    cab_ULONG slot = 0, hi = sizeof(lzx_position_base) / sizeof(lzx_position_base[0]) - 1;
+
+    while (slot < hi)
+    {
+        cab_ULONG mid = (slot + hi + 1) / 2;
+        if (lzx_position_base[mid] <= f) slot = mid;
+        else hi = mid - 1;
+    }
+    return slot;
+}
+
+/* find the longest match for the data at pos, not extending beyond end */
+static unsigned int lzx_find_match( struct lzx_encoder *lzx, cab_ULONG pos, cab_ULONG end, cab_ULONG *distance )
+{
+    const unsigned char *data = lzx->data;
+    cab_ULONG limit = min( end - pos, LZX_MAX_MATCH ), max_distance = lzx->window_size - 3;
+    unsigned int chain = LZX_MAX_CHAIN, best = 2, len;
+    int candidate;
+
+    if (pos >= end || limit < 3) return 0;
+
+    for (candidate = lzx->head[lzx_hash( data + pos )]; candidate >= 0 && chain--;
+         candidate = lzx->prev[candidate])
+    {
+        if (pos - candidate > max_distance) break;
+        if (data[candidate + best] != data[pos + best]) continue;
+        for (len = 0; len < limit && data[candidate + len] == data[pos + len]; len++) ;
+        if (len > best)
+        {
+            best = len;
+            *distance = pos - candidate;
+            if (len == limit) break;
+        }
+    }
+    if (best == 3 && *distance > LZX_TOO_FAR) return 0;
+    return best > 2 ? best : 0;
+}
+
+/* split the current block into literals and matches, using one step of lazy evaluation */
+static unsigned int lzx_parse_block( struct lzx_encoder *lzx, cab_ULONG size )
+{
+    cab_ULONG pos = lzx->pos, end = lzx->pos + size, distance = 0, next_distance = 0;
+    unsigned int len, next, count = 0;
+
+    memset( lzx->main_freq, 0, sizeof(lzx->main_freq) );
+    memset( lzx->length_freq, 0, sizeof(lzx->length_freq) );
+
+    len = lzx_find_match( lzx, pos, end, &distance );
+    while (pos < end)
+    {
+        struct lzx_token *token = &lzx->tokens[count++];
+
+        lzx_insert( lzx, pos, end );
+        if (len)
+        {
+            next = lzx_find_match( lzx, pos + 1, end, &next_distance );
+            if (next <= len)
+            {
+                cab_ULONG footer = min( len - LZX_MIN_MATCH, LZX_NUM_PRIMARY_LENGTHS );
+                cab_ULONG slot = lzx_position_slot( distance + 2 );
+
+                token->length = len;
+                token->value  = distance;
+                lzx->main_freq[LZX_NUM_CHARS + (slot << 3) + footer]++;
+                if (footer == LZX_NUM_PRIMARY_LENGTHS)
+                    lzx->length_freq[len - LZX_MIN_MATCH - LZX_NUM_PRIMARY_LENGTHS]++;
+
+                while (--len) lzx_insert( lzx, ++pos, end );
+                len = lzx_find_match( lzx, ++pos, end, &distance );
+                continue;
+            }
+            len = next;
+            distance = next_distance;
+        }
+        token->length = 0;
+        token->value  = lzx->data[pos];
+        lzx->main_freq[token->value]++;
+        if (!len) len = lzx_find_match( lzx, pos + 1, end, &distance );
+        pos++;
+    }
+    return count;
+}
+
+/* write the current block, returns the number of bytes or 0 if an uncompressed block would be smaller */
+static cab_ULONG lzx_write_verbatim( struct lzx_encoder *lzx, unsigned int count, cab_ULONG size,
+                                     unsigned char *out )
+{
+    struct lzx_bits_out bits = { out, 0, size + 16, 0, 0 };
+    cab_UBYTE main_len[LZX_MAINTREE_MAXSYMBOLS], length_len[LZX_NUM_SECONDARY_LENGTHS];
+    cab_UWORD main_code[LZX_MAINTREE_MAXSYMBOLS], length_code[LZX_NUM_SECONDARY_LENGTHS];
+    unsigned int i;
+
+    lzx_build_lengths( lzx->main_freq, lzx->main_elements, 16, main_len );
+    lzx_build_lengths( lzx->length_freq, LZX_NUM_SECONDARY_LENGTHS, 16, length_len );
+    lzx_make_codes( main_len, lzx->main_elements, main_code );
+    lzx_make_codes( length_len, LZX_NUM_SECONDARY_LENGTHS, length_code );
+
+    if (!lzx->header_written) lzx_put_bits( &bits, 0, 1 );  /* no E8 translation */
+    lzx_put_bits( &bits, LZX_BLOCKTYPE_VERBATIM, 3 );
+    lzx_put_bits( &bits, size >> 8, 16 );
+    lzx_put_bits( &bits, size & 0xff, 8 );
+    lzx_write_lengths( &bits, main_len, lzx->main_len, 0, LZX_NUM_CHARS );
+    lzx_write_lengths( &bits, main_len, lzx->main_len, LZX_NUM_CHARS, lzx->main_elements );
+    lzx_write_lengths( &bits, length_len, lzx->length_len, 0, LZX_NUM_SECONDARY_LENGTHS );
+
+    for (i = 0; i < count && bits.pos <= bits.size; i++)
+    {
+        const struct lzx_token *token = &lzx->tokens[i];
+        cab_ULONG footer, slot, f, sym;
+
+        if (!token->length)
+        {
+            lzx_put_bits( &bits, main_code[token->value], main_len[token->value] );
+            continue;
+        }
+        footer = min( token->length - LZX_MIN_MATCH, LZX_NUM_PRIMARY_LENGTHS );
+        f = token->value + 2;
+        slot = lzx_position_slot( f );
+        sym = LZX_NUM_CHARS + (slot << 3) + footer;
+        lzx_put_bits( &bits, main_code[sym], main_len[sym] );
+        if (footer == LZX_NUM_PRIMARY_LENGTHS)
+        {
+            sym = token->length - LZX_MIN_MATCH - LZX_NUM_PRIMARY_LENGTHS;
+            lzx_put_bits( &bits, length_code[sym], length_len[sym] );
+        }
+        lzx_put_bits( &bits, f - lzx_position_base[slot], lzx_extra_bits[slot] );
+    }
+    lzx_align_bits( &bits );
+    if (bits.pos > bits.size) return 0;
+
+    memcpy( lzx->main_len, main_len, lzx->main_elements );
+    memcpy( lzx->length_len, length_len, LZX_NUM_SECONDARY_LENGTHS );
+    return bits.pos;
+}
+
+static cab_ULONG lzx_write_uncompressed( struct lzx_encoder *lzx, cab_ULONG size, unsigned char *out )
+{
+    struct lzx_bits_out bits = { out, 0, CAB_INPUTMAX, 0, 0 };
+    unsigned int i;
+
+    if (!lzx->header_written) lzx_put_bits( &bits, 0, 1 );
+    lzx_put_bits( &bits, LZX_BLOCKTYPE_UNCOMPRESSED, 3 );
+    lzx_put_bits( &bits, size >> 8, 16 );
+    lzx_put_bits( &bits, size & 0xff, 8 );
+    /* the decoder always skips to the next 16-bit word, even when aligned */
+    lzx_put_bits( &bits, 0, 16 - bits.count );
+
+    /* R0, R1 and R2 */
+    for (i = 0; i < 3; i++)
+    {
+        out[bits.pos++] = 1;
+        out[bits.pos++] = 0;
+        out[bits.pos++] = 0;
+        out[bits.pos++] = 0;
+    }
+    memcpy( out + bits.pos, lzx->data + lzx->pos, size );
+    bits.pos += size;
+    if (size & 1) out[bits.pos++] = 0;
+    return bits.pos;
+}
+
+static void reset_lzx_encoder( struct lzx_encoder *lzx )
+{
+    lzx->pos = 0;
+    lzx->header_written = FALSE;
+    memset( lzx->head, 0xff, sizeof(lzx->head) );
+    memset( lzx->main_len, 0, sizeof(lzx->main_len) );
+    memset( lzx->length_len, 0, sizeof(lzx->length_len) );
+}
+
+static struct lzx_encoder *create_lzx_encoder( FCI_Int *fci )
+{
+    struct lzx_encoder *lzx;
+    int window = LZXCompressionWindowFromTCOMP( fci->compression );
+    cab_ULONG window_size = 1 << window, posn_slots;
+
+    if (!(lzx = fci->alloc( sizeof(*lzx) + 2 * window_size * (sizeof(int) + 1) ))) return NULL;
+
+    if (window == 20) posn_slots = 42;
+    else if (window == 21) posn_slots = 50;
+    else posn_slots = window << 1;
+
+    lzx->window_size   = window_size;
+    lzx->main_elements = LZX_NUM_CHARS + (posn_slots << 3);
+    lzx->prev          = (int *)(lzx + 1);
+    lzx->data          = (unsigned char *)(lzx->prev + 2 * window_size);
+    reset_lzx_encoder( lzx );
+    return lzx;
+}
+
+static void free_lzx_encoder( FCI_Int *fci )
+{
+    if (fci->lzx) fci->free( fci->lzx );
+    fci->lzx = NULL;
+}
+
+/* drop the oldest window_size bytes of history */
+static void lzx_slide_window( struct lzx_encoder *lzx )
+{
+    cab_ULONG i, size = lzx->window_size;
+
+    memmove( lzx->data, lzx->data + size, lzx->pos - size );
+    for (i = 0; i < LZX_HASH_SIZE; i++)
+        lzx->head[i] = lzx->head[i] >= (int)size ? lzx->head[i] - size : -1;
+    for (i = 0; i < lzx->pos - size; i++)
+        lzx->prev[i] = lzx->prev[i + size] >= (int)size ? lzx->prev[i + size] - size : -1;
+    lzx->pos -= size;
+}
+
+static cab_UWORD compress_LZX( FCI_Int *fci )
+{
+    struct lzx_encoder *lzx = fci->lzx;
+    cab_ULONG size;
+    unsigned int count;
+
+    if (!lzx && !(lzx = fci->lzx = create_lzx_encoder( fci )))
     {
         set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
         return 0;
     }
-    stream.next_in   = fci->data_in;
-    stream.avail_in  = fci->cdata_in;
-    stream.next_out  = fci->data_out + 2;
-    stream.avail_out = sizeof(fci->data_out) - 2;
-    /* insert the signature */
-    fci->data_out[0] = 'C';
-    fci->data_out[1] = 'K';
-    deflate( &stream, Z_FINISH );
-    deflateEnd( &stream );
-    return stream.total_out + 2;
-}
+    if (lzx->pos + CAB_BLOCKMAX > 2 * lzx->window_size) lzx_slide_window( lzx );
 
-#endif  /* HAVE_ZLIB */
+    memcpy( lzx->data + lzx->pos, fci->data_in, fci->cdata_in );
+    count = lzx_parse_block( lzx, fci->cdata_in );
+    if (!(size = lzx_write_verbatim( lzx, count, fci->cdata_in, fci->data_out )))
+        size = lzx_write_uncompressed( lzx, fci->cdata_in, fci->data_out );
+
+    TRACE( "block of %u bytes compressed to %u\n", fci->cdata_in, size );
+
+    lzx->header_written = TRUE;
+    lzx->pos += fci->cdata_in;
+    return size;
+}
 
 
 /***********************************************************************
@@ -1071,6 +1660,8 @@ HFCI __cdecl FCICreate(
   p_fci_internal->folders_data_size = 0;
   p_fci_internal->compression = tcompTYPE_NONE;
   p_fci_internal->compress = compress_NONE;
+  p_fci_internal->lzx = NULL;
+  p_fci_internal->batch = NULL;
 
   list_init( &p_fci_internal->folders_list );
   list_init( &p_fci_internal->files_list );
@@ -1129,6 +1720,9 @@ static BOOL fci_flush_folder( FCI_Int *p_fci_internal,
   /* START of COPY */
   if (!add_data_block( p_fci_internal, pfnfcis )) return FALSE;
 
+  /* the next folder starts with a fresh LZX window */
+  if (p_fci_internal->lzx) reset_lzx_encoder( p_fci_internal->lzx );
+
   /* reset to get the number of data blocks of this folder which are */
   /* actually in this cabinet ( at least partially ) */
   p_fci_internal->cDataBlocks=0;
@@ -1441,9 +2035,19 @@ BOOL __cdecl FCIAddFile(
 #ifdef HAVE_ZLIB
           p_fci_internal->compression = tcompTYPE_MSZIP;
           p_fci_internal->compress    = compress_MSZIP;
+          if (!p_fci_internal->batch) p_fci_internal->batch = create_mszip_batch( p_fci_internal );
           break;
 #endif
       default:
+          if ((typeCompress & ~tcompMASK_LZX_WINDOW) == tcompTYPE_LZX &&
+              LZXCompressionWindowFromTCOMP( typeCompress ) >= 15 &&
+              LZXCompressionWindowFromTCOMP( typeCompress ) <= 21)
+          {
+              free_lzx_encoder( p_fci_internal );
+              p_fci_internal->compression = typeCompress;
+              p_fci_internal->compress    = compress_LZX;
+              break;
+          }
           FIXME( "compression %x not supported, defaulting to none\n", typeCompress );
           /* fall through */
       case tcompTYPE_NONE:
@@ -1751,6 +2355,13 @@ BOOL __cdecl FCIDestroy(HFCI hfci)
 
     close_temp_file( p_fci_internal, &p_fci_internal->data );
 
+    free_lzx_encoder( p_fci_internal );
+    if (p_fci_internal->batch)
+    {
+        CloseHandle( p_fci_internal->batch->done );
+        p_fci_internal->free( p_fci_internal->batch );
+    }
+
     /* hfci can now be removed */
     p_fci_internal->free(hfci);
     return TRUE;
@@ -650,6 +650,248 @@ static void test_FDICopy(void)
     DeleteFileA(name);
 }
 
+static void create_large_file(const char *name, DWORD size)
+{
+    static const char *words[] = { "cabinet", "folder", "file", "data", "block", "window", "match", "literal" };
+    char line[128];
+    DWORD written, total = 0, seed = 12345;
+    HANDLE file;
+    int len;
+
+    file = CreateFileA(name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failure to open file %s\n", name);
+    while (total < size)
+    {
+        seed = seed * 1103515245 + 12345;
+        len = sprintf(line, "%u %s %s %u\n", total, words[(seed >> 16) % 8], words[(seed >> 20) % 8],
+                      (seed >> 8) & 0xfff);
+        WriteFile(file, line, len, &written, NULL);
+        total += written;
+    }
+    CloseHandle(file);
+}
+
+static void create_random_file(const char *name, DWORD size)
+{
+    static BYTE buf[4096];
+    DWORD written, count, seed = 0xdeadbeef, i;
+    HANDLE file;
+
+    file = CreateFileA(name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failure to open file %s\n", name);
+    while (size)
+    {
+        count = min(size, sizeof(buf));
+        for (i = 0; i < count; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            buf[i] = seed >> 16;
+        }
+        WriteFile(file, buf, count, &written, NULL);
+        size -= count;
+    }
+    CloseHandle(file);
+}
+
+/* stores the file in extract.cab */
+static BOOL compress_file(char *name, TCOMP type)
+{
+    char path[MAX_PATH];
+    CCAB cabParams;
+    HFCI hfci;
+    ERF erf;
+    BOOL ret;
+
+    set_cab_parameters(&cabParams);
+    hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                     fci_read, fci_write, fci_close, fci_seek,
+                     fci_delete, get_temp_file, &cabParams, NULL);
+    if (!hfci) return FALSE;
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+    lstrcatA(path, name);
+    ret = FCIAddFile(hfci, path, name, FALSE, get_next_cabinet, progress, get_open_info, type) &&
+          FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+    FCIDestroy(hfci);
+    return ret;
+}
+
+static BOOL compare_files(const char *name1, const char *name2)
+{
+    static char buf1[4096], buf2[4096];
+    HANDLE file1, file2;
+    DWORD read1, read2;
+    BOOL same = TRUE;
+
+    file1 = CreateFileA(name1, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    file2 = CreateFileA(name2, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    if (file1 == INVALID_HANDLE_VALUE || file2 == INVALID_HANDLE_VALUE) same = FALSE;
+    while (same)
+    {
+        ReadFile(file1, buf1, sizeof(buf1), &read1, NULL);
+        ReadFile(file2, buf2, sizeof(buf2), &read2, NULL);
+        if (read1 != read2 || memcmp(buf1, buf2, read1)) same = FALSE;
+        if (!read1) break;
+    }
+    CloseHandle(file1);
+    CloseHandle(file2);
+    return same;
+}
+
+static INT_PTR __cdecl extract_notify(FDINOTIFICATIONTYPE fdint, PFDINOTIFICATION pfdin)
+{
+    HANDLE file;
+
+    switch (fdint)
+    {
+    case fdintCOPY_FILE:
+        ok(!lstrcmpA(pfdin->psz1, pfdin->pv), "got %s\n", pfdin->psz1);
+        file = CreateFileA("extracted.txt", GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+        ok(file != INVALID_HANDLE_VALUE, "Failed to create extracted.txt\n");
+        return (INT_PTR)file;
+    case fdintCLOSE_FILE_INFO:
+        CloseHandle((HANDLE)pfdin->hf);
+        return TRUE;
+    default:
+        return 0;
+    }
+}
+
+/* extracts the file stored in extract.cab to extracted.txt */
+static BOOL extract_file(char *name)
+{
+    char cab[] = "extract.cab", path[MAX_PATH];
+    HFDI hfdi;
+    ERF erf;
+    BOOL ret;
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_open, fdi_read,
+                     fdi_write, fdi_close, fdi_seek, cpuUNKNOWN, &erf);
+    ret = FDICopy(hfdi, cab, path, 0, extract_notify, NULL, name);
+    FDIDestroy(hfdi);
+    return ret;
+}
+
+static void test_compression(void)
+{
+    static const TCOMP types[] =
+    {
+        tcompTYPE_NONE, tcompTYPE_MSZIP, TCOMPfromLZXWindow(15), TCOMPfromLZXWindow(21)
+    };
+    static CHAR large_txt[] = "large.txt";
+    DWORD start, compress_time, size;
+    HANDLE file;
+    BOOL ret;
+    int i;
+
+    create_large_file(large_txt, 3 * 1024 * 1024);
+
+    for (i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+    {
+        start = GetTickCount();
+        ret = compress_file(large_txt, types[i]);
+        ok(ret, "%x: Failed to create the cabinet\n", types[i]);
+        compress_time = GetTickCount() - start;
+
+        file = CreateFileA("extract.cab", GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+        size = GetFileSize(file, NULL);
+        CloseHandle(file);
+
+        start = GetTickCount();
+        ret = extract_file(large_txt);
+        ok(ret, "%x: FDICopy failed\n", types[i]);
+        trace("compression %x: %u bytes, %u ms to compress, %u ms to extract\n",
+              types[i], size, compress_time, GetTickCount() - start);
+
+        ok(compare_files(large_txt, "extracted.txt"), "%x: extracted file differs\n", types[i]);
+        DeleteFileA("extracted.txt");
+        DeleteFileA("extract.cab");
+    }
+
+    DeleteFileA(large_txt);
+}
+
+/* blocks that don't compress are stored as uncompressed LZX blocks */
+static void test_lzx_uncompressed_blocks(void)
+{
+    static CHAR random_bin[] = "random.bin";
+    static const DWORD size = 3 * 32768 + 1001;
+    BYTE header[36], folder[8], data[8];
+    DWORD read, total = 0;
+    WORD i, count, word, cbData, cbUncomp;
+    HANDLE file;
+    BOOL ret;
+
+    create_random_file(random_bin, size);
+    ret = compress_file(random_bin, TCOMPfromLZXWindow(15));
+    ok(ret, "Failed to create the cabinet\n");
+
+    file = CreateFileA("extract.cab", GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open extract.cab\n");
+    ReadFile(file, header, sizeof(header), &read, NULL);
+    ok(read == sizeof(header), "got %u\n", read);
+    ReadFile(file, folder, sizeof(folder), &read, NULL);
+    ok(read == sizeof(folder), "got %u\n", read);
+    ok(*(WORD *)(folder + 6) == TCOMPfromLZXWindow(15), "got typeCompress %x\n", *(WORD *)(folder + 6));
+    count = *(WORD *)(folder + 4);
+    ok(count == 4, "got %u data blocks\n", count);
+
+    SetFilePointer(file, *(DWORD *)folder, NULL, FILE_BEGIN);
+    for (i = 0; i < count; i++)
+    {
+        ReadFile(file, data, sizeof(data), &read, NULL);
+        cbData = *(WORD *)(data + 4);
+        cbUncomp = *(WORD *)(data + 6);
+        /* block header, R0-R2 and the data padded to 16 bits */
+        ok(cbData == 16 + ((cbUncomp + 1) & ~1), "block %u: %u bytes stored in %u\n", i, cbUncomp, cbData);
+        /* the first block of the folder starts with the E8 translation bit */
+        ReadFile(file, &word, sizeof(word), &read, NULL);
+        ok((i ? word >> 13 : word >> 12) == 3, "block %u: got %04x\n", i, word);
+        SetFilePointer(file, cbData - sizeof(word), NULL, FILE_CURRENT);
+        total += cbUncomp;
+    }
+    ok(total == size, "got %u bytes\n", total);
+    CloseHandle(file);
+
+    ret = extract_file(random_bin);
+    ok(ret, "FDICopy failed\n");
+    ok(compare_files(random_bin, "extracted.txt"), "extracted file differs\n");
+
+    DeleteFileA("extracted.txt");
+    DeleteFileA("extract.cab");
+    DeleteFileA(random_bin);
+}
+
+/* batched MSZIP blocks and LZX must produce the same cabinet every time */
+static void test_deterministic_output(void)
+{
+    static const TCOMP types[] = { tcompTYPE_MSZIP, TCOMPfromLZXWindow(21) };
+    static CHAR large_txt[] = "large.txt";
+    BOOL ret;
+    int i;
+
+    create_large_file(large_txt, 1024 * 1024);
+
+    for (i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+    {
+        ret = compress_file(large_txt, types[i]);
+        ok(ret, "%x: Failed to create the cabinet\n", types[i]);
+        ret = MoveFileA("extract.cab", "first.cab");
+        ok(ret, "%x: MoveFile failed %u\n", types[i], GetLastError());
+        ret = compress_file(large_txt, types[i]);
+        ok(ret, "%x: Failed to create the cabinet\n", types[i]);
+
+        ok(compare_files("first.cab", "extract.cab"), "%x: cabinets differ\n", types[i]);
+        DeleteFileA("first.cab");
+        DeleteFileA("extract.cab");
+    }
+
+    DeleteFileA(large_txt);
+}
+
 
 START_TEST(fdi)
 {
@@ -657,4 +899,7 @@ START_TEST(fdi)
     test_FDIDestroy();
     test_FDIIsCabinet();
     test_FDICopy();
+    test_compression();
+    test_lzx_uncompressed_blocks();
+    test_deterministic_output();
 }
@@ -61,9 +61,6 @@
  *   -- LISTVIEW_GetNextItem needs to be rewritten. It is currently
  *      linear in the number of items in the list, and this is
  *      unacceptable for large lists.
- *   -- if list is sorted by item text LISTVIEW_InsertItemT could use
- *      binary search to calculate item index (e.g. DPA_Search()).
- *      This requires sorted state to be reliably tracked in item modifiers.
  *   -- we should keep an ordered array of coordinates in iconic mode
  *      this would allow to frame items (iterator_frameditems),
  *      and find nearest item (LVFI_NEARESTXY) a lot more efficiently
@@ -264,6 +261,7 @@ typedef struct tagLISTVIEW_INFO
   /* sorting */
   PFNLVCOMPARE pfnCompare;      /* sorting callback pointer */
   LPARAM lParamSort;
+  BOOL bTextSorted;             /* items are known to be in LVS_SORT* order */
 
   /* style */
   DWORD dwStyle;		/* the cached window GWL_STYLE */
@@ -2574,6 +2572,12 @@ static INT CALLBACK MapIdSearchCompare(LPVOID p1, LPVOID p2, LPARAM lParam)
     return (id1->id < id2->id) ? -1 : 1;
 }
 
+/* Item ids are handed out in increasing order, so the id array stays sorted */
+static INT get_itemid_index(const LISTVIEW_INFO *infoPtr, ITEM_ID *lpID)
+{
+    return DPA_Search(infoPtr->hdpaItemIds, lpID, 0, MapIdSearchCompare, 0, DPAS_SORTED);
+}
+
 /***
  * DESCRIPTION:
  * Returns the item index for id specified.
@@ -4262,7 +4266,10 @@ static BOOL set_main_item(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem, BOOL
 
     /* copy information */
     if (lpLVItem->mask & LVIF_TEXT)
+    {
         textsetptrT(&lpItem->hdr.pszText, lpLVItem->pszText, isW);
+        if (!isNew && (uChanged & LVIF_TEXT)) infoPtr->bTextSorted = FALSE;
+    }
 
     if (lpLVItem->mask & LVIF_IMAGE)
 	lpItem->hdr.iImage = lpLVItem->iImage;
@@ -5416,7 +5423,7 @@ static BOOL LISTVIEW_DeleteAllItems(LISTVIEW_INFO *infoPtr, BOOL destroy)
 	    hdpaSubItems = DPA_GetPtr(infoPtr->hdpaItems, i);
 	    lpItem = DPA_GetPtr(hdpaSubItems, 0);
 	    /* free id struct */
-	    j = DPA_GetPtrIndex(infoPtr->hdpaItemIds, lpItem->id);
+	    j = get_itemid_index(infoPtr, lpItem->id);
 	    lpID = DPA_GetPtr(infoPtr->hdpaItemIds, j);
 	    DPA_DeletePtr(infoPtr->hdpaItemIds, j);
 	    Free(lpID);
@@ -5434,6 +5441,7 @@ static BOOL LISTVIEW_DeleteAllItems(LISTVIEW_INFO *infoPtr, BOOL destroy)
 	DPA_DeletePtr(infoPtr->hdpaPosY, i);
 	infoPtr->nItemCount --;
     }
+    infoPtr->bTextSorted = TRUE;
     
     if (!destroy)
     {
@@ -5707,7 +5715,7 @@ static BOOL LISTVIEW_DeleteItem(LISTVIEW_INFO *infoPtr, INT nItem)
 	lpItem = DPA_GetPtr(hdpaSubItems, 0);
 
 	/* free id struct */
-	i = DPA_GetPtrIndex(infoPtr->hdpaItemIds, lpItem->id);
+	i = get_itemid_index(infoPtr, lpItem->id);
 	lpID = DPA_GetPtr(infoPtr->hdpaItemIds, i);
 	DPA_DeletePtr(infoPtr->hdpaItemIds, i);
 	Free(lpID);
@@ -7386,6 +7394,18 @@ static INT LISTVIEW_GetNextItem(const LISTVIEW_INFO *infoPtr, INT nItem, UINT uF
         }
       }
     }
+    else if (uMask == LVIS_SELECTED && !(infoPtr->uCallbackMask & LVIS_SELECTED))
+    {
+      /* the selection ranges are sorted, look up the next selected item there */
+      nItem++;
+      for (i = 0; i < DPA_GetPtrCount(infoPtr->selectionRanges->hdpa); i++)
+      {
+        RANGE *range = DPA_GetPtr(infoPtr->selectionRanges->hdpa, i);
+
+        if (range->upper > nItem)
+          return max(range->lower, nItem);
+      }
+    }
     else
     {
       nItem++;
@@ -7696,6 +7716,14 @@ static INT LISTVIEW_InsertItemT(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem,
     if ( !(hdpaSubItems = DPA_Create(8)) ) goto fail;
     if ( !DPA_SetPtr(hdpaSubItems, 0, lpItem) ) assert (FALSE);
 
+    /* grow the item arrays geometrically, so that inserting many items
+     * doesn't reallocate them over and over */
+    if (infoPtr->nItemCount >= 64 && !(infoPtr->nItemCount & (infoPtr->nItemCount - 1)))
+    {
+        DPA_Grow(infoPtr->hdpaItems, infoPtr->nItemCount);
+        DPA_Grow(infoPtr->hdpaItemIds, infoPtr->nItemCount);
+    }
+
     /* link with id struct */
     if (!(lpID = Alloc(sizeof(ITEM_ID)))) goto fail;
     lpItem->id = lpID;
@@ -7709,7 +7737,29 @@ static INT LISTVIEW_InsertItemT(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem,
     if (lpLVItem->iItem < 0 && !is_sorted) return -1;
 
     /* calculate new item index */
-    if (is_sorted)
+    if (is_sorted && infoPtr->bTextSorted)
+    {
+        /* the items are in order, so binary search for the first item
+         * that doesn't sort before the new one */
+        LPWSTR text = textdupTtoW(lpLVItem->pszText, isW);
+        INT low = 0, high = infoPtr->nItemCount, cmpv;
+
+        while (low < high)
+        {
+            INT mid = low + (high - low) / 2;
+            HDPA hItem = DPA_GetPtr(infoPtr->hdpaItems, mid);
+            ITEM_INFO *item_s = DPA_GetPtr(hItem, 0);
+
+            cmpv = textcmpWT(item_s->hdr.pszText, text, TRUE);
+            if (infoPtr->dwStyle & LVS_SORTDESCENDING) cmpv *= -1;
+
+            if (cmpv >= 0) high = mid;
+            else low = mid + 1;
+        }
+        textfreeT(text, isW);
+        nItem = low;
+    }
+    else if (is_sorted)
     {
         HDPA hItem;
         ITEM_INFO *item_s;
@@ -7729,7 +7779,11 @@ static INT LISTVIEW_InsertItemT(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem,
         nItem = i;
     }
     else
+    {
         nItem = min(lpLVItem->iItem, infoPtr->nItemCount);
+        /* an item placed by index may break the text order */
+        if (infoPtr->nItemCount) infoPtr->bTextSorted = FALSE;
+    }
 
     TRACE("inserting at %d, sorted=%d, count=%d, iItem=%d\n", nItem, is_sorted, infoPtr->nItemCount, lpLVItem->iItem);
     nItem = DPA_InsertPtr( infoPtr->hdpaItems, nItem, hdpaSubItems );
@@ -8760,10 +8814,13 @@ static BOOL LISTVIEW_SetItemCount(LISTVIEW_INFO *infoPtr, INT nItems, DWORD dwFl
 	/* According to MSDN for non-LVS_OWNERDATA this is just
 	 * a performance issue. The control allocates its internal
 	 * data structures for the number of items specified. It
-	 * cuts down on the number of memory allocations. Therefore
-	 * we will just issue a WARN here
+	 * cuts down on the number of memory allocations.
 	 */
-	WARN("for non-ownerdata performance option not implemented.\n");
+	if (nItems > infoPtr->nItemCount)
+	{
+	    DPA_Grow(infoPtr->hdpaItems, nItems);
+	    DPA_Grow(infoPtr->hdpaItemIds, nItems);
+	}
     }
 
     return TRUE;
@@ -9173,6 +9230,8 @@ static BOOL LISTVIEW_SortItems(LISTVIEW_INFO *infoPtr, PFNLVCOMPARE pfnCompare,
     /* if there are 0 or 1 items, there is no need to sort */
     if (infoPtr->nItemCount < 2) return TRUE;
 
+    infoPtr->bTextSorted = FALSE;
+
     /* clear selection */
     ranges_clear(infoPtr->selectionRanges);
 
@@ -9380,6 +9439,7 @@ static LRESULT LISTVIEW_NCCreate(HWND hwnd, const CREATESTRUCTW *lpcs)
   if (!(infoPtr->hdpaPosX  = DPA_Create(10))) goto fail;
   if (!(infoPtr->hdpaPosY  = DPA_Create(10))) goto fail;
   if (!(infoPtr->hdpaColumns = DPA_Create(10))) goto fail;
+  infoPtr->bTextSorted = TRUE;
   return TRUE;
 
 fail:
@@ -10988,6 +11048,9 @@ static INT LISTVIEW_StyleChanged(LISTVIEW_INFO *infoPtr, WPARAM wStyleType,
     infoPtr->dwStyle = lpss->styleNew;
     map_style_view(infoPtr);
 
+    if ((lpss->styleOld ^ lpss->styleNew) & (LVS_SORTASCENDING | LVS_SORTDESCENDING))
+        infoPtr->bTextSorted = !infoPtr->nItemCount;
+
     if (((lpss->styleOld & WS_HSCROLL) != 0)&&
         ((lpss->styleNew & WS_HSCROLL) == 0))
        ShowScrollBar(infoPtr->hwndSelf, SB_HORZ, FALSE);
@@ -2911,6 +2911,102 @@ static void test_sorting(void)
     DestroyWindow(hwnd);
 }
 
+static void test_large_insert(void)
+{
+    /* large counts are only used as a benchmark */
+    const INT num_items = winetest_interactive ? 1000000 : 2000;
+    const INT num_sorted = winetest_interactive ? 100000 : 1000;
+    HWND parent, hwnd;
+    LVITEMA item;
+    CHAR text[16], buff[16];
+    DWORD start;
+    INT i, r, count;
+
+    /* plain parent, so that the notifications don't end up in the message log */
+    parent = CreateWindowExA(0, "static", NULL, WS_POPUP, 0, 0, 100, 100, NULL, NULL, NULL, NULL);
+    ok(parent != NULL, "failed to create parent window\n");
+
+    /* appending with redraw disabled */
+    hwnd = CreateWindowExA(0, WC_LISTVIEWA, NULL, WS_CHILD | WS_VISIBLE | LVS_REPORT,
+                           0, 0, 100, 100, parent, NULL, NULL, NULL);
+    ok(hwnd != NULL, "failed to create listview window\n");
+    SendMessageA(hwnd, WM_SETREDRAW, FALSE, 0);
+    memset(&item, 0, sizeof(item));
+    item.mask = LVIF_TEXT;
+    item.pszText = text;
+    start = GetTickCount();
+    for (i = 0; i < num_items; i++)
+    {
+        sprintf(text, "%07d", i);
+        item.iItem = i;
+        r = SendMessageA(hwnd, LVM_INSERTITEMA, 0, (LPARAM)&item);
+        if (r != i) break;
+    }
+    SendMessageA(hwnd, WM_SETREDRAW, TRUE, 0);
+    ok(i == num_items, "insert failed at %d, got %d\n", i, r);
+    if (winetest_interactive)
+        trace("appended %d items in %u ms\n", num_items, GetTickCount() - start);
+    r = SendMessageA(hwnd, LVM_GETITEMCOUNT, 0, 0);
+    expect(num_items, r);
+    start = GetTickCount();
+    SendMessageA(hwnd, LVM_DELETEALLITEMS, 0, 0);
+    if (winetest_interactive)
+        trace("deleted %d items in %u ms\n", num_items, GetTickCount() - start);
+    DestroyWindow(hwnd);
+
+    /* sorted insertion of items in pseudo-random order */
+    hwnd = CreateWindowExA(0, WC_LISTVIEWA, NULL, WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SORTASCENDING,
+                           0, 0, 100, 100, parent, NULL, NULL, NULL);
+    ok(hwnd != NULL, "failed to create listview window\n");
+    SendMessageA(hwnd, LVM_SETITEMCOUNT, num_sorted, 0);
+    start = GetTickCount();
+    for (i = 0; i < num_sorted; i++)
+    {
+        sprintf(text, "%07d", (i * 7919) % num_sorted);
+        item.iItem = 0;
+        SendMessageA(hwnd, LVM_INSERTITEMA, 0, (LPARAM)&item);
+    }
+    if (winetest_interactive)
+        trace("inserted %d sorted items in %u ms\n", num_sorted, GetTickCount() - start);
+
+    for (i = 0; i < num_sorted; i += 97)
+    {
+        item.iItem = i;
+        item.pszText = buff;
+        item.cchTextMax = sizeof(buff);
+        SendMessageA(hwnd, LVM_GETITEMTEXTA, i, (LPARAM)&item);
+        sprintf(text, "%07d", i);
+        if (strcmp(buff, text))
+        {
+            ok(0, "item %d: got %s, expected %s\n", i, buff, text);
+            break;
+        }
+    }
+
+    DestroyWindow(hwnd);
+
+    /* virtual list: walking a few selected items among many */
+    hwnd = CreateWindowExA(0, WC_LISTVIEWA, NULL, WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_OWNERDATA,
+                           0, 0, 100, 100, parent, NULL, NULL, NULL);
+    ok(hwnd != NULL, "failed to create listview window\n");
+    SendMessageA(hwnd, LVM_SETITEMCOUNT, num_items, 0);
+    memset(&item, 0, sizeof(item));
+    item.stateMask = LVIS_SELECTED;
+    item.state = LVIS_SELECTED;
+    SendMessageA(hwnd, LVM_SETITEMSTATE, 10, (LPARAM)&item);
+    SendMessageA(hwnd, LVM_SETITEMSTATE, num_items / 2, (LPARAM)&item);
+    SendMessageA(hwnd, LVM_SETITEMSTATE, num_items - 1, (LPARAM)&item);
+    start = GetTickCount();
+    for (count = 0, i = -1; (i = SendMessageA(hwnd, LVM_GETNEXTITEM, i, LVNI_SELECTED)) != -1; count++)
+        ok(i == 10 || i == num_items / 2 || i == num_items - 1, "got item %d\n", i);
+    expect(3, count);
+    if (winetest_interactive)
+        trace("walked selection of %d items in %u ms\n", num_items, GetTickCount() - start);
+    DestroyWindow(hwnd);
+
+    DestroyWindow(parent);
+}
+
 static void test_ownerdata(void)
 {
     static char test_str[] = "test";
@@ -5594,6 +5690,7 @@ START_TEST(listview)
     test_subitem_rect();
     test_sorting();
     test_ownerdata();
+    test_large_insert();
     test_norecompute();
     test_nosortheader();
     test_setredraw();
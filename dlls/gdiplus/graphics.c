@@ -939,6 +939,309 @@ static ARGB resample_bitmap_pixel(GDIPCONST GpRect *src_rect, LPBYTE bits, UINT
     }
 }
 
+/* precomputed taps of a one-dimensional resampling filter */
+struct resample_filter
+{
+    INT  max_taps;    /* number of taps allocated per destination pixel */
+    INT *counts;      /* number of taps of each destination pixel, 0 if outside of the source */
+    INT *indices;     /* index of each tap in the sampled area, -1 for the outside color */
+    INT *weights;     /* weight of each tap, in RESAMPLE_WEIGHT_ONE units */
+};
+
+#define RESAMPLE_WEIGHT_SHIFT 14
+#define RESAMPLE_WEIGHT_ONE   (1 << RESAMPLE_WEIGHT_SHIFT)
+
+static REAL resample_kernel(InterpolationMode interpolation, REAL x)
+{
+    x = fabsf(x);
+
+    switch (interpolation)
+    {
+    case InterpolationModeBicubic:
+    case InterpolationModeHighQualityBicubic:
+        /* Catmull-Rom spline */
+        if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+        if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+        return 0.0;
+    default:
+        return x < 1.0 ? 1.0 - x : 0.0;
+    }
+}
+
+/* map a source coordinate to the sampled area, following the wrap mode */
+static INT get_resample_index(INT i, INT size, WrapMode wrap, BOOL flip, INT area_start, INT area_size)
+{
+    if (wrap == WrapModeClamp)
+    {
+        if (i < 0 || i >= size) return -1;
+    }
+    else
+    {
+        if (i < 0) i = size * 2 + i % (size * 2);
+        if (flip && (i / size) % 2) i = size - 1 - i % size;
+        else i = i % size;
+    }
+
+    i -= area_start;
+    if (i < 0) i = 0;
+    if (i >= area_size) i = area_size - 1;
+    return i;
+}
+
+static void free_resample_filter(struct resample_filter *filter)
+{
+    GdipFree(filter->counts);
+    GdipFree(filter->indices);
+    GdipFree(filter->weights);
+}
+
+/* compute the taps for the destination pixels dst_start..dst_start+dst_count-1, whose
+ * source coordinates are origin + i * step */
+static GpStatus init_resample_filter(struct resample_filter *filter, InterpolationMode interpolation,
+    PixelOffsetMode offset_mode, WrapMode wrap, BOOL flip, REAL origin, REAL step, INT dst_start,
+    INT dst_count, REAL src_start, REAL src_size, INT area_start, INT area_size, INT size)
+{
+    REAL scale = 1.0, radius, weights[64];
+    INT i, j;
+
+    switch (interpolation)
+    {
+    case InterpolationModeNearestNeighbor:
+        radius = 0.0;
+        break;
+    case InterpolationModeBicubic:
+        radius = 2.0;
+        break;
+    case InterpolationModeHighQualityBicubic:
+        scale = max(fabsf(step), 1.0);
+        radius = 2.0 * scale;
+        break;
+    case InterpolationModeHighQualityBilinear:
+        scale = max(fabsf(step), 1.0);
+        radius = scale;
+        break;
+    default:
+        radius = 1.0;
+        break;
+    }
+
+    /* keep the prefilter of large downscales within a reasonable number of taps */
+    if (radius > 31.0)
+    {
+        scale *= 31.0 / radius;
+        radius = 31.0;
+    }
+
+    filter->max_taps = 2 * (INT)ceilf(radius) + 1;
+    filter->counts = GdipAlloc(sizeof(INT) * dst_count);
+    filter->indices = GdipAlloc(sizeof(INT) * dst_count * filter->max_taps);
+    filter->weights = GdipAlloc(sizeof(INT) * dst_count * filter->max_taps);
+    if (!filter->counts || !filter->indices || !filter->weights)
+    {
+        free_resample_filter(filter);
+        return OutOfMemory;
+    }
+
+    for (i = 0; i < dst_count; i++)
+    {
+        REAL pos = origin + (dst_start + i) * step, total = 0.0;
+        INT *indices = filter->indices + i * filter->max_taps;
+        INT *fixed = filter->weights + i * filter->max_taps;
+        INT first, last, count = 0, sum = 0, largest = 0;
+
+        if (pos < src_start || pos >= src_start + src_size)
+        {
+            filter->counts[i] = 0;
+            continue;
+        }
+
+        if (interpolation == InterpolationModeNearestNeighbor)
+        {
+            REAL pixel_offset = (offset_mode == PixelOffsetModeHalf ||
+                offset_mode == PixelOffsetModeHighQuality) ? 0.0 : 0.5;
+
+            indices[0] = get_resample_index(floorf(pos + pixel_offset), size, wrap, flip, area_start, area_size);
+            fixed[0] = RESAMPLE_WEIGHT_ONE;
+            filter->counts[i] = 1;
+            continue;
+        }
+
+        first = ceilf(pos - radius);
+        last = floorf(pos + radius);
+        for (j = first; j <= last && count < filter->max_taps; j++)
+        {
+            REAL weight = resample_kernel(interpolation, (j - pos) / scale);
+
+            if (weight == 0.0) continue;
+            indices[count] = get_resample_index(j, size, wrap, flip, area_start, area_size);
+            weights[count] = weight;
+            total += weight;
+            count++;
+        }
+
+        if (!count || total == 0.0)
+        {
+            indices[0] = get_resample_index(floorf(pos), size, wrap, flip, area_start, area_size);
+            fixed[0] = RESAMPLE_WEIGHT_ONE;
+            filter->counts[i] = 1;
+            continue;
+        }
+
+        /* normalize so that the weights add up exactly to one */
+        for (j = 0; j < count; j++)
+        {
+            fixed[j] = gdip_round(weights[j] / total * RESAMPLE_WEIGHT_ONE);
+            sum += fixed[j];
+            if (fixed[j] > fixed[largest]) largest = j;
+        }
+        fixed[largest] += RESAMPLE_WEIGHT_ONE - sum;
+        filter->counts[i] = count;
+    }
+
+    return Ok;
+}
+
+static inline BYTE clamp_resampled_channel(INT value)
+{
+    value = (value + RESAMPLE_WEIGHT_ONE / 2) >> RESAMPLE_WEIGHT_SHIFT;
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+/* apply a filter to a row of pixels */
+static void resample_row(const struct resample_filter *filter, const ARGB *src,
+    ARGB *dst, INT dst_count, ARGB outside_color)
+{
+    INT i, j;
+
+    for (i = 0; i < dst_count; i++)
+    {
+        const INT *indices = filter->indices + i * filter->max_taps;
+        const INT *weights = filter->weights + i * filter->max_taps;
+        INT a = 0, r = 0, g = 0, b = 0;
+
+        if (!filter->counts[i])
+        {
+            dst[i] = 0;
+            continue;
+        }
+
+        for (j = 0; j < filter->counts[i]; j++)
+        {
+            ARGB color = indices[j] < 0 ? outside_color : src[indices[j]];
+
+            a += (INT)(color >> 24) * weights[j];
+            r += (INT)((color >> 16) & 0xff) * weights[j];
+            g += (INT)((color >> 8) & 0xff) * weights[j];
+            b += (INT)(color & 0xff) * weights[j];
+        }
+
+        dst[i] = (clamp_resampled_channel(a) << 24) | (clamp_resampled_channel(r) << 16) |
+                 (clamp_resampled_channel(g) << 8) | clamp_resampled_channel(b);
+    }
+}
+
+/* scale an axis-aligned image with two one-dimensional passes */
+static GpStatus resample_bitmap_separable(const GpRect *src_area, const ARGB *src_data,
+    GpBitmap *bitmap, REAL srcx, REAL srcy, REAL srcwidth, REAL srcheight,
+    const GpPointF *origin, REAL x_step, REAL y_step, const RECT *dst_area, ARGB *dst_data,
+    GDIPCONST GpImageAttributes *attributes, InterpolationMode interpolation, PixelOffsetMode offset_mode)
+{
+    struct resample_filter x_filter, y_filter;
+    INT dst_width = dst_area->right - dst_area->left;
+    INT dst_height = dst_area->bottom - dst_area->top;
+    ARGB *temp;
+    INT *accum;
+    GpStatus stat;
+    INT x, y, i;
+
+    stat = init_resample_filter(&x_filter, interpolation, offset_mode, attributes->wrap,
+        (attributes->wrap & 1) != 0, origin->X, x_step, dst_area->left, dst_width,
+        srcx, srcwidth, src_area->X, src_area->Width, bitmap->width);
+    if (stat != Ok) return stat;
+
+    stat = init_resample_filter(&y_filter, interpolation, offset_mode, attributes->wrap,
+        (attributes->wrap & 2) != 0, origin->Y, y_step, dst_area->top, dst_height,
+        srcy, srcheight, src_area->Y, src_area->Height, bitmap->height);
+    if (stat != Ok)
+    {
+        free_resample_filter(&x_filter);
+        return stat;
+    }
+
+    temp = GdipAlloc(sizeof(ARGB) * dst_width * src_area->Height);
+    accum = GdipAlloc(sizeof(INT) * 4 * dst_width);
+    if (!temp || !accum)
+        stat = OutOfMemory;
+
+    if (stat == Ok)
+    {
+        /* horizontal pass over all the sampled rows */
+        for (y = 0; y < src_area->Height; y++)
+            resample_row(&x_filter, src_data + y * src_area->Width,
+                temp + y * dst_width, dst_width, attributes->outside_color);
+
+        /* vertical pass, accumulating whole rows at a time */
+        for (y = 0; y < dst_height; y++)
+        {
+            const INT *indices = y_filter.indices + y * y_filter.max_taps;
+            const INT *weights = y_filter.weights + y * y_filter.max_taps;
+            ARGB *dst = dst_data + y * dst_width;
+
+            if (!y_filter.counts[y])
+            {
+                memset(dst, 0, sizeof(ARGB) * dst_width);
+                continue;
+            }
+
+            memset(accum, 0, sizeof(INT) * 4 * dst_width);
+            for (i = 0; i < y_filter.counts[y]; i++)
+            {
+                const ARGB *src;
+                INT weight = weights[i];
+
+                if (indices[i] < 0)
+                {
+                    ARGB color = attributes->outside_color;
+                    for (x = 0; x < dst_width; x++)
+                    {
+                        accum[4 * x]     += (INT)(color >> 24) * weight;
+                        accum[4 * x + 1] += (INT)((color >> 16) & 0xff) * weight;
+                        accum[4 * x + 2] += (INT)((color >> 8) & 0xff) * weight;
+                        accum[4 * x + 3] += (INT)(color & 0xff) * weight;
+                    }
+                    continue;
+                }
+
+                src = temp + indices[i] * dst_width;
+                for (x = 0; x < dst_width; x++)
+                {
+                    accum[4 * x]     += (INT)(src[x] >> 24) * weight;
+                    accum[4 * x + 1] += (INT)((src[x] >> 16) & 0xff) * weight;
+                    accum[4 * x + 2] += (INT)((src[x] >> 8) & 0xff) * weight;
+                    accum[4 * x + 3] += (INT)(src[x] & 0xff) * weight;
+                }
+            }
+
+            for (x = 0; x < dst_width; x++)
+            {
+                if (!x_filter.counts[x])
+                    dst[x] = 0;
+                else
+                    dst[x] = (clamp_resampled_channel(accum[4 * x]) << 24) |
+                             (clamp_resampled_channel(accum[4 * x + 1]) << 16) |
+                             (clamp_resampled_channel(accum[4 * x + 2]) << 8) |
+                             clamp_resampled_channel(accum[4 * x + 3]);
+            }
+        }
+    }
+
+    GdipFree(temp);
+    GdipFree(accum);
+    free_resample_filter(&x_filter);
+    free_resample_filter(&y_filter);
+    return stat;
+}
+
 static REAL intersect_line_scanline(const GpPointF *p1, const GpPointF *p2, REAL y)
 {
     return (p1->X - p2->X) * (p2->Y - y) / (p2->Y - p1->Y) + p2->X;
@@ -3032,7 +3335,12 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
             y_dx = dst_to_src_points[2].X - dst_to_src_points[0].X;
             y_dy = dst_to_src_points[2].Y - dst_to_src_points[0].Y;
 
-            for (x=dst_area.left; x<dst_area.right; x++)
+            /* Scaling without rotation or shear can be done in two separate passes. */
+            if (x_dy == 0.0 && y_dx == 0.0)
+                stat = resample_bitmap_separable(&src_area, (ARGB*)src_data, bitmap,
+                    srcx, srcy, srcwidth, srcheight, &dst_to_src_points[0], x_dx, y_dy,
+                    &dst_area, (ARGB*)dst_data, imageAttributes, interpolation, offset_mode);
+            else for (x=dst_area.left; x<dst_area.right; x++)
             {
                 for (y=dst_area.top; y<dst_area.bottom; y++)
                 {
@@ -3054,8 +3362,9 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
 
             GdipFree(src_data);
 
-            stat = alpha_blend_pixels(graphics, dst_area.left, dst_area.top,
-                dst_data, dst_area.right - dst_area.left, dst_area.bottom - dst_area.top, dst_stride);
+            if (stat == Ok)
+                stat = alpha_blend_pixels(graphics, dst_area.left, dst_area.top,
+                    dst_data, dst_area.right - dst_area.left, dst_area.bottom - dst_area.top, dst_stride);
 
             GdipFree(dst_data);
 
@@ -3655,6 +3964,319 @@ end:
     return retval;
 }
 
+/* number of sub-scanlines per pixel row for antialiased fills */
+#define AA_SUBSAMPLES 16
+/* number of pixel rows rasterized before being blended */
+#define FILL_BAND_HEIGHT 32
+
+/* a non-horizontal edge of a flattened path, in device coordinates */
+struct fill_edge
+{
+    REAL ytop;      /* top of the edge */
+    REAL ybottom;   /* bottom of the edge */
+    REAL x;         /* x coordinate at ytop */
+    REAL dxdy;      /* x increment per unit of y */
+    INT winding;    /* +1 for downward edges, -1 for upward ones */
+};
+
+/* a crossing of a sub-scanline with an edge */
+struct fill_crossing
+{
+    REAL x;
+    INT winding;
+};
+
+static int fill_edge_compare(const void *a, const void *b)
+{
+    const struct fill_edge *edge1 = a, *edge2 = b;
+    if (edge1->ytop < edge2->ytop) return -1;
+    return edge1->ytop > edge2->ytop;
+}
+
+static void add_fill_edge(struct fill_edge *edges, INT *count, const GpPointF *p1, const GpPointF *p2)
+{
+    struct fill_edge *edge = &edges[*count];
+
+    if (p1->Y == p2->Y) return;
+
+    if (p1->Y < p2->Y)
+    {
+        edge->ytop = p1->Y;
+        edge->ybottom = p2->Y;
+        edge->x = p1->X;
+        edge->winding = 1;
+    }
+    else
+    {
+        edge->ytop = p2->Y;
+        edge->ybottom = p1->Y;
+        edge->x = p2->X;
+        edge->winding = -1;
+    }
+    edge->dxdy = (p2->X - p1->X) / (p2->Y - p1->Y);
+    (*count)++;
+}
+
+/* accumulate the coverage of a sub-scanline span into a row */
+static void add_span_coverage(REAL *coverage, REAL *accum, REAL left, REAL right,
+    INT min_x, INT max_x, REAL weight)
+{
+    INT start, end;
+
+    if (left < min_x) left = min_x;
+    if (right > max_x) right = max_x;
+    if (left >= right) return;
+
+    left -= min_x;
+    right -= min_x;
+    start = floorf(left);
+    end = floorf(right);
+
+    if (start == end)
+    {
+        coverage[start] += (right - left) * weight;
+        return;
+    }
+
+    coverage[start] += (start + 1 - left) * weight;
+    accum[start + 1] += weight;
+    accum[end] -= weight;
+    if (end < max_x - min_x)
+        coverage[end] += (right - end) * weight;
+}
+
+/* fill the pixels of a band of rows with the brush, using the coverage mask as alpha */
+static GpStatus blend_fill_band(GpGraphics *graphics, GpBrush *brush, DWORD *pixels,
+    const BYTE *mask, INT mask_stride, INT min_x, INT y, INT height, INT band_left, INT band_right)
+{
+    GpRect fill_area;
+    GpStatus stat;
+    INT x, row;
+
+    fill_area.X = min_x + band_left;
+    fill_area.Y = y;
+    fill_area.Width = band_right - band_left;
+    fill_area.Height = height;
+
+    memset(pixels, 0, sizeof(*pixels) * fill_area.Width * height);
+    stat = brush_fill_pixels(graphics, brush, pixels, &fill_area, fill_area.Width);
+    if (stat != Ok)
+        return stat;
+
+    for (row = 0; row < height; row++)
+    {
+        DWORD *line = pixels + row * fill_area.Width;
+        const BYTE *alpha = mask + row * mask_stride + band_left;
+
+        for (x = 0; x < fill_area.Width; x++)
+            line[x] = (line[x] & 0x00ffffff) | (((line[x] >> 24) * alpha[x] / 255) << 24);
+    }
+
+    return alpha_blend_pixels(graphics, fill_area.X, fill_area.Y, (BYTE*)pixels,
+        fill_area.Width, fill_area.Height, fill_area.Width * 4);
+}
+
+/* rasterize a path with coverage-based antialiasing, feeding the brush a band of rows at a time */
+static GpStatus SOFTWARE_GdipFillPath_AntiAlias(GpGraphics *graphics, GpBrush *brush, GpPath *path)
+{
+    GpStatus stat;
+    GpPath *flat_path;
+    GpMatrix world_to_device;
+    GpRectF graphics_bounds;
+    struct fill_edge *edges = NULL, **active = NULL;
+    struct fill_crossing *crossings = NULL;
+    REAL *coverage = NULL, *accum = NULL, min_xf, min_yf, max_xf, max_yf, offset;
+    BYTE *mask = NULL;
+    DWORD *pixels = NULL;
+    INT i, j, count, edge_count = 0, next_edge = 0, active_count = 0, figure_start = 0;
+    INT min_x, min_y, max_x, max_y, width, y, band_y, band_left, band_right, sub;
+
+    stat = get_graphics_bounds(graphics, &graphics_bounds);
+
+    if (stat == Ok)
+        stat = GdipClonePath(path, &flat_path);
+
+    if (stat != Ok)
+        return stat;
+
+    stat = get_graphics_transform(graphics, CoordinateSpaceDevice,
+        CoordinateSpaceWorld, &world_to_device);
+
+    if (stat == Ok)
+    {
+        /* pixel centers are on integer coordinates unless a half pixel offset is requested */
+        if (graphics->pixeloffset == PixelOffsetModeHalf ||
+            graphics->pixeloffset == PixelOffsetModeHighQuality)
+            offset = 0.0;
+        else
+            offset = 0.5;
+        GdipTranslateMatrix(&world_to_device, offset, offset, MatrixOrderAppend);
+
+        stat = GdipTransformPath(flat_path, &world_to_device);
+    }
+
+    if (stat == Ok)
+        stat = GdipFlattenPath(flat_path, NULL, 0.25);
+
+    count = flat_path->pathdata.Count;
+
+    if (stat == Ok && count)
+    {
+        edges = GdipAlloc(sizeof(*edges) * count);
+        active = GdipAlloc(sizeof(*active) * count);
+        crossings = GdipAlloc(sizeof(*crossings) * count);
+        if (!edges || !active || !crossings)
+            stat = OutOfMemory;
+    }
+
+    if (stat != Ok || !count)
+        goto end;
+
+    /* build the edge list, closing all figures */
+
+    min_xf = max_xf = flat_path->pathdata.Points[0].X;
+    min_yf = max_yf = flat_path->pathdata.Points[0].Y;
+
+    for (i = 0; i < count; i++)
+    {
+        const GpPointF *point = &flat_path->pathdata.Points[i];
+        BYTE type = flat_path->pathdata.Types[i];
+
+        if ((type & PathPointTypePathTypeMask) == PathPointTypeStart)
+            figure_start = i;
+        else
+            add_fill_edge(edges, &edge_count, &flat_path->pathdata.Points[i-1], point);
+
+        if (i + 1 == count || (type & PathPointTypeCloseSubpath) ||
+            (flat_path->pathdata.Types[i+1] & PathPointTypePathTypeMask) == PathPointTypeStart)
+            add_fill_edge(edges, &edge_count, point, &flat_path->pathdata.Points[figure_start]);
+
+        min_xf = min(min_xf, point->X);
+        max_xf = max(max_xf, point->X);
+        min_yf = min(min_yf, point->Y);
+        max_yf = max(max_yf, point->Y);
+    }
+
+    min_x = max(floorf(min_xf), graphics_bounds.X);
+    min_y = max(floorf(min_yf), graphics_bounds.Y);
+    max_x = min(ceilf(max_xf), graphics_bounds.X + graphics_bounds.Width);
+    max_y = min(ceilf(max_yf), graphics_bounds.Y + graphics_bounds.Height);
+
+    if (!edge_count || min_x >= max_x || min_y >= max_y)
+        goto end;
+
+    qsort(edges, edge_count, sizeof(*edges), fill_edge_compare);
+
+    width = max_x - min_x;
+    coverage = GdipAlloc(sizeof(*coverage) * (width + 1));
+    accum = GdipAlloc(sizeof(*accum) * (width + 1));
+    mask = GdipAlloc(width * FILL_BAND_HEIGHT);
+    pixels = GdipAlloc(sizeof(*pixels) * width * FILL_BAND_HEIGHT);
+    if (!coverage || !accum || !mask || !pixels)
+    {
+        stat = OutOfMemory;
+        goto end;
+    }
+
+    band_y = min_y;
+    band_left = width;
+    band_right = 0;
+
+    for (y = min_y; y < max_y && stat == Ok; y++)
+    {
+        BYTE *row_mask = mask + (y - band_y) * width;
+        BOOL last_row;
+        REAL sum = 0.0;
+
+        memset(coverage, 0, sizeof(*coverage) * (width + 1));
+        memset(accum, 0, sizeof(*accum) * (width + 1));
+        memset(row_mask, 0, width);
+
+        for (sub = 0; sub < AA_SUBSAMPLES; sub++)
+        {
+            REAL sample_y = y + (sub + 0.5) / AA_SUBSAMPLES;
+            INT crossing_count = 0, winding = 0;
+
+            /* update the active edge list */
+            for (i = 0, j = 0; i < active_count; i++)
+                if (active[i]->ybottom > sample_y) active[j++] = active[i];
+            active_count = j;
+            while (next_edge < edge_count && edges[next_edge].ytop <= sample_y)
+            {
+                if (edges[next_edge].ybottom > sample_y)
+                    active[active_count++] = &edges[next_edge];
+                next_edge++;
+            }
+
+            /* collect the crossings, sorted by x */
+            for (i = 0; i < active_count; i++)
+            {
+                struct fill_crossing crossing;
+
+                crossing.x = active[i]->x + (sample_y - active[i]->ytop) * active[i]->dxdy;
+                crossing.winding = active[i]->winding;
+                for (j = crossing_count; j > 0 && crossings[j-1].x > crossing.x; j--)
+                    crossings[j] = crossings[j-1];
+                crossings[j] = crossing;
+                crossing_count++;
+            }
+
+            /* and accumulate the spans that are inside according to the fill mode */
+            for (i = 0; i + 1 < crossing_count; i++)
+            {
+                if (flat_path->fill == FillModeAlternate)
+                    winding ^= 1;
+                else
+                    winding += crossings[i].winding;
+
+                if (winding && crossings[i+1].x > crossings[i].x)
+                {
+                    add_span_coverage(coverage, accum, crossings[i].x, crossings[i+1].x,
+                        min_x, max_x, 1.0 / AA_SUBSAMPLES);
+                    band_left = min(band_left, max(floorf(crossings[i].x) - min_x, 0));
+                    band_right = max(band_right, min(ceilf(crossings[i+1].x) - min_x, width));
+                }
+            }
+        }
+
+        /* resolve the coverage of the row into the band mask */
+        for (i = 0; i < band_right; i++)
+        {
+            REAL value;
+
+            sum += accum[i];
+            value = coverage[i] + sum;
+            if (value > 0.0)
+                row_mask[i] = value >= 1.0 ? 255 : (BYTE)(value * 255.0 + 0.5);
+        }
+
+        last_row = (y + 1 == max_y) || (next_edge == edge_count && !active_count);
+
+        if (y + 1 - band_y == FILL_BAND_HEIGHT || last_row)
+        {
+            if (band_left < band_right)
+                stat = blend_fill_band(graphics, brush, pixels, mask, width, min_x,
+                    band_y, y + 1 - band_y, band_left, band_right);
+            band_y = y + 1;
+            band_left = width;
+            band_right = 0;
+        }
+
+        if (last_row) break;
+    }
+
+end:
+    GdipFree(edges);
+    GdipFree(active);
+    GdipFree(crossings);
+    GdipFree(coverage);
+    GdipFree(accum);
+    GdipFree(mask);
+    GdipFree(pixels);
+    GdipDeletePath(flat_path);
+    return stat;
+}
+
 static GpStatus SOFTWARE_GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPath *path)
 {
     GpStatus stat;
@@ -3663,7 +4285,9 @@ static GpStatus SOFTWARE_GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPa
     if (!brush_can_fill_pixels(brush))
         return NotImplemented;
 
-    /* FIXME: This could probably be done more efficiently without regions. */
+    if (graphics->smoothing == SmoothingModeAntiAlias ||
+        graphics->smoothing == SmoothingModeHighQuality)
+        return SOFTWARE_GdipFillPath_AntiAlias(graphics, brush, path);
 
     stat = GdipCreateRegionPath(path, &rgn);
 
@@ -3952,6 +4576,7 @@ static GpStatus SOFTWARE_GdipFillRegion(GpGraphics *graphics, GpBrush *brush,
     HRGN hregion;
     RECT bound_rect;
     GpRect gp_bound_rect;
+    INT y;
 
     if (!brush_can_fill_pixels(brush))
         return NotImplemented;
@@ -3987,16 +4612,21 @@ static GpStatus SOFTWARE_GdipFillRegion(GpGraphics *graphics, GpBrush *brush,
     if (stat == Ok)
     {
         gp_bound_rect.X = bound_rect.left;
-        gp_bound_rect.Y = bound_rect.top;
         gp_bound_rect.Width = bound_rect.right - bound_rect.left;
-        gp_bound_rect.Height = bound_rect.bottom - bound_rect.top;
 
-        pixel_data = GdipAlloc(sizeof(*pixel_data) * gp_bound_rect.Width * gp_bound_rect.Height);
+        /* fill a band of rows at a time to avoid allocating the whole area */
+        pixel_data = GdipAlloc(sizeof(*pixel_data) * gp_bound_rect.Width *
+            min(FILL_BAND_HEIGHT, bound_rect.bottom - bound_rect.top));
         if (!pixel_data)
             stat = OutOfMemory;
 
-        if (stat == Ok)
+        for (y = bound_rect.top; stat == Ok && y < bound_rect.bottom; y += FILL_BAND_HEIGHT)
         {
+            gp_bound_rect.Y = y;
+            gp_bound_rect.Height = min(FILL_BAND_HEIGHT, bound_rect.bottom - y);
+
+            /* some brushes don't set the pixels outside of their shape */
+            memset(pixel_data, 0, sizeof(*pixel_data) * gp_bound_rect.Width * gp_bound_rect.Height);
             stat = brush_fill_pixels(graphics, brush, pixel_data,
                 &gp_bound_rect, gp_bound_rect.Width);
 
@@ -4004,10 +4634,10 @@ static GpStatus SOFTWARE_GdipFillRegion(GpGraphics *graphics, GpBrush *brush,
                 stat = alpha_blend_pixels_hrgn(graphics, gp_bound_rect.X,
                     gp_bound_rect.Y, (BYTE*)pixel_data, gp_bound_rect.Width,
                     gp_bound_rect.Height, gp_bound_rect.Width * 4, hregion);
-
-            GdipFree(pixel_data);
         }
 
+        GdipFree(pixel_data);
+
         DeleteObject(hregion);
     }
 
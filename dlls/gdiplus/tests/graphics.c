@@ -1297,6 +1297,102 @@ static void test_GdipDrawImagePointsRect(void)
     ReleaseDC(hwnd, hdc);
 }
 
+static void test_GdipDrawImagePointsRect_scaling(void)
+{
+    static const InterpolationMode modes[] = { InterpolationModeNearestNeighbor, InterpolationModeBilinear,
+        InterpolationModeHighQualityBilinear, InterpolationModeBicubic, InterpolationModeHighQualityBicubic };
+    GpStatus status;
+    GpBitmap *src, *dst;
+    GpGraphics *graphics;
+    GpPointF ptf[3];
+    ARGB color;
+    DWORD start;
+    int i, x, y;
+
+    status = GdipCreateBitmapFromScan0(16, 16, 0, PixelFormat32bppARGB, NULL, &src);
+    expect(Ok, status);
+    for (y = 0; y < 16; y++)
+        for (x = 0; x < 16; x++)
+            GdipBitmapSetPixel(src, x, y, x < 8 ? 0xffff0000 : 0xff0000ff);
+
+    status = GdipCreateBitmapFromScan0(64, 64, 0, PixelFormat32bppARGB, NULL, &dst);
+    expect(Ok, status);
+    status = GdipGetImageGraphicsContext((GpImage*)dst, &graphics);
+    expect(Ok, status);
+
+    for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++)
+    {
+        status = GdipSetInterpolationMode(graphics, modes[i]);
+        expect(Ok, status);
+
+        /* upscaling */
+        GdipGraphicsClear(graphics, 0);
+        ptf[0].X = 0.0;  ptf[0].Y = 0.0;
+        ptf[1].X = 64.0; ptf[1].Y = 0.0;
+        ptf[2].X = 0.0;  ptf[2].Y = 64.0;
+        status = GdipDrawImagePointsRect(graphics, (GpImage*)src, ptf, 3, 0, 0, 16, 16, UnitPixel, NULL, NULL, NULL);
+        expect(Ok, status);
+        GdipBitmapGetPixel(dst, 10, 32, &color);
+        ok(color == 0xffff0000, "%d: got %08x\n", modes[i], color);
+        GdipBitmapGetPixel(dst, 50, 32, &color);
+        ok(color == 0xff0000ff, "%d: got %08x\n", modes[i], color);
+
+        /* downscaling */
+        GdipGraphicsClear(graphics, 0);
+        ptf[1].X = 8.0;
+        ptf[2].Y = 8.0;
+        status = GdipDrawImagePointsRect(graphics, (GpImage*)src, ptf, 3, 0, 0, 16, 16, UnitPixel, NULL, NULL, NULL);
+        expect(Ok, status);
+        GdipBitmapGetPixel(dst, 2, 4, &color);
+        ok(color == 0xffff0000, "%d: got %08x\n", modes[i], color);
+        GdipBitmapGetPixel(dst, 6, 4, &color);
+        ok(color == 0xff0000ff, "%d: got %08x\n", modes[i], color);
+        GdipBitmapGetPixel(dst, 20, 4, &color);
+        ok(color == 0, "%d: got %08x\n", modes[i], color);
+
+        /* mirrored */
+        GdipGraphicsClear(graphics, 0);
+        ptf[0].X = 32.0;
+        ptf[1].X = 0.0;
+        ptf[2].X = 32.0; ptf[2].Y = 32.0;
+        status = GdipDrawImagePointsRect(graphics, (GpImage*)src, ptf, 3, 0, 0, 16, 16, UnitPixel, NULL, NULL, NULL);
+        expect(Ok, status);
+        GdipBitmapGetPixel(dst, 4, 16, &color);
+        ok(color == 0xff0000ff, "%d: got %08x\n", modes[i], color);
+        GdipBitmapGetPixel(dst, 28, 16, &color);
+        ok(color == 0xffff0000, "%d: got %08x\n", modes[i], color);
+    }
+
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage*)dst);
+    GdipDisposeImage((GpImage*)src);
+
+    if (winetest_interactive)
+    {
+        /* scale a photo sized image */
+        status = GdipCreateBitmapFromScan0(2048, 1536, 0, PixelFormat32bppARGB, NULL, &src);
+        expect(Ok, status);
+        status = GdipCreateBitmapFromScan0(1024, 768, 0, PixelFormat32bppARGB, NULL, &dst);
+        expect(Ok, status);
+        status = GdipGetImageGraphicsContext((GpImage*)dst, &graphics);
+        expect(Ok, status);
+        ptf[0].X = 0.0;    ptf[0].Y = 0.0;
+        ptf[1].X = 1024.0; ptf[1].Y = 0.0;
+        ptf[2].X = 0.0;    ptf[2].Y = 768.0;
+        for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++)
+        {
+            GdipSetInterpolationMode(graphics, modes[i]);
+            start = GetTickCount();
+            status = GdipDrawImagePointsRect(graphics, (GpImage*)src, ptf, 3, 0, 0, 2048, 1536, UnitPixel, NULL, NULL, NULL);
+            expect(Ok, status);
+            trace("mode %d: scaled 2048x1536 to 1024x768 in %u ms\n", modes[i], GetTickCount() - start);
+        }
+        GdipDeleteGraphics(graphics);
+        GdipDisposeImage((GpImage*)dst);
+        GdipDisposeImage((GpImage*)src);
+    }
+}
+
 static void test_GdipDrawLinesI(void)
 {
     GpStatus status;
@@ -5494,6 +5590,124 @@ static void test_clipping_2(void)
     DeleteDC(hdc);
 }
 
+static void test_fill_path_antialias(void)
+{
+    GpStatus status;
+    GpBitmap *bitmap;
+    GpGraphics *graphics;
+    GpSolidFill *brush;
+    GpPath *path;
+    ARGB color;
+    DWORD start;
+    int i;
+
+    status = GdipCreateBitmapFromScan0(40, 40, 0, PixelFormat32bppARGB, NULL, &bitmap);
+    expect(Ok, status);
+    status = GdipGetImageGraphicsContext((GpImage*)bitmap, &graphics);
+    expect(Ok, status);
+    status = GdipSetSmoothingMode(graphics, SmoothingModeAntiAlias);
+    expect(Ok, status);
+    status = GdipCreateSolidFill(0xffff0000, &brush);
+    expect(Ok, status);
+
+    /* pixel centers are on integer coordinates, so the left edge covers half a pixel */
+    status = GdipCreatePath(FillModeAlternate, &path);
+    expect(Ok, status);
+    status = GdipAddPathRectangle(path, 10.0, 10.0, 10.5, 10.5);
+    expect(Ok, status);
+    status = GdipFillPath(graphics, (GpBrush*)brush, path);
+    expect(Ok, status);
+
+    status = GdipBitmapGetPixel(bitmap, 15, 15, &color);
+    expect(Ok, status);
+    ok(color == 0xffff0000, "got %08x\n", color);
+    status = GdipBitmapGetPixel(bitmap, 20, 15, &color);
+    expect(Ok, status);
+    ok(color == 0xffff0000, "got %08x\n", color);
+    status = GdipBitmapGetPixel(bitmap, 10, 15, &color);
+    expect(Ok, status);
+    ok((color & 0xffffff) == 0xff0000 && (color >> 24) >= 0x40 && (color >> 24) <= 0xc0, "got %08x\n", color);
+    status = GdipBitmapGetPixel(bitmap, 21, 15, &color);
+    expect(Ok, status);
+    ok(color == 0, "got %08x\n", color);
+    status = GdipBitmapGetPixel(bitmap, 5, 5, &color);
+    expect(Ok, status);
+    ok(color == 0, "got %08x\n", color);
+    GdipDeletePath(path);
+
+    /* nested figures leave a hole with the alternate fill mode only */
+    status = GdipGraphicsClear(graphics, 0);
+    expect(Ok, status);
+    status = GdipCreatePath(FillModeAlternate, &path);
+    expect(Ok, status);
+    GdipAddPathRectangle(path, 2.0, 2.0, 30.0, 30.0);
+    GdipAddPathRectangle(path, 10.0, 10.0, 10.0, 10.0);
+    status = GdipFillPath(graphics, (GpBrush*)brush, path);
+    expect(Ok, status);
+    status = GdipBitmapGetPixel(bitmap, 5, 5, &color);
+    expect(Ok, status);
+    ok(color == 0xffff0000, "got %08x\n", color);
+    status = GdipBitmapGetPixel(bitmap, 15, 15, &color);
+    expect(Ok, status);
+    ok(color == 0, "got %08x\n", color);
+
+    status = GdipSetPathFillMode(path, FillModeWinding);
+    expect(Ok, status);
+    status = GdipFillPath(graphics, (GpBrush*)brush, path);
+    expect(Ok, status);
+    status = GdipBitmapGetPixel(bitmap, 15, 15, &color);
+    expect(Ok, status);
+    ok(color == 0xffff0000, "got %08x\n", color);
+    GdipDeletePath(path);
+
+    /* overlapping ellipses */
+    status = GdipGraphicsClear(graphics, 0);
+    expect(Ok, status);
+    status = GdipCreatePath(FillModeWinding, &path);
+    expect(Ok, status);
+    for (i = 0; i < 4; i++)
+        GdipAddPathEllipse(path, 2.0 + i * 5.0, 10.0 + (i % 2) * 4.0, 16.0, 16.0);
+    status = GdipFillPath(graphics, (GpBrush*)brush, path);
+    expect(Ok, status);
+    status = GdipBitmapGetPixel(bitmap, 18, 20, &color);
+    expect(Ok, status);
+    ok(color == 0xffff0000, "got %08x\n", color);
+    status = GdipBitmapGetPixel(bitmap, 3, 3, &color);
+    expect(Ok, status);
+    ok(color == 0, "got %08x\n", color);
+    GdipDeletePath(path);
+
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage*)bitmap);
+
+    if (winetest_interactive)
+    {
+        /* fill a complex path at 4K resolution */
+        status = GdipCreateBitmapFromScan0(3840, 2160, 0, PixelFormat32bppARGB, NULL, &bitmap);
+        expect(Ok, status);
+        status = GdipGetImageGraphicsContext((GpImage*)bitmap, &graphics);
+        expect(Ok, status);
+        status = GdipSetSmoothingMode(graphics, SmoothingModeAntiAlias);
+        expect(Ok, status);
+        status = GdipCreatePath(FillModeWinding, &path);
+        expect(Ok, status);
+        for (i = 0; i < 20; i++)
+            GdipAddPathEllipse(path, 100.0 + i * 170.0, 80.0 + (i % 4) * 480.0, 600.0, 600.0);
+        start = GetTickCount();
+        status = GdipFillPath(graphics, (GpBrush*)brush, path);
+        expect(Ok, status);
+        trace("filled 20 ellipses at 3840x2160 in %u ms\n", GetTickCount() - start);
+        status = GdipBitmapGetPixel(bitmap, 400, 380, &color);
+        expect(Ok, status);
+        ok(color == 0xffff0000, "got %08x\n", color);
+        GdipDeletePath(path);
+        GdipDeleteGraphics(graphics);
+        GdipDisposeImage((GpImage*)bitmap);
+    }
+
+    GdipDeleteBrush((GpBrush*)brush);
+}
+
 START_TEST(graphics)
 {
     struct GdiplusStartupInput gdiplusStartupInput;
@@ -5543,6 +5757,7 @@ START_TEST(graphics)
     test_GdipDrawLineI();
     test_GdipDrawLinesI();
     test_GdipDrawImagePointsRect();
+    test_GdipDrawImagePointsRect_scaling();
     test_GdipFillClosedCurve();
     test_GdipFillClosedCurveI();
     test_GdipDrawString();
@@ -5564,6 +5779,7 @@ START_TEST(graphics)
     test_getdc_scaled();
     test_alpha_hdc();
     test_bitmapfromgraphics();
+    test_fill_path_antialias();
 
     GdiplusShutdown(gdiplusToken);
     DestroyWindow( hwnd );
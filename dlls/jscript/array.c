@@ -31,6 +31,12 @@ typedef struct {
     jsdisp_t dispex;
 
     DWORD length;
+
+    /* Elements [0, elems_cnt) are stored in elems, all others are stored as named properties. */
+    jsval_t *elems;
+    DWORD elems_cnt;
+    DWORD elems_size;
+    BOOL sparse;
 } ArrayInstance;
 
 static const WCHAR lengthW[] = {'l','e','n','g','t','h',0};
@@ -91,26 +97,55 @@ static HRESULT get_length(script_ctx_t *ctx, vdisp_t *vdisp, jsdisp_t **jsthis,
 static HRESULT set_length(jsdisp_t *obj, DWORD length)
 {
     if(is_class(obj, JSCLASS_ARRAY)) {
-        ((ArrayInstance*)obj)->length = length;
+        ArrayInstance *array = (ArrayInstance*)obj;
+
+        array->length = length;
+        if(length == array->elems_cnt)
+            array->sparse = FALSE;
         return S_OK;
     }
 
     return jsdisp_propput_name(obj, lengthW, jsval_number(length));
 }
 
-static WCHAR *idx_to_str(DWORD idx, WCHAR *ptr)
+static HRESULT ensure_elems_size(ArrayInstance *array, DWORD size)
 {
-    if(!idx) {
-        *ptr = '0';
-        return ptr;
-    }
+    jsval_t *new_elems;
+    DWORD new_size;
 
-    while(idx) {
-        *ptr-- = '0' + (idx%10);
-        idx /= 10;
-    }
+    if(size <= array->elems_size)
+        return S_OK;
+
+    new_size = array->elems_size ? array->elems_size*2 : 8;
+    if(new_size < size)
+        new_size = size;
+
+    if(array->elems)
+        new_elems = heap_realloc(array->elems, new_size*sizeof(*new_elems));
+    else
+        new_elems = heap_alloc(new_size*sizeof(*new_elems));
+    if(!new_elems)
+        return E_OUTOFMEMORY;
+
+    array->elems = new_elems;
+    array->elems_size = new_size;
+    return S_OK;
+}
+
+static HRESULT move_elem(jsdisp_t *obj, DWORD from, DWORD to)
+{
+    jsval_t val;
+    HRESULT hres;
 
-    return ptr+1;
+    hres = jsdisp_get_idx(obj, from, &val);
+    if(hres == DISP_E_UNKNOWNNAME)
+        return jsdisp_delete_idx(obj, to);
+    if(FAILED(hres))
+        return hres;
+
+    hres = jsdisp_propput_idx(obj, to, val);
+    jsval_release(val);
+    return hres;
 }
 
 static HRESULT Array_length(script_ctx_t *ctx, vdisp_t *jsthis, WORD flags, unsigned argc, jsval_t *argv,
@@ -137,13 +172,22 @@ static HRESULT Array_length(script_ctx_t *ctx, vdisp_t *jsthis, WORD flags, unsi
         if(len!=(DWORD)len)
             return throw_range_error(ctx, JS_E_INVALID_LENGTH, NULL);
 
-        for(i=len; i<This->length; i++) {
-            hres = jsdisp_delete_idx(&This->dispex, i);
-            if(FAILED(hres))
-                return hres;
+        for(i=len; i<This->elems_cnt; i++)
+            jsval_release(This->elems[i]);
+        if(len < This->elems_cnt)
+            This->elems_cnt = len;
+
+        if(This->sparse) {
+            for(i=len; i<This->length; i++) {
+                hres = jsdisp_delete_idx(&This->dispex, i);
+                if(FAILED(hres))
+                    return hres;
+            }
         }
 
-        This->length = len;
+        hres = set_length(&This->dispex, len);
+        if(FAILED(hres))
+            return hres;
         break;
     }
     default:
@@ -490,6 +534,7 @@ static HRESULT Array_reverse(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsi
 static HRESULT Array_shift(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsigned argc, jsval_t *argv,
         jsval_t *r)
 {
+    ArrayInstance *array;
     jsdisp_t *jsthis;
     DWORD length = 0, i;
     jsval_t v, ret;
@@ -513,6 +558,20 @@ static HRESULT Array_shift(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsign
         return S_OK;
     }
 
+    array = array_this(vthis);
+    if(array && array->elems_cnt == length) {
+        ret = array->elems[0];
+        memmove(array->elems, array->elems+1, (length-1)*sizeof(*array->elems));
+        array->elems_cnt--;
+        array->length--;
+
+        if(r)
+            *r = ret;
+        else
+            jsval_release(ret);
+        return S_OK;
+    }
+
     hres = jsdisp_get_idx(jsthis, 0, &ret);
     if(hres == DISP_E_UNKNOWNNAME) {
         ret = jsval_undefined();
@@ -878,28 +937,20 @@ static HRESULT Array_splice(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsig
     }
 
     if(add_args < delete_cnt) {
-        for(i = start; SUCCEEDED(hres) && i < length-delete_cnt; i++) {
-            hres = jsdisp_get_idx(jsthis, i+delete_cnt, &val);
-            if(hres == DISP_E_UNKNOWNNAME) {
-                hres = jsdisp_delete_idx(jsthis, i+add_args);
-            }else if(SUCCEEDED(hres)) {
-                hres = jsdisp_propput_idx(jsthis, i+add_args, val);
-                jsval_release(val);
-            }
-        }
+        for(i = start; SUCCEEDED(hres) && i < length-delete_cnt; i++)
+            hres = move_elem(jsthis, i+delete_cnt, i+add_args);
 
         for(i=length; SUCCEEDED(hres) && i != length-delete_cnt+add_args; i--)
             hres = jsdisp_delete_idx(jsthis, i-1);
     }else if(add_args > delete_cnt) {
-        for(i=length-delete_cnt; SUCCEEDED(hres) && i != start; i--) {
-            hres = jsdisp_get_idx(jsthis, i+delete_cnt-1, &val);
-            if(hres == DISP_E_UNKNOWNNAME) {
-                hres = jsdisp_delete_idx(jsthis, i+add_args-1);
-            }else if(SUCCEEDED(hres)) {
-                hres = jsdisp_propput_idx(jsthis, i+add_args-1, val);
-                jsval_release(val);
-            }
-        }
+        DWORD tail = length >= start+add_args ? length-add_args+delete_cnt : start+delete_cnt;
+
+        /* Elements moved past the end are appended in order, so that dense arrays stay dense. */
+        for(i = tail; SUCCEEDED(hres) && i < length; i++)
+            hres = move_elem(jsthis, i, i+add_args-delete_cnt);
+
+        for(i = tail; SUCCEEDED(hres) && i > start+delete_cnt; i--)
+            hres = move_elem(jsthis, i-1, i-1+add_args-delete_cnt);
     }
 
     for(i=0; SUCCEEDED(hres) && i < add_args; i++)
@@ -945,11 +996,10 @@ static HRESULT Array_toLocaleString(script_ctx_t *ctx, vdisp_t *vthis, WORD flag
 static HRESULT Array_unshift(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsigned argc, jsval_t *argv,
         jsval_t *r)
 {
+    ArrayInstance *array;
     jsdisp_t *jsthis;
-    WCHAR buf[14], *buf_end, *str;
     DWORD i, length;
     jsval_t val;
-    DISPID id;
     HRESULT hres;
 
     TRACE("\n");
@@ -958,38 +1008,47 @@ static HRESULT Array_unshift(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsi
     if(FAILED(hres))
         return hres;
 
-    if(argc) {
-        buf_end = buf + sizeof(buf)/sizeof(WCHAR)-1;
-        *buf_end-- = 0;
-        i = length;
+    array = array_this(vthis);
+    if(argc && array && !array->sparse && array->elems_cnt == length) {
+        hres = ensure_elems_size(array, length+argc);
+        if(FAILED(hres))
+            return hres;
 
-        while(i--) {
-            str = idx_to_str(i, buf_end);
+        memmove(array->elems+argc, array->elems, length*sizeof(*array->elems));
+        for(i=0; i<argc; i++) {
+            hres = jsval_copy(argv[i], array->elems+i);
+            if(FAILED(hres))
+                break;
+        }
+        if(FAILED(hres)) {
+            while(i--)
+                jsval_release(array->elems[i]);
+            memmove(array->elems, array->elems+argc, length*sizeof(*array->elems));
+            return hres;
+        }
 
-            hres = jsdisp_get_id(jsthis, str, 0, &id);
+        length += argc;
+        array->elems_cnt = array->length = length;
+    }else if(argc) {
+        i = length;
+        while(i--) {
+            hres = jsdisp_get_idx(jsthis, i, &val);
             if(SUCCEEDED(hres)) {
-                hres = jsdisp_propget(jsthis, id, &val);
-                if(FAILED(hres))
-                    return hres;
-
                 hres = jsdisp_propput_idx(jsthis, i+argc, val);
                 jsval_release(val);
             }else if(hres == DISP_E_UNKNOWNNAME) {
-                hres = IDispatchEx_DeleteMemberByDispID(vthis->u.dispex, id);
+                hres = jsdisp_delete_idx(jsthis, i+argc);
             }
+            if(FAILED(hres))
+                return hres;
         }
 
-        if(FAILED(hres))
-            return hres;
-    }
-
-    for(i=0; i<argc; i++) {
-        hres = jsdisp_propput_idx(jsthis, i, argv[i]);
-        if(FAILED(hres))
-            return hres;
-    }
+        for(i=0; i<argc; i++) {
+            hres = jsdisp_propput_idx(jsthis, i, argv[i]);
+            if(FAILED(hres))
+                return hres;
+        }
 
-    if(argc) {
         length += argc;
         hres = set_length(jsthis, length);
         if(FAILED(hres))
@@ -1021,7 +1080,13 @@ static HRESULT Array_value(script_ctx_t *ctx, vdisp_t *jsthis, WORD flags, unsig
 
 static void Array_destructor(jsdisp_t *dispex)
 {
-    heap_free(dispex);
+    ArrayInstance *array = (ArrayInstance*)dispex;
+    DWORD i;
+
+    for(i=0; i < array->elems_cnt; i++)
+        jsval_release(array->elems[i]);
+    heap_free(array->elems);
+    heap_free(array);
 }
 
 static void Array_on_put(jsdisp_t *dispex, const WCHAR *name)
@@ -1041,10 +1106,90 @@ static void Array_on_put(jsdisp_t *dispex, const WCHAR *name)
     if(*ptr)
         return;
 
+    array->sparse = TRUE;
     if(id >= array->length)
         array->length = id+1;
 }
 
+static unsigned Array_idx_length(jsdisp_t *jsdisp)
+{
+    ArrayInstance *array = (ArrayInstance*)jsdisp;
+    return array->elems_cnt;
+}
+
+static HRESULT Array_idx_get(jsdisp_t *jsdisp, unsigned idx, jsval_t *r)
+{
+    ArrayInstance *array = (ArrayInstance*)jsdisp;
+
+    TRACE("%p[%u]\n", array, idx);
+
+    if(idx >= array->elems_cnt) {
+        *r = jsval_undefined();
+        return S_OK;
+    }
+
+    return jsval_copy(array->elems[idx], r);
+}
+
+static HRESULT Array_idx_put(jsdisp_t *jsdisp, unsigned idx, jsval_t val)
+{
+    ArrayInstance *array = (ArrayInstance*)jsdisp;
+    jsval_t copy;
+    HRESULT hres;
+
+    TRACE("%p[%u] = %s\n", array, idx, debugstr_jsval(val));
+
+    if(idx < array->elems_cnt) {
+        hres = jsval_copy(val, &copy);
+        if(FAILED(hres))
+            return hres;
+
+        jsval_release(array->elems[idx]);
+        array->elems[idx] = copy;
+        return S_OK;
+    }
+
+    /* Only appending keeps the array dense, other elements are stored as named properties. */
+    if(idx != array->elems_cnt || array->sparse)
+        return S_FALSE;
+
+    hres = ensure_elems_size(array, idx+1);
+    if(FAILED(hres))
+        return hres;
+
+    hres = jsval_copy(val, array->elems+idx);
+    if(FAILED(hres))
+        return hres;
+
+    array->elems_cnt++;
+    if(idx >= array->length)
+        array->length = idx+1;
+    return S_OK;
+}
+
+static HRESULT Array_idx_delete(jsdisp_t *jsdisp, unsigned idx)
+{
+    ArrayInstance *array = (ArrayInstance*)jsdisp;
+    DWORD i, cnt = array->elems_cnt;
+    HRESULT hres = S_OK;
+
+    TRACE("%p[%u]\n", array, idx);
+
+    if(idx >= cnt)
+        return S_OK;
+
+    /* Elements following the hole are moved to named properties. */
+    array->elems_cnt = idx;
+    jsval_release(array->elems[idx]);
+    for(i=idx+1; i < cnt; i++) {
+        if(SUCCEEDED(hres))
+            hres = jsdisp_propput_idx(jsdisp, i, array->elems[i]);
+        jsval_release(array->elems[i]);
+    }
+
+    return hres;
+}
+
 static const builtin_prop_t Array_props[] = {
     {concatW,                Array_concat,               PROPF_METHOD|1},
     {joinW,                  Array_join,                 PROPF_METHOD|1},
@@ -1067,7 +1212,11 @@ static const builtin_info_t Array_info = {
     sizeof(Array_props)/sizeof(*Array_props),
     Array_props,
     Array_destructor,
-    Array_on_put
+    Array_on_put,
+    Array_idx_length,
+    Array_idx_get,
+    Array_idx_put,
+    Array_idx_delete
 };
 
 static const builtin_prop_t ArrayInst_props[] = {
@@ -1080,7 +1229,11 @@ static const builtin_info_t ArrayInst_info = {
     sizeof(ArrayInst_props)/sizeof(*ArrayInst_props),
     ArrayInst_props,
     Array_destructor,
-    Array_on_put
+    Array_on_put,
+    Array_idx_length,
+    Array_idx_get,
+    Array_idx_put,
+    Array_idx_delete
 };
 
 static HRESULT ArrayConstr_value(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsigned argc, jsval_t *argv,
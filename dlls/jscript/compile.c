@@ -82,6 +82,9 @@ static void dump_instr_arg(instr_arg_type_t type, instr_arg_t *arg)
     case ARG_BSTR:
         TRACE_(jscript_disas)("\t%s", debugstr_wn(arg->bstr, SysStringLen(arg->bstr)));
         break;
+    case ARG_CACHE:
+        TRACE_(jscript_disas)("\t%s", debugstr_wn(arg->cache->name, SysStringLen(arg->cache->name)));
+        break;
     case ARG_INT:
         TRACE_(jscript_disas)("\t%d", arg->uint);
         break;
@@ -269,6 +272,30 @@ static HRESULT push_instr_bstr(compiler_ctx_t *ctx, jsop_t op, const WCHAR *arg)
     return S_OK;
 }
 
+static HRESULT push_instr_cache_uint(compiler_ctx_t *ctx, jsop_t op, const WCHAR *arg1, unsigned arg2)
+{
+    member_cache_t *cache;
+    unsigned instr;
+
+    cache = compiler_alloc(ctx->code, sizeof(*cache));
+    if(!cache)
+        return E_OUTOFMEMORY;
+
+    cache->name = compiler_alloc_bstr(ctx, arg1);
+    if(!cache->name)
+        return E_OUTOFMEMORY;
+    cache->shape = 0;
+    cache->id = 0;
+
+    instr = push_instr(ctx, op);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->u.arg[0].cache = cache;
+    instr_ptr(ctx, instr)->u.arg[1].uint = arg2;
+    return S_OK;
+}
+
 static HRESULT push_instr_bstr_uint(compiler_ctx_t *ctx, jsop_t op, const WCHAR *arg1, unsigned arg2)
 {
     unsigned instr;
@@ -369,7 +396,7 @@ static HRESULT compile_member_expression(compiler_ctx_t *ctx, member_expression_
     if(FAILED(hres))
         return hres;
 
-    return push_instr_bstr(ctx, OP_member, expr->identifier);
+    return push_instr_cache_uint(ctx, OP_member, expr->identifier, 0);
 }
 
 #define LABEL_FLAG 0x80000000
@@ -438,12 +465,7 @@ static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *ex
         if(FAILED(hres))
             return hres;
 
-        /* FIXME: Potential optimization */
-        hres = push_instr_str(ctx, OP_str, member_expr->identifier);
-        if(FAILED(hres))
-            return hres;
-
-        hres = push_instr_uint(ctx, OP_memberid, flags);
+        hres = push_instr_cache_uint(ctx, OP_memberid_name, member_expr->identifier, flags);
         break;
     }
     DEFAULT_UNREACHABLE;
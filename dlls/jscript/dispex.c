@@ -35,6 +35,27 @@ static const IID IID_IDispatchJS =
 #define FDEX_VERSION_MASK 0xf0000000
 #define GOLDEN_RATIO 0x9E3779B9U
 
+/* Shape shared by all objects before they allocate any property entry. */
+#define ROOT_SHAPE 1
+
+/* Objects with more properties are likely used as dictionaries and don't get shapes. */
+#define MAX_SHAPE_PROPS 64
+#define MAX_SHAPE_TRANSITIONS 4096
+
+struct _shape_transition_t {
+    unsigned parent;
+    unsigned shape;
+    unsigned hash;
+    WCHAR *name;
+    shape_transition_t *next;
+};
+
+static LONG last_shape = ROOT_SHAPE;
+
+/* Indexed properties may be referenced without a property entry using DISPIDs from this range. */
+#define IDX_DISPID_BASE 0x40000000
+#define IDX_DISPID_MAX  0x10000000
+
 typedef enum {
     PROP_JSVAL,
     PROP_BUILTIN,
@@ -65,12 +86,24 @@ static inline DISPID prop_to_id(jsdisp_t *This, dispex_prop_t *prop)
     return prop - This->props;
 }
 
+static inline BOOL is_idx_id(DISPID id)
+{
+    return id >= IDX_DISPID_BASE && id < IDX_DISPID_BASE+IDX_DISPID_MAX;
+}
+
+static dispex_prop_t *get_idx_prop(jsdisp_t*,DISPID);
+
 static inline dispex_prop_t *get_prop(jsdisp_t *This, DISPID id)
 {
-    if(id < 0 || id >= This->prop_cnt || This->props[id].type == PROP_DELETED)
-        return NULL;
+    dispex_prop_t *prop;
+
+    if(id < 0 || id >= This->prop_cnt)
+        return is_idx_id(id) ? get_idx_prop(This, id) : NULL;
 
-    return This->props+id;
+    prop = This->props+id;
+    if(prop->type == PROP_IDX && prop->u.idx >= This->builtin_info->idx_length(This))
+        prop->type = PROP_DELETED;
+    return prop->type == PROP_DELETED ? NULL : prop;
 }
 
 static DWORD get_flags(jsdisp_t *This, dispex_prop_t *prop)
@@ -152,6 +185,90 @@ static inline HRESULT resize_props(jsdisp_t *This)
     return S_OK;
 }
 
+static inline shape_transition_t **get_shape_bucket(script_ctx_t *ctx, unsigned parent, unsigned hash)
+{
+    return ctx->shapes + ((hash ^ parent*GOLDEN_RATIO) & (ctx->shapes_size-1));
+}
+
+static unsigned get_shape_transition(jsdisp_t *This, const WCHAR *name, unsigned hash)
+{
+    script_ctx_t *ctx = This->ctx;
+    shape_transition_t *iter, **bucket;
+
+    if(!This->shape || This->prop_cnt > MAX_SHAPE_PROPS)
+        return 0;
+
+    if(ctx->shapes_size) {
+        for(iter = *get_shape_bucket(ctx, This->shape, hash); iter; iter = iter->next) {
+            if(iter->parent == This->shape && iter->hash == hash && !strcmpW(iter->name, name))
+                return iter->shape;
+        }
+    }
+
+    if(ctx->shape_cnt == MAX_SHAPE_TRANSITIONS)
+        return 0;
+
+    if(ctx->shape_cnt == ctx->shapes_size) {
+        shape_transition_t **old_shapes = ctx->shapes, *next;
+        unsigned i, old_size = ctx->shapes_size;
+
+        ctx->shapes = heap_alloc_zero((old_size ? old_size*2 : 64) * sizeof(*ctx->shapes));
+        if(!ctx->shapes) {
+            ctx->shapes = old_shapes;
+            return 0;
+        }
+        ctx->shapes_size = old_size ? old_size*2 : 64;
+
+        for(i = 0; i < old_size; i++) {
+            for(iter = old_shapes[i]; iter; iter = next) {
+                next = iter->next;
+                bucket = get_shape_bucket(ctx, iter->parent, iter->hash);
+                iter->next = *bucket;
+                *bucket = iter;
+            }
+        }
+        heap_free(old_shapes);
+    }
+
+    iter = heap_alloc(sizeof(*iter));
+    if(!iter)
+        return 0;
+
+    iter->name = heap_strdupW(name);
+    if(!iter->name) {
+        heap_free(iter);
+        return 0;
+    }
+
+    iter->parent = This->shape;
+    iter->hash = hash;
+    iter->shape = InterlockedIncrement(&last_shape);
+
+    bucket = get_shape_bucket(ctx, iter->parent, hash);
+    iter->next = *bucket;
+    *bucket = iter;
+    ctx->shape_cnt++;
+    return iter->shape;
+}
+
+void release_shapes(script_ctx_t *ctx)
+{
+    shape_transition_t *iter, *next;
+    unsigned i;
+
+    for(i = 0; i < ctx->shapes_size; i++) {
+        for(iter = ctx->shapes[i]; iter; iter = next) {
+            next = iter->next;
+            heap_free(iter->name);
+            heap_free(iter);
+        }
+    }
+
+    heap_free(ctx->shapes);
+    ctx->shapes = NULL;
+    ctx->shapes_size = ctx->shape_cnt = 0;
+}
+
 static inline dispex_prop_t* alloc_prop(jsdisp_t *This, const WCHAR *name, prop_type_t type, DWORD flags)
 {
     dispex_prop_t *prop;
@@ -167,6 +284,7 @@ static inline dispex_prop_t* alloc_prop(jsdisp_t *This, const WCHAR *name, prop_
     prop->type = type;
     prop->flags = flags;
     prop->hash = string_hash(name);
+    This->shape = get_shape_transition(This, name, prop->hash);
 
     bucket = get_props_idx(This, prop->hash);
     prop->bucket_next = This->props[bucket].bucket_head;
@@ -186,6 +304,50 @@ static dispex_prop_t *alloc_protref(jsdisp_t *This, const WCHAR *name, DWORD ref
     return ret;
 }
 
+static BOOL is_idx_name(const WCHAR *name, unsigned *ret)
+{
+    const WCHAR *ptr = name;
+    unsigned idx = 0;
+
+    if(!isdigitW(*ptr) || (*ptr == '0' && ptr[1]))
+        return FALSE;
+
+    for(; isdigitW(*ptr); ptr++) {
+        if(idx >= IDX_DISPID_MAX)
+            return FALSE;
+        idx = idx*10 + (*ptr-'0');
+    }
+    if(*ptr)
+        return FALSE;
+
+    *ret = idx;
+    return TRUE;
+}
+
+static inline DWORD idx_prop_flags(jsdisp_t *This)
+{
+    /* Array elements are the only enumerable indexed properties. */
+    if(This->builtin_info->class == JSCLASS_ARRAY)
+        return PROPF_ENUM;
+    return This->builtin_info->idx_put ? 0 : PROPF_CONST;
+}
+
+/* Indexed properties come and go with idx_length, so their entries are kept up to date lazily. */
+static void update_idx_prop(jsdisp_t *This, dispex_prop_t *prop)
+{
+    unsigned idx;
+
+    if(prop->type == PROP_IDX) {
+        if(prop->u.idx >= This->builtin_info->idx_length(This))
+            prop->type = PROP_DELETED;
+    }else if((prop->type == PROP_DELETED || prop->type == PROP_PROTREF) && is_idx_name(prop->name, &idx)
+            && idx < This->builtin_info->idx_length(This)) {
+        prop->type = PROP_IDX;
+        prop->flags = idx_prop_flags(This);
+        prop->u.idx = idx;
+    }
+}
+
 static HRESULT find_prop_name(jsdisp_t *This, unsigned hash, const WCHAR *name, dispex_prop_t **ret)
 {
     const builtin_prop_t *builtin;
@@ -202,6 +364,9 @@ static HRESULT find_prop_name(jsdisp_t *This, unsigned hash, const WCHAR *name,
                 This->props[bucket].bucket_head = pos;
             }
 
+            if(This->builtin_info->idx_length)
+                update_idx_prop(This, &This->props[pos]);
+
             *ret = &This->props[pos];
             return S_OK;
         }
@@ -222,13 +387,10 @@ static HRESULT find_prop_name(jsdisp_t *This, unsigned hash, const WCHAR *name,
     }
 
     if(This->builtin_info->idx_length) {
-        const WCHAR *ptr;
-        unsigned idx = 0;
+        unsigned idx;
 
-        for(ptr = name; isdigitW(*ptr) && idx < 0x10000; ptr++)
-            idx = idx*10 + (*ptr-'0');
-        if(!*ptr && idx < This->builtin_info->idx_length(This)) {
-            prop = alloc_prop(This, name, PROP_IDX, This->builtin_info->idx_put ? 0 : PROPF_CONST);
+        if(is_idx_name(name, &idx) && idx < This->builtin_info->idx_length(This)) {
+            prop = alloc_prop(This, name, PROP_IDX, idx_prop_flags(This));
             if(!prop)
                 return E_OUTOFMEMORY;
 
@@ -242,6 +404,19 @@ static HRESULT find_prop_name(jsdisp_t *This, unsigned hash, const WCHAR *name,
     return S_OK;
 }
 
+static dispex_prop_t *get_idx_prop(jsdisp_t *This, DISPID id)
+{
+    static const WCHAR formatW[] = {'%','d',0};
+    dispex_prop_t *prop;
+    WCHAR name[12];
+
+    sprintfW(name, formatW, id-IDX_DISPID_BASE);
+
+    if(FAILED(find_prop_name(This, string_hash(name), name, &prop)) || !prop || prop->type == PROP_DELETED)
+        return NULL;
+    return prop;
+}
+
 static HRESULT find_prop_name_prot(jsdisp_t *This, unsigned hash, const WCHAR *name, dispex_prop_t **ret)
 {
     dispex_prop_t *prop, *del=NULL;
@@ -402,9 +577,24 @@ static HRESULT invoke_prop_func(jsdisp_t *This, IDispatch *jsthis, dispex_prop_t
 
         return disp_call_value(This->ctx, get_object(prop->u.val), jsthis, flags, argc, argv, r);
     }
-    case PROP_IDX:
-        FIXME("Invoking PROP_IDX not yet supported\n");
-        return E_NOTIMPL;
+    case PROP_IDX: {
+        jsval_t val;
+
+        hres = This->builtin_info->idx_get(This, prop->u.idx, &val);
+        if(FAILED(hres))
+            return hres;
+
+        if(is_object_instance(val)) {
+            TRACE("call %s %p\n", debugstr_w(prop->name), get_object(val));
+            hres = disp_call_value(This->ctx, get_object(val), jsthis, flags, argc, argv, r);
+        }else {
+            FIXME("invoke %s\n", debugstr_jsval(val));
+            hres = E_FAIL;
+        }
+
+        jsval_release(val);
+        return hres;
+    }
     case PROP_DELETED:
         assert(0);
     }
@@ -740,7 +930,7 @@ static HRESULT WINAPI DispatchEx_InvokeEx(IDispatchEx *iface, DISPID id, LCID lc
     return hres;
 }
 
-static HRESULT delete_prop(dispex_prop_t *prop, BOOL *ret)
+static HRESULT delete_prop(jsdisp_t *This, dispex_prop_t *prop, BOOL *ret)
 {
     if(prop->flags & PROPF_DONTDELETE) {
         *ret = FALSE;
@@ -752,6 +942,9 @@ static HRESULT delete_prop(dispex_prop_t *prop, BOOL *ret)
     if(prop->type == PROP_JSVAL) {
         jsval_release(prop->u.val);
         prop->type = PROP_DELETED;
+    }else if(prop->type == PROP_IDX && This->builtin_info->idx_delete) {
+        prop->type = PROP_DELETED;
+        return This->builtin_info->idx_delete(This, prop->u.idx);
     }
     return S_OK;
 }
@@ -776,7 +969,7 @@ static HRESULT WINAPI DispatchEx_DeleteMemberByName(IDispatchEx *iface, BSTR bst
         return S_OK;
     }
 
-    return delete_prop(prop, &b);
+    return delete_prop(This, prop, &b);
 }
 
 static HRESULT WINAPI DispatchEx_DeleteMemberByDispID(IDispatchEx *iface, DISPID id)
@@ -793,7 +986,7 @@ static HRESULT WINAPI DispatchEx_DeleteMemberByDispID(IDispatchEx *iface, DISPID
         return DISP_E_MEMBERNOTFOUND;
     }
 
-    return delete_prop(prop, &b);
+    return delete_prop(This, prop, &b);
 }
 
 static HRESULT WINAPI DispatchEx_GetMemberProperties(IDispatchEx *iface, DISPID id, DWORD grfdexFetch, DWORD *pgrfdex)
@@ -810,6 +1003,15 @@ static HRESULT WINAPI DispatchEx_GetMemberName(IDispatchEx *iface, DISPID id, BS
 
     TRACE("(%p)->(%x %p)\n", This, id, pbstrName);
 
+    if(is_idx_id(id)) {
+        static const WCHAR formatW[] = {'%','d',0};
+        WCHAR name[12];
+
+        sprintfW(name, formatW, id-IDX_DISPID_BASE);
+        *pbstrName = SysAllocString(name);
+        return *pbstrName ? S_OK : E_OUTOFMEMORY;
+    }
+
     prop = get_prop(This, id);
     if(!prop || !prop->name || prop->type == PROP_DELETED)
         return DISP_E_MEMBERNOTFOUND;
@@ -835,6 +1037,24 @@ static HRESULT WINAPI DispatchEx_GetNextDispID(IDispatchEx *iface, DWORD grfdex,
             return hres;
     }
 
+    /* Enumerable indexed properties are enumerated first, without allocating property entries. */
+    if(This->builtin_info->idx_length && (idx_prop_flags(This) & PROPF_ENUM)) {
+        unsigned length = min(This->builtin_info->idx_length(This), IDX_DISPID_MAX);
+
+        if(id == DISPID_STARTENUM && length) {
+            *pid = IDX_DISPID_BASE;
+            return S_OK;
+        }
+
+        if(is_idx_id(id)) {
+            if(id-IDX_DISPID_BASE+1 < length) {
+                *pid = id+1;
+                return S_OK;
+            }
+            id = DISPID_STARTENUM;
+        }
+    }
+
     if(id+1>=0 && id+1<This->prop_cnt) {
         iter = &This->props[id+1];
     }else {
@@ -843,7 +1063,8 @@ static HRESULT WINAPI DispatchEx_GetNextDispID(IDispatchEx *iface, DWORD grfdex,
     }
 
     while(iter < This->props + This->prop_cnt) {
-        if(iter->name && (get_flags(This, iter) & PROPF_ENUM) && iter->type!=PROP_DELETED) {
+        if(iter->name && (get_flags(This, iter) & PROPF_ENUM) && iter->type!=PROP_DELETED
+                && iter->type!=PROP_IDX) {
             *pid = prop_to_id(This, iter);
             return S_OK;
         }
@@ -914,6 +1135,7 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
         dispex->props[0].type = PROP_DELETED;
     }
 
+    dispex->shape = ROOT_SHAPE;
     script_addref(ctx);
     dispex->ctx = ctx;
 
@@ -1053,6 +1275,47 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+HRESULT jsdisp_get_id_cached(jsdisp_t *jsdisp, member_cache_t *cache, DWORD flags, DISPID *id)
+{
+    HRESULT hres;
+
+    if(cache->shape && cache->shape == jsdisp->shape && jsdisp->props[cache->id].type != PROP_DELETED) {
+        *id = cache->id;
+        return S_OK;
+    }
+
+    hres = jsdisp_get_id(jsdisp, cache->name, flags, id);
+    if(SUCCEEDED(hres)) {
+        cache->shape = jsdisp->shape;
+        cache->id = *id;
+    }
+    return hres;
+}
+
+/*
+ * Returns a DISPID that refers to the indexed property directly, so that numeric member
+ * access doesn't need to go through property names. FALSE means that the name lookup
+ * should be used instead.
+ */
+BOOL jsdisp_get_idx_id(jsdisp_t *jsdisp, DWORD idx, DWORD flags, DISPID *id)
+{
+    unsigned length;
+
+    if(!jsdisp->builtin_info->idx_length || idx >= IDX_DISPID_MAX)
+        return FALSE;
+
+    length = jsdisp->builtin_info->idx_length(jsdisp);
+    if(idx > length)
+        return FALSE;
+
+    /* Only arrays grow when an element is appended, other objects store it as a named property. */
+    if(idx == length && (!(flags & fdexNameEnsure) || !is_class(jsdisp, JSCLASS_ARRAY)))
+        return FALSE;
+
+    *id = IDX_DISPID_BASE + idx;
+    return TRUE;
+}
+
 HRESULT jsdisp_call_value(jsdisp_t *jsfunc, IDispatch *jsthis, WORD flags, unsigned argc, jsval_t *argv, jsval_t *r)
 {
     HRESULT hres;
@@ -1321,9 +1584,18 @@ HRESULT jsdisp_propput_dontenum(jsdisp_t *obj, const WCHAR *name, jsval_t val)
 HRESULT jsdisp_propput_idx(jsdisp_t *obj, DWORD idx, jsval_t val)
 {
     WCHAR buf[12];
+    HRESULT hres;
 
     static const WCHAR formatW[] = {'%','d',0};
 
+    if(obj->builtin_info->idx_put) {
+        hres = obj->builtin_info->idx_put(obj, idx, val);
+        if(hres != S_FALSE)
+            return hres;
+    }else if(obj->builtin_info->idx_length && idx < obj->builtin_info->idx_length(obj)) {
+        return S_OK;
+    }
+
     sprintfW(buf, formatW, idx);
     return jsdisp_propput_name(obj, buf, val);
 }
@@ -1337,6 +1609,12 @@ HRESULT disp_propput(script_ctx_t *ctx, IDispatch *disp, DISPID id, jsval_t val)
     if(jsdisp) {
         dispex_prop_t *prop;
 
+        if(is_idx_id(id)) {
+            hres = jsdisp_propput_idx(jsdisp, id-IDX_DISPID_BASE, val);
+            jsdisp_release(jsdisp);
+            return hres;
+        }
+
         prop = get_prop(jsdisp, id);
         if(prop)
             hres = prop_put(jsdisp, prop, val, NULL);
@@ -1400,6 +1678,9 @@ HRESULT jsdisp_get_idx(jsdisp_t *obj, DWORD idx, jsval_t *r)
 
     static const WCHAR formatW[] = {'%','d',0};
 
+    if(obj->builtin_info->idx_length && idx < obj->builtin_info->idx_length(obj))
+        return obj->builtin_info->idx_get(obj, idx, r);
+
     sprintfW(name, formatW, idx);
 
     hres = find_prop_name_prot(obj, string_hash(name), name, &prop);
@@ -1419,6 +1700,13 @@ HRESULT jsdisp_propget(jsdisp_t *jsdisp, DISPID id, jsval_t *val)
     DISPPARAMS dp  = {NULL,NULL,0,0};
     dispex_prop_t *prop;
 
+    if(is_idx_id(id)) {
+        HRESULT hres;
+
+        hres = jsdisp_get_idx(jsdisp, id-IDX_DISPID_BASE, val);
+        return hres == DISP_E_UNKNOWNNAME ? S_OK : hres;
+    }
+
     prop = get_prop(jsdisp, id);
     if(!prop)
         return DISP_E_MEMBERNOTFOUND;
@@ -1470,13 +1758,16 @@ HRESULT jsdisp_delete_idx(jsdisp_t *obj, DWORD idx)
     BOOL b;
     HRESULT hres;
 
+    if(obj->builtin_info->idx_delete && idx < obj->builtin_info->idx_length(obj))
+        return obj->builtin_info->idx_delete(obj, idx);
+
     sprintfW(buf, formatW, idx);
 
     hres = find_prop_name(obj, string_hash(buf), buf, &prop);
     if(FAILED(hres) || !prop)
         return hres;
 
-    return delete_prop(prop, &b);
+    return delete_prop(obj, prop, &b);
 }
 
 HRESULT disp_delete(IDispatch *disp, DISPID id, BOOL *ret)
@@ -1491,7 +1782,7 @@ HRESULT disp_delete(IDispatch *disp, DISPID id, BOOL *ret)
 
         prop = get_prop(jsdisp, id);
         if(prop)
-            hres = delete_prop(prop, ret);
+            hres = delete_prop(jsdisp, prop, ret);
         else
             hres = DISP_E_MEMBERNOTFOUND;
 
@@ -1534,7 +1825,7 @@ HRESULT disp_delete_name(script_ctx_t *ctx, IDispatch *disp, jsstr_t *name, BOOL
 
         hres = find_prop_name(jsdisp, string_hash(ptr), ptr, &prop);
         if(prop) {
-            hres = delete_prop(prop, ret);
+            hres = delete_prop(jsdisp, prop, ret);
         }else {
             *ret = TRUE;
             hres = S_OK;
@@ -1582,7 +1873,7 @@ HRESULT jsdisp_is_own_prop(jsdisp_t *obj, const WCHAR *name, BOOL *ret)
     if(FAILED(hres))
         return hres;
 
-    *ret = prop && (prop->type == PROP_JSVAL || prop->type == PROP_BUILTIN);
+    *ret = prop && (prop->type == PROP_JSVAL || prop->type == PROP_BUILTIN || prop->type == PROP_IDX);
     return S_OK;
 }
 
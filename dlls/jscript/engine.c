@@ -571,6 +571,10 @@ static inline jsstr_t *get_op_str(exec_ctx_t *ctx, int i){
     return ctx->code->instrs[ctx->ip].u.arg[i].str;
 }
 
+static inline member_cache_t *get_op_cache(exec_ctx_t *ctx, int i){
+    return ctx->code->instrs[ctx->ip].u.arg[i].cache;
+}
+
 static inline double get_op_double(exec_ctx_t *ctx){
     return ctx->code->instrs[ctx->ip].u.dbl;
 }
@@ -827,6 +831,23 @@ static HRESULT interp_func(exec_ctx_t *ctx)
     return stack_push(ctx, jsval_obj(dispex));
 }
 
+/* Numeric member names of script objects are looked up without converting them to strings. */
+static BOOL get_idx_id(IDispatch *obj, jsval_t name, DWORD flags, DISPID *id)
+{
+    jsdisp_t *jsdisp;
+    double n;
+
+    if(!is_number(name))
+        return FALSE;
+
+    n = get_number(name);
+    if(n < 0 || n >= 0xffffffff || n != (DWORD)n)
+        return FALSE;
+
+    jsdisp = to_jsdisp(obj);
+    return jsdisp && jsdisp_get_idx_id(jsdisp, (DWORD)n, flags, id);
+}
+
 /* ECMA-262 3rd Edition    11.2.1 */
 static HRESULT interp_array(exec_ctx_t *ctx)
 {
@@ -847,6 +868,15 @@ static HRESULT interp_array(exec_ctx_t *ctx)
         return hres;
     }
 
+    if(get_idx_id(obj, namev, 0, &id)) {
+        hres = disp_propget(ctx->script, obj, id, &v);
+        IDispatch_Release(obj);
+        if(FAILED(hres))
+            return hres;
+
+        return stack_push(ctx, v);
+    }
+
     hres = to_flat_string(ctx->script, namev, &name_str, &name);
     jsval_release(namev);
     if(FAILED(hres)) {
@@ -872,21 +902,29 @@ static HRESULT interp_array(exec_ctx_t *ctx)
 /* ECMA-262 3rd Edition    11.2.1 */
 static HRESULT interp_member(exec_ctx_t *ctx)
 {
-    const BSTR arg = get_op_bstr(ctx, 0);
+    member_cache_t *cache = get_op_cache(ctx, 0);
+    jsdisp_t *jsdisp;
     IDispatch *obj;
     jsval_t v;
     DISPID id;
     HRESULT hres;
 
-    TRACE("\n");
+    TRACE("%s\n", debugstr_w(cache->name));
 
     hres = stack_pop_object(ctx, &obj);
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx->script, obj, arg, arg, 0, &id);
+    jsdisp = to_jsdisp(obj);
+    if(jsdisp)
+        hres = jsdisp_get_id_cached(jsdisp, cache, 0, &id);
+    else
+        hres = disp_get_id(ctx->script, obj, cache->name, cache->name, 0, &id);
     if(SUCCEEDED(hres)) {
-        hres = disp_propget(ctx->script, obj, id, &v);
+        if(jsdisp)
+            hres = jsdisp_propget(jsdisp, id, &v);
+        else
+            hres = disp_propget(ctx->script, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
         v = jsval_undefined();
         hres = S_OK;
@@ -916,6 +954,8 @@ static HRESULT interp_memberid(exec_ctx_t *ctx)
 
     hres = to_object(ctx->script, objv, &obj);
     jsval_release(objv);
+    if(SUCCEEDED(hres) && get_idx_id(obj, namev, arg, &id))
+        return stack_push_objid(ctx, obj, id);
     if(SUCCEEDED(hres)) {
         hres = to_flat_string(ctx->script, namev, &name_str, &name);
         if(FAILED(hres))
@@ -941,6 +981,44 @@ static HRESULT interp_memberid(exec_ctx_t *ctx)
     return stack_push_objid(ctx, obj, id);
 }
 
+/* ECMA-262 3rd Edition    11.2.1 */
+static HRESULT interp_memberid_name(exec_ctx_t *ctx)
+{
+    member_cache_t *cache = get_op_cache(ctx, 0);
+    const unsigned arg = get_op_uint(ctx, 1);
+    jsdisp_t *jsdisp;
+    IDispatch *obj;
+    jsval_t objv;
+    DISPID id;
+    HRESULT hres;
+
+    TRACE("%s %x\n", debugstr_w(cache->name), arg);
+
+    objv = stack_pop(ctx);
+    hres = to_object(ctx->script, objv, &obj);
+    jsval_release(objv);
+    if(FAILED(hres))
+        return hres;
+
+    jsdisp = to_jsdisp(obj);
+    if(jsdisp)
+        hres = jsdisp_get_id_cached(jsdisp, cache, arg, &id);
+    else
+        hres = disp_get_id(ctx->script, obj, cache->name, cache->name, arg, &id);
+    if(FAILED(hres)) {
+        IDispatch_Release(obj);
+        if(hres == DISP_E_UNKNOWNNAME && !(arg & fdexNameEnsure)) {
+            obj = NULL;
+            id = JS_E_INVALID_PROPERTY;
+        }else {
+            ERR("failed %08x\n", hres);
+            return hres;
+        }
+    }
+
+    return stack_push_objid(ctx, obj, id);
+}
+
 /* ECMA-262 3rd Edition    11.2.1 */
 static HRESULT interp_refval(exec_ctx_t *ctx)
 {
@@ -1175,7 +1253,6 @@ static HRESULT interp_carray(exec_ctx_t *ctx)
 {
     const unsigned arg = get_op_uint(ctx, 0);
     jsdisp_t *array;
-    jsval_t val;
     unsigned i;
     HRESULT hres;
 
@@ -1185,17 +1262,16 @@ static HRESULT interp_carray(exec_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    i = arg;
-    while(i--) {
-        val = stack_pop(ctx);
-        hres = jsdisp_propput_idx(array, i, val);
-        jsval_release(val);
+    /* Elements are stored in order, so that the array may use dense storage. */
+    for(i=0; i < arg; i++) {
+        hres = jsdisp_propput_idx(array, i, stack_topn(ctx, arg-i-1));
         if(FAILED(hres)) {
             jsdisp_release(array);
             return hres;
         }
     }
 
+    stack_popn(ctx, arg);
     return stack_push(ctx, jsval_obj(array));
 }
 
@@ -71,8 +71,9 @@ typedef struct {
     X(lshift,     1, 0,0)                  \
     X(lt,         1, 0,0)                  \
     X(lteq,       1, 0,0)                  \
-    X(member,     1, ARG_BSTR,   0)        \
+    X(member,     1, ARG_CACHE,  0)        \
     X(memberid,   1, ARG_UINT,   0)        \
+    X(memberid_name,1,ARG_CACHE,ARG_UINT) \
     X(minus,      1, 0,0)                  \
     X(mod,        1, 0,0)                  \
     X(mul,        1, 0,0)                  \
@@ -124,12 +125,14 @@ typedef union {
     LONG lng;
     jsstr_t *str;
     unsigned uint;
+    member_cache_t *cache;
 } instr_arg_t;
 
 typedef enum {
     ARG_NONE = 0,
     ARG_ADDR,
     ARG_BSTR,
+    ARG_CACHE,
     ARG_DBL,
     ARG_FUNC,
     ARG_INT,
@@ -114,6 +114,9 @@ static HRESULT Arguments_idx_put(jsdisp_t *jsdisp, unsigned idx, jsval_t val)
 
     TRACE("%p[%u] = %s\n", arguments, idx, debugstr_jsval(val));
 
+    if(idx >= arguments->function->length)
+        return S_FALSE;
+
     /* FIXME: Accessing by name won't work for duplicated argument names */
     return jsdisp_propput_name(arguments->var_obj, arguments->function->func_code->params[idx], val);
 }
@@ -72,6 +72,7 @@ void script_release(script_ctx_t *ctx)
     if(ctx->cc)
         release_cc(ctx->cc);
     heap_pool_free(&ctx->tmp_heap);
+    release_shapes(ctx);
     if(ctx->last_match)
         jsstr_release(ctx->last_match);
 
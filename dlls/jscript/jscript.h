@@ -204,8 +204,22 @@ typedef struct {
     unsigned (*idx_length)(jsdisp_t*);
     HRESULT (*idx_get)(jsdisp_t*,unsigned,jsval_t*);
     HRESULT (*idx_put)(jsdisp_t*,unsigned,jsval_t);
+    HRESULT (*idx_delete)(jsdisp_t*,unsigned);
 } builtin_info_t;
 
+/*
+ * Inline cache of a property lookup done by a single bytecode instruction. Objects
+ * that allocated the same property names in the same order share their shape, so
+ * a matching shape means that the cached DISPID refers to the same name.
+ */
+typedef struct {
+    BSTR name;
+    unsigned shape;
+    DISPID id;
+} member_cache_t;
+
+typedef struct _shape_transition_t shape_transition_t;
+
 struct jsdisp_t {
     IDispatchEx IDispatchEx_iface;
 
@@ -214,6 +228,7 @@ struct jsdisp_t {
     DWORD buf_size;
     DWORD prop_cnt;
     dispex_prop_t *props;
+    unsigned shape;
     script_ctx_t *ctx;
 
     jsdisp_t *prototype;
@@ -277,6 +292,9 @@ HRESULT jsdisp_propput_idx(jsdisp_t*,DWORD,jsval_t) DECLSPEC_HIDDEN;
 HRESULT jsdisp_propget_name(jsdisp_t*,LPCWSTR,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_get_idx(jsdisp_t*,DWORD,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_get_id(jsdisp_t*,const WCHAR*,DWORD,DISPID*) DECLSPEC_HIDDEN;
+BOOL jsdisp_get_idx_id(jsdisp_t*,DWORD,DWORD,DISPID*) DECLSPEC_HIDDEN;
+HRESULT jsdisp_get_id_cached(jsdisp_t*,member_cache_t*,DWORD,DISPID*) DECLSPEC_HIDDEN;
+void release_shapes(script_ctx_t*) DECLSPEC_HIDDEN;
 HRESULT disp_delete(IDispatch*,DISPID,BOOL*) DECLSPEC_HIDDEN;
 HRESULT disp_delete_name(script_ctx_t*,IDispatch*,jsstr_t*,BOOL*);
 HRESULT jsdisp_delete_idx(jsdisp_t*,DWORD) DECLSPEC_HIDDEN;
@@ -386,6 +404,10 @@ struct _script_ctx_t {
 
     heap_pool_t tmp_heap;
 
+    shape_transition_t **shapes;
+    unsigned shapes_size;
+    unsigned shape_cnt;
+
     IDispatch *host_global;
 
     jsstr_t *last_match;
@@ -878,6 +878,69 @@ tmp = arr.pop();
 ok(arr.length === 5, "arr.length = " + arr.length);
 ok(tmp === undefined, "tmp = " + tmp);
 
+arr = [];
+for(i = 0; i < 70000; i++)
+    arr[i] = i;
+ok(arr.length === 70000, "arr.length = " + arr.length);
+ok(arr[69999] === 69999, "arr[69999] = " + arr[69999]);
+ok(arr["69999"] === 69999, "arr['69999'] = " + arr["69999"]);
+ok(arr["01"] === undefined, "arr['01'] = " + arr["01"]);
+ok(arr.hasOwnProperty(5), "arr.hasOwnProperty(5) is false");
+arr.length = 3;
+ok(arr[69999] === undefined, "arr[69999] = " + arr[69999]);
+ok(!(3 in arr), "3 in arr");
+arr[3] = "x";
+ok(arr.length === 4, "arr.length = " + arr.length);
+ok(arr.join() === "0,1,2,x", "arr.join() = " + arr.join());
+
+arr = [1,2,3,4,5];
+delete arr[1];
+ok(arr.length === 5, "arr.length = " + arr.length);
+ok(!(1 in arr), "1 in arr");
+ok(arr[1] === undefined, "arr[1] = " + arr[1]);
+ok(arr[4] === 5, "arr[4] = " + arr[4]);
+ok(arr.join() === "1,,3,4,5", "arr.join() = " + arr.join());
+arr[1] = 2;
+ok(arr.join() === "1,2,3,4,5", "arr.join() = " + arr.join());
+tmp = "";
+for(i in arr)
+    tmp += i;
+ok(tmp === "01234", "for in arr = " + tmp);
+arr.length = 0;
+arr[0] = "a";
+arr[1] = "b";
+ok(arr.join() === "a,b", "arr.join() = " + arr.join());
+
+arr = [];
+arr[2] = 2;
+arr[0] = 0;
+ok(arr.length === 3, "arr.length = " + arr.length);
+ok(!(1 in arr), "1 in arr");
+arr[1] = 1;
+ok(arr.join() === "0,1,2", "arr.join() = " + arr.join());
+
+arr = [1,2,3];
+arr.foo = "bar";
+tmp = "";
+for(i in arr)
+    tmp += i + ";";
+ok(tmp === "0;1;2;foo;", "for in arr = " + tmp);
+
+arr = [2,3];
+tmp = arr.unshift(0,1);
+ok(arr.join() === "0,1,2,3", "arr.join() = " + arr.join());
+tmp = arr.shift();
+ok(tmp === 0, "arr.shift() = " + tmp);
+ok(arr.join() === "1,2,3", "arr.join() = " + arr.join());
+tmp = arr.splice(1, 0, "a", "b");
+ok(arr.join() === "1,a,b,2,3", "arr.join() = " + arr.join());
+tmp = arr.splice(1, 3);
+ok(tmp.join() === "a,b,2", "arr.splice() = " + tmp.join());
+ok(arr.join() === "1,3", "arr.join() = " + arr.join());
+
+arr = [function() { return this === arr; }];
+ok(arr[0](), "arr[0]() returned false");
+
 function PseudoArray() {
     this[0] = 0;
 }
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2016 Wine Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Array access patterns in the spirit of SunSpider's access-* tests. */
+
+function nsieve(m, isPrime) {
+    var i, k, count;
+
+    for(i = 0; i <= m; i++)
+        isPrime[i] = true;
+    count = 0;
+
+    for(i = 2; i <= m; i++) {
+        if(isPrime[i]) {
+            for(k = i+i; k <= m; k += i)
+                isPrime[k] = false;
+            count++;
+        }
+    }
+    return count;
+}
+
+function fannkuch(n) {
+    var perm = [], perm1 = [], count = [];
+    var maxFlips = 0, r = n, i, k;
+
+    for(i = 0; i < n; i++)
+        perm1.push(i);
+
+    while(true) {
+        for(; r != 1; r--)
+            count[r-1] = r;
+
+        for(i = 0; i < n; i++)
+            perm[i] = perm1[i];
+
+        var flips = 0;
+        while((k = perm[0]) != 0) {
+            var k2 = (k+1) >> 1;
+            for(i = 0; i < k2; i++) {
+                var tmp = perm[i];
+                perm[i] = perm[k-i];
+                perm[k-i] = tmp;
+            }
+            flips++;
+        }
+        if(flips > maxFlips)
+            maxFlips = flips;
+
+        while(true) {
+            if(r == n)
+                return maxFlips;
+
+            var perm0 = perm1[0];
+            for(i = 0; i < r; i++)
+                perm1[i] = perm1[i+1];
+            perm1[r] = perm0;
+
+            count[r]--;
+            if(count[r] > 0)
+                break;
+            r++;
+        }
+    }
+}
+
+function queue(n) {
+    var q = [], sum = 0, i;
+
+    for(i = 0; i < n; i++) {
+        q.push(i);
+        if(q.length > 16)
+            sum += q.shift();
+    }
+    while(q.length)
+        sum += q.pop();
+    return sum;
+}
+
+function sortJoin(n) {
+    var arr = [], i;
+
+    for(i = 0; i < n; i++)
+        arr[i] = (i * 7919) % n;
+    arr.sort(function(a, b) { return a - b; });
+    return arr.join(",").length;
+}
+
+for(var i = 1; i <= 3; i++)
+    nsieve((1 << i) * 10000, []);
+fannkuch(8);
+queue(50000);
+sortJoin(10000);
@@ -91,6 +91,11 @@ function testFunc1(x, y) {
     ok(y === "x", "y = " + y);
     ok(arguments[1] === "x", "arguments[1] = " + arguments[1]);
 
+    arguments[arguments.length] = "z";
+    ok(arguments[2] === "z", "arguments[2] = " + arguments[2]);
+    ok(arguments.length === 2, "arguments.length = " + arguments.length);
+    ok(y === "x", "y = " + y);
+
     ok(arguments["0x0"] === undefined, "arguments['0x0'] = " + arguments["0x0"]);
     ok(arguments["x"] === undefined, "arguments['x'] = " + arguments["x"]);
 
@@ -1463,4 +1468,19 @@ ok(Infinity === 6, "Infinity !== 6");
 Math = 6;
 ok(Math === 6, "NaN !== 6");
 
+function getMemberX(o) { return o.x; }
+function setMemberX(o, v) { o.x = v; }
+
+tmp = [{x: 1}, {y: 2, x: 3}, {x: 4, y: 5}, {z: 6}, {x: 7}];
+for(i = 0; i < tmp.length; i++)
+    ok(getMemberX(tmp[i]) === [1,3,4,undefined,7][i], "getMemberX(tmp[" + i + "]) = " + getMemberX(tmp[i]));
+
+tmp = {x: 1, y: 2};
+ok(getMemberX(tmp) === 1, "getMemberX(tmp) = " + getMemberX(tmp));
+delete tmp.x;
+ok(getMemberX(tmp) === undefined, "getMemberX(tmp) after delete = " + getMemberX(tmp));
+setMemberX(tmp, 8);
+ok(getMemberX(tmp) === 8, "getMemberX(tmp) after re-adding = " + getMemberX(tmp));
+ok(tmp.y === 2, "tmp.y = " + tmp.y);
+
 reportSuccess();
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2016 Wine Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+
+/* Property access on objects sharing the same layout. */
+
+function Point(x, y) {
+    this.x = x;
+    this.y = y;
+}
+
+function pointSum(n) {
+    var pts = [], sum = 0, i, j;
+
+    for(i = 0; i < 100; i++)
+        pts.push(new Point(i, 2*i));
+
+    for(j = 0; j < n; j++) {
+        for(i = 0; i < pts.length; i++) {
+            sum += pts[i].x + pts[i].y;
+            pts[i].x++;
+        }
+    }
+    return sum;
+}
+
+function literalAccess(n) {
+    var sum = 0, i, o;
+
+    for(i = 0; i < n; i++) {
+        o = {a: i, b: i+1, c: i+2};
+        sum += o.a + o.b + o.c;
+        o.d = o.a * o.c;
+        sum += o.d;
+    }
+    return sum;
+}
+
+function polymorphicAccess(n) {
+    var objs = [{v: 1}, {w: 0, v: 2}, {u: 0, w: 0, v: 3}], sum = 0, i;
+
+    for(i = 0; i < n; i++)
+        sum += objs[i % objs.length].v;
+    return sum;
+}
+
+pointSum(500);
+literalAccess(50000);
+polymorphicAccess(100000);
@@ -330,22 +330,79 @@ static void grow_buffer(encoded_buffer *buffer, int length)
     }
 }
 
-static HRESULT write_output_buffer_mode(output_buffer *buffer, output_mode mode, const WCHAR *data, int len)
+/* Attempts to the write data from the mxwriter's buffer to
+ * the destination stream (if there is one).
+ */
+static HRESULT write_data_to_stream(mxwriter *This)
+{
+    encoded_buffer *buffer;
+    ULONG written = 0;
+    HRESULT hr;
+
+    if (!This->dest)
+        return S_OK;
+
+    if (This->xml_enc != XmlEncoding_UTF16)
+        buffer = &This->buffer->encoded;
+    else
+        buffer = &This->buffer->utf16;
+
+    if (This->dest_written > buffer->written) {
+        ERR("Failed sanity check! Not sure what to do... (%d > %d)\n", This->dest_written, buffer->written);
+        return E_FAIL;
+    } else if (This->dest_written == buffer->written && This->xml_enc != XmlEncoding_UTF8)
+        /* Windows seems to make an empty write call when the encoding is UTF-8 and
+         * all the data has been written to the stream. It doesn't seem make this call
+         * for any other encodings.
+         */
+        return S_OK;
+
+    /* Write the current content from the output buffer into 'dest'.
+     * TODO: Check what Windows does if the IStream doesn't write all of
+     *       the data we give it at once.
+     */
+    hr = IStream_Write(This->dest, buffer->data+This->dest_written,
+                         buffer->written-This->dest_written, &written);
+    if (FAILED(hr)) {
+        WARN("Failed to write data to IStream (0x%08x)\n", hr);
+        return hr;
+    }
+
+    This->dest_written += written;
+
+    /* everything was written, reuse buffer space */
+    if (This->dest_written == buffer->written)
+        buffer->written = This->dest_written = 0;
+
+    return hr;
+}
+
+/* pending output is written to destination stream when it reaches this size */
+#define MXWRITER_FLUSH_THRESHOLD 0x1000
+
+static HRESULT write_output_buffer_mode(mxwriter *writer, output_mode mode, const WCHAR *data, int len)
 {
+    output_buffer *buffer = writer->buffer;
+    encoded_buffer *dest_buffer;
     int length;
     char *ptr;
 
     if (mode & (OutputBuffer_Encoded | OutputBuffer_Both)) {
         if (buffer->code_page != ~0)
         {
-            length = WideCharToMultiByte(buffer->code_page, 0, data, len, NULL, 0, NULL, NULL);
-            grow_buffer(&buffer->encoded, length);
+            /* one WCHAR never takes more than 3 bytes in supported code pages */
+            length = len == -1 ? strlenW(data) : len;
+            grow_buffer(&buffer->encoded, length*3);
             ptr = buffer->encoded.data + buffer->encoded.written;
-            length = WideCharToMultiByte(buffer->code_page, 0, data, len, ptr, length, NULL, NULL);
-            buffer->encoded.written += len == -1 ? length-1 : length;
+            length = length ? WideCharToMultiByte(buffer->code_page, 0, data, length, ptr, length*3, NULL, NULL) : 0;
+            buffer->encoded.written += length;
         }
     }
 
+    /* WCHAR copy is not used when writing encoded data to a stream */
+    if (writer->dest && buffer->code_page != ~0)
+        mode &= ~(OutputBuffer_Native | OutputBuffer_Both);
+
     if (mode & (OutputBuffer_Native | OutputBuffer_Both)) {
         /* WCHAR data just copied */
         length = len == -1 ? strlenW(data) : len;
@@ -364,19 +421,25 @@ static HRESULT write_output_buffer_mode(output_buffer *buffer, output_mode mode,
         }
     }
 
+    if (!writer->dest) return S_OK;
+
+    dest_buffer = buffer->code_page != ~0 ? &buffer->encoded : &buffer->utf16;
+    if (dest_buffer->written - writer->dest_written >= MXWRITER_FLUSH_THRESHOLD)
+        return write_data_to_stream(writer);
+
     return S_OK;
 }
 
-static HRESULT write_output_buffer(output_buffer *buffer, const WCHAR *data, int len)
+static HRESULT write_output_buffer(mxwriter *writer, const WCHAR *data, int len)
 {
-    return write_output_buffer_mode(buffer, OutputBuffer_Both, data, len);
+    return write_output_buffer_mode(writer, OutputBuffer_Both, data, len);
 }
 
-static HRESULT write_output_buffer_quoted(output_buffer *buffer, const WCHAR *data, int len)
+static HRESULT write_output_buffer_quoted(mxwriter *writer, const WCHAR *data, int len)
 {
-    write_output_buffer(buffer, quotW, 1);
-    write_output_buffer(buffer, data, len);
-    write_output_buffer(buffer, quotW, 1);
+    write_output_buffer(writer, quotW, 1);
+    write_output_buffer(writer, data, len);
+    write_output_buffer(writer, quotW, 1);
 
     return S_OK;
 }
@@ -396,68 +459,63 @@ static void close_output_buffer(mxwriter *This)
    '&' -> "&amp;"
    '"' -> "&quot;"
    '>' -> "&gt;"
+
+   Unescaped runs are written directly, so no intermediate copy is made.
 */
-static WCHAR *get_escaped_string(const WCHAR *str, escape_mode mode, int *len)
+static HRESULT write_output_buffer_escaped(mxwriter *writer, const WCHAR *str, int len, escape_mode mode)
 {
     static const WCHAR ltW[]    = {'&','l','t',';'};
     static const WCHAR ampW[]   = {'&','a','m','p',';'};
     static const WCHAR equotW[] = {'&','q','u','o','t',';'};
     static const WCHAR gtW[]    = {'&','g','t',';'};
+    const WCHAR *run = str;
 
-    const int default_alloc = 100;
-    const int grow_thresh = 10;
-    int p = *len, conv_len;
-    WCHAR *ptr, *ret;
-
-    /* default buffer size to something if length is unknown */
-    conv_len = *len == -1 ? default_alloc : max(2**len, default_alloc);
-    ptr = ret = heap_alloc(conv_len*sizeof(WCHAR));
-
-    while (*str && p)
+    while (*str && len)
     {
-        if (ptr - ret > conv_len - grow_thresh)
-        {
-            int written = ptr - ret;
-            conv_len *= 2;
-            ptr = ret = heap_realloc(ret, conv_len*sizeof(WCHAR));
-            ptr += written;
-        }
+        const WCHAR *entity;
+        int entity_len;
 
         switch (*str)
         {
         case '<':
-            memcpy(ptr, ltW, sizeof(ltW));
-            ptr += sizeof(ltW)/sizeof(WCHAR);
+            entity = ltW;
+            entity_len = sizeof(ltW)/sizeof(WCHAR);
             break;
         case '&':
-            memcpy(ptr, ampW, sizeof(ampW));
-            ptr += sizeof(ampW)/sizeof(WCHAR);
+            entity = ampW;
+            entity_len = sizeof(ampW)/sizeof(WCHAR);
             break;
         case '>':
-            memcpy(ptr, gtW, sizeof(gtW));
-            ptr += sizeof(gtW)/sizeof(WCHAR);
+            entity = gtW;
+            entity_len = sizeof(gtW)/sizeof(WCHAR);
             break;
         case '"':
             if (mode == EscapeValue)
             {
-                memcpy(ptr, equotW, sizeof(equotW));
-                ptr += sizeof(equotW)/sizeof(WCHAR);
+                entity = equotW;
+                entity_len = sizeof(equotW)/sizeof(WCHAR);
                 break;
             }
             /* fallthrough for text mode */
         default:
-            *ptr++ = *str;
+            entity = NULL;
+            entity_len = 0;
             break;
         }
 
+        if (entity)
+        {
+            if (str > run) write_output_buffer(writer, run, str - run);
+            write_output_buffer(writer, entity, entity_len);
+            run = str + 1;
+        }
+
         str++;
-        if (*len != -1) p--;
+        if (len != -1) len--;
     }
 
-    if (*len != -1) *len = ptr-ret;
-    *++ptr = 0;
-
-    return ret;
+    if (str > run) write_output_buffer(writer, run, str - run);
+    return S_OK;
 }
 
 static void write_prolog_buffer(mxwriter *This)
@@ -469,77 +527,35 @@ static void write_prolog_buffer(mxwriter *This)
     static const WCHAR noW[] = {'n','o','\"','?','>'};
 
     /* version */
-    write_output_buffer(This->buffer, versionW, sizeof(versionW)/sizeof(WCHAR));
-    write_output_buffer_quoted(This->buffer, This->version, -1);
+    write_output_buffer(This, versionW, sizeof(versionW)/sizeof(WCHAR));
+    write_output_buffer_quoted(This, This->version, -1);
 
     /* encoding */
-    write_output_buffer(This->buffer, encodingW, sizeof(encodingW)/sizeof(WCHAR));
+    write_output_buffer(This, encodingW, sizeof(encodingW)/sizeof(WCHAR));
 
     /* always write UTF-16 to WCHAR buffer */
-    write_output_buffer_mode(This->buffer, OutputBuffer_Native, utf16W, sizeof(utf16W)/sizeof(WCHAR) - 1);
-    write_output_buffer_mode(This->buffer, OutputBuffer_Encoded, This->encoding, -1);
-    write_output_buffer(This->buffer, quotW, 1);
+    write_output_buffer_mode(This, OutputBuffer_Native, utf16W, sizeof(utf16W)/sizeof(WCHAR) - 1);
+    write_output_buffer_mode(This, OutputBuffer_Encoded, This->encoding, -1);
+    write_output_buffer(This, quotW, 1);
 
     /* standalone */
-    write_output_buffer(This->buffer, standaloneW, sizeof(standaloneW)/sizeof(WCHAR));
+    write_output_buffer(This, standaloneW, sizeof(standaloneW)/sizeof(WCHAR));
     if (This->props[MXWriter_Standalone] == VARIANT_TRUE)
-        write_output_buffer(This->buffer, yesW, sizeof(yesW)/sizeof(WCHAR));
+        write_output_buffer(This, yesW, sizeof(yesW)/sizeof(WCHAR));
     else
-        write_output_buffer(This->buffer, noW, sizeof(noW)/sizeof(WCHAR));
+        write_output_buffer(This, noW, sizeof(noW)/sizeof(WCHAR));
 
-    write_output_buffer(This->buffer, crlfW, sizeof(crlfW)/sizeof(WCHAR));
+    write_output_buffer(This, crlfW, sizeof(crlfW)/sizeof(WCHAR));
     This->newline = TRUE;
 }
 
-/* Attempts to the write data from the mxwriter's buffer to
- * the destination stream (if there is one).
- */
-static HRESULT write_data_to_stream(mxwriter *This)
-{
-    encoded_buffer *buffer;
-    ULONG written = 0;
-    HRESULT hr;
-
-    if (!This->dest)
-        return S_OK;
-
-    if (This->xml_enc != XmlEncoding_UTF16)
-        buffer = &This->buffer->encoded;
-    else
-        buffer = &This->buffer->utf16;
-
-    if (This->dest_written > buffer->written) {
-        ERR("Failed sanity check! Not sure what to do... (%d > %d)\n", This->dest_written, buffer->written);
-        return E_FAIL;
-    } else if (This->dest_written == buffer->written && This->xml_enc != XmlEncoding_UTF8)
-        /* Windows seems to make an empty write call when the encoding is UTF-8 and
-         * all the data has been written to the stream. It doesn't seem make this call
-         * for any other encodings.
-         */
-        return S_OK;
-
-    /* Write the current content from the output buffer into 'dest'.
-     * TODO: Check what Windows does if the IStream doesn't write all of
-     *       the data we give it at once.
-     */
-    hr = IStream_Write(This->dest, buffer->data+This->dest_written,
-                         buffer->written-This->dest_written, &written);
-    if (FAILED(hr)) {
-        WARN("Failed to write data to IStream (0x%08x)\n", hr);
-        return hr;
-    }
-
-    This->dest_written += written;
-    return hr;
-}
-
 /* Newly added element start tag left unclosed cause for empty elements
    we have to close it differently. */
-static void close_element_starttag(const mxwriter *This)
+static void close_element_starttag(mxwriter *This)
 {
     static const WCHAR gtW[] = {'>'};
     if (!This->element) return;
-    write_output_buffer(This->buffer, gtW, 1);
+    write_output_buffer(This, gtW, 1);
 }
 
 static void write_node_indent(mxwriter *This)
@@ -556,9 +572,9 @@ static void write_node_indent(mxwriter *This)
     /* This is to workaround PI output logic that always puts newline chars,
        document prolog PI does that too. */
     if (!This->newline)
-        write_output_buffer(This->buffer, crlfW, sizeof(crlfW)/sizeof(WCHAR));
+        write_output_buffer(This, crlfW, sizeof(crlfW)/sizeof(WCHAR));
     while (indent--)
-        write_output_buffer(This->buffer, tabW, 1);
+        write_output_buffer(This, tabW, 1);
 
     This->newline = FALSE;
     This->text = FALSE;
@@ -1125,8 +1141,8 @@ static HRESULT WINAPI SAXContentHandler_startElement(
 
     write_node_indent(This);
 
-    write_output_buffer(This->buffer, ltW, 1);
-    write_output_buffer(This->buffer, QName, nQName);
+    write_output_buffer(This, ltW, 1);
+    write_output_buffer(This, QName, nQName);
     writer_inc_indent(This);
 
     if (attr)
@@ -1150,10 +1166,10 @@ static HRESULT WINAPI SAXContentHandler_startElement(
             if (FAILED(hr)) return hr;
 
             /* space separator in front of every attribute */
-            write_output_buffer(This->buffer, spaceW, 1);
-            write_output_buffer(This->buffer, str, len);
+            write_output_buffer(This, spaceW, 1);
+            write_output_buffer(This, str, len);
 
-            write_output_buffer(This->buffer, eqW, 1);
+            write_output_buffer(This, eqW, 1);
 
             len = 0;
             hr = ISAXAttributes_getValue(attr, i, &str, &len);
@@ -1161,12 +1177,12 @@ static HRESULT WINAPI SAXContentHandler_startElement(
 
             if (escape)
             {
-                WCHAR *escaped = get_escaped_string(str, EscapeValue, &len);
-                write_output_buffer_quoted(This->buffer, escaped, len);
-                heap_free(escaped);
+                write_output_buffer(This, quotW, 1);
+                write_output_buffer_escaped(This, str, len, EscapeValue);
+                write_output_buffer(This, quotW, 1);
             }
             else
-                write_output_buffer_quoted(This->buffer, str, len);
+                write_output_buffer_quoted(This, str, len);
         }
     }
 
@@ -1196,7 +1212,7 @@ static HRESULT WINAPI SAXContentHandler_endElement(
     if (This->element)
     {
         static const WCHAR closeW[] = {'/','>'};
-        write_output_buffer(This->buffer, closeW, 2);
+        write_output_buffer(This, closeW, 2);
     }
     else
     {
@@ -1204,9 +1220,9 @@ static HRESULT WINAPI SAXContentHandler_endElement(
         static const WCHAR gtW[] = {'>'};
 
         write_node_indent(This);
-        write_output_buffer(This->buffer, closetagW, 2);
-        write_output_buffer(This->buffer, QName, nQName);
-        write_output_buffer(This->buffer, gtW, 1);
+        write_output_buffer(This, closetagW, 2);
+        write_output_buffer(This, QName, nQName);
+        write_output_buffer(This, gtW, 1);
     }
 
     set_element_name(This, NULL, 0);
@@ -1234,16 +1250,9 @@ static HRESULT WINAPI SAXContentHandler_characters(
     if (nchars)
     {
         if (This->cdata || This->props[MXWriter_DisableEscaping] == VARIANT_TRUE)
-            write_output_buffer(This->buffer, chars, nchars);
+            write_output_buffer(This, chars, nchars);
         else
-        {
-            int len = nchars;
-            WCHAR *escaped;
-
-            escaped = get_escaped_string(chars, EscapeText, &len);
-            write_output_buffer(This->buffer, escaped, len);
-            heap_free(escaped);
-        }
+            write_output_buffer_escaped(This, chars, nchars, EscapeText);
     }
 
     return S_OK;
@@ -1260,7 +1269,7 @@ static HRESULT WINAPI SAXContentHandler_ignorableWhitespace(
 
     if (!chars) return E_INVALIDARG;
 
-    write_output_buffer(This->buffer, chars, nchars);
+    write_output_buffer(This, chars, nchars);
 
     return S_OK;
 }
@@ -1281,18 +1290,18 @@ static HRESULT WINAPI SAXContentHandler_processingInstruction(
     if (!target) return E_INVALIDARG;
 
     write_node_indent(This);
-    write_output_buffer(This->buffer, openpiW, sizeof(openpiW)/sizeof(WCHAR));
+    write_output_buffer(This, openpiW, sizeof(openpiW)/sizeof(WCHAR));
 
     if (*target)
-        write_output_buffer(This->buffer, target, ntarget);
+        write_output_buffer(This, target, ntarget);
 
     if (data && *data && ndata)
     {
-        write_output_buffer(This->buffer, spaceW, 1);
-        write_output_buffer(This->buffer, data, ndata);
+        write_output_buffer(This, spaceW, 1);
+        write_output_buffer(This, data, ndata);
     }
 
-    write_output_buffer(This->buffer, closepiW, sizeof(closepiW)/sizeof(WCHAR));
+    write_output_buffer(This, closepiW, sizeof(closepiW)/sizeof(WCHAR));
     This->newline = TRUE;
 
     return S_OK;
@@ -1360,42 +1369,42 @@ static HRESULT WINAPI SAXLexicalHandler_startDTD(ISAXLexicalHandler *iface,
 
     if (!name) return E_INVALIDARG;
 
-    write_output_buffer(This->buffer, doctypeW, sizeof(doctypeW)/sizeof(WCHAR));
+    write_output_buffer(This, doctypeW, sizeof(doctypeW)/sizeof(WCHAR));
 
     if (*name)
     {
-        write_output_buffer(This->buffer, name, name_len);
-        write_output_buffer(This->buffer, spaceW, 1);
+        write_output_buffer(This, name, name_len);
+        write_output_buffer(This, spaceW, 1);
     }
 
     if (publicId)
     {
         static const WCHAR publicW[] = {'P','U','B','L','I','C',' '};
 
-        write_output_buffer(This->buffer, publicW, sizeof(publicW)/sizeof(WCHAR));
-        write_output_buffer_quoted(This->buffer, publicId, publicId_len);
+        write_output_buffer(This, publicW, sizeof(publicW)/sizeof(WCHAR));
+        write_output_buffer_quoted(This, publicId, publicId_len);
 
         if (!systemId) return E_INVALIDARG;
 
         if (*publicId)
-            write_output_buffer(This->buffer, spaceW, 1);
+            write_output_buffer(This, spaceW, 1);
 
-        write_output_buffer_quoted(This->buffer, systemId, systemId_len);
+        write_output_buffer_quoted(This, systemId, systemId_len);
 
         if (*systemId)
-            write_output_buffer(This->buffer, spaceW, 1);
+            write_output_buffer(This, spaceW, 1);
     }
     else if (systemId)
     {
         static const WCHAR systemW[] = {'S','Y','S','T','E','M',' '};
 
-        write_output_buffer(This->buffer, systemW, sizeof(systemW)/sizeof(WCHAR));
-        write_output_buffer_quoted(This->buffer, systemId, systemId_len);
+        write_output_buffer(This, systemW, sizeof(systemW)/sizeof(WCHAR));
+        write_output_buffer_quoted(This, systemId, systemId_len);
         if (*systemId)
-            write_output_buffer(This->buffer, spaceW, 1);
+            write_output_buffer(This, spaceW, 1);
     }
 
-    write_output_buffer(This->buffer, openintW, sizeof(openintW)/sizeof(WCHAR));
+    write_output_buffer(This, openintW, sizeof(openintW)/sizeof(WCHAR));
 
     return S_OK;
 }
@@ -1407,7 +1416,7 @@ static HRESULT WINAPI SAXLexicalHandler_endDTD(ISAXLexicalHandler *iface)
 
     TRACE("(%p)\n", This);
 
-    write_output_buffer(This->buffer, closedtdW, sizeof(closedtdW)/sizeof(WCHAR));
+    write_output_buffer(This, closedtdW, sizeof(closedtdW)/sizeof(WCHAR));
 
     return S_OK;
 }
@@ -1434,7 +1443,7 @@ static HRESULT WINAPI SAXLexicalHandler_startCDATA(ISAXLexicalHandler *iface)
     TRACE("(%p)\n", This);
 
     write_node_indent(This);
-    write_output_buffer(This->buffer, scdataW, sizeof(scdataW)/sizeof(WCHAR));
+    write_output_buffer(This, scdataW, sizeof(scdataW)/sizeof(WCHAR));
     This->cdata = TRUE;
 
     return S_OK;
@@ -1447,7 +1456,7 @@ static HRESULT WINAPI SAXLexicalHandler_endCDATA(ISAXLexicalHandler *iface)
 
     TRACE("(%p)\n", This);
 
-    write_output_buffer(This->buffer, ecdataW, sizeof(ecdataW)/sizeof(WCHAR));
+    write_output_buffer(This, ecdataW, sizeof(ecdataW)/sizeof(WCHAR));
     This->cdata = FALSE;
 
     return S_OK;
@@ -1466,10 +1475,10 @@ static HRESULT WINAPI SAXLexicalHandler_comment(ISAXLexicalHandler *iface, const
     close_element_starttag(This);
     write_node_indent(This);
 
-    write_output_buffer(This->buffer, copenW, sizeof(copenW)/sizeof(WCHAR));
+    write_output_buffer(This, copenW, sizeof(copenW)/sizeof(WCHAR));
     if (nchars)
-        write_output_buffer(This->buffer, chars, nchars);
-    write_output_buffer(This->buffer, ccloseW, sizeof(ccloseW)/sizeof(WCHAR));
+        write_output_buffer(This, chars, nchars);
+    write_output_buffer(This, ccloseW, sizeof(ccloseW)/sizeof(WCHAR));
 
     return S_OK;
 }
@@ -1519,14 +1528,14 @@ static HRESULT WINAPI SAXDeclHandler_elementDecl(ISAXDeclHandler *iface,
 
     if (!name || !model) return E_INVALIDARG;
 
-    write_output_buffer(This->buffer, elementW, sizeof(elementW)/sizeof(WCHAR));
+    write_output_buffer(This, elementW, sizeof(elementW)/sizeof(WCHAR));
     if (n_name) {
-        write_output_buffer(This->buffer, name, n_name);
-        write_output_buffer(This->buffer, spaceW, sizeof(spaceW)/sizeof(WCHAR));
+        write_output_buffer(This, name, n_name);
+        write_output_buffer(This, spaceW, sizeof(spaceW)/sizeof(WCHAR));
     }
     if (n_model)
-        write_output_buffer(This->buffer, model, n_model);
-    write_output_buffer(This->buffer, closetagW, sizeof(closetagW)/sizeof(WCHAR));
+        write_output_buffer(This, model, n_model);
+    write_output_buffer(This, closetagW, sizeof(closetagW)/sizeof(WCHAR));
 
     return S_OK;
 }
@@ -1544,31 +1553,31 @@ static HRESULT WINAPI SAXDeclHandler_attributeDecl(ISAXDeclHandler *iface,
         debugstr_wn(attr, n_attr), n_attr, debugstr_wn(type, n_type), n_type, debugstr_wn(Default, n_default), n_default,
         debugstr_wn(value, n_value), n_value);
 
-    write_output_buffer(This->buffer, attlistW, sizeof(attlistW)/sizeof(WCHAR));
+    write_output_buffer(This, attlistW, sizeof(attlistW)/sizeof(WCHAR));
     if (n_element) {
-        write_output_buffer(This->buffer, element, n_element);
-        write_output_buffer(This->buffer, spaceW, sizeof(spaceW)/sizeof(WCHAR));
+        write_output_buffer(This, element, n_element);
+        write_output_buffer(This, spaceW, sizeof(spaceW)/sizeof(WCHAR));
     }
 
     if (n_attr) {
-        write_output_buffer(This->buffer, attr, n_attr);
-        write_output_buffer(This->buffer, spaceW, sizeof(spaceW)/sizeof(WCHAR));
+        write_output_buffer(This, attr, n_attr);
+        write_output_buffer(This, spaceW, sizeof(spaceW)/sizeof(WCHAR));
     }
 
     if (n_type) {
-        write_output_buffer(This->buffer, type, n_type);
-        write_output_buffer(This->buffer, spaceW, sizeof(spaceW)/sizeof(WCHAR));
+        write_output_buffer(This, type, n_type);
+        write_output_buffer(This, spaceW, sizeof(spaceW)/sizeof(WCHAR));
     }
 
     if (n_default) {
-        write_output_buffer(This->buffer, Default, n_default);
-        write_output_buffer(This->buffer, spaceW, sizeof(spaceW)/sizeof(WCHAR));
+        write_output_buffer(This, Default, n_default);
+        write_output_buffer(This, spaceW, sizeof(spaceW)/sizeof(WCHAR));
     }
 
     if (n_value)
-        write_output_buffer_quoted(This->buffer, value, n_value);
+        write_output_buffer_quoted(This, value, n_value);
 
-    write_output_buffer(This->buffer, closetagW, sizeof(closetagW)/sizeof(WCHAR));
+    write_output_buffer(This, closetagW, sizeof(closetagW)/sizeof(WCHAR));
 
     return S_OK;
 }
@@ -1583,16 +1592,16 @@ static HRESULT WINAPI SAXDeclHandler_internalEntityDecl(ISAXDeclHandler *iface,
 
     if (!name || !value) return E_INVALIDARG;
 
-    write_output_buffer(This->buffer, entityW, sizeof(entityW)/sizeof(WCHAR));
+    write_output_buffer(This, entityW, sizeof(entityW)/sizeof(WCHAR));
     if (n_name) {
-        write_output_buffer(This->buffer, name, n_name);
-        write_output_buffer(This->buffer, spaceW, sizeof(spaceW)/sizeof(WCHAR));
+        write_output_buffer(This, name, n_name);
+        write_output_buffer(This, spaceW, sizeof(spaceW)/sizeof(WCHAR));
     }
 
     if (n_value)
-        write_output_buffer_quoted(This->buffer, value, n_value);
+        write_output_buffer_quoted(This, value, n_value);
 
-    write_output_buffer(This->buffer, closetagW, sizeof(closetagW)/sizeof(WCHAR));
+    write_output_buffer(This, closetagW, sizeof(closetagW)/sizeof(WCHAR));
 
     return S_OK;
 }
@@ -1612,26 +1621,26 @@ static HRESULT WINAPI SAXDeclHandler_externalEntityDecl(ISAXDeclHandler *iface,
     if (publicId && !systemId) return E_INVALIDARG;
     if (!publicId && !systemId) return E_INVALIDARG;
 
-    write_output_buffer(This->buffer, entityW, sizeof(entityW)/sizeof(WCHAR));
+    write_output_buffer(This, entityW, sizeof(entityW)/sizeof(WCHAR));
     if (n_name) {
-        write_output_buffer(This->buffer, name, n_name);
-        write_output_buffer(This->buffer, spaceW, sizeof(spaceW)/sizeof(WCHAR));
+        write_output_buffer(This, name, n_name);
+        write_output_buffer(This, spaceW, sizeof(spaceW)/sizeof(WCHAR));
     }
 
     if (publicId)
     {
-        write_output_buffer(This->buffer, publicW, sizeof(publicW)/sizeof(WCHAR));
-        write_output_buffer_quoted(This->buffer, publicId, n_publicId);
-        write_output_buffer(This->buffer, spaceW, sizeof(spaceW)/sizeof(WCHAR));
-        write_output_buffer_quoted(This->buffer, systemId, n_systemId);
+        write_output_buffer(This, publicW, sizeof(publicW)/sizeof(WCHAR));
+        write_output_buffer_quoted(This, publicId, n_publicId);
+        write_output_buffer(This, spaceW, sizeof(spaceW)/sizeof(WCHAR));
+        write_output_buffer_quoted(This, systemId, n_systemId);
     }
     else
     {
-        write_output_buffer(This->buffer, systemW, sizeof(systemW)/sizeof(WCHAR));
-        write_output_buffer_quoted(This->buffer, systemId, n_systemId);
+        write_output_buffer(This, systemW, sizeof(systemW)/sizeof(WCHAR));
+        write_output_buffer_quoted(This, systemId, n_systemId);
     }
 
-    write_output_buffer(This->buffer, closetagW, sizeof(closetagW)/sizeof(WCHAR));
+    write_output_buffer(This, closetagW, sizeof(closetagW)/sizeof(WCHAR));
 
     return S_OK;
 }
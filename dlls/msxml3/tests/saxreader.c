@@ -3159,7 +3159,6 @@ static void test_mxwriter_flush(void)
     pos2.QuadPart = 0;
     hr = IStream_Seek(stream, pos, STREAM_SEEK_CUR, &pos2);
     EXPECT_HR(hr, S_OK);
-todo_wine
     ok(pos2.QuadPart != 0, "unexpected stream beginning\n");
 
     hr = IMXWriter_get_output(writer, NULL);
@@ -3238,6 +3237,84 @@ todo_wine
     free_bstrs();
 }
 
+static void test_mxwriter_large(void)
+{
+    static const char elementA[] = "<e>1&lt;2</e>";
+    const int count = 100000;
+    ISAXContentHandler *content;
+    BSTR name, text;
+    IMXWriter *writer;
+    ULARGE_INTEGER pos2;
+    LARGE_INTEGER pos;
+    IStream *stream;
+    VARIANT dest;
+    DWORD ticks;
+    HRESULT hr;
+    int i;
+
+    hr = CoCreateInstance(&CLSID_MXXMLWriter, NULL, CLSCTX_INPROC_SERVER,
+            &IID_IMXWriter, (void**)&writer);
+    EXPECT_HR(hr, S_OK);
+
+    hr = IMXWriter_QueryInterface(writer, &IID_ISAXContentHandler, (void**)&content);
+    EXPECT_HR(hr, S_OK);
+
+    hr = IMXWriter_put_omitXMLDeclaration(writer, VARIANT_TRUE);
+    EXPECT_HR(hr, S_OK);
+
+    hr = IMXWriter_put_encoding(writer, _bstr_("UTF-8"));
+    EXPECT_HR(hr, S_OK);
+
+    hr = CreateStreamOnHGlobal(NULL, TRUE, &stream);
+    EXPECT_HR(hr, S_OK);
+
+    V_VT(&dest) = VT_UNKNOWN;
+    V_UNKNOWN(&dest) = (IUnknown*)stream;
+    hr = IMXWriter_put_output(writer, dest);
+    EXPECT_HR(hr, S_OK);
+
+    name = _bstr_("e");
+    text = _bstr_("1<2");
+
+    hr = ISAXContentHandler_startDocument(content);
+    EXPECT_HR(hr, S_OK);
+
+    ticks = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        hr = ISAXContentHandler_startElement(content, emptyW, 0, emptyW, 0, name, 1, NULL);
+        if (hr != S_OK) break;
+        hr = ISAXContentHandler_characters(content, text, 3);
+        if (hr != S_OK) break;
+        hr = ISAXContentHandler_endElement(content, emptyW, 0, emptyW, 0, name, 1);
+        if (hr != S_OK) break;
+    }
+    ok(i == count, "got 0x%08x after %d elements\n", hr, i);
+
+    /* output is written out while document is generated */
+    pos.QuadPart = 0;
+    pos2.QuadPart = 0;
+    hr = IStream_Seek(stream, pos, STREAM_SEEK_CUR, &pos2);
+    EXPECT_HR(hr, S_OK);
+    ok(pos2.QuadPart > 0, "unexpected stream beginning\n");
+
+    hr = ISAXContentHandler_endDocument(content);
+    EXPECT_HR(hr, S_OK);
+    ticks = GetTickCount() - ticks;
+
+    pos.QuadPart = 0;
+    pos2.QuadPart = 0;
+    hr = IStream_Seek(stream, pos, STREAM_SEEK_CUR, &pos2);
+    EXPECT_HR(hr, S_OK);
+    ok(pos2.QuadPart == count * (sizeof(elementA) - 1), "got %u\n", (ULONG)pos2.QuadPart);
+    trace("wrote %d elements in %u ms\n", count, ticks);
+
+    ISAXContentHandler_Release(content);
+    IStream_Release(stream);
+    IMXWriter_Release(writer);
+    free_bstrs();
+}
+
 static void test_mxwriter_startenddocument(void)
 {
     ISAXContentHandler *content;
@@ -5370,6 +5447,7 @@ START_TEST(saxreader)
         test_mxwriter_dtd();
         test_mxwriter_properties();
         test_mxwriter_flush();
+        test_mxwriter_large();
         test_mxwriter_stream();
         test_mxwriter_encoding();
         test_mxwriter_dispex();
@@ -151,6 +151,13 @@ struct progidredirect_data
     ULONG clsid_offset;
 };
 
+enum class_reg_data_origin
+{
+    CLASS_REG_ACTCTX,
+    CLASS_REG_REGISTRY,
+    CLASS_REG_CACHE
+};
+
 struct class_reg_data
 {
     union
@@ -162,8 +169,13 @@ struct class_reg_data
             HANDLE hactctx;
         } actctx;
         HKEY hkey;
+        struct
+        {
+            enum comclass_threadingmodel model;
+            WCHAR dllpath[MAX_PATH+1];
+        } cache;
     } u;
-    BOOL hkey;
+    enum class_reg_data_origin origin;
 };
 
 struct registered_psclsid
@@ -607,6 +619,9 @@ static APARTMENT *apartment_construct(DWORD model)
 
     list_init(&apt->proxies);
     list_init(&apt->stubmgrs);
+    stub_hash_init(&apt->stubmgrs_by_object);
+    stub_hash_init(&apt->stubmgrs_by_oid);
+    stub_hash_init(&apt->ifstubs_by_ipid);
     list_init(&apt->psclsids);
     list_init(&apt->loaded_dlls);
     apt->ipidc = 0;
@@ -1171,6 +1186,9 @@ DWORD apartment_release(struct apartment *apt)
          * stub manager without taking a reference to the containing
          * apartment, which it must do. */
         assert(list_empty(&apt->stubmgrs));
+        stub_hash_destroy(&apt->stubmgrs_by_object);
+        stub_hash_destroy(&apt->stubmgrs_by_oid);
+        stub_hash_destroy(&apt->ifstubs_by_ipid);
 
         if (apt->filter) IMessageFilter_Release(apt->filter);
 
@@ -1372,7 +1390,14 @@ static DWORD COM_RegReadPath(const struct class_reg_data *regdata, WCHAR *dst, D
 {
     DWORD ret;
 
-    if (regdata->hkey)
+    if (regdata->origin == CLASS_REG_CACHE)
+    {
+        if (!regdata->u.cache.dllpath[0]) return ERROR_FILE_NOT_FOUND;
+        if (strlenW(regdata->u.cache.dllpath) >= dstlen) return ERROR_MORE_DATA;
+        strcpyW(dst, regdata->u.cache.dllpath);
+        return ERROR_SUCCESS;
+    }
+    else if (regdata->origin == CLASS_REG_REGISTRY)
     {
 	DWORD keytype;
 	WCHAR src[MAX_PATH];
@@ -2792,7 +2817,9 @@ HRESULT WINAPI CoRegisterClassObject(
 
 static enum comclass_threadingmodel get_threading_model(const struct class_reg_data *data)
 {
-    if (data->hkey)
+    if (data->origin == CLASS_REG_CACHE)
+        return data->u.cache.model;
+    else if (data->origin == CLASS_REG_REGISTRY)
     {
         static const WCHAR wszThreadingModel[] = {'T','h','r','e','a','d','i','n','g','M','o','d','e','l',0};
         static const WCHAR wszApartment[] = {'A','p','a','r','t','m','e','n','t',0};
@@ -2819,6 +2846,186 @@ static enum comclass_threadingmodel get_threading_model(const struct class_reg_d
         return data->u.actctx.data->model;
 }
 
+/*
+ * Per-process cache of InprocServer32 registrations, so that creating objects
+ * doesn't go through the registry every time. The whole cache is flushed
+ * whenever anything below HKCR\CLSID changes.
+ */
+struct inproc_server_cache_entry
+{
+    struct list entry;
+    CLSID clsid;
+    enum comclass_threadingmodel model;
+    WCHAR dllpath[MAX_PATH+1];
+};
+
+#define INPROC_SERVER_CACHE_SIZE 64
+
+static struct list inproc_server_cache[INPROC_SERVER_CACHE_SIZE];
+static HKEY inproc_server_cache_key;
+static HANDLE inproc_server_cache_event;
+static DWORD inproc_server_cache_generation;
+
+static CRITICAL_SECTION csInprocServerCache;
+static CRITICAL_SECTION_DEBUG inproc_server_cache_cs_debug =
+{
+    0, 0, &csInprocServerCache,
+    { &inproc_server_cache_cs_debug.ProcessLocksList, &inproc_server_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": csInprocServerCache") }
+};
+static CRITICAL_SECTION csInprocServerCache = { &inproc_server_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static inline struct list *inproc_server_cache_bucket(REFCLSID clsid)
+{
+    return &inproc_server_cache[clsid->Data1 % INPROC_SERVER_CACHE_SIZE];
+}
+
+/* must be called with csInprocServerCache held */
+static void inproc_server_cache_flush(void)
+{
+    struct inproc_server_cache_entry *entry, *next;
+    unsigned int i;
+
+    if (!inproc_server_cache_event) return;
+
+    for (i = 0; i < INPROC_SERVER_CACHE_SIZE; i++)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE(entry, next, &inproc_server_cache[i], struct inproc_server_cache_entry, entry)
+        {
+            list_remove(&entry->entry);
+            HeapFree(GetProcessHeap(), 0, entry);
+        }
+    }
+    inproc_server_cache_generation++;
+}
+
+/* must be called with csInprocServerCache held */
+static void inproc_server_cache_shutdown(void)
+{
+    inproc_server_cache_flush();
+    if (inproc_server_cache_key) RegCloseKey(inproc_server_cache_key);
+    if (inproc_server_cache_event) CloseHandle(inproc_server_cache_event);
+    inproc_server_cache_key = NULL;
+    inproc_server_cache_event = NULL;
+}
+
+/* Flushes the cache if the class registrations changed since the last call.
+ * Returns FALSE if the cache can't be used.
+ * Must be called with csInprocServerCache held. */
+static BOOL inproc_server_cache_validate(void)
+{
+    static const WCHAR clsidW[] = {'C','L','S','I','D',0};
+    unsigned int i;
+
+    if (!inproc_server_cache_event)
+    {
+        if (open_classes_key(HKEY_CLASSES_ROOT, clsidW, KEY_NOTIFY, &inproc_server_cache_key))
+        {
+            inproc_server_cache_key = NULL;
+            return FALSE;
+        }
+        if (!(inproc_server_cache_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        {
+            inproc_server_cache_shutdown();
+            return FALSE;
+        }
+        for (i = 0; i < INPROC_SERVER_CACHE_SIZE; i++)
+            list_init(&inproc_server_cache[i]);
+    }
+    else if (WaitForSingleObject(inproc_server_cache_event, 0) == WAIT_OBJECT_0)
+    {
+        TRACE("class registrations changed, flushing cache\n");
+        inproc_server_cache_flush();
+    }
+    else
+        return TRUE;
+
+    if (RegNotifyChangeKeyValue(inproc_server_cache_key, TRUE, REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET,
+                                inproc_server_cache_event, TRUE))
+    {
+        WARN("failed to watch class registrations, not caching them\n");
+        inproc_server_cache_shutdown();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Looks up the InprocServer32 registration of a class, from the cache if
+ * possible, otherwise from the registry. */
+static HRESULT get_inproc_server_regdata(REFCLSID rclsid, struct class_reg_data *regdata)
+{
+    static const WCHAR wszInprocServer32[] = {'I','n','p','r','o','c','S','e','r','v','e','r','3','2',0};
+    struct inproc_server_cache_entry *entry;
+    struct class_reg_data keydata;
+    DWORD generation = 0;
+    BOOL use_cache;
+    HKEY hkey;
+    HRESULT hr;
+
+    EnterCriticalSection(&csInprocServerCache);
+    if ((use_cache = inproc_server_cache_validate()))
+    {
+        generation = inproc_server_cache_generation;
+        LIST_FOR_EACH_ENTRY(entry, inproc_server_cache_bucket(rclsid), struct inproc_server_cache_entry, entry)
+        {
+            if (IsEqualCLSID(&entry->clsid, rclsid))
+            {
+                regdata->u.cache.model = entry->model;
+                strcpyW(regdata->u.cache.dllpath, entry->dllpath);
+                regdata->origin = CLASS_REG_CACHE;
+                LeaveCriticalSection(&csInprocServerCache);
+                return S_OK;
+            }
+        }
+    }
+    LeaveCriticalSection(&csInprocServerCache);
+
+    hr = COM_OpenKeyForCLSID(rclsid, wszInprocServer32, KEY_READ, &hkey);
+    if (FAILED(hr))
+        return hr;
+
+    keydata.u.hkey = hkey;
+    keydata.origin = CLASS_REG_REGISTRY;
+    regdata->u.cache.model = get_threading_model(&keydata);
+    if (COM_RegReadPath(&keydata, regdata->u.cache.dllpath, ARRAYSIZE(regdata->u.cache.dllpath)) != ERROR_SUCCESS)
+    {
+        regdata->u.cache.dllpath[0] = 0;
+        use_cache = FALSE;
+    }
+    regdata->origin = CLASS_REG_CACHE;
+    RegCloseKey(hkey);
+
+    if (!use_cache || !(entry = HeapAlloc(GetProcessHeap(), 0, sizeof(*entry))))
+        return S_OK;
+
+    entry->clsid = *rclsid;
+    entry->model = regdata->u.cache.model;
+    strcpyW(entry->dllpath, regdata->u.cache.dllpath);
+
+    EnterCriticalSection(&csInprocServerCache);
+    /* don't add what we read if the registrations changed in the meantime */
+    if (inproc_server_cache_validate() && generation == inproc_server_cache_generation)
+    {
+        struct inproc_server_cache_entry *cur;
+
+        LIST_FOR_EACH_ENTRY(cur, inproc_server_cache_bucket(rclsid), struct inproc_server_cache_entry, entry)
+        {
+            if (IsEqualCLSID(&cur->clsid, rclsid))
+            {
+                HeapFree(GetProcessHeap(), 0, entry);
+                entry = NULL;
+                break;
+            }
+        }
+        if (entry) list_add_head(inproc_server_cache_bucket(rclsid), &entry->entry);
+    }
+    else
+        HeapFree(GetProcessHeap(), 0, entry);
+    LeaveCriticalSection(&csInprocServerCache);
+
+    return S_OK;
+}
+
 static HRESULT get_inproc_class_object(APARTMENT *apt, const struct class_reg_data *regdata,
                                        REFCLSID rclsid, REFIID riid,
                                        BOOL hostifnecessary, void **ppv)
@@ -2952,7 +3159,7 @@ HRESULT WINAPI CoGetClassObject(
             clsreg.u.actctx.hactctx = data.hActCtx;
             clsreg.u.actctx.data = data.lpData;
             clsreg.u.actctx.section = data.lpSectionBase;
-            clsreg.hkey = FALSE;
+            clsreg.origin = CLASS_REG_ACTCTX;
 
             hres = get_inproc_class_object(apt, &clsreg, &comclass->clsid, iid, !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
             ReleaseActCtx(data.hActCtx);
@@ -2984,10 +3191,7 @@ HRESULT WINAPI CoGetClassObject(
     /* First try in-process server */
     if (CLSCTX_INPROC_SERVER & dwClsContext)
     {
-        static const WCHAR wszInprocServer32[] = {'I','n','p','r','o','c','S','e','r','v','e','r','3','2',0};
-        HKEY hkey;
-
-        hres = COM_OpenKeyForCLSID(rclsid, wszInprocServer32, KEY_READ, &hkey);
+        hres = get_inproc_server_regdata(rclsid, &clsreg);
         if (FAILED(hres))
         {
             if (hres == REGDB_E_CLASSNOTREG)
@@ -3000,13 +3204,7 @@ HRESULT WINAPI CoGetClassObject(
         }
 
         if (SUCCEEDED(hres))
-        {
-            clsreg.u.hkey = hkey;
-            clsreg.hkey = TRUE;
-
             hres = get_inproc_class_object(apt, &clsreg, rclsid, iid, !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
-            RegCloseKey(hkey);
-        }
 
         /* return if we got a class, otherwise fall through to one of the
          * other types */
@@ -3038,7 +3236,7 @@ HRESULT WINAPI CoGetClassObject(
         if (SUCCEEDED(hres))
         {
             clsreg.u.hkey = hkey;
-            clsreg.hkey = TRUE;
+            clsreg.origin = CLASS_REG_REGISTRY;
 
             hres = get_inproc_class_object(apt, &clsreg, rclsid, iid, !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
             RegCloseKey(hkey);
@@ -4807,7 +5005,7 @@ HRESULT Handler_DllGetClassObject(REFCLSID rclsid, REFIID riid, LPVOID *ppv)
         WCHAR dllpath[MAX_PATH+1];
 
         regdata.u.hkey = hkey;
-        regdata.hkey = TRUE;
+        regdata.origin = CLASS_REG_REGISTRY;
 
         if (COM_RegReadPath(&regdata, dllpath, ARRAYSIZE(dllpath)) == ERROR_SUCCESS)
         {
@@ -4844,6 +5042,8 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID reserved)
         UnregisterClassW( wszAptWinClass, hProxyDll );
         RPC_UnregisterAllChannelHooks();
         COMPOBJ_DllList_Free();
+        inproc_server_cache_shutdown();
+        DeleteCriticalSection(&csInprocServerCache);
         DeleteCriticalSection(&csRegisteredClassList);
         DeleteCriticalSection(&csApartment);
 	break;
@@ -73,6 +73,8 @@ typedef enum ifstub_state
 struct ifstub   
 {
     struct list       entry;      /* entry in stub_manager->ifstubs list (CS stub_manager->lock) */
+    struct list       ipid_entry; /* entry in apartment ifstubs_by_ipid hash (CS apt->cs) */
+    struct stub_manager *stubmgr; /* owning stub manager (RO) */
     IRpcStubBuffer   *stubbuffer; /* RO */
     IID               iid;        /* RO */
     IPID              ipid;       /* RO */
@@ -86,6 +88,8 @@ struct ifstub
 struct stub_manager
 {
     struct list       entry;      /* entry in apartment stubmgr list (CS apt->cs) */
+    struct list       object_entry; /* entry in apartment stubmgrs_by_object hash (CS apt->cs) */
+    struct list       oid_entry;  /* entry in apartment stubmgrs_by_oid hash (CS apt->cs) */
     struct list       ifstubs;    /* list of active ifstubs for the object (CS lock) */
     CRITICAL_SECTION  lock;
     APARTMENT        *apt;        /* owning apt (RO) */
@@ -122,6 +126,18 @@ struct ifproxy
   IRpcChannelBuffer *chan; /* channel to object (CS parent->cs) */
 };
 
+#define STUB_HASH_INITIAL_SIZE 16
+
+/* hash table used to look up the stub managers and interface stubs of an
+ * apartment without walking all of them */
+struct stub_hash
+{
+    struct list  *buckets;
+    unsigned int  size;    /* number of buckets, always a power of two */
+    unsigned int  count;   /* number of entries */
+    struct list   initial[STUB_HASH_INITIAL_SIZE];
+};
+
 struct apartment
 {
   struct list entry;
@@ -134,6 +150,9 @@ struct apartment
   CRITICAL_SECTION cs;     /* thread safety */
   struct list proxies;     /* imported objects (CS cs) */
   struct list stubmgrs;    /* stub managers for exported objects (CS cs) */
+  struct stub_hash stubmgrs_by_object; /* stub managers indexed by object (CS cs) */
+  struct stub_hash stubmgrs_by_oid;    /* stub managers indexed by OID (CS cs) */
+  struct stub_hash ifstubs_by_ipid;    /* interface stubs indexed by IPID (CS cs) */
   BOOL remunk_exported;    /* has the IRemUnknown interface for this apartment been created yet? (CS cs) */
   LONG remoting_started;   /* has the RPC system been started for this apartment? (LOCK) */
   struct list psclsids;    /* list of registered PS CLSIDs (CS cs) */
@@ -184,6 +203,8 @@ HRESULT FTMarshalCF_Create(REFIID riid, LPVOID *ppv) DECLSPEC_HIDDEN;
 
 /* Stub Manager */
 
+void stub_hash_init(struct stub_hash *hash) DECLSPEC_HIDDEN;
+void stub_hash_destroy(struct stub_hash *hash) DECLSPEC_HIDDEN;
 ULONG stub_manager_int_release(struct stub_manager *This) DECLSPEC_HIDDEN;
 struct stub_manager *new_stub_manager(APARTMENT *apt, IUnknown *object) DECLSPEC_HIDDEN;
 ULONG stub_manager_ext_addref(struct stub_manager *m, ULONG refs, BOOL tableweak) DECLSPEC_HIDDEN;
@@ -66,6 +66,102 @@ static inline HRESULT generate_ipid(struct stub_manager *m, IPID *ipid)
     return S_OK;
 }
 
+void stub_hash_init(struct stub_hash *hash)
+{
+    unsigned int i;
+
+    for (i = 0; i < STUB_HASH_INITIAL_SIZE; i++)
+        list_init(&hash->initial[i]);
+    hash->buckets = hash->initial;
+    hash->size = STUB_HASH_INITIAL_SIZE;
+    hash->count = 0;
+}
+
+void stub_hash_destroy(struct stub_hash *hash)
+{
+    if (hash->buckets != hash->initial)
+        HeapFree(GetProcessHeap(), 0, hash->buckets);
+}
+
+static inline struct list *stub_hash_bucket(const struct stub_hash *hash, ULONG_PTR key)
+{
+    return &hash->buckets[key & (hash->size - 1)];
+}
+
+/* adds an entry, growing the table when the chains get too long. if that
+ * fails we just carry on with longer chains. */
+static void stub_hash_add(struct stub_hash *hash, struct list *entry, ULONG_PTR key,
+                          ULONG_PTR (*get_key)(struct list *))
+{
+    if (hash->count >= hash->size * 2)
+    {
+        unsigned int i, new_size = hash->size * 2;
+        struct list *buckets = HeapAlloc(GetProcessHeap(), 0, new_size * sizeof(*buckets));
+
+        if (buckets)
+        {
+            struct list *old_buckets = hash->buckets, *cursor;
+            unsigned int old_size = hash->size;
+
+            for (i = 0; i < new_size; i++)
+                list_init(&buckets[i]);
+            hash->buckets = buckets;
+            hash->size = new_size;
+
+            for (i = 0; i < old_size; i++)
+            {
+                while ((cursor = list_head(&old_buckets[i])))
+                {
+                    list_remove(cursor);
+                    list_add_tail(stub_hash_bucket(hash, get_key(cursor)), cursor);
+                }
+            }
+            if (old_buckets != hash->initial)
+                HeapFree(GetProcessHeap(), 0, old_buckets);
+        }
+    }
+
+    list_add_head(stub_hash_bucket(hash, key), entry);
+    hash->count++;
+}
+
+static void stub_hash_remove(struct stub_hash *hash, struct list *entry)
+{
+    list_remove(entry);
+    hash->count--;
+}
+
+static inline ULONG_PTR object_hash_key(const void *object)
+{
+    return (ULONG_PTR)object >> 4;
+}
+
+static inline ULONG_PTR oid_hash_key(OID oid)
+{
+    return (ULONG_PTR)oid;
+}
+
+/* the first part of an ipid is the apartment-local counter, see generate_ipid */
+static inline ULONG_PTR ipid_hash_key(const IPID *ipid)
+{
+    return ipid->Data1;
+}
+
+static ULONG_PTR stubmgr_object_key(struct list *entry)
+{
+    return object_hash_key(LIST_ENTRY(entry, struct stub_manager, object_entry)->object);
+}
+
+static ULONG_PTR stubmgr_oid_key(struct list *entry)
+{
+    return oid_hash_key(LIST_ENTRY(entry, struct stub_manager, oid_entry)->oid);
+}
+
+static ULONG_PTR ifstub_ipid_key(struct list *entry)
+{
+    return ipid_hash_key(&LIST_ENTRY(entry, struct ifstub, ipid_entry)->ipid);
+}
+
 /* registers a new interface stub COM object with the stub manager and returns registration record */
 struct ifstub *stub_manager_new_ifstub(struct stub_manager *m, IRpcStubBuffer *sb, IUnknown *iptr, REFIID iid, DWORD dest_context,
     void *dest_context_data, MSHLFLAGS flags)
@@ -88,6 +184,7 @@ struct ifstub *stub_manager_new_ifstub(struct stub_manager *m, IRpcStubBuffer *s
 
     stub->stubbuffer = sb;
     if (sb) IRpcStubBuffer_AddRef(sb);
+    stub->stubmgr = m;
 
     IUnknown_AddRef(iptr);
     stub->iface = iptr;
@@ -107,6 +204,10 @@ struct ifstub *stub_manager_new_ifstub(struct stub_manager *m, IRpcStubBuffer *s
     if (flags & MSHLFLAGS_NORMAL) m->norm_refs++;
     LeaveCriticalSection(&m->lock);
 
+    EnterCriticalSection(&m->apt->cs);
+    stub_hash_add(&m->apt->ifstubs_by_ipid, &stub->ipid_entry, ipid_hash_key(&stub->ipid), ifstub_ipid_key);
+    LeaveCriticalSection(&m->apt->cs);
+
     TRACE("ifstub %p created with ipid %s\n", stub, debugstr_guid(&stub->ipid));
 
     return stub;
@@ -127,23 +228,35 @@ static void stub_manager_delete_ifstub(struct stub_manager *m, struct ifstub *if
     HeapFree(GetProcessHeap(), 0, ifstub);
 }
 
+/* must be called with apt->cs held */
+static struct ifstub *apartment_ipid_to_ifstub(APARTMENT *apt, const IPID *ipid)
+{
+    struct ifstub *ifstub;
+
+    LIST_FOR_EACH_ENTRY( ifstub, stub_hash_bucket(&apt->ifstubs_by_ipid, ipid_hash_key(ipid)), struct ifstub, ipid_entry )
+    {
+        if (IsEqualGUID(ipid, &ifstub->ipid))
+            return ifstub;
+    }
+
+    return NULL;
+}
+
 static struct ifstub *stub_manager_ipid_to_ifstub(struct stub_manager *m, const IPID *ipid)
 {
-    struct list    *cursor;
     struct ifstub  *result = NULL;
+    struct ifstub  *ifstub;
 
-    EnterCriticalSection(&m->lock);
-    LIST_FOR_EACH( cursor, &m->ifstubs )
+    EnterCriticalSection(&m->apt->cs);
+    LIST_FOR_EACH_ENTRY( ifstub, stub_hash_bucket(&m->apt->ifstubs_by_ipid, ipid_hash_key(ipid)), struct ifstub, ipid_entry )
     {
-        struct ifstub *ifstub = LIST_ENTRY( cursor, struct ifstub, entry );
-
-        if (IsEqualGUID(ipid, &ifstub->ipid))
+        if (ifstub->stubmgr == m && IsEqualGUID(ipid, &ifstub->ipid))
         {
             result = ifstub;
             break;
         }
     }
-    LeaveCriticalSection(&m->lock);
+    LeaveCriticalSection(&m->apt->cs);
 
     return result;
 }
@@ -226,6 +339,8 @@ struct stub_manager *new_stub_manager(APARTMENT *apt, IUnknown *object)
     EnterCriticalSection(&apt->cs);
     sm->oid = apt->oidc++;
     list_add_head(&apt->stubmgrs, &sm->entry);
+    stub_hash_add(&apt->stubmgrs_by_object, &sm->object_entry, object_hash_key(object), stubmgr_object_key);
+    stub_hash_add(&apt->stubmgrs_by_oid, &sm->oid_entry, oid_hash_key(sm->oid), stubmgr_oid_key);
     LeaveCriticalSection(&apt->cs);
 
     TRACE("Created new stub manager (oid=%s) at %p for object with IUnknown %p\n", wine_dbgstr_longlong(sm->oid), sm, object);
@@ -286,7 +401,15 @@ ULONG stub_manager_int_release(struct stub_manager *This)
 
     /* remove from apartment so no other thread can access it... */
     if (!refs)
+    {
+        struct ifstub *ifstub;
+
         list_remove(&This->entry);
+        stub_hash_remove(&apt->stubmgrs_by_object, &This->object_entry);
+        stub_hash_remove(&apt->stubmgrs_by_oid, &This->oid_entry);
+        LIST_FOR_EACH_ENTRY( ifstub, &This->ifstubs, struct ifstub, entry )
+            stub_hash_remove(&apt->ifstubs_by_ipid, &ifstub->ipid_entry);
+    }
 
     LeaveCriticalSection(&apt->cs);
 
@@ -303,13 +426,11 @@ ULONG stub_manager_int_release(struct stub_manager *This)
 struct stub_manager *get_stub_manager_from_object(APARTMENT *apt, void *object)
 {
     struct stub_manager *result = NULL;
-    struct list         *cursor;
+    struct stub_manager *m;
 
     EnterCriticalSection(&apt->cs);
-    LIST_FOR_EACH( cursor, &apt->stubmgrs )
+    LIST_FOR_EACH_ENTRY( m, stub_hash_bucket(&apt->stubmgrs_by_object, object_hash_key(object)), struct stub_manager, object_entry )
     {
-        struct stub_manager *m = LIST_ENTRY( cursor, struct stub_manager, entry );
-
         if (m->object == object)
         {
             result = m;
@@ -335,7 +456,7 @@ void apartment_disconnectobject(struct apartment *apt, void *object)
     struct stub_manager *stubmgr;
 
     EnterCriticalSection(&apt->cs);
-    LIST_FOR_EACH_ENTRY( stubmgr, &apt->stubmgrs, struct stub_manager, entry )
+    LIST_FOR_EACH_ENTRY( stubmgr, stub_hash_bucket(&apt->stubmgrs_by_object, object_hash_key(object)), struct stub_manager, object_entry )
     {
         if (stubmgr->object == object)
         {
@@ -358,13 +479,11 @@ void apartment_disconnectobject(struct apartment *apt, void *object)
 struct stub_manager *get_stub_manager(APARTMENT *apt, OID oid)
 {
     struct stub_manager *result = NULL;
-    struct list         *cursor;
+    struct stub_manager *m;
 
     EnterCriticalSection(&apt->cs);
-    LIST_FOR_EACH( cursor, &apt->stubmgrs )
+    LIST_FOR_EACH_ENTRY( m, stub_hash_bucket(&apt->stubmgrs_by_oid, oid_hash_key(oid)), struct stub_manager, oid_entry )
     {
-        struct stub_manager *m = LIST_ENTRY( cursor, struct stub_manager, entry );
-
         if (m->oid == oid)
         {
             result = m;
@@ -452,19 +571,13 @@ ULONG stub_manager_ext_release(struct stub_manager *m, ULONG refs, BOOL tablewea
 static struct stub_manager *get_stub_manager_from_ipid(APARTMENT *apt, const IPID *ipid)
 {
     struct stub_manager *result = NULL;
-    struct list         *cursor;
+    struct ifstub       *ifstub;
 
     EnterCriticalSection(&apt->cs);
-    LIST_FOR_EACH( cursor, &apt->stubmgrs )
+    if ((ifstub = apartment_ipid_to_ifstub(apt, ipid)))
     {
-        struct stub_manager *m = LIST_ENTRY( cursor, struct stub_manager, entry );
-
-        if (stub_manager_ipid_to_ifstub(m, ipid))
-        {
-            result = m;
-            stub_manager_int_addref(result);
-            break;
-        }
+        result = ifstub->stubmgr;
+        stub_manager_int_addref(result);
     }
     LeaveCriticalSection(&apt->cs);
 
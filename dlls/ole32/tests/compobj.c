@@ -550,6 +550,19 @@ static void test_CoCreateInstance(void)
 
     ok_ole_success(hr, "CoCreateInstance");
     if(pUnk) IUnknown_Release(pUnk);
+
+    if (winetest_interactive)
+    {
+        DWORD start = GetTickCount();
+        int i;
+
+        for (i = 0; i < 10000; i++)
+        {
+            hr = CoCreateInstance(rclsid, NULL, CLSCTX_INPROC_SERVER, &IID_IUnknown, (void **)&pUnk);
+            if (SUCCEEDED(hr)) IUnknown_Release(pUnk);
+        }
+        trace("10000 CoCreateInstance calls took %u ms\n", GetTickCount() - start);
+    }
     OleUninitialize();
 
     hr = CoCreateInstance(rclsid, NULL, CLSCTX_INPROC_SERVER, &IID_IUnknown, (void **)&pUnk);
@@ -1909,6 +1922,63 @@ static void test_OleRegGetMiscStatus(void)
     }
 }
 
+static const CLSID CLSID_WineTestRegChange = { 0xd4b7a8c2, 0x5f03, 0x4c71, { 0x9a, 0x2e, 0x6b, 0x1f, 0x0e, 0x3c, 0x9d, 0x45 } };
+
+static HRESULT get_class_object_from_dll(const char *dll)
+{
+    IClassFactory *cf;
+    HKEY hkey;
+    LONG res;
+    HRESULT hr;
+
+    res = RegCreateKeyExA(HKEY_CLASSES_ROOT, "CLSID\\{d4b7a8c2-5f03-4c71-9a2e-6b1f0e3c9d45}\\InprocServer32",
+                          0, NULL, 0, KEY_ALL_ACCESS, NULL, &hkey, NULL);
+    if (res == ERROR_ACCESS_DENIED) return E_ACCESSDENIED;
+    ok(!res, "RegCreateKeyEx returned %d\n", res);
+    res = RegSetValueExA(hkey, NULL, 0, REG_SZ, (const BYTE *)dll, strlen(dll) + 1);
+    ok(!res, "RegSetValueEx returned %d\n", res);
+    res = RegSetValueExA(hkey, "ThreadingModel", 0, REG_SZ, (const BYTE *)"Both", sizeof("Both"));
+    ok(!res, "RegSetValueEx returned %d\n", res);
+    RegCloseKey(hkey);
+
+    hr = CoGetClassObject(&CLSID_WineTestRegChange, CLSCTX_INPROC_SERVER, NULL, &IID_IClassFactory, (void **)&cf);
+    if (SUCCEEDED(hr)) IClassFactory_Release(cf);
+    return hr;
+}
+
+/* class registrations may be cached, changes must still be seen by the next lookup */
+static void test_CoGetClassObject_registration_change(void)
+{
+    IClassFactory *cf;
+    HRESULT hr;
+
+    pCoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+
+    /* kernel32 doesn't export DllGetClassObject, ole32 doesn't know the class */
+    hr = get_class_object_from_dll("kernel32.dll");
+    if (hr == E_ACCESSDENIED)
+    {
+        skip("Not authorized to modify the Classes key\n");
+        CoUninitialize();
+        return;
+    }
+    ok(FAILED(hr) && hr != CLASS_E_CLASSNOTAVAILABLE, "got 0x%08x\n", hr);
+
+    hr = get_class_object_from_dll("ole32.dll");
+    ok(hr == CLASS_E_CLASSNOTAVAILABLE, "got 0x%08x\n", hr);
+
+    hr = get_class_object_from_dll("kernel32.dll");
+    ok(FAILED(hr) && hr != CLASS_E_CLASSNOTAVAILABLE, "got 0x%08x\n", hr);
+
+    RegDeleteKeyA(HKEY_CLASSES_ROOT, "CLSID\\{d4b7a8c2-5f03-4c71-9a2e-6b1f0e3c9d45}\\InprocServer32");
+    RegDeleteKeyA(HKEY_CLASSES_ROOT, "CLSID\\{d4b7a8c2-5f03-4c71-9a2e-6b1f0e3c9d45}");
+
+    hr = CoGetClassObject(&CLSID_WineTestRegChange, CLSCTX_INPROC_SERVER, NULL, &IID_IClassFactory, (void **)&cf);
+    ok(hr == REGDB_E_CLASSNOTREG, "got 0x%08x\n", hr);
+
+    CoUninitialize();
+}
+
 static void init_funcs(void)
 {
     HMODULE hOle32 = GetModuleHandleA("ole32");
@@ -1948,6 +2018,7 @@ START_TEST(compobj)
     test_CoCreateInstance();
     test_ole_menu();
     test_CoGetClassObject();
+    test_CoGetClassObject_registration_change();
     test_CoRegisterMessageFilter();
     test_CoRegisterPSClsid();
     test_CoGetPSClsid();
@@ -1685,6 +1685,57 @@ static void test_normal_marshal_and_unmarshal_twice(void)
     ok_no_locks();
 }
 
+/* tests marshaling and unmarshaling many objects in the same apartment */
+static void test_marshal_many_objects(void)
+{
+    unsigned int i, count = winetest_interactive ? 20000 : 100;
+    IUnknown *objects, *unk = NULL;
+    IStream *pStream = NULL;
+    DWORD start;
+    HRESULT hr = S_OK;
+
+    cLocks = 0;
+
+    objects = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*objects));
+    for (i = 0; i < count; i++)
+        objects[i].lpVtbl = &TestUnknown_Vtbl;
+
+    hr = CreateStreamOnHGlobal(NULL, TRUE, &pStream);
+    ok_ole_success(hr, CreateStreamOnHGlobal);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        hr = CoMarshalInterface(pStream, &IID_IUnknown, &objects[i], MSHCTX_INPROC, NULL, MSHLFLAGS_NORMAL);
+        if (hr != S_OK) break;
+    }
+    ok_ole_success(hr, CoMarshalInterface);
+    if (winetest_interactive)
+        trace("marshaling %u objects took %u ms\n", count, GetTickCount() - start);
+
+    ok_more_than_one_lock();
+
+    IStream_Seek(pStream, ullZero, STREAM_SEEK_SET, NULL);
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        hr = CoUnmarshalInterface(pStream, &IID_IUnknown, (void **)&unk);
+        if (hr != S_OK) break;
+        IUnknown_Release(unk);
+        if (unk != &objects[i]) break;
+    }
+    ok_ole_success(hr, CoUnmarshalInterface);
+    ok(i == count, "got object %p instead of %p\n", unk, &objects[i]);
+    if (winetest_interactive)
+        trace("unmarshaling %u objects took %u ms\n", count, GetTickCount() - start);
+
+    IStream_Release(pStream);
+
+    ok_no_locks();
+
+    HeapFree(GetProcessHeap(), 0, objects);
+}
+
 /* tests success case of marshaling and unmarshaling an HRESULT */
 static void test_hresult_marshaling(void)
 {
@@ -3533,6 +3584,7 @@ START_TEST(marshal)
         with_external_conn = !with_external_conn;
     } while (with_external_conn);
 
+    test_marshal_many_objects();
     test_hresult_marshaling();
     test_proxy_used_in_wrong_thread();
     test_message_filter();
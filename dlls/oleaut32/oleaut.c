@@ -65,6 +65,8 @@ WINE_DECLARE_DEBUG_CHANNEL(heap);
  *
  *  BSTR's are cached by Ole Automation by default. To override this behaviour
  *  either set the environment variable 'OANOCACHE', or call SetOaNoCache().
+ *  Small strings are cached per thread first, so that most allocations don't
+ *  need to take a lock; the shared cache holds what doesn't fit there.
  *
  * SEE ALSO
  *  'Inside OLE, second edition' by Kraig Brockshmidt.
@@ -82,6 +84,7 @@ static CRITICAL_SECTION_DEBUG cs_bstr_cache_dbg =
 static CRITICAL_SECTION cs_bstr_cache = { &cs_bstr_cache_dbg, -1, 0, 0, 0, 0 };
 
 typedef struct {
+    LONG cached; /* set while the string is in one of the caches */
     DWORD size;
     union {
         char ptr[1];
@@ -99,12 +102,21 @@ typedef struct {
     bstr_t *buf[BUCKET_BUFFER_SIZE];
 } bstr_cache_entry_t;
 
+/* Per-thread buckets cover strings up to about 1KB. */
+#define THREAD_BUCKET_CNT 64
+
+typedef struct {
+    bstr_cache_entry_t buckets[THREAD_BUCKET_CNT];
+} thread_bstr_cache_t;
+
 #define ARENA_INUSE_FILLER     0x55
 #define ARENA_TAIL_FILLER      0xab
 #define ARENA_FREE_FILLER      0xfeeefeee
 
 static bstr_cache_entry_t bstr_cache[0x10000/BUCKET_SIZE];
 
+static DWORD bstr_cache_tls = TLS_OUT_OF_INDEXES;
+
 static inline size_t bstr_alloc_size(size_t size)
 {
     return (FIELD_OFFSET(bstr_t, u.ptr[size]) + sizeof(WCHAR) + BUCKET_SIZE-1) & ~(BUCKET_SIZE-1);
@@ -115,37 +127,109 @@ static inline bstr_t *bstr_from_str(BSTR str)
     return CONTAINING_RECORD(str, bstr_t, u.str);
 }
 
-static inline bstr_cache_entry_t *get_cache_entry(size_t size)
+static inline unsigned get_cache_idx(size_t size)
 {
-    unsigned cache_idx = FIELD_OFFSET(bstr_t, u.ptr[size-1])/BUCKET_SIZE;
-    return bstr_cache_enabled && cache_idx < sizeof(bstr_cache)/sizeof(*bstr_cache)
-        ? bstr_cache + cache_idx
-        : NULL;
+    return FIELD_OFFSET(bstr_t, u.ptr[size-1])/BUCKET_SIZE;
 }
 
-static bstr_t *alloc_bstr(size_t size)
+static thread_bstr_cache_t *get_thread_bstr_cache(BOOL create)
 {
-    bstr_cache_entry_t *cache_entry = get_cache_entry(size+sizeof(WCHAR));
+    thread_bstr_cache_t *cache;
+
+    if(bstr_cache_tls == TLS_OUT_OF_INDEXES)
+        return NULL;
+
+    cache = TlsGetValue(bstr_cache_tls);
+    if(!cache && create) {
+        cache = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache));
+        if(cache)
+            TlsSetValue(bstr_cache_tls, cache);
+    }
+
+    return cache;
+}
+
+/* Takes a string large enough for size bytes from the bucket of given size or the next one. */
+static bstr_t *cache_pop(bstr_cache_entry_t *cache, unsigned bucket_cnt, size_t size)
+{
+    unsigned cache_idx = get_cache_idx(size);
+    bstr_cache_entry_t *cache_entry;
     bstr_t *ret;
 
-    if(cache_entry) {
-        EnterCriticalSection(&cs_bstr_cache);
+    if(cache_idx >= bucket_cnt)
+        return NULL;
+
+    cache_entry = cache + cache_idx;
+    if(!cache_entry->cnt) {
+        if(cache_idx+1 >= bucket_cnt || !cache_entry[1].cnt)
+            return NULL;
+        cache_entry++;
+    }
 
-        if(!cache_entry->cnt) {
-            cache_entry = get_cache_entry(size+sizeof(WCHAR)+BUCKET_SIZE);
-            if(cache_entry && !cache_entry->cnt)
-                cache_entry = NULL;
-        }
+    ret = cache_entry->buf[cache_entry->head++];
+    cache_entry->head %= BUCKET_BUFFER_SIZE;
+    cache_entry->cnt--;
+    return ret;
+}
+
+static BOOL cache_entry_push(bstr_cache_entry_t *cache_entry, bstr_t *bstr)
+{
+    if(cache_entry->cnt == sizeof(cache_entry->buf)/sizeof(*cache_entry->buf))
+        return FALSE;
+
+    cache_entry->buf[(cache_entry->head+cache_entry->cnt) % BUCKET_BUFFER_SIZE] = bstr;
+    cache_entry->cnt++;
+    return TRUE;
+}
+
+static void release_thread_bstr_cache(void)
+{
+    thread_bstr_cache_t *cache = get_thread_bstr_cache(FALSE);
+    bstr_cache_entry_t *cache_entry;
+    bstr_t *bstr;
+    unsigned i;
+
+    if(!cache)
+        return;
 
-        if(cache_entry) {
-            ret = cache_entry->buf[cache_entry->head++];
+    /* Hand the strings over to the shared cache, so that other threads can reuse them. */
+    EnterCriticalSection(&cs_bstr_cache);
+
+    for(i=0; i < THREAD_BUCKET_CNT; i++) {
+        cache_entry = cache->buckets+i;
+        while(cache_entry->cnt) {
+            bstr = cache_entry->buf[cache_entry->head++];
             cache_entry->head %= BUCKET_BUFFER_SIZE;
             cache_entry->cnt--;
+
+            if(!bstr_cache_enabled || !cache_entry_push(bstr_cache+i, bstr))
+                HeapFree(GetProcessHeap(), 0, bstr);
         }
+    }
+
+    LeaveCriticalSection(&cs_bstr_cache);
 
-        LeaveCriticalSection(&cs_bstr_cache);
+    TlsSetValue(bstr_cache_tls, NULL);
+    HeapFree(GetProcessHeap(), 0, cache);
+}
+
+static bstr_t *alloc_bstr(size_t size)
+{
+    bstr_t *ret = NULL;
 
-        if(cache_entry) {
+    if(bstr_cache_enabled) {
+        thread_bstr_cache_t *thread_cache = get_thread_bstr_cache(FALSE);
+
+        if(thread_cache)
+            ret = cache_pop(thread_cache->buckets, THREAD_BUCKET_CNT, size+sizeof(WCHAR));
+
+        if(!ret && get_cache_idx(size+sizeof(WCHAR)) < sizeof(bstr_cache)/sizeof(*bstr_cache)) {
+            EnterCriticalSection(&cs_bstr_cache);
+            ret = cache_pop(bstr_cache, sizeof(bstr_cache)/sizeof(*bstr_cache), size+sizeof(WCHAR));
+            LeaveCriticalSection(&cs_bstr_cache);
+        }
+
+        if(ret) {
             if(WARN_ON(heap)) {
                 size_t tail;
 
@@ -154,14 +238,17 @@ static bstr_t *alloc_bstr(size_t size)
                 if(tail)
                     memset(ret->u.ptr+size+sizeof(WCHAR), ARENA_TAIL_FILLER, tail);
             }
+            ret->cached = FALSE;
             ret->size = size;
             return ret;
         }
     }
 
     ret = HeapAlloc(GetProcessHeap(), 0, bstr_alloc_size(size));
-    if(ret)
+    if(ret) {
+        ret->cached = FALSE;
         ret->size = size;
+    }
     return ret;
 }
 
@@ -247,47 +334,60 @@ BSTR WINAPI SysAllocString(LPCOLESTR str)
  *  See BSTR.
  *  str may be NULL, in which case this function does nothing.
  */
+static void fill_free_bstr(bstr_t *bstr)
+{
+    if(WARN_ON(heap)) {
+        unsigned i, n = (bstr_alloc_size(bstr->size) - FIELD_OFFSET(bstr_t, u)) / sizeof(DWORD);
+        bstr->size = ARENA_FREE_FILLER;
+        for(i=0; i<n; i++)
+            bstr->u.dwptr[i] = ARENA_FREE_FILLER;
+    }
+}
+
 void WINAPI SysFreeString(BSTR str)
 {
+    thread_bstr_cache_t *thread_cache;
     bstr_cache_entry_t *cache_entry;
+    unsigned cache_idx;
     bstr_t *bstr;
 
     if(!str)
         return;
 
     bstr = bstr_from_str(str);
-    cache_entry = get_cache_entry(bstr->size+sizeof(WCHAR));
-    if(cache_entry) {
-        unsigned i;
+    if(bstr_cache_enabled) {
+        /* According to tests, freeing a string that's already in cache doesn't corrupt anything.
+         * Strings are flagged while they are in any of the caches, including the buckets of
+         * other threads, so that we don't need to search them. */
+        if(InterlockedExchange(&bstr->cached, TRUE)) {
+            WARN_(heap)("String already is in cache!\n");
+            return;
+        }
 
-        EnterCriticalSection(&cs_bstr_cache);
+        cache_idx = get_cache_idx(bstr->size+sizeof(WCHAR));
 
-        /* According to tests, freeing a string that's already in cache doesn't corrupt anything.
-         * For that to work we need to search the cache. */
-        for(i=0; i < cache_entry->cnt; i++) {
-            if(cache_entry->buf[(cache_entry->head+i) % BUCKET_BUFFER_SIZE] == bstr) {
-                WARN_(heap)("String already is in cache!\n");
-                LeaveCriticalSection(&cs_bstr_cache);
+        thread_cache = cache_idx < THREAD_BUCKET_CNT ? get_thread_bstr_cache(TRUE) : NULL;
+        if(thread_cache) {
+            cache_entry = thread_cache->buckets+cache_idx;
+            if(cache_entry_push(cache_entry, bstr)) {
+                fill_free_bstr(bstr);
                 return;
             }
         }
 
-        if(cache_entry->cnt < sizeof(cache_entry->buf)/sizeof(*cache_entry->buf)) {
-            cache_entry->buf[(cache_entry->head+cache_entry->cnt) % BUCKET_BUFFER_SIZE] = bstr;
-            cache_entry->cnt++;
+        if(cache_idx < sizeof(bstr_cache)/sizeof(*bstr_cache)) {
+            cache_entry = bstr_cache+cache_idx;
 
-            if(WARN_ON(heap)) {
-                unsigned n = bstr_alloc_size(bstr->size) / sizeof(DWORD) - 1;
-                bstr->size = ARENA_FREE_FILLER;
-                for(i=0; i<n; i++)
-                    bstr->u.dwptr[i] = ARENA_FREE_FILLER;
+            EnterCriticalSection(&cs_bstr_cache);
+
+            if(cache_entry_push(cache_entry, bstr)) {
+                fill_free_bstr(bstr);
+                LeaveCriticalSection(&cs_bstr_cache);
+                return;
             }
 
             LeaveCriticalSection(&cs_bstr_cache);
-            return;
         }
-
-        LeaveCriticalSection(&cs_bstr_cache);
     }
 
     HeapFree(GetProcessHeap(), 0, bstr);
@@ -362,7 +462,7 @@ int WINAPI SysReAllocStringLen(BSTR* old, const OLECHAR* str, unsigned int len)
     if (*old!=NULL) {
       BSTR old_copy = *old;
       DWORD newbytelen = len*sizeof(WCHAR);
-      bstr_t *bstr = HeapReAlloc(GetProcessHeap(),0,((DWORD*)*old)-1,bstr_alloc_size(newbytelen));
+      bstr_t *bstr = HeapReAlloc(GetProcessHeap(),0,bstr_from_str(*old),bstr_alloc_size(newbytelen));
       *old = bstr->u.str;
       bstr->size = newbytelen;
       /* Subtle hidden feature: The old string data is still there
@@ -736,9 +836,9 @@ HRESULT WINAPI OleTranslateColor(
 }
 
 extern HRESULT WINAPI OLEAUTPS_DllGetClassObject(REFCLSID, REFIID, LPVOID *) DECLSPEC_HIDDEN;
-extern BOOL WINAPI OLEAUTPS_DllMain(HINSTANCE, DWORD, LPVOID) DECLSPEC_HIDDEN;
 extern HRESULT WINAPI OLEAUTPS_DllRegisterServer(void) DECLSPEC_HIDDEN;
 extern HRESULT WINAPI OLEAUTPS_DllUnregisterServer(void) DECLSPEC_HIDDEN;
+extern HINSTANCE hProxyDll DECLSPEC_HIDDEN;
 
 extern void _get_STDFONT_CF(LPVOID *);
 extern void _get_STDPIC_CF(LPVOID *);
@@ -875,9 +975,27 @@ BOOL WINAPI DllMain(HINSTANCE hInstDll, DWORD fdwReason, LPVOID lpvReserved)
 {
     static const WCHAR oanocacheW[] = {'o','a','n','o','c','a','c','h','e',0};
 
-    bstr_cache_enabled = !GetEnvironmentVariableW(oanocacheW, NULL, 0);
+    /* We don't use OLEAUTPS_DllMain, because it disables thread notifications,
+     * which are needed to release per-thread BSTR caches. */
+    switch(fdwReason) {
+    case DLL_PROCESS_ATTACH:
+        hProxyDll = hInstDll;
+        bstr_cache_enabled = !GetEnvironmentVariableW(oanocacheW, NULL, 0);
+        bstr_cache_tls = TlsAlloc();
+        break;
+    case DLL_PROCESS_DETACH:
+        if(lpvReserved)
+            break;
+        release_thread_bstr_cache();
+        if(bstr_cache_tls != TLS_OUT_OF_INDEXES)
+            TlsFree(bstr_cache_tls);
+        break;
+    case DLL_THREAD_DETACH:
+        release_thread_bstr_cache();
+        break;
+    }
 
-    return OLEAUTPS_DllMain( hInstDll, fdwReason, lpvReserved );
+    return TRUE;
 }
 
 /***********************************************************************
@@ -945,6 +945,12 @@ static HRESULT WINAPI StaticWidget_TestSecondIface(IStaticWidget *iface, ITestSe
     return S_OK;
 }
 
+static HRESULT WINAPI StaticWidget_StrLen(IStaticWidget *iface, BSTR str, INT add, INT *len)
+{
+    *len = SysStringLen(str) + add;
+    return S_OK;
+}
+
 static const IStaticWidgetVtbl StaticWidgetVtbl = {
     StaticWidget_QueryInterface,
     StaticWidget_AddRef,
@@ -954,7 +960,8 @@ static const IStaticWidgetVtbl StaticWidgetVtbl = {
     StaticWidget_GetIDsOfNames,
     StaticWidget_Invoke,
     StaticWidget_TestDual,
-    StaticWidget_TestSecondIface
+    StaticWidget_TestSecondIface,
+    StaticWidget_StrLen
 };
 
 static IStaticWidget StaticWidget = { &StaticWidgetVtbl };
@@ -1175,6 +1182,128 @@ static INonOleAutomationVtbl NonOleAutomation_VTable =
 
 static INonOleAutomation NonOleAutomation = { &NonOleAutomation_VTable };
 
+static ISimpleTypes SimpleTypes;
+static IVariantTypes VariantTypes;
+
+static const WCHAR inW[] = {'i','n',0};
+static const WCHAR outW[] = {'o','u','t',0};
+static const WCHAR inoutW[] = {'i','n','o','u','t',0};
+static const WCHAR changedW[] = {'c','h','a','n','g','e','d',0};
+
+static HRESULT WINAPI SimpleTypes_QueryInterface(ISimpleTypes *iface, REFIID riid, void **ppv)
+{
+    if (IsEqualIID(riid, &IID_IUnknown) || IsEqualIID(riid, &IID_ISimpleTypes))
+    {
+        *ppv = &SimpleTypes;
+        return S_OK;
+    }
+    if (IsEqualIID(riid, &IID_IVariantTypes))
+    {
+        *ppv = &VariantTypes;
+        return S_OK;
+    }
+    *ppv = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI SimpleTypes_AddRef(ISimpleTypes *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI SimpleTypes_Release(ISimpleTypes *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI SimpleTypes_BaseTypes(ISimpleTypes *iface, INT i, SHORT s, DOUBLE d, FLOAT f,
+                                            INT *out, DOUBLE *inout)
+{
+    ok(i == 5, "got i %d\n", i);
+    ok(s == -3, "got s %d\n", s);
+    ok(d == 1.5, "got d %f\n", d);
+    ok(f == 2.5f, "got f %f\n", f);
+    ok(*inout == 4.0, "got inout %f\n", *inout);
+    *out = i + s;
+    *inout = *inout * 2 + d;
+    return S_OK;
+}
+
+static HRESULT WINAPI SimpleTypes_Strings(ISimpleTypes *iface, BSTR in, BSTR *out, BSTR *inout)
+{
+    ok(!lstrcmpW(in, inW), "got in %s\n", wine_dbgstr_w(in));
+    ok(!lstrcmpW(*inout, inoutW), "got inout %s\n", wine_dbgstr_w(*inout));
+    *out = SysAllocString(outW);
+    SysFreeString(*inout);
+    *inout = SysAllocString(changedW);
+    return S_OK;
+}
+
+static HRESULT WINAPI SimpleTypes_Interfaces(ISimpleTypes *iface, IUnknown *in, ISimpleTypes **out,
+                                             IUnknown **inout)
+{
+    ok(in == (IUnknown *)&SimpleTypes, "got in %p\n", in);
+    ok(*inout == (IUnknown *)&SimpleTypes, "got inout %p\n", *inout);
+    *out = &SimpleTypes;
+    IUnknown_Release(*inout);
+    *inout = NULL;
+    return S_OK;
+}
+
+static HRESULT WINAPI SimpleTypes_StrLen(ISimpleTypes *iface, BSTR str, INT add, INT *len)
+{
+    *len = SysStringLen(str) + add;
+    return S_OK;
+}
+
+static const ISimpleTypesVtbl SimpleTypesVtbl = {
+    SimpleTypes_QueryInterface,
+    SimpleTypes_AddRef,
+    SimpleTypes_Release,
+    SimpleTypes_BaseTypes,
+    SimpleTypes_Strings,
+    SimpleTypes_Interfaces,
+    SimpleTypes_StrLen
+};
+
+static ISimpleTypes SimpleTypes = { &SimpleTypesVtbl };
+
+static HRESULT WINAPI VariantTypes_QueryInterface(IVariantTypes *iface, REFIID riid, void **ppv)
+{
+    return ISimpleTypes_QueryInterface(&SimpleTypes, riid, ppv);
+}
+
+static ULONG WINAPI VariantTypes_AddRef(IVariantTypes *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI VariantTypes_Release(IVariantTypes *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI VariantTypes_StrLen(IVariantTypes *iface, BSTR str, INT add, INT *len)
+{
+    *len = SysStringLen(str) + add;
+    return S_OK;
+}
+
+static HRESULT WINAPI VariantTypes_VariantArg(IVariantTypes *iface, VARIANT v)
+{
+    return S_OK;
+}
+
+static const IVariantTypesVtbl VariantTypesVtbl = {
+    VariantTypes_QueryInterface,
+    VariantTypes_AddRef,
+    VariantTypes_Release,
+    VariantTypes_StrLen,
+    VariantTypes_VariantArg
+};
+
+static IVariantTypes VariantTypes = { &VariantTypesVtbl };
+
 static ITypeInfo *NonOleAutomation_GetTypeInfo(void)
 {
     ITypeLib *pTypeLib;
@@ -1722,6 +1851,29 @@ static void test_typelibmarshal(void)
     ok(V_I4(&varresult) == DISPID_TM_NEG_RESTRICTED, "got %x\n", V_I4(&varresult));
     VariantClear(&varresult);
 
+    if (winetest_interactive)
+    {
+        DWORD start;
+        int i;
+
+        /* typelib marshaled call */
+        start = GetTickCount();
+        for (i = 0; i < 10000; i++)
+            IWidget_get_State(pWidget, &the_state);
+        trace("10000 typelib marshaled calls took %u ms\n", GetTickCount() - start);
+
+        /* same property through the NDR generated IDispatch proxy */
+        dispparams.cNamedArgs = 0;
+        dispparams.rgdispidNamedArgs = NULL;
+        dispparams.cArgs = 0;
+        dispparams.rgvarg = NULL;
+        start = GetTickCount();
+        for (i = 0; i < 10000; i++)
+            IDispatch_Invoke(pDispatch, DISPID_TM_STATE, &IID_NULL, LOCALE_NEUTRAL, DISPATCH_PROPERTYGET,
+                             &dispparams, &varresult, &excepinfo, NULL);
+        trace("10000 IDispatch::Invoke calls took %u ms\n", GetTickCount() - start);
+    }
+
     IDispatch_Release(pDispatch);
     IWidget_Release(pWidget);
 
@@ -1729,6 +1881,97 @@ static void test_typelibmarshal(void)
     end_host_object(tid, thread);
 }
 
+static void test_simple_types(void)
+{
+    static const LARGE_INTEGER zero;
+    BSTR in, out, inout, str;
+    IVariantTypes *variant;
+    ISimpleTypes *simple, *out_iface;
+    IUnknown *inout_iface;
+    IStream *stream;
+    HANDLE thread;
+    double d;
+    DWORD tid;
+    HRESULT hr;
+    int i, len;
+
+    hr = CreateStreamOnHGlobal(NULL, TRUE, &stream);
+    ok_ole_success(hr, CreateStreamOnHGlobal);
+    tid = start_host_object(stream, &IID_ISimpleTypes, (IUnknown *)&SimpleTypes, MSHLFLAGS_NORMAL, &thread);
+    IStream_Seek(stream, zero, STREAM_SEEK_SET, NULL);
+    hr = CoUnmarshalInterface(stream, &IID_ISimpleTypes, (void **)&simple);
+    ok_ole_success(hr, CoUnmarshalInterface);
+    IStream_Release(stream);
+
+    d = 4.0;
+    i = 0;
+    hr = ISimpleTypes_BaseTypes(simple, 5, -3, 1.5, 2.5f, &i, &d);
+    ok_ole_success(hr, ISimpleTypes_BaseTypes);
+    ok(i == 2, "got %d\n", i);
+    ok(d == 9.5, "got %f\n", d);
+
+    in = SysAllocString(inW);
+    inout = SysAllocString(inoutW);
+    out = NULL;
+    hr = ISimpleTypes_Strings(simple, in, &out, &inout);
+    ok_ole_success(hr, ISimpleTypes_Strings);
+    ok(!lstrcmpW(in, inW), "got %s\n", wine_dbgstr_w(in));
+    ok(!lstrcmpW(out, outW), "got %s\n", wine_dbgstr_w(out));
+    ok(!lstrcmpW(inout, changedW), "got %s\n", wine_dbgstr_w(inout));
+    SysFreeString(in);
+    SysFreeString(out);
+    SysFreeString(inout);
+
+    out_iface = NULL;
+    inout_iface = (IUnknown *)simple;
+    ISimpleTypes_AddRef(simple);
+    hr = ISimpleTypes_Interfaces(simple, (IUnknown *)simple, &out_iface, &inout_iface);
+    ok_ole_success(hr, ISimpleTypes_Interfaces);
+    ok(out_iface == simple, "got %p, expected %p\n", out_iface, simple);
+    ok(!inout_iface, "got %p\n", inout_iface);
+    if (out_iface) ISimpleTypes_Release(out_iface);
+
+    str = SysAllocString(inoutW);
+    len = 0;
+    hr = ISimpleTypes_StrLen(simple, str, 2, &len);
+    ok_ole_success(hr, ISimpleTypes_StrLen);
+    ok(len == 7, "got %d\n", len);
+
+    /* IVariantTypes can't be described with format strings, so it still goes
+     * through the typelib marshaler, which is only implemented on i386 */
+    hr = ISimpleTypes_QueryInterface(simple, &IID_IVariantTypes, (void **)&variant);
+    if (hr == S_OK)
+    {
+        len = 0;
+        hr = IVariantTypes_StrLen(variant, str, 2, &len);
+        ok_ole_success(hr, IVariantTypes_StrLen);
+        ok(len == 7, "got %d\n", len);
+
+        if (winetest_interactive)
+        {
+            DWORD start;
+
+            start = GetTickCount();
+            for (i = 0; i < 10000; i++)
+                ISimpleTypes_StrLen(simple, str, 2, &len);
+            trace("10000 format string marshaled calls took %u ms\n", GetTickCount() - start);
+
+            start = GetTickCount();
+            for (i = 0; i < 10000; i++)
+                IVariantTypes_StrLen(variant, str, 2, &len);
+            trace("10000 typelib marshaled calls took %u ms\n", GetTickCount() - start);
+        }
+
+        IVariantTypes_Release(variant);
+    }
+    else
+        skip("IVariantTypes proxy not available, hr %#x\n", hr);
+
+    SysFreeString(str);
+    ISimpleTypes_Release(simple);
+    end_host_object(tid, thread);
+}
+
 static void test_DispCallFunc(void)
 {
     static const WCHAR szEmpty[] = { 0 };
@@ -1761,12 +2004,14 @@ static void test_DispCallFunc(void)
 
 static void test_StaticWidget(void)
 {
+    static const WCHAR testW[] = {'t','e','s','t',0};
     ITypeInfo *type_info;
     DISPPARAMS dispparams;
     VARIANTARG vararg[4];
     EXCEPINFO excepinfo;
     VARIANT varresult;
     HRESULT hr;
+    int i;
 
     type_info = get_type_info(&IID_IStaticWidget);
 
@@ -1798,6 +2043,49 @@ static void test_StaticWidget(void)
     ok(V_VT(&varresult) == VT_EMPTY, "vt %x\n", V_VT(&varresult));
     VariantClear(&varresult);
 
+    /* call StrLen, both with matching and with coerced argument types */
+    for (i = 0; i < 2; i++)
+    {
+        dispparams.cNamedArgs = 0;
+        dispparams.cArgs = 2;
+        dispparams.rgdispidNamedArgs = NULL;
+        dispparams.rgvarg = vararg;
+        V_VT(&vararg[1]) = VT_BSTR;
+        V_BSTR(&vararg[1]) = SysAllocString(testW);
+        if (i)
+        {
+            V_VT(&vararg[0]) = VT_R8;
+            V_R8(&vararg[0]) = 3.0;
+        }
+        else
+        {
+            V_VT(&vararg[0]) = VT_I4;
+            V_I4(&vararg[0]) = 3;
+        }
+        VariantInit(&varresult);
+        hr = ITypeInfo_Invoke(type_info, &StaticWidget, DISPID_TM_STRLEN, DISPATCH_METHOD,
+                &dispparams, &varresult, &excepinfo, NULL);
+        ok_ole_success(hr, IDispatch_Invoke);
+        ok(V_VT(&varresult) == VT_I4, "vt %x\n", V_VT(&varresult));
+        ok(V_I4(&varresult) == 7, "got %d\n", V_I4(&varresult));
+        SysFreeString(V_BSTR(&vararg[1]));
+    }
+
+    if (winetest_interactive)
+    {
+        DWORD start = GetTickCount();
+
+        V_VT(&vararg[1]) = VT_BSTR;
+        V_BSTR(&vararg[1]) = SysAllocString(testW);
+        V_VT(&vararg[0]) = VT_I4;
+        V_I4(&vararg[0]) = 3;
+        for (i = 0; i < 100000; i++)
+            ITypeInfo_Invoke(type_info, &StaticWidget, DISPID_TM_STRLEN, DISPATCH_METHOD,
+                    &dispparams, &varresult, &excepinfo, NULL);
+        trace("100000 invokes took %u ms\n", GetTickCount() - start);
+        SysFreeString(V_BSTR(&vararg[1]));
+    }
+
     ITypeInfo_Release(type_info);
 }
 
@@ -1947,6 +2235,7 @@ START_TEST(tmarshal)
     }
 
     test_typelibmarshal();
+    test_simple_types();
     test_DispCallFunc();
     test_StaticWidget();
     test_libattr();
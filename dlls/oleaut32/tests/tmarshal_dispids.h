@@ -44,6 +44,7 @@
 #define DISPID_TM_RESTRICTED 25
 #define DISPID_TM_NEG_RESTRICTED -26
 #define DISPID_TM_TESTSECONDIFACE 27
+#define DISPID_TM_STRLEN 28
 
 #define DISPID_NOA_BSTRRET 1
 #define DISPID_NOA_ERROR 2
@@ -4189,6 +4189,56 @@ static void test_LoadTypeLib(void)
     ok(hres == TYPE_E_CANTLOADLIBRARY, "LoadTypeLib returned: %08x, expected TYPE_E_CANTLOADLIBRARY\n", hres);
 }
 
+/* time loading a typelib and binding to its first interface, as done by
+ * scripting hosts on startup */
+static void test_LoadTypeLib_perf(void)
+{
+    static const WCHAR mshtml_tlbW[] = {'m','s','h','t','m','l','.','t','l','b',0};
+    static const WCHAR *libs[] = { wszStdOle2, mshtml_tlbW };
+    static OLECHAR invokeW[] = {'I','n','v','o','k','e',0};
+    OLECHAR *name = invokeW;
+    unsigned int i, j;
+    ITypeLib *tl;
+    ITypeInfo *ti;
+    TYPEATTR *attr;
+    MEMBERID memid;
+    DWORD start;
+    GUID guid;
+    HRESULT hr;
+
+    for (i = 0; i < sizeof(libs)/sizeof(libs[0]); i++)
+    {
+        hr = LoadTypeLib(libs[i], &tl);
+        if (FAILED(hr))
+        {
+            skip("can't load %s: %08x\n", wine_dbgstr_w(libs[i]), hr);
+            continue;
+        }
+
+        hr = ITypeLib_GetTypeInfo(tl, ITypeLib_GetTypeInfoCount(tl) - 1, &ti);
+        ok(hr == S_OK, "GetTypeInfo failed: %08x\n", hr);
+        hr = ITypeInfo_GetTypeAttr(ti, &attr);
+        ok(hr == S_OK, "GetTypeAttr failed: %08x\n", hr);
+        guid = attr->guid;
+        ITypeInfo_ReleaseTypeAttr(ti, attr);
+        ITypeInfo_Release(ti);
+        ITypeLib_Release(tl);
+
+        start = GetTickCount();
+        for (j = 0; j < 100; j++)
+        {
+            hr = LoadTypeLib(libs[i], &tl);
+            ok(hr == S_OK, "LoadTypeLib failed: %08x\n", hr);
+            hr = ITypeLib_GetTypeInfoOfGuid(tl, &guid, &ti);
+            ok(hr == S_OK, "GetTypeInfoOfGuid failed: %08x\n", hr);
+            ITypeInfo_GetIDsOfNames(ti, &name, 1, &memid);
+            ITypeInfo_Release(ti);
+            ITypeLib_Release(tl);
+        }
+        trace("%s: %u ms for 100 loads\n", wine_dbgstr_w(libs[i]), GetTickCount() - start);
+    }
+}
+
 static void test_SetVarHelpContext(void)
 {
     static OLECHAR nameW[] = {'n','a','m','e',0};
@@ -5253,6 +5303,8 @@ START_TEST(typelib)
     test_register_typelib(FALSE);
     test_create_typelibs();
     test_LoadTypeLib();
+    if (winetest_interactive)
+        test_LoadTypeLib_perf();
     test_TypeInfo2_GetContainingTypeLib();
     test_LoadRegTypeLib();
     test_GetLibAttr();
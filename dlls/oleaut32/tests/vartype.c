@@ -6077,11 +6077,18 @@ static void test_ChangeType_keep_dst(void)
      SysFreeString(bstr);
 }
 
+static DWORD WINAPI free_bstr_proc(void *arg)
+{
+    SysFreeString(arg);
+    return 0;
+}
+
 /* This tests assumes an empty cache, so it needs to be ran early in the test. */
 static void test_bstr_cache(void)
 {
     BSTR str, str2, strs[20];
-    unsigned i;
+    HANDLE thread;
+    unsigned i, j;
 
     static const WCHAR testW[] = {'t','e','s','t',0};
 
@@ -6096,8 +6103,29 @@ static void test_bstr_cache(void)
 
     str2 = SysAllocString(testW);
     ok(str == str2, "str != str2\n");
+
+    /* The string was freed twice, but it's handed out only once */
+    strs[0] = SysAllocString(testW);
+    ok(strs[0] != str2, "got the same string twice\n");
+    SysFreeString(strs[0]);
     SysFreeString(str2);
 
+    /* Same when the second free happens on another thread, which has its own cache */
+    str = SysAllocString(testW);
+    SysFreeString(str);
+    thread = CreateThread(NULL, 0, free_bstr_proc, str, 0, NULL);
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+
+    for(i=0; i < sizeof(strs)/sizeof(*strs); i++)
+        strs[i] = SysAllocString(testW);
+    for(i=0; i < sizeof(strs)/sizeof(*strs); i++) {
+        for(j=0; j < i; j++)
+            ok(strs[i] != strs[j], "strs[%u] == strs[%u]\n", i, j);
+    }
+    for(i=0; i < sizeof(strs)/sizeof(*strs); i++)
+        SysFreeString(strs[i]);
+
     /* Fill the bucket with cached entries. */
     for(i=0; i < sizeof(strs)/sizeof(*strs); i++)
         strs[i] = SysAllocStringLen(NULL, 24);
@@ -6118,6 +6146,51 @@ static void test_bstr_cache(void)
     SysFreeString(str2);
 }
 
+static DWORD WINAPI bstr_churn_proc(void *arg)
+{
+    BSTR strs[16];
+    unsigned i, j, failures = 0;
+
+    static const WCHAR testW[] = {'t','e','s','t',0};
+
+    for(i=0; i < 100000; i++) {
+        for(j=0; j < sizeof(strs)/sizeof(*strs); j++) {
+            strs[j] = SysAllocStringLen(NULL, 4 + (i+j) % 64);
+            memcpy(strs[j], testW, sizeof(testW));
+        }
+        for(j=0; j < sizeof(strs)/sizeof(*strs); j++) {
+            if(lstrcmpW(strs[j], testW))
+                failures++;
+            SysFreeString(strs[j]);
+        }
+    }
+
+    ok(!failures, "got %u unexpected strings\n", failures);
+    return 0;
+}
+
+static void test_bstr_cache_threads(void)
+{
+    HANDLE threads[8];
+    DWORD start, ticks, base = 0;
+    unsigned i, thread_cnt;
+
+    for(thread_cnt = 1; thread_cnt <= sizeof(threads)/sizeof(*threads); thread_cnt *= 2) {
+        start = GetTickCount();
+        for(i=0; i < thread_cnt; i++)
+            threads[i] = CreateThread(NULL, 0, bstr_churn_proc, NULL, 0, NULL);
+        WaitForMultipleObjects(thread_cnt, threads, TRUE, INFINITE);
+        ticks = GetTickCount() - start;
+        for(i=0; i < thread_cnt; i++)
+            CloseHandle(threads[i]);
+
+        if(thread_cnt == 1)
+            base = ticks;
+        trace("%u threads: %u ms (%.2fx throughput)\n", thread_cnt, ticks,
+              ticks ? (double)base * thread_cnt / ticks : 0.0);
+    }
+}
+
 START_TEST(vartype)
 {
   hOleaut32 = GetModuleHandleA("oleaut32.dll");
@@ -6129,6 +6202,8 @@ START_TEST(vartype)
         GetUserDefaultLCID());
 
   test_bstr_cache();
+  if(winetest_interactive)
+      test_bstr_cache_threads();
 
   test_VarI1FromI2();
   test_VarI1FromI4();
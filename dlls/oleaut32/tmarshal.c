@@ -54,6 +54,12 @@ static const WCHAR IDispatchW[] = { 'I','D','i','s','p','a','t','c','h',0};
 WINE_DEFAULT_DEBUG_CHANNEL(ole);
 WINE_DECLARE_DEBUG_CHANNEL(olerelay);
 
+/* implemented in rpcrt4, but not declared in rpcproxy.h */
+extern HRESULT WINAPI CreateProxyFromTypeInfo(ITypeInfo *typeinfo, IUnknown *outer, REFIID iid,
+                                              IRpcProxyBuffer **proxy, void **obj);
+extern HRESULT WINAPI CreateStubFromTypeInfo(ITypeInfo *typeinfo, REFIID iid, IUnknown *server,
+                                             IRpcStubBuffer **stub);
+
 static HRESULT TMarshalDispatchChannel_Create(
     IRpcChannelBuffer *pDelegateChannel, REFIID tmarshal_riid,
     IRpcChannelBuffer **ppChannel);
@@ -436,6 +442,18 @@ typedef struct _TMAsmProxy {
 } TMAsmProxy;
 #endif
 
+/* Per-method description, built from the typeinfo on first use and
+ * kept for the lifetime of the proxy or stub. */
+typedef struct _TMMethod {
+    ITypeInfo		*tinfo;		/* typeinfo declaring the method */
+    const FUNCDESC	*fdesc;
+    BSTR		iname;
+    BSTR		fname;
+    BSTR		names[10];
+    UINT		nrofnames;
+    DWORD		nrofargs;	/* stack slots, not including This */
+} TMMethod;
+
 typedef struct _TMProxyImpl {
     LPVOID                             *lpvtbl;
     IRpcProxyBuffer                     IRpcProxyBuffer_iface;
@@ -449,6 +467,8 @@ typedef struct _TMProxyImpl {
     IUnknown				*outerunknown;
     IDispatch				*dispatch;
     IRpcProxyBuffer			*dispatch_proxy;
+    TMMethod				**methods;
+    unsigned int			nrofmethods;
 } TMProxyImpl;
 
 static inline TMProxyImpl *impl_from_IRpcProxyBuffer( IRpcProxyBuffer *iface )
@@ -480,6 +500,8 @@ TMProxyImpl_AddRef(LPRPCPROXYBUFFER iface)
     return refCount;
 }
 
+static void free_methods(TMMethod **methods, unsigned int count);
+
 static ULONG WINAPI
 TMProxyImpl_Release(LPRPCPROXYBUFFER iface)
 {
@@ -496,6 +518,7 @@ TMProxyImpl_Release(LPRPCPROXYBUFFER iface)
         if (This->chanbuf) IRpcChannelBuffer_Release(This->chanbuf);
         VirtualFree(This->asmstubs, 0, MEM_RELEASE);
         HeapFree(GetProcessHeap(), 0, This->lpvtbl);
+        free_methods(This->methods, This->nrofmethods);
         ITypeInfo_Release(This->tinfo);
         CoTaskMemFree(This);
     }
@@ -1325,6 +1348,75 @@ static HRESULT get_funcdesc(ITypeInfo *tinfo, int iMethod, ITypeInfo **tactual,
     return S_OK;
 }
 
+static void free_method(TMMethod *method)
+{
+    UINT i;
+
+    for (i = 0; i < method->nrofnames; i++)
+        SysFreeString(method->names[i]);
+    SysFreeString(method->iname);
+    SysFreeString(method->fname);
+    ITypeInfo_Release(method->tinfo);
+    HeapFree(GetProcessHeap(), 0, method);
+}
+
+static void free_methods(TMMethod **methods, unsigned int count)
+{
+    unsigned int i;
+
+    if (!methods) return;
+    for (i = 0; i < count; i++)
+        if (methods[i]) free_method(methods[i]);
+    HeapFree(GetProcessHeap(), 0, methods);
+}
+
+/* Returns the cached description of a method, building it on first use so
+ * that calls don't have to walk the inheritance chain and fetch names again. */
+static HRESULT get_method(ITypeInfo *tinfo, TMMethod **methods, unsigned int count,
+                          int iMethod, const TMMethod **ret)
+{
+    TMMethod *method;
+    HRESULT hr;
+    int i;
+
+    if (iMethod < 0 || iMethod >= count)
+        return E_INVALIDARG;
+
+    if ((method = methods[iMethod]))
+    {
+        *ret = method;
+        return S_OK;
+    }
+
+    method = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*method));
+    if (!method) return E_OUTOFMEMORY;
+
+    hr = get_funcdesc(tinfo, iMethod, &method->tinfo, &method->fdesc, &method->iname, &method->fname, NULL);
+    if (hr)
+    {
+        HeapFree(GetProcessHeap(), 0, method);
+        return hr;
+    }
+
+    /* Needed for relay traces and error messages */
+    if (ITypeInfo_GetNames(method->tinfo, method->fdesc->memid, method->names,
+                           sizeof(method->names)/sizeof(method->names[0]), &method->nrofnames))
+        method->nrofnames = 0;
+    if (method->nrofnames > sizeof(method->names)/sizeof(method->names[0]))
+        ERR("Need more names!\n");
+
+    for (i = 0; i < method->fdesc->cParams; i++)
+        method->nrofargs += _argsize(&method->fdesc->lprgelemdescParam[i].tdesc, method->tinfo);
+
+    if (InterlockedCompareExchangePointer((void **)&methods[iMethod], method, NULL))
+    {
+        free_method(method);
+        method = methods[iMethod];
+    }
+    *ret = method;
+    return S_OK;
+}
+
 static inline BOOL is_in_elem(const ELEMDESC *elem)
 {
     return (elem->u.paramdesc.wParamFlags & PARAMFLAG_FIN || !elem->u.paramdesc.wParamFlags);
@@ -1339,32 +1431,34 @@ static DWORD WINAPI xCall(int method, void **args)
 {
     TMProxyImpl *tpinfo = args[0];
     DWORD *xargs;
+    const TMMethod	*tmmethod;
     const FUNCDESC	*fdesc;
     HRESULT		hres;
     int			i;
     marshal_state	buf;
     RPCOLEMESSAGE	msg;
     ULONG		status;
-    BSTR		fname,iname;
-    BSTR		names[10];
+    BSTR const		*names;
     UINT		nrofnames;
     DWORD		remoteresult = 0;
     ITypeInfo 		*tinfo;
     IRpcChannelBuffer *chanbuf;
 
-    EnterCriticalSection(&tpinfo->crit);
-
-    hres = get_funcdesc(tpinfo->tinfo,method,&tinfo,&fdesc,&iname,&fname,NULL);
+    hres = get_method(tpinfo->tinfo,tpinfo->methods,tpinfo->nrofmethods,method,&tmmethod);
     if (hres) {
         ERR("Did not find typeinfo/funcdesc entry for method %d!\n",method);
-        LeaveCriticalSection(&tpinfo->crit);
         return E_FAIL;
     }
+    tinfo = tmmethod->tinfo;
+    fdesc = tmmethod->fdesc;
+    names = tmmethod->names;
+    nrofnames = tmmethod->nrofnames;
+
+    EnterCriticalSection(&tpinfo->crit);
 
     if (!tpinfo->chanbuf)
     {
         WARN("Tried to use disconnected proxy\n");
-        ITypeInfo_Release(tinfo);
         LeaveCriticalSection(&tpinfo->crit);
         return RPC_E_DISCONNECTED;
     }
@@ -1375,29 +1469,18 @@ static DWORD WINAPI xCall(int method, void **args)
 
     if (TRACE_ON(olerelay)) {
        TRACE_(olerelay)("->");
-	if (iname)
-	    TRACE_(olerelay)("%s:",relaystr(iname));
-	if (fname)
-	    TRACE_(olerelay)("%s(%d)",relaystr(fname),method);
+	if (tmmethod->iname)
+	    TRACE_(olerelay)("%s:",relaystr(tmmethod->iname));
+	if (tmmethod->fname)
+	    TRACE_(olerelay)("%s(%d)",relaystr(tmmethod->fname),method);
 	else
 	    TRACE_(olerelay)("%d",method);
 	TRACE_(olerelay)("(");
     }
 
-    SysFreeString(iname);
-    SysFreeString(fname);
-
     memset(&buf,0,sizeof(buf));
 
     /* normal typelib driven serializing */
-
-    /* Need them for hack below */
-    memset(names,0,sizeof(names));
-    if (ITypeInfo_GetNames(tinfo,fdesc->memid,names,sizeof(names)/sizeof(names[0]),&nrofnames))
-	nrofnames = 0;
-    if (nrofnames > sizeof(names)/sizeof(names[0]))
-	ERR("Need more names!\n");
-
     xargs = (DWORD *)(args + 1);
     for (i=0;i<fdesc->cParams;i++) {
 	ELEMDESC	*elem = fdesc->lprgelemdescParam+i;
@@ -1505,11 +1588,8 @@ static DWORD WINAPI xCall(int method, void **args)
 
 exit:
     IRpcChannelBuffer_FreeBuffer(chanbuf,&msg);
-    for (i = 0; i < nrofnames; i++)
-        SysFreeString(names[i]);
     HeapFree(GetProcessHeap(),0,buf.base);
     IRpcChannelBuffer_Release(chanbuf);
-    ITypeInfo_Release(tinfo);
     TRACE("-- 0x%08x\n", hres);
     return hres;
 }
@@ -1722,23 +1802,21 @@ static inline HRESULT get_facbuf_for_iid(REFIID riid, IPSFactoryBuffer **facbuf)
 
 static HRESULT init_proxy_entry_point(TMProxyImpl *proxy, unsigned int num)
 {
-    int j;
     /* nrofargs including This */
-    int nrofargs = 1;
-    ITypeInfo *tinfo2;
+    int nrofargs;
     TMAsmProxy	*xasm = proxy->asmstubs + num;
     HRESULT hres;
+    const TMMethod *method;
     const FUNCDESC *fdesc;
 
-    hres = get_funcdesc(proxy->tinfo, num, &tinfo2, &fdesc, NULL, NULL, NULL);
+    hres = get_method(proxy->tinfo, proxy->methods, proxy->nrofmethods, num, &method);
     if (hres) {
         ERR("GetFuncDesc %x should not fail here.\n",hres);
         return hres;
     }
-    ITypeInfo_Release(tinfo2);
+    fdesc = method->fdesc;
     /* some args take more than 4 byte on the stack */
-    for (j=0;j<fdesc->cParams;j++)
-        nrofargs += _argsize(&fdesc->lprgelemdescParam[j].tdesc, proxy->tinfo);
+    nrofargs = method->nrofargs + 1;
 
 #ifdef __i386__
     if (fdesc->callconv != CC_STDCALL) {
@@ -1787,6 +1865,15 @@ PSFacBuf_CreateProxy(
 	return hres;
     }
 
+    /* let rpcrt4 marshal the interface with NDR format strings when it can
+     * describe all of its methods */
+    hres = CreateProxyFromTypeInfo(tinfo, pUnkOuter, riid, ppProxy, ppv);
+    if (hres != E_NOTIMPL)
+    {
+        ITypeInfo_Release(tinfo);
+        return hres;
+    }
+
     hres = num_of_funcs(tinfo, &nroffuncs, &vtbl_size);
     TRACE("Got %d funcs, vtbl size %d\n", nroffuncs, vtbl_size);
 
@@ -1820,6 +1907,13 @@ PSFacBuf_CreateProxy(
 
     proxy->lpvtbl = HeapAlloc(GetProcessHeap(), 0, vtbl_size);
 
+    proxy->nrofmethods = nroffuncs;
+    proxy->methods = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, nroffuncs * sizeof(*proxy->methods));
+    if (!proxy->methods) {
+        TMProxyImpl_Release(&proxy->IRpcProxyBuffer_iface);
+        return E_OUTOFMEMORY;
+    }
+
     /* if we derive from IDispatch then defer to its proxy for its methods */
     hres = ITypeInfo_GetTypeAttr(tinfo, &typeattr);
     if (hres == S_OK)
@@ -1901,6 +1995,8 @@ typedef struct _TMStubImpl {
     IID				iid;
     IRpcStubBuffer		*dispatch_stub;
     BOOL			dispatch_derivative;
+    TMMethod			**methods;
+    unsigned int		nrofmethods;
 } TMStubImpl;
 
 static inline TMStubImpl *impl_from_IRpcStubBuffer(IRpcStubBuffer *iface)
@@ -1945,6 +2041,7 @@ TMStubImpl_Release(LPRPCSTUBBUFFER iface)
         ITypeInfo_Release(This->tinfo);
         if (This->dispatch_stub)
             IRpcStubBuffer_Release(This->dispatch_stub);
+        free_methods(This->methods, This->nrofmethods);
         CoTaskMemFree(This);
     }
     return refCount;
@@ -1989,15 +2086,14 @@ TMStubImpl_Invoke(
 {
 #ifdef __i386__
     int		i;
+    const TMMethod *method;
     const FUNCDESC *fdesc;
     TMStubImpl *This = impl_from_IRpcStubBuffer(iface);
     HRESULT	hres;
     DWORD	*args = NULL, res, *xargs, nrofargs;
     marshal_state	buf;
-    UINT	nrofnames = 0;
-    BSTR	names[10];
-    BSTR	iname = NULL;
-    ITypeInfo 	*tinfo = NULL;
+    BSTR const	*names;
+    ITypeInfo 	*tinfo;
 
     TRACE("...\n");
 
@@ -2024,39 +2120,30 @@ TMStubImpl_Invoke(
         return IRpcStubBuffer_Invoke(This->dispatch_stub, xmsg, rpcchanbuf);
     }
 
-    memset(&buf,0,sizeof(buf));
-    buf.size	= xmsg->cbBuffer;
-    buf.base	= HeapAlloc(GetProcessHeap(), 0, xmsg->cbBuffer);
-    memcpy(buf.base, xmsg->Buffer, xmsg->cbBuffer);
-    buf.curoff	= 0;
-
-    hres = get_funcdesc(This->tinfo,xmsg->iMethod,&tinfo,&fdesc,&iname,NULL,NULL);
+    hres = get_method(This->tinfo,This->methods,This->nrofmethods,xmsg->iMethod,&method);
     if (hres) {
 	ERR("GetFuncDesc on method %d failed with %x\n",xmsg->iMethod,hres);
 	return hres;
     }
 
-    if (iname && !lstrcmpW(iname, IDispatchW))
+    if (method->iname && !lstrcmpW(method->iname, IDispatchW))
     {
         ERR("IDispatch cannot be marshaled by the typelib marshaler\n");
-        hres = E_UNEXPECTED;
-        SysFreeString (iname);
-        goto exit;
+        return E_UNEXPECTED;
     }
 
-    SysFreeString (iname);
+    tinfo = method->tinfo;
+    fdesc = method->fdesc;
+    names = method->names;
+    nrofargs = method->nrofargs;
 
-    /* Need them for hack below */
-    memset(names,0,sizeof(names));
-    ITypeInfo_GetNames(tinfo,fdesc->memid,names,sizeof(names)/sizeof(names[0]),&nrofnames);
-    if (nrofnames > sizeof(names)/sizeof(names[0])) {
-	ERR("Need more names!\n");
-    }
+    memset(&buf,0,sizeof(buf));
+    buf.size	= xmsg->cbBuffer;
+    buf.base	= HeapAlloc(GetProcessHeap(), 0, xmsg->cbBuffer);
+    memcpy(buf.base, xmsg->Buffer, xmsg->cbBuffer);
+    buf.curoff	= 0;
 
     /*dump_FUNCDESC(fdesc);*/
-    nrofargs = 0;
-    for (i=0;i<fdesc->cParams;i++)
-	nrofargs += _argsize(&fdesc->lprgelemdescParam[i].tdesc, tinfo);
     args = HeapAlloc(GetProcessHeap(),HEAP_ZERO_MEMORY,(nrofargs+1)*sizeof(DWORD));
     if (!args)
     {
@@ -2145,10 +2232,6 @@ TMStubImpl_Invoke(
         memcpy(xmsg->Buffer, buf.base, buf.curoff);
 
 exit:
-    for (i = 0; i < nrofnames; i++)
-        SysFreeString(names[i]);
-
-    ITypeInfo_Release(tinfo);
     HeapFree(GetProcessHeap(), 0, args);
 
     HeapFree(GetProcessHeap(), 0, buf.base);
@@ -2216,6 +2299,14 @@ PSFacBuf_CreateStub(
 	return hres;
     }
 
+    /* this must make the same choice as PSFacBuf_CreateProxy */
+    hres = CreateStubFromTypeInfo(tinfo, riid, pUnkServer, ppStub);
+    if (hres != E_NOTIMPL)
+    {
+        ITypeInfo_Release(tinfo);
+        return hres;
+    }
+
     stub = CoTaskMemAlloc(sizeof(TMStubImpl));
     if (!stub)
 	return E_OUTOFMEMORY;
@@ -2225,6 +2316,16 @@ PSFacBuf_CreateStub(
     stub->dispatch_stub = NULL;
     stub->dispatch_derivative = FALSE;
     stub->iid		= *riid;
+    stub->methods	= NULL;
+    if (SUCCEEDED(num_of_funcs(tinfo, &stub->nrofmethods, NULL)))
+        stub->methods = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                  stub->nrofmethods * sizeof(*stub->methods));
+    if (!stub->methods)
+    {
+        ITypeInfo_Release(tinfo);
+        CoTaskMemFree(stub);
+        return E_OUTOFMEMORY;
+    }
     hres = IRpcStubBuffer_Connect(&stub->IRpcStubBuffer_iface,pUnkServer);
     *ppStub = &stub->IRpcStubBuffer_iface;
     TRACE("IRpcStubBuffer: %p\n", stub);
@@ -1103,12 +1103,13 @@ typedef struct tagITypeLibImpl
 				   typelibs */
     struct list ref_list;       /* list of ref types in this typelib */
     HREFTYPE dispatch_href;     /* reference to IDispatch, -1 if unused */
+    struct tagMSFT_Image *msft_image; /* mapped image, kept while members are not loaded */
 
-
-    /* typelibs are cached, keyed by path and index, so store the linked list info within them */
+    /* typelibs are cached, keyed by path, index and modification time, so store the linked list info within them */
     struct list entry;
     WCHAR *path;
     INT index;
+    FILETIME mtime;
 } ITypeLibImpl;
 
 static const ITypeLib2Vtbl tlbvt;
@@ -1136,7 +1137,7 @@ static inline ITypeLibImpl *impl_from_ICreateTypeLib2( ICreateTypeLib2 *iface )
 }
 
 /* ITypeLib methods */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength);
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *pFile);
 static ITypeLib2* ITypeLib2_Constructor_SLTG(LPVOID pLib, DWORD dwTLBLength);
 
 /*======================= ITypeInfo implementation =======================*/
@@ -1183,6 +1184,7 @@ typedef struct tagTLBFuncDesc
     const TLBString *HelpString;
     const TLBString *Entry;            /* if IS_INTRESOURCE true, it's numeric; if -1 it isn't present */
     struct list custdata_list;
+    struct tagTLBInvokePlan *invoke_plan; /* argument types cached by ITypeInfo::Invoke */
 } TLBFuncDesc;
 
 /* internal Variable data */
@@ -1252,6 +1254,10 @@ typedef struct tagITypeInfoImpl
     /* variables  */
     TLBVarDesc *vardescs;
 
+    /* MSFT typelibs read functions and variables on first use */
+    LONG members_pending;
+    int memoffset;
+
     /* Implemented Interfaces  */
     TLBImplType *impltypes;
 
@@ -1296,6 +1302,24 @@ typedef struct tagTLBContext
 	ITypeLibImpl* pLibInfo;
 } TLBContext;
 
+/* MSFT image data needed to read members of typeinfos on demand */
+typedef struct tagMSFT_Image
+{
+    IUnknown *file;       /* keeps the mapping alive */
+    void *mapping;
+    unsigned int length;
+    MSFT_SegDir segdir;
+    LONG pending;         /* number of typeinfos with members not yet read */
+
+    /* name, string and guid lists sorted by offset */
+    TLBString **names;
+    TLBString **strings;
+    TLBGuid **guids;
+    int name_cnt;
+    int string_cnt;
+    int guid_cnt;
+} MSFT_Image;
+
 
 static inline BSTR TLB_get_bstr(const TLBString *str)
 {
@@ -1536,6 +1560,8 @@ static void dump_Variant(const VARIANT * pvar)
 {
     SYSTEMTIME st;
 
+    if (!TRACE_ON(ole)) return;
+
     TRACE("%p->{%s%s", pvar, debugstr_VT(pvar), debugstr_VF(pvar));
 
     if (pvar)
@@ -1591,6 +1617,8 @@ static void dump_DispParms(const DISPPARAMS * pdp)
 {
     unsigned int index;
 
+    if (!TRACE_ON(ole)) return;
+
     TRACE("args=%u named args=%u\n", pdp->cArgs, pdp->cNamedArgs);
 
     if (pdp->cNamedArgs && pdp->rgdispidNamedArgs)
@@ -1618,9 +1646,14 @@ static void dump_TypeInfo(const ITypeInfoImpl * pty)
     TRACE("wTypeFlags: 0x%04x\n", pty->wTypeFlags);
     TRACE("parent tlb:%p index in TLB:%u\n",pty->pTypeLib, pty->index);
     if (pty->typekind == TKIND_MODULE) TRACE("dllname:%s\n", debugstr_w(TLB_get_bstr(pty->DllName)));
-    if (TRACE_ON(ole))
-        dump_TLBFuncDesc(pty->funcdescs, pty->cFuncs);
-    dump_TLBVarDesc(pty->vardescs, pty->cVars);
+    if (pty->members_pending)
+        TRACE("members not read yet\n");
+    else
+    {
+        if (TRACE_ON(ole))
+            dump_TLBFuncDesc(pty->funcdescs, pty->cFuncs);
+        dump_TLBVarDesc(pty->vardescs, pty->cVars);
+    }
     dump_TLBImplType(pty->impltypes, pty->cImplTypes);
 }
 
@@ -2182,8 +2215,27 @@ static HRESULT MSFT_ReadAllGuids(TLBContext *pcx)
 
 static TLBGuid *MSFT_ReadGuid( int offset, TLBContext *pcx)
 {
+    MSFT_Image *image = pcx->pLibInfo->msft_image;
     TLBGuid *ret;
 
+    if(image && image->guids){
+        int min = 0, max = image->guid_cnt - 1, i;
+
+        while(min <= max){
+            i = (min + max) / 2;
+            ret = image->guids[i];
+            if(ret->offset == offset){
+                TRACE_(typelib)("%s\n", debugstr_guid(&ret->guid));
+                return ret;
+            }
+            if(ret->offset < offset)
+                min = i + 1;
+            else
+                max = i - 1;
+        }
+        return NULL;
+    }
+
     LIST_FOR_EACH_ENTRY(ret, &pcx->pLibInfo->guid_list, TLBGuid, entry){
         if(ret->offset == offset){
             TRACE_(typelib)("%s\n", debugstr_guid(&ret->guid));
@@ -2257,10 +2309,33 @@ static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
     }
 }
 
+static TLBString *MSFT_FindString(TLBString **strs, int cnt, int offset)
+{
+    int min = 0, max = cnt - 1, i;
+
+    while(min <= max) {
+        i = (min + max) / 2;
+        if (strs[i]->offset == offset) {
+            TRACE_(typelib)("%s\n", debugstr_w(strs[i]->str));
+            return strs[i];
+        }
+        if (strs[i]->offset < offset)
+            min = i + 1;
+        else
+            max = i - 1;
+    }
+
+    return NULL;
+}
+
 static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
 {
+    MSFT_Image *image = pcx->pLibInfo->msft_image;
     TLBString *tlbstr;
 
+    if (image && image->names)
+        return MSFT_FindString(image->names, image->name_cnt, offset);
+
     LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->name_list, TLBString, entry) {
         if (tlbstr->offset == offset) {
             TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
@@ -2273,8 +2348,12 @@ static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
 
 static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
 {
+    MSFT_Image *image = pcx->pLibInfo->msft_image;
     TLBString *tlbstr;
 
+    if (image && image->strings)
+        return MSFT_FindString(image->strings, image->string_cnt, offset);
+
     LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->string_list, TLBString, entry) {
         if (tlbstr->offset == offset) {
             TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
@@ -2730,6 +2809,108 @@ static void TLB_fix_32on64_typeinfo(ITypeInfoImpl *info)
 }
 #endif
 
+static CRITICAL_SECTION members_section;
+static CRITICAL_SECTION_DEBUG members_section_debug =
+{
+    0, 0, &members_section,
+    { &members_section_debug.ProcessLocksList, &members_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": typeinfo members") }
+};
+static CRITICAL_SECTION members_section = { &members_section_debug, -1, 0, 0, 0, 0 };
+
+static void MSFT_FreeImage(MSFT_Image *image)
+{
+    if (image->file)
+        IUnknown_Release(image->file);
+    heap_free(image->names);
+    heap_free(image->strings);
+    heap_free(image->guids);
+    heap_free(image);
+}
+
+static TLBString **MSFT_IndexStrings(struct list *list, int *cnt)
+{
+    TLBString **ret, *str;
+    int i = 0;
+
+    *cnt = list_count(list);
+    ret = heap_alloc(*cnt * sizeof(*ret));
+    if (!ret)
+        return NULL;
+
+    /* strings are read in order, so the list is already sorted by offset */
+    LIST_FOR_EACH_ENTRY(str, list, TLBString, entry)
+        ret[i++] = str;
+
+    return ret;
+}
+
+static TLBGuid **MSFT_IndexGuids(struct list *list, int *cnt)
+{
+    TLBGuid **ret, *guid;
+    int i = 0;
+
+    *cnt = list_count(list);
+    ret = heap_alloc(*cnt * sizeof(*ret));
+    if (!ret)
+        return NULL;
+
+    LIST_FOR_EACH_ENTRY(guid, list, TLBGuid, entry)
+        ret[i++] = guid;
+
+    return ret;
+}
+
+/* reads functions and variables of a typeinfo, called with members_section held
+ * or while the typelib is still being constructed */
+static void MSFT_DoMembers(TLBContext *pcx, ITypeInfoImpl *pTI)
+{
+    if (!pTI->members_pending)
+        return;
+
+    if(pTI->cFuncs > 0)
+        MSFT_DoFuncs(pcx, pTI, pTI->cFuncs, pTI->cVars, pTI->memoffset, &pTI->funcdescs);
+    if(pTI->cVars > 0)
+        MSFT_DoVars(pcx, pTI, pTI->cFuncs, pTI->cVars, pTI->memoffset, &pTI->vardescs);
+
+    pcx->pLibInfo->msft_image->pending--;
+    InterlockedExchange(&pTI->members_pending, FALSE);
+}
+
+static void TLB_load_members(ITypeInfoImpl *This)
+{
+    ITypeLibImpl *lib = This->pTypeLib;
+    MSFT_Image *image;
+    TLBContext cx;
+
+    if (!This->members_pending)
+        return;
+
+    EnterCriticalSection(&members_section);
+    if (This->members_pending)
+    {
+        image = lib->msft_image;
+
+        TRACE_(typelib)("reading members of %s\n", debugstr_w(TLB_get_bstr(This->Name)));
+
+        cx.oStart = 0;
+        cx.pos = 0;
+        cx.length = image->length;
+        cx.mapping = image->mapping;
+        cx.pTblDir = &image->segdir;
+        cx.pLibInfo = lib;
+        MSFT_DoMembers(&cx, This);
+
+        /* the image is not needed any more once all members are read */
+        if (!image->pending)
+        {
+            lib->msft_image = NULL;
+            MSFT_FreeImage(image);
+        }
+    }
+    LeaveCriticalSection(&members_section);
+}
+
 /*
  * process a typeinfo record
  */
@@ -2789,16 +2970,13 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
 /* note: InfoType's Help file and HelpStringDll come from the containing
  * library. Further HelpString and Docstring appear to be the same thing :(
  */
-    /* functions */
-    if(ptiRet->cFuncs >0 )
-        MSFT_DoFuncs(pcx, ptiRet, ptiRet->cFuncs,
-		    ptiRet->cVars,
-		    tiBase.memoffset, &ptiRet->funcdescs);
-    /* variables */
-    if(ptiRet->cVars >0 )
-        MSFT_DoVars(pcx, ptiRet, ptiRet->cFuncs,
-		   ptiRet->cVars,
-		   tiBase.memoffset, &ptiRet->vardescs);
+    /* functions and variables are read on first use */
+    ptiRet->memoffset = tiBase.memoffset;
+    if(ptiRet->cFuncs > 0 || ptiRet->cVars > 0)
+    {
+        ptiRet->members_pending = TRUE;
+        pLibInfo->msft_image->pending++;
+    }
     if(ptiRet->cImplTypes >0 ) {
         switch(ptiRet->typekind)
         {
@@ -2832,7 +3010,10 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
        debugstr_guid(TLB_get_guidref(ptiRet->guid)),
        typekind_desc[ptiRet->typekind]);
     if (TRACE_ON(typelib))
+    {
+      MSFT_DoMembers(pcx, ptiRet);
       dump_TypeInfo(ptiRet);
+    }
 
     return ptiRet;
 }
@@ -3370,6 +3551,7 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
     LPVOID pBase = NULL;
     DWORD dwTLBLength = 0;
     IUnknown *pFile = NULL;
+    FILETIME mtime = { 0 };
     HANDLE h;
 
     *ppTypeLib = NULL;
@@ -3405,7 +3587,8 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
 
     if(file != pszFileName) heap_free(file);
 
-    h = CreateFileW(pszPath, GENERIC_READ, 0, NULL, OPEN_ALWAYS,
+    /* loaded typelibs may keep the file mapped, so share it for reading */
+    h = CreateFileW(pszPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_ALWAYS,
             FILE_ATTRIBUTE_NORMAL, NULL);
     if(h != INVALID_HANDLE_VALUE){
         FILE_NAME_INFORMATION *info;
@@ -3420,16 +3603,19 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
             info->FileName[info->FileNameLength / sizeof(WCHAR)] = 0;
             lstrcpynW(pszPath + 2, info->FileName, cchPath - 2);
         }
+        GetFileTime(h, NULL, NULL, &mtime);
         CloseHandle(h);
     }
 
     TRACE_(typelib)("File %s index %d\n", debugstr_w(pszPath), index);
 
-    /* We look the path up in the typelib cache. If found, we just addref it, and return the pointer. */
+    /* We look the path up in the typelib cache. If found, we just addref it, and return the pointer.
+     * A typelib that was rewritten since it was cached is loaded again. */
     EnterCriticalSection(&cache_section);
     LIST_FOR_EACH_ENTRY(entry, &tlb_cache, ITypeLibImpl, entry)
     {
-        if (!strcmpiW(entry->path, pszPath) && entry->index == index)
+        if (!strcmpiW(entry->path, pszPath) && entry->index == index &&
+            !CompareFileTime(&entry->mtime, &mtime))
         {
             TRACE("cache hit\n");
             *ppTypeLib = &entry->ITypeLib2_iface;
@@ -3453,7 +3639,7 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
         {
             DWORD dwSignature = FromLEDWord(*((DWORD*) pBase));
             if (dwSignature == MSFT_SIGNATURE)
-                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength);
+                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength, pFile);
             else if (dwSignature == SLTG_SIGNATURE)
                 *ppTypeLib = ITypeLib2_Constructor_SLTG(pBase, dwTLBLength);
             else
@@ -3475,11 +3661,31 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
 	lstrcpyW(impl->path, pszPath);
 	/* We should really canonicalise the path here. */
         impl->index = index;
+        impl->mtime = mtime;
 
-        /* FIXME: check if it has added already in the meantime */
         EnterCriticalSection(&cache_section);
-        list_add_head(&tlb_cache, &impl->entry);
-        LeaveCriticalSection(&cache_section);
+        /* another thread may have loaded the same typelib in the meantime */
+        LIST_FOR_EACH_ENTRY(entry, &tlb_cache, ITypeLibImpl, entry)
+        {
+            if (!strcmpiW(entry->path, pszPath) && entry->index == index &&
+                !CompareFileTime(&entry->mtime, &mtime))
+            {
+                ITypeLib2_AddRef(&entry->ITypeLib2_iface);
+                break;
+            }
+        }
+        if (&entry->entry != &tlb_cache)
+        {
+            LeaveCriticalSection(&cache_section);
+            TRACE("cache hit\n");
+            ITypeLib2_Release(*ppTypeLib);
+            *ppTypeLib = &entry->ITypeLib2_iface;
+        }
+        else
+        {
+            list_add_head(&tlb_cache, &impl->entry);
+            LeaveCriticalSection(&cache_section);
+        }
         ret = S_OK;
     }
     else
@@ -3523,14 +3729,20 @@ static ITypeLibImpl* TypeLibImpl_Constructor(void)
  *	ITypeLib2_Constructor_MSFT
  *
  * loading an MSFT typelib from an in-memory image
+ *
+ * Functions and variables of the typeinfos are read on first use, pFile
+ * keeps the image mapped until then. If pFile is NULL, everything is read
+ * immediately.
  */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *pFile)
 {
     TLBContext cx;
     LONG lPSegDir;
     MSFT_Header tlbHeader;
     MSFT_SegDir tlbSegDir;
     ITypeLibImpl * pTypeLibImpl;
+    MSFT_Image *image;
+    BOOL load_all = !pFile || TRACE_ON(typelib);
     int i;
 
     TRACE("%p, TLB length = %d\n", pLib, dwTLBLength);
@@ -3555,6 +3767,16 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     }
     TRACE_(typelib)("\tdispatchpos = 0x%x\n", tlbHeader.dispatchpos);
 
+    image = heap_alloc_zero(sizeof(*image));
+    if (!image)
+    {
+        heap_free(pTypeLibImpl);
+        return NULL;
+    }
+    image->mapping = pLib;
+    image->length = dwTLBLength;
+    pTypeLibImpl->msft_image = image;
+
     /* there is a small amount of information here until the next important
      * part:
      * the segment directory . Try to calculate the amount of data */
@@ -3563,12 +3785,14 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     /* now read the segment directory */
     TRACE("read segment directory (at %d)\n",lPSegDir);
     MSFT_ReadLEDWords(&tlbSegDir, sizeof(tlbSegDir), &cx, lPSegDir);
-    cx.pTblDir = &tlbSegDir;
+    image->segdir = tlbSegDir;
+    cx.pTblDir = &image->segdir;
 
     /* just check two entries */
     if ( tlbSegDir.pTypeInfoTab.res0c != 0x0F || tlbSegDir.pImpInfo.res0c != 0x0F)
     {
         ERR("cannot find the table directory, ptr=0x%x\n",lPSegDir);
+        MSFT_FreeImage(image);
 	heap_free(pTypeLibImpl);
 	return NULL;
     }
@@ -3577,6 +3801,11 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     MSFT_ReadAllStrings(&cx);
     MSFT_ReadAllGuids(&cx);
 
+    /* names, strings and guids are looked up by offset for every member */
+    image->names = MSFT_IndexStrings(&pTypeLibImpl->name_list, &image->name_cnt);
+    image->strings = MSFT_IndexStrings(&pTypeLibImpl->string_list, &image->string_cnt);
+    image->guids = MSFT_IndexGuids(&pTypeLibImpl->guid_list, &image->guid_cnt);
+
     /* now fill our internal data */
     /* TLIBATTR fields */
     pTypeLibImpl->guid = MSFT_ReadGuid(tlbHeader.posguid, &cx);
@@ -3729,6 +3958,28 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
         }
     }
 
+#ifdef _WIN64
+    if(pTypeLibImpl->syskind == SYS_WIN32)
+        load_all = TRUE;
+#endif
+
+    if(load_all)
+    {
+        for(i = 0; i < pTypeLibImpl->TypeInfoCount; ++i)
+            MSFT_DoMembers(&cx, pTypeLibImpl->typeinfos[i]);
+    }
+
+    if(image->pending)
+    {
+        image->file = pFile;
+        IUnknown_AddRef(pFile);
+    }
+    else
+    {
+        pTypeLibImpl->msft_image = NULL;
+        MSFT_FreeImage(image);
+    }
+
 #ifdef _WIN64
     if(pTypeLibImpl->syskind == SYS_WIN32){
         for(i = 0; i < pTypeLibImpl->TypeInfoCount; ++i)
@@ -4776,6 +5027,11 @@ static HRESULT WINAPI ITypeLib2_fnQueryInterface(ITypeLib2 *iface, REFIID riid,
     else if(IsEqualIID(riid, &IID_ICreateTypeLib) ||
              IsEqualIID(riid, &IID_ICreateTypeLib2))
     {
+        int i;
+
+        /* saving renumbers strings and names, read everything before that */
+        for(i = 0; i < This->TypeInfoCount; ++i)
+            TLB_load_members(This->typeinfos[i]);
         *ppv = &This->ICreateTypeLib2_iface;
     }
     else
@@ -4873,6 +5129,8 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
           ITypeInfoImpl_Destroy(This->typeinfos[i]);
       }
       heap_free(This->typeinfos);
+      if (This->msft_image)
+          MSFT_FreeImage(This->msft_image);
       heap_free(This);
       return 0;
     }
@@ -5128,6 +5386,7 @@ static HRESULT WINAPI ITypeLib2_fnIsName(
     for(tic = 0; tic < This->TypeInfoCount; ++tic){
         ITypeInfoImpl *pTInfo = This->typeinfos[tic];
         if(!TLB_str_memcmp(szNameBuf, pTInfo->Name, nNameBufLen)) goto ITypeLib2_fnIsName_exit;
+        TLB_load_members(pTInfo);
         for(fdc = 0; fdc < pTInfo->cFuncs; ++fdc) {
             TLBFuncDesc *pFInfo = &pTInfo->funcdescs[fdc];
             int pc;
@@ -5183,6 +5442,7 @@ static HRESULT WINAPI ITypeLib2_fnFindName(
         UINT fdc;
 
         if(!TLB_str_memcmp(name, pTInfo->Name, len)) goto ITypeLib2_fnFindName_exit;
+        TLB_load_members(pTInfo);
         for(fdc = 0; fdc < pTInfo->cFuncs; ++fdc) {
             TLBFuncDesc *func = &pTInfo->funcdescs[fdc];
             int pc;
@@ -5638,7 +5898,11 @@ static HRESULT WINAPI ITypeInfo_fnQueryInterface(
         *ppvObject = This;
     else if(IsEqualIID(riid, &IID_ICreateTypeInfo) ||
              IsEqualIID(riid, &IID_ICreateTypeInfo2))
+    {
+        /* members have to be read before they can be modified */
+        TLB_load_members(This);
         *ppvObject = &This->ICreateTypeInfo2_iface;
+    }
 
     if(*ppvObject){
         ITypeInfo2_AddRef(iface);
@@ -5670,6 +5934,10 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TRACE("destroying ITypeInfo(%p)\n",This);
 
+    /* members that were never read have nothing to free */
+    if (This->members_pending)
+        This->cFuncs = This->cVars = 0;
+
     for (i = 0; i < This->cFuncs; ++i)
     {
         int j;
@@ -5683,6 +5951,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
         }
         heap_free(pFInfo->funcdesc.lprgelemdescParam);
         heap_free(pFInfo->pParamDesc);
+        heap_free(pFInfo->invoke_plan);
         TLB_FreeCustData(&pFInfo->custdata_list);
     }
     heap_free(This->funcdescs);
@@ -5976,6 +6245,7 @@ HRESULT ITypeInfoImpl_GetInternalFuncDesc( ITypeInfo *iface, UINT index, const F
     if (index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
     *ppFuncDesc = &This->funcdescs[index].funcdesc;
     return S_OK;
 }
@@ -6165,17 +6435,17 @@ static HRESULT WINAPI ITypeInfo_fnGetVarDesc( ITypeInfo2 *iface, UINT index,
         LPVARDESC  *ppVarDesc)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    const TLBVarDesc *pVDesc = &This->vardescs[index];
 
     TRACE("(%p) index %d\n", This, index);
 
     if(index >= This->cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
     if (This->needs_layout)
         ICreateTypeInfo2_LayOut(&This->ICreateTypeInfo2_iface);
 
-    return TLB_AllocAndInitVarDesc(&pVDesc->vardesc, ppVarDesc);
+    return TLB_AllocAndInitVarDesc(&This->vardescs[index].vardesc, ppVarDesc);
 }
 
 /* ITypeInfo_GetNames
@@ -6197,6 +6467,7 @@ static HRESULT WINAPI ITypeInfo_fnGetNames( ITypeInfo2 *iface, MEMBERID memid,
         return E_INVALIDARG;
 
     *pcNames = 0;
+    TLB_load_members(This);
 
     pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
     if(pFDesc)
@@ -6357,6 +6628,7 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
+    TLB_load_members(This);
     for (fdc = 0; fdc < This->cFuncs; ++fdc) {
         int j;
         const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
@@ -6690,6 +6962,9 @@ static HRESULT get_iface_guid(ITypeInfo *tinfo, const TYPEDESC *tdesc, GUID *gui
     return hres;
 }
 
+/* number of arguments for which DispCallFunc builds the call frame on the stack */
+#define DISPCALL_STACK_ARGS 8
+
 /***********************************************************************
  *		DispCallFunc (OLEAUT32.@)
  *
@@ -6737,7 +7012,7 @@ DispCallFunc(
     int argspos, stack_offset;
     void *func;
     UINT i;
-    DWORD *args;
+    DWORD *args, args_buffer[(sizeof(VARIANT) * DISPCALL_STACK_ARGS) / sizeof(DWORD) + 2];
 
     TRACE("(%p, %ld, %d, %d, %d, %p, %p, %p (vt=%d))\n",
         pvInstance, oVft, cc, vtReturn, cActuals, prgvt, prgpvarg,
@@ -6750,7 +7025,10 @@ DispCallFunc(
     }
 
     /* maximum size for an argument is sizeof(VARIANT) */
-    args = heap_alloc(sizeof(VARIANT) * cActuals + sizeof(DWORD) * 2 );
+    if (cActuals <= DISPCALL_STACK_ARGS)
+        args = args_buffer;
+    else if (!(args = heap_alloc(sizeof(VARIANT) * cActuals + sizeof(DWORD) * 2 )))
+        return E_OUTOFMEMORY;
 
     /* start at 1 in case we need to pass a pointer to the return value as arg 0 */
     argspos = 1;
@@ -6818,13 +7096,13 @@ DispCallFunc(
         break;
     case VT_HRESULT:
         WARN("invalid return type %u\n", vtReturn);
-        heap_free( args );
+        if (args != args_buffer) heap_free( args );
         return E_INVALIDARG;
     default:
         V_UI4(pvargResult) = call_method( func, argspos - 1, args + 1, &stack_offset );
         break;
     }
-    heap_free( args );
+    if (args != args_buffer) heap_free( args );
     if (stack_offset && cc == CC_STDCALL)
     {
         WARN( "stack pointer off by %d\n", stack_offset );
@@ -6837,7 +7115,8 @@ DispCallFunc(
 #elif defined(__x86_64__)
     int argspos;
     UINT i;
-    DWORD_PTR *args;
+    DWORD_PTR *args, args_buffer[DISPCALL_STACK_ARGS + 2];
+    BOOL int_args = TRUE;
     void *func;
 
     TRACE("(%p, %ld, %d, %d, %d, %p, %p, %p (vt=%d))\n",
@@ -6851,7 +7130,10 @@ DispCallFunc(
     }
 
     /* maximum size for an argument is sizeof(DWORD_PTR) */
-    args = heap_alloc( sizeof(DWORD_PTR) * (cActuals + 2) );
+    if (cActuals <= DISPCALL_STACK_ARGS)
+        args = args_buffer;
+    else if (!(args = heap_alloc( sizeof(DWORD_PTR) * (cActuals + 2) )))
+        return E_OUTOFMEMORY;
 
     /* start at 1 in case we need to pass a pointer to the return value as arg 0 */
     argspos = 1;
@@ -6876,6 +7158,11 @@ DispCallFunc(
         case VT_BOOL:  /* VT_BOOL is 16-bit but BOOL is 32-bit, needs to be extended */
             args[argspos++] = V_BOOL(arg);
             break;
+        case VT_R4:
+        case VT_R8:
+        case VT_DATE:
+            int_args = FALSE;
+            /* fall through */
         default:
             args[argspos++] = V_UI8(arg);
             break;
@@ -6884,6 +7171,33 @@ DispCallFunc(
         dump_Variant(arg);
     }
 
+    switch (vtReturn)
+    {
+    case VT_R4:
+    case VT_R8:
+    case VT_DATE:
+    case VT_DECIMAL:
+    case VT_VARIANT:
+    case VT_HRESULT:
+        break;
+    default:
+        /* Integer and pointer arguments that fit in registers can be passed
+         * with a plain call, most automation methods look like that. Unused
+         * registers are harmless for the callee. */
+        if (int_args && argspos <= 5)
+        {
+            DWORD_PTR (WINAPI *reg_func)(DWORD_PTR,DWORD_PTR,DWORD_PTR,DWORD_PTR) = func;
+
+            while (argspos <= 4) args[argspos++] = 0;
+            V_UI8(pvargResult) = reg_func( args[1], args[2], args[3], args[4] );
+            if (args != args_buffer) heap_free( args );
+            V_VT(pvargResult) = vtReturn;
+            TRACE("retval: "); dump_Variant(pvargResult);
+            return S_OK;
+        }
+        break;
+    }
+
     switch (vtReturn)
     {
     case VT_R4:
@@ -6900,13 +7214,13 @@ DispCallFunc(
         break;
     case VT_HRESULT:
         WARN("invalid return type %u\n", vtReturn);
-        heap_free( args );
+        if (args != args_buffer) heap_free( args );
         return E_INVALIDARG;
     default:
         V_UI8(pvargResult) = call_method( func, argspos - 1, args + 1 );
         break;
     }
-    heap_free( args );
+    if (args != args_buffer) heap_free( args );
     if (vtReturn != VT_VARIANT) V_VT(pvargResult) = vtReturn;
     TRACE("retval: "); dump_Variant(pvargResult);
     return S_OK;
@@ -6923,6 +7237,75 @@ static inline BOOL func_restricted( const FUNCDESC *desc )
     return (desc->wFuncFlags & FUNCFLAG_FRESTRICTED) && (desc->memid >= 0);
 }
 
+/* Argument and return types of a function as passed to DispCallFunc. They
+ * only depend on the function description, so they are worked out on the
+ * first call and reused. */
+typedef struct tagTLBInvokePlan
+{
+    VARTYPE ret_vt;
+    struct
+    {
+        VARTYPE vt;
+        HRESULT iid_hres;   /* result of looking up iid, S_FALSE if not an interface */
+        GUID iid;           /* interface expected for user defined interface arguments */
+    } params[1];
+} TLBInvokePlan;
+
+static HRESULT get_invoke_plan(ITypeInfo *tinfo, TLBFuncDesc *func, const TLBInvokePlan **ret)
+{
+    const FUNCDESC *func_desc = &func->funcdesc;
+    TLBInvokePlan *plan;
+    HRESULT hres;
+    int i;
+
+    if ((*ret = func->invoke_plan))
+        return S_OK;
+
+    plan = heap_alloc_zero(FIELD_OFFSET(TLBInvokePlan, params[func_desc->cParams]));
+    if (!plan)
+        return E_OUTOFMEMORY;
+
+    for (i = 0; i < func_desc->cParams; i++)
+    {
+        const TYPEDESC *tdesc = &func_desc->lprgelemdescParam[i].tdesc;
+
+        hres = typedescvt_to_variantvt(tinfo, tdesc, &plan->params[i].vt);
+        if (FAILED(hres))
+        {
+            heap_free(plan);
+            return hres;
+        }
+
+        if (tdesc->vt == VT_USERDEFINED || (tdesc->vt == VT_PTR && tdesc->u.lptdesc->vt == VT_USERDEFINED))
+            plan->params[i].iid_hres = get_iface_guid(tinfo, tdesc->vt == VT_PTR ? tdesc->u.lptdesc : tdesc,
+                                                      &plan->params[i].iid);
+        else
+            plan->params[i].iid_hres = S_FALSE;
+    }
+
+    /* VT_VOID is a special case for return types, so it is not
+     * handled in the general function */
+    if (func_desc->elemdescFunc.tdesc.vt == VT_VOID)
+        plan->ret_vt = VT_EMPTY;
+    else
+    {
+        hres = typedescvt_to_variantvt(tinfo, &func_desc->elemdescFunc.tdesc, &plan->ret_vt);
+        if (FAILED(hres))
+        {
+            heap_free(plan);
+            return hres;
+        }
+    }
+
+    if (InterlockedCompareExchangePointer((void **)&func->invoke_plan, plan, NULL))
+        heap_free(plan);
+    *ret = func->invoke_plan;
+    return S_OK;
+}
+
+/* number of parameters for which the argument buffer is kept on the stack */
+#define INVBUF_STACK_PARAMS 8
+
 #define INVBUF_ELEMENT_SIZE \
     (sizeof(VARIANTARG) + sizeof(VARIANTARG) + sizeof(VARIANTARG *) + sizeof(VARTYPE))
 #define INVBUF_GET_ARG_ARRAY(buffer, params) (buffer)
@@ -6948,7 +7331,7 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
     unsigned int var_index;
     TYPEKIND type_kind;
     HRESULT hres;
-    const TLBFuncDesc *pFuncInfo;
+    TLBFuncDesc *pFuncInfo;
     UINT fdc;
 
     TRACE("(%p)(%p,id=%d,flags=0x%08x,%p,%p,%p,%p)\n",
@@ -6958,6 +7341,8 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
     if( This->wTypeFlags & TYPEFLAG_FRESTRICTED )
         return DISP_E_MEMBERNOTFOUND;
 
+    TLB_load_members(This);
+
     if (!pDispParams)
     {
         ERR("NULL pDispParams not allowed\n");
@@ -6995,16 +7380,29 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
 	switch (func_desc->funckind) {
 	case FUNC_PUREVIRTUAL:
 	case FUNC_VIRTUAL: {
-            void *buffer = heap_alloc_zero(INVBUF_ELEMENT_SIZE * func_desc->cParams);
+            VARIANTARG stack_buffer[(INVBUF_ELEMENT_SIZE * INVBUF_STACK_PARAMS + sizeof(VARIANTARG) - 1) / sizeof(VARIANTARG)];
+            void *buffer;
+            const TLBInvokePlan *plan;
             VARIANT varresult;
             VARIANT retval; /* pointer for storing byref retvals in */
-            VARIANTARG **prgpvarg = INVBUF_GET_ARG_PTR_ARRAY(buffer, func_desc->cParams);
-            VARIANTARG *rgvarg = INVBUF_GET_ARG_ARRAY(buffer, func_desc->cParams);
-            VARTYPE *rgvt = INVBUF_GET_ARG_TYPE_ARRAY(buffer, func_desc->cParams);
+            VARIANTARG **prgpvarg;
+            VARIANTARG *rgvarg;
+            VARTYPE *rgvt;
             UINT cNamedArgs = pDispParams->cNamedArgs;
             DISPID *rgdispidNamedArgs = pDispParams->rgdispidNamedArgs;
             UINT vargs_converted=0;
 
+            if (func_desc->cParams <= INVBUF_STACK_PARAMS)
+            {
+                buffer = stack_buffer;
+                memset(buffer, 0, INVBUF_ELEMENT_SIZE * func_desc->cParams);
+            }
+            else if (!(buffer = heap_alloc_zero(INVBUF_ELEMENT_SIZE * func_desc->cParams)))
+                return E_OUTOFMEMORY;
+            prgpvarg = INVBUF_GET_ARG_PTR_ARRAY(buffer, func_desc->cParams);
+            rgvarg = INVBUF_GET_ARG_ARRAY(buffer, func_desc->cParams);
+            rgvt = INVBUF_GET_ARG_TYPE_ARRAY(buffer, func_desc->cParams);
+
             hres = S_OK;
 
             if (func_desc->invkind & (INVOKE_PROPERTYPUT|INVOKE_PROPERTYPUTREF))
@@ -7024,19 +7422,16 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
                 goto func_fail;
             }
 
+            hres = get_invoke_plan((ITypeInfo *)iface, pFuncInfo, &plan);
+            if (FAILED(hres))
+                goto func_fail;
             for (i = 0; i < func_desc->cParams; i++)
-            {
-                TYPEDESC *tdesc = &func_desc->lprgelemdescParam[i].tdesc;
-                hres = typedescvt_to_variantvt((ITypeInfo *)iface, tdesc, &rgvt[i]);
-                if (FAILED(hres))
-                    goto func_fail;
-            }
+                rgvt[i] = plan->params[i].vt;
 
             TRACE("changing args\n");
             for (i = 0; i < func_desc->cParams; i++)
             {
                 USHORT wParamFlags = func_desc->lprgelemdescParam[i].u.paramdesc.wParamFlags;
-                TYPEDESC *tdesc = &func_desc->lprgelemdescParam[i].tdesc;
                 VARIANTARG *src_arg;
 
                 if (wParamFlags & PARAMFLAG_FLCID)
@@ -7192,19 +7587,18 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
                         prgpvarg[i] = src_arg;
                     }
 
-                    if((tdesc->vt == VT_USERDEFINED || (tdesc->vt == VT_PTR && tdesc->u.lptdesc->vt == VT_USERDEFINED))
+                    if(plan->params[i].iid_hres != S_FALSE
                        && (V_VT(prgpvarg[i]) == VT_DISPATCH || V_VT(prgpvarg[i]) == VT_UNKNOWN)
                        && V_UNKNOWN(prgpvarg[i])) {
                         IUnknown *userdefined_iface;
-                        GUID guid;
 
-                        hres = get_iface_guid((ITypeInfo*)iface, tdesc->vt == VT_PTR ? tdesc->u.lptdesc : tdesc, &guid);
+                        hres = plan->params[i].iid_hres;
                         if(FAILED(hres))
                             break;
 
-                        hres = IUnknown_QueryInterface(V_UNKNOWN(prgpvarg[i]), &guid, (void**)&userdefined_iface);
+                        hres = IUnknown_QueryInterface(V_UNKNOWN(prgpvarg[i]), &plan->params[i].iid, (void**)&userdefined_iface);
                         if(FAILED(hres)) {
-                            ERR("argument does not support %s interface\n", debugstr_guid(&guid));
+                            ERR("argument does not support %s interface\n", debugstr_guid(&plan->params[i].iid));
                             break;
                         }
 
@@ -7248,16 +7642,7 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
             }
             if (FAILED(hres)) goto func_fail; /* FIXME: we don't free changed types here */
 
-            /* VT_VOID is a special case for return types, so it is not
-             * handled in the general function */
-            if (func_desc->elemdescFunc.tdesc.vt == VT_VOID)
-                V_VT(&varresult) = VT_EMPTY;
-            else
-            {
-                V_VT(&varresult) = 0;
-                hres = typedescvt_to_variantvt((ITypeInfo *)iface, &func_desc->elemdescFunc.tdesc, &V_VT(&varresult));
-                if (FAILED(hres)) goto func_fail; /* FIXME: we don't free changed types here */
-            }
+            V_VT(&varresult) = plan->ret_vt;
 
             hres = DispCallFunc(pIUnk, func_desc->oVft & 0xFFFC, func_desc->callconv,
                                 V_VT(&varresult), func_desc->cParams, rgvt,
@@ -7403,7 +7788,8 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
             }
 
 func_fail:
-            heap_free(buffer);
+            if (buffer != stack_buffer)
+                heap_free(buffer);
             break;
         }
 	case FUNC_DISPATCH:  {
@@ -7491,6 +7877,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDocumentation( ITypeInfo2 *iface,
             *pBstrHelpFile=SysAllocString(TLB_get_bstr(This->pTypeLib->HelpFile));
         return S_OK;
     }else {/* for a member */
+        TLB_load_members(This);
         pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
         if(pFDesc){
             if(pBstrName)
@@ -7557,6 +7944,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDllEntry( ITypeInfo2 *iface, MEMBERID memid
     if (This->typekind != TKIND_MODULE)
         return TYPE_E_BADMODULEKIND;
 
+    TLB_load_members(This);
     pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
     if(pFDesc){
 	    dump_TypeInfo(This);
@@ -7643,6 +8031,8 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
         */
         pTypeInfoImpl = ITypeInfoImpl_Constructor();
 
+        /* the copy shares our members, so they have to be read first */
+        TLB_load_members(This);
         *pTypeInfoImpl = *This;
         pTypeInfoImpl->ref = 0;
         list_init(&pTypeInfoImpl->custdata_list);
@@ -7983,6 +8373,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncIndexOfMemId( ITypeInfo2 * iface,
     UINT fdc;
     HRESULT result;
 
+    TLB_load_members(This);
     for (fdc = 0; fdc < This->cFuncs; ++fdc){
         const TLBFuncDesc *pFuncInfo = &This->funcdescs[fdc];
         if(memid == pFuncInfo->funcdesc.memid && (invKind & pFuncInfo->funcdesc.invkind))
@@ -8013,6 +8404,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetVarIndexOfMemId( ITypeInfo2 * iface,
 
     TRACE("%p %d %p\n", iface, memid, pVarIndex);
 
+    TLB_load_members(This);
     pVarInfo = TLB_get_vardesc_by_memberid(This->vardescs, This->cVars, memid);
     if(!pVarInfo)
         return TYPE_E_ELEMENTNOTFOUND;
@@ -8061,13 +8453,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBFuncDesc *pFDesc = &This->funcdescs[index];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %s %p\n", This, index, debugstr_guid(guid), pVarVal);
 
     if(index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pFDesc = &This->funcdescs[index];
+
     pCData = TLB_get_custdata_by_guid(&pFDesc->custdata_list, guid);
     if(!pCData)
         return TYPE_E_ELEMENTNOTFOUND;
@@ -8091,7 +8486,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetParamCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBFuncDesc *pFDesc = &This->funcdescs[indexFunc];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %u %s %p\n", This, indexFunc, indexParam,
             debugstr_guid(guid), pVarVal);
@@ -8099,6 +8494,9 @@ static HRESULT WINAPI ITypeInfo2_fnGetParamCustData(
     if(indexFunc >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pFDesc = &This->funcdescs[indexFunc];
+
     if(indexParam >= pFDesc->funcdesc.cParams)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -8124,13 +8522,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetVarCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBVarDesc *pVDesc = &This->vardescs[index];
+    TLBVarDesc *pVDesc;
 
     TRACE("%p %s %p\n", This, debugstr_guid(guid), pVarVal);
 
     if(index >= This->cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pVDesc = &This->vardescs[index];
+
     pCData = TLB_get_custdata_by_guid(&pVDesc->custdata_list, guid);
     if(!pCData)
         return TYPE_E_ELEMENTNOTFOUND;
@@ -8206,6 +8607,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetDocumentation2(
                 SysAllocString(TLB_get_bstr(This->pTypeLib->HelpStringDll));/* FIXME */
         return S_OK;
     }else {/* for a member */
+        TLB_load_members(This);
         pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
         if(pFDesc){
             if(pbstrHelpString)
@@ -8259,14 +8661,14 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllFuncCustData(
 	CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBFuncDesc *pFDesc = &This->funcdescs[index];
 
     TRACE("%p %u %p\n", This, index, pCustData);
 
     if(index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
-    return TLB_copy_all_custdata(&pFDesc->custdata_list, pCustData);
+    TLB_load_members(This);
+    return TLB_copy_all_custdata(&This->funcdescs[index].custdata_list, pCustData);
 }
 
 /* ITypeInfo2::GetAllParamCustData
@@ -8278,13 +8680,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllParamCustData( ITypeInfo2 * iface,
     UINT indexFunc, UINT indexParam, CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBFuncDesc *pFDesc = &This->funcdescs[indexFunc];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %u %p\n", This, indexFunc, indexParam, pCustData);
 
     if(indexFunc >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pFDesc = &This->funcdescs[indexFunc];
+
     if(indexParam >= pFDesc->funcdesc.cParams)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -8300,14 +8705,14 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllVarCustData( ITypeInfo2 * iface,
     UINT index, CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBVarDesc * pVDesc = &This->vardescs[index];
 
     TRACE("%p %u %p\n", This, index, pCustData);
 
     if(index >= This->cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
-    return TLB_copy_all_custdata(&pVDesc->custdata_list, pCustData);
+    TLB_load_members(This);
+    return TLB_copy_all_custdata(&This->vardescs[index].custdata_list, pCustData);
 }
 
 /* ITypeInfo2::GetAllImplCustData
@@ -8540,6 +8945,7 @@ static HRESULT WINAPI ITypeComp_fnBind(
     pBindPtr->lpfuncdesc = NULL;
     *ppTInfo = NULL;
 
+    TLB_load_members(This);
     for(fdc = 0; fdc < This->cFuncs; ++fdc){
         pFDesc = &This->funcdescs[fdc];
         if (!lstrcmpiW(TLB_get_bstr(pFDesc->Name), szName)) {
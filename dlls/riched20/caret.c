@@ -919,11 +919,12 @@ static BOOL ME_FindRunInRow(ME_TextEditor *editor, ME_DisplayItem *pRow,
 static BOOL ME_FindPixelPos(ME_TextEditor *editor, int x, int y,
                             ME_Cursor *result, BOOL *is_eol)
 {
-  ME_DisplayItem *p = editor->pBuffer->pFirst->member.para.next_para;
+  ME_DisplayItem *p;
   BOOL isExact = TRUE;
 
   x -= editor->rcFormat.left;
   y -= editor->rcFormat.top;
+  p = ME_FindParaNearY(editor, y);
 
   if (is_eol)
     *is_eol = 0;
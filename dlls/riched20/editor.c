@@ -2790,6 +2790,9 @@ ME_TextEditor *ME_MakeEditor(ITextHost *texthost, BOOL bEmulateVersion10)
   ed->nUndoLimit = STACK_SIZE_DEFAULT;
   ed->nUndoMode = umAddToUndo;
   ed->nParagraphs = 1;
+  ed->pParaIndex = NULL;
+  ed->bWrapTimer = FALSE;
+  ed->nParaIndexSize = ed->nParaIndexValid = 0;
   ed->nLastSelStart = ed->nLastSelEnd = 0;
   ed->pLastSelStartPara = ed->pLastSelEndPara = ed->pCursors[0].pPara;
   ed->bHideSelection = FALSE;
@@ -2871,6 +2874,8 @@ static void ME_DestroyEditor(ME_TextEditor *editor)
 
   ME_ClearTempStyle(editor);
   ME_EmptyUndoStack(editor);
+  if (editor->bWrapTimer)
+    ITextHost_TxKillTimer(editor->texthost, ME_WRAP_TIMER_ID);
   while(p) {
     pNext = p->next;
     ME_DestroyDisplayItem(p);
@@ -2891,6 +2896,7 @@ static void ME_DestroyEditor(ME_TextEditor *editor)
 
   FREE_OBJ(editor->pBuffer);
   FREE_OBJ(editor->pCursors);
+  heap_free(editor->pParaIndex);
 
   FREE_OBJ(editor);
 }
@@ -4360,6 +4366,11 @@ LRESULT ME_HandleMessage(ME_TextEditor *editor, UINT msg, WPARAM wParam,
     ME_RewrapRepaint(editor);
     goto do_default;
   }
+  case WM_TIMER:
+    if (wParam != ME_WRAP_TIMER_ID)
+      goto do_default;
+    ME_WrapInBackground(editor);
+    return 0;
   /* IME messages to make richedit controls IME aware */
   case WM_IME_SETCONTEXT:
   case WM_IME_CONTROL:
@@ -40,6 +40,8 @@ static inline void * __WINE_ALLOC_SIZE(2) heap_realloc( void *ptr, size_t len )
     return HeapReAlloc( me_heap, 0, ptr, len );
 }
 
+#define ME_WRAP_TIMER_ID 1
+
 #define ALLOC_OBJ(type) heap_alloc(sizeof(type))
 #define ALLOC_N_OBJ(type, count) heap_alloc((count)*sizeof(type))
 #define FREE_OBJ(ptr) heap_free(ptr)
@@ -196,6 +198,7 @@ void ME_DestroyContext(ME_Context *c) DECLSPEC_HIDDEN;
 
 /* wrap.c */
 BOOL ME_WrapMarkedParagraphs(ME_TextEditor *editor) DECLSPEC_HIDDEN;
+void ME_WrapInBackground(ME_TextEditor *editor) DECLSPEC_HIDDEN;
 void ME_InvalidateParagraphRange(ME_TextEditor *editor, ME_DisplayItem *start_para, ME_DisplayItem *last_para) DECLSPEC_HIDDEN;
 void ME_SendRequestResize(ME_TextEditor *editor, BOOL force) DECLSPEC_HIDDEN;
 
@@ -212,6 +215,8 @@ BOOL ME_SetSelectionParaFormat(ME_TextEditor *editor, const PARAFORMAT2 *pFmt) D
 void ME_GetSelectionParaFormat(ME_TextEditor *editor, PARAFORMAT2 *pFmt) DECLSPEC_HIDDEN;
 void ME_MarkAllForWrapping(ME_TextEditor *editor) DECLSPEC_HIDDEN;
 void ME_SetDefaultParaFormat(PARAFORMAT2 *pFmt) DECLSPEC_HIDDEN;
+ME_DisplayItem *ME_FindParaAtCharOfs(ME_TextEditor *editor, int nCharOfs) DECLSPEC_HIDDEN;
+ME_DisplayItem *ME_FindParaNearY(ME_TextEditor *editor, int y) DECLSPEC_HIDDEN;
 
 /* paint.c */
 void ME_PaintContent(ME_TextEditor *editor, HDC hDC, const RECT *rcUpdate) DECLSPEC_HIDDEN;
@@ -179,6 +179,7 @@ typedef struct tagME_Paragraph
   POINT pt;
   int nHeight, nWidth;
   int nRows;
+  int nIndex; /* position in the editor's paragraph index, see para.c */
   struct tagME_DisplayItem *prev_para, *next_para;
 } ME_Paragraph;
 
@@ -398,6 +399,8 @@ typedef struct tagME_TextEditor
   int nUndoLimit;
   ME_UndoMode nUndoMode;
   int nParagraphs;
+  ME_DisplayItem **pParaIndex;
+  int nParaIndexSize, nParaIndexValid;
   int nLastSelStart, nLastSelEnd;
   ME_DisplayItem *pLastSelStartPara, *pLastSelEndPara;
   ME_FontCacheItem pFontCache[HFONT_CACHE_SIZE];
@@ -431,6 +434,9 @@ typedef struct tagME_TextEditor
   SCROLLINFO vert_si, horz_si;
 
   BOOL bMouseCaptured;
+
+  /* Set while paragraphs are left to be wrapped by the wrap timer */
+  BOOL bWrapTimer;
 } ME_TextEditor;
 
 typedef struct tagME_Context
@@ -189,6 +189,115 @@ static BOOL ME_SetParaFormat(ME_TextEditor *editor, ME_DisplayItem *para, const
   return TRUE;
 }
 
+/* The paragraph index is an array of all paragraphs in document order,
+ * which allows finding a paragraph by character offset or y position with
+ * a binary search instead of walking the paragraph list.  Paragraphs keep
+ * their absolute offsets and positions up to date, so the index only needs
+ * to know where the list was last changed; entries after that point are
+ * refreshed lazily on the next lookup. */
+static void ME_InvalidateParaIndex(ME_TextEditor *editor, ME_DisplayItem *para)
+{
+  int index = para->member.para.nIndex;
+
+  if (index >= 0 && index < editor->nParaIndexValid && editor->pParaIndex[index] == para)
+    editor->nParaIndexValid = index + 1;
+}
+
+static BOOL ME_UpdateParaIndex(ME_TextEditor *editor)
+{
+  ME_DisplayItem *para;
+  int index = editor->nParaIndexValid;
+
+  if (index == editor->nParagraphs)
+    return TRUE;
+
+  if (editor->nParaIndexSize < editor->nParagraphs)
+  {
+    ME_DisplayItem **new_index;
+    int size = max(editor->nParaIndexSize * 2, 64);
+
+    while (size < editor->nParagraphs) size *= 2;
+    if (editor->pParaIndex)
+      new_index = heap_realloc(editor->pParaIndex, size * sizeof(*new_index));
+    else
+      new_index = heap_alloc(size * sizeof(*new_index));
+    if (!new_index) return FALSE;
+    editor->pParaIndex = new_index;
+    editor->nParaIndexSize = size;
+  }
+
+  if (index)
+    para = editor->pParaIndex[index - 1]->member.para.next_para;
+  else
+    para = editor->pBuffer->pFirst->member.para.next_para;
+  for (; para != editor->pBuffer->pLast; para = para->member.para.next_para, index++)
+  {
+    assert(index < editor->nParagraphs);
+    para->member.para.nIndex = index;
+    editor->pParaIndex[index] = para;
+  }
+  assert(index == editor->nParagraphs);
+  editor->nParaIndexValid = index;
+  return TRUE;
+}
+
+/* Returns the paragraph containing the given character offset. */
+ME_DisplayItem *ME_FindParaAtCharOfs(ME_TextEditor *editor, int nCharOfs)
+{
+  ME_DisplayItem *para;
+  int low = 0, high;
+
+  if (!ME_UpdateParaIndex(editor))
+  {
+    para = editor->pBuffer->pFirst->member.para.next_para;
+    while (para->member.para.next_para->member.para.nCharOfs <= nCharOfs &&
+           para->member.para.next_para != editor->pBuffer->pLast)
+      para = para->member.para.next_para;
+    return para;
+  }
+
+  /* find the last paragraph starting at or before nCharOfs */
+  high = editor->nParagraphs - 1;
+  while (low < high)
+  {
+    int mid = (low + high + 1) / 2;
+    if (editor->pParaIndex[mid]->member.para.nCharOfs <= nCharOfs)
+      low = mid;
+    else
+      high = mid - 1;
+  }
+  return editor->pParaIndex[low];
+}
+
+/* Returns a paragraph at or before the one containing the given y position
+ * (relative to the top of the document), which is the right place to start
+ * searching for it.  Paragraphs in table cells are laid out side by side, so
+ * the result is moved back out of any table row it falls into. */
+ME_DisplayItem *ME_FindParaNearY(ME_TextEditor *editor, int y)
+{
+  ME_DisplayItem *para;
+  int low = 0, high;
+
+  if (!ME_UpdateParaIndex(editor))
+    return editor->pBuffer->pFirst->member.para.next_para;
+
+  high = editor->nParagraphs - 1;
+  while (low < high)
+  {
+    int mid = (low + high + 1) / 2;
+    if (editor->pParaIndex[mid]->member.para.pt.y <= y)
+      low = mid;
+    else
+      high = mid - 1;
+  }
+
+  para = editor->pParaIndex[low];
+  while (para->member.para.prev_para != editor->pBuffer->pFirst &&
+         (para->member.para.pCell || para->member.para.nFlags & MEPF_ROWEND))
+    para = para->member.para.prev_para;
+  return para;
+}
+
 /* split paragraph at the beginning of the run */
 ME_DisplayItem *ME_SplitParagraph(ME_TextEditor *editor, ME_DisplayItem *run,
                                   ME_Style *style, const WCHAR *eol_str, int eol_len,
@@ -314,6 +423,7 @@ ME_DisplayItem *ME_SplitParagraph(ME_TextEditor *editor, ME_DisplayItem *run,
 
   /* we've added the end run, so we need to modify nCharOfs in the next paragraphs */
   ME_PropagateCharOffset(next_para, eol_len);
+  ME_InvalidateParaIndex(editor, run_para);
   editor->nParagraphs++;
 
   return new_para;
@@ -437,6 +547,7 @@ ME_DisplayItem *ME_JoinParagraphs(ME_TextEditor *editor, ME_DisplayItem *tp,
 
   ME_CheckCharOffsets(editor);
 
+  ME_InvalidateParaIndex(editor, tp);
   editor->nParagraphs--;
   tp->member.para.nFlags |= MEPF_REWRAP;
   return tp;
@@ -186,11 +186,7 @@ void ME_RunOfsFromCharOfs(ME_TextEditor *editor,
   nCharOfs = min(nCharOfs, ME_GetTextLength(editor));
 
   /* Find the paragraph at the offset. */
-  next_item = editor->pBuffer->pFirst->member.para.next_para;
-  do {
-    item = next_item;
-    next_item = item->member.para.next_para;
-  } while (next_item->member.para.nCharOfs <= nCharOfs);
+  item = ME_FindParaAtCharOfs(editor, nCharOfs);
   assert(item->type == diParagraph);
   nCharOfs -= item->member.para.nCharOfs;
   if (ppPara) *ppPara = item;
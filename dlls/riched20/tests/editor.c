@@ -4422,6 +4422,79 @@ static void test_EM_EXSETSEL(void)
     DestroyWindow(hwndRichEdit);
 }
 
+static void test_EM_SETSEL_large_document(void)
+{
+    /* the large document is only used as a benchmark */
+    const int num_lines = winetest_interactive ? 100000 : 5000;
+    const int num_selections = winetest_interactive ? 10000 : 500;
+    const int line_len = 11; /* "line 00000\r" */
+    HWND hwndRichEdit = new_richedit(NULL);
+    char *chunk, *p, buffer[16], expected[16];
+    TEXTRANGEA range;
+    DWORD start;
+    int i, r, len;
+    LONG from, to;
+
+    SendMessageA(hwndRichEdit, EM_EXLIMITTEXT, 0, num_lines * line_len + 16);
+
+    chunk = HeapAlloc(GetProcessHeap(), 0, 1000 * 12 + 1);
+    start = GetTickCount();
+    for (i = 0; i < num_lines; )
+    {
+        p = chunk;
+        do p += sprintf(p, "line %05d\r\n", i); while (++i % 1000);
+        SendMessageA(hwndRichEdit, EM_SETSEL, -1, -1);
+        SendMessageA(hwndRichEdit, EM_REPLACESEL, FALSE, (LPARAM)chunk);
+    }
+    if (winetest_interactive)
+        trace("appended %d lines in %u ms\n", num_lines, GetTickCount() - start);
+    HeapFree(GetProcessHeap(), 0, chunk);
+
+    len = SendMessageA(hwndRichEdit, WM_GETTEXTLENGTH, 0, 0);
+    ok(len == num_lines * line_len + 1, "got length %d\n", len);
+
+    srand(1);
+    start = GetTickCount();
+    for (i = 0; i < num_selections; i++)
+    {
+        int line = ((rand() & 0x7fff) << 15 | (rand() & 0x7fff)) % num_lines;
+        int ofs = rand() % line_len;
+
+        SendMessageA(hwndRichEdit, EM_SETSEL, line * line_len + ofs, line * line_len + line_len - 1);
+        SendMessageA(hwndRichEdit, EM_GETSEL, (WPARAM)&from, (LPARAM)&to);
+        if (from != line * line_len + ofs || to != line * line_len + line_len - 1)
+        {
+            ok(0, "line %d, offset %d: got selection %d-%d\n", line, ofs, from, to);
+            break;
+        }
+    }
+    if (winetest_interactive)
+        trace("%d random selections in %u ms\n", num_selections, GetTickCount() - start);
+
+    for (i = 0; i < num_lines; i += num_lines / 10 - 1)
+    {
+        range.chrg.cpMin = i * line_len;
+        range.chrg.cpMax = i * line_len + line_len - 1;
+        range.lpstrText = buffer;
+        r = SendMessageA(hwndRichEdit, EM_GETTEXTRANGE, 0, (LPARAM)&range);
+        sprintf(expected, "line %05d", i);
+        ok(r == line_len - 1, "got %d\n", r);
+        ok(!strcmp(buffer, expected), "got %s, expected %s\n", buffer, expected);
+    }
+
+    /* editing near the end must keep offsets of the following text right */
+    SendMessageA(hwndRichEdit, EM_SETSEL, (num_lines - 2) * line_len, (num_lines - 2) * line_len);
+    SendMessageA(hwndRichEdit, EM_REPLACESEL, FALSE, (LPARAM)"new\r");
+    range.chrg.cpMin = (num_lines - 1) * line_len + 4;
+    range.chrg.cpMax = range.chrg.cpMin + line_len - 1;
+    range.lpstrText = buffer;
+    SendMessageA(hwndRichEdit, EM_GETTEXTRANGE, 0, (LPARAM)&range);
+    sprintf(expected, "line %05d", num_lines - 1);
+    ok(!strcmp(buffer, expected), "got %s, expected %s\n", buffer, expected);
+
+    DestroyWindow(hwndRichEdit);
+}
+
 static void test_EM_REPLACESEL(int redraw)
 {
     HWND hwndRichEdit = new_richedit(NULL);
@@ -6188,6 +6261,58 @@ static void test_EM_CHARFROMPOS(void)
     DestroyWindow(hwnd);
 }
 
+static void test_resize_large_document(void)
+{
+    /* the large document is only used as a benchmark */
+    const int num_paras = winetest_interactive ? 50000 : 1000;
+    const DWORD timeout = winetest_interactive ? 30000 : 5000;
+    DWORD style = WS_VISIBLE|WS_POPUP|WS_VSCROLL|ES_MULTILINE;
+    HWND hwnd, hwnd_ref;
+    char *text, *p;
+    DWORD start;
+    int i, lines, expected;
+    MSG msg;
+
+    text = HeapAlloc(GetProcessHeap(), 0, num_paras * 64);
+    for (i = 0, p = text; i < num_paras; i++)
+        p += sprintf(p, "paragraph %05d is long enough to wrap\r\n", i);
+
+    hwnd = CreateWindowA(RICHEDIT_CLASS20A, NULL, style, 0, 0, 400, 200, NULL, NULL, hmoduleRichEdit, NULL);
+    ok(hwnd != NULL, "error: %d\n", (int) GetLastError());
+    SendMessageA(hwnd, EM_EXLIMITTEXT, 0, num_paras * 64);
+    SendMessageA(hwnd, WM_SETTEXT, 0, (LPARAM)text);
+
+    /* the reference control is wrapped at the final width from the start */
+    hwnd_ref = CreateWindowA(RICHEDIT_CLASS20A, NULL, style, 0, 0, 150, 200, NULL, NULL, hmoduleRichEdit, NULL);
+    ok(hwnd_ref != NULL, "error: %d\n", (int) GetLastError());
+    SendMessageA(hwnd_ref, EM_EXLIMITTEXT, 0, num_paras * 64);
+    SendMessageA(hwnd_ref, WM_SETTEXT, 0, (LPARAM)text);
+    expected = SendMessageA(hwnd_ref, EM_GETLINECOUNT, 0, 0);
+    ok(expected > num_paras, "text wasn't wrapped, got %d lines\n", expected);
+    DestroyWindow(hwnd_ref);
+    HeapFree(GetProcessHeap(), 0, text);
+
+    start = GetTickCount();
+    MoveWindow(hwnd, 0, 0, 150, 200, TRUE);
+    UpdateWindow(hwnd);
+    if (winetest_interactive)
+        trace("resizing %d paragraphs took %u ms\n", num_paras, GetTickCount() - start);
+
+    /* wrapping may finish in the background, but has to converge */
+    lines = SendMessageA(hwnd, EM_GETLINECOUNT, 0, 0);
+    while (lines != expected && GetTickCount() - start < timeout)
+    {
+        while (PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE)) DispatchMessageA(&msg);
+        Sleep(10);
+        lines = SendMessageA(hwnd, EM_GETLINECOUNT, 0, 0);
+    }
+    ok(lines == expected, "got %d lines, expected %d\n", lines, expected);
+    if (winetest_interactive)
+        trace("wrapping converged after %u ms\n", GetTickCount() - start);
+
+    DestroyWindow(hwnd);
+}
+
 static void test_word_wrap(void)
 {
     HWND hwnd;
@@ -7499,6 +7624,7 @@ START_TEST( editor )
   test_WM_SETFONT();
   test_EM_GETMODIFY();
   test_EM_EXSETSEL();
+  test_EM_SETSEL_large_document();
   test_WM_PASTE();
   test_EM_STREAMIN();
   test_EM_STREAMOUT();
@@ -7517,6 +7643,7 @@ START_TEST( editor )
   test_EM_CHARFROMPOS();
   test_SETPARAFORMAT();
   test_word_wrap();
+  test_resize_large_document();
   test_autoscroll();
   test_format_rect();
   test_WM_GETDLGCODE();
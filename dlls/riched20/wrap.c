@@ -24,6 +24,12 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(richedit);
 
+/* documents with fewer paragraphs are always wrapped completely */
+#define WRAP_DEFER_MIN_PARAGRAPHS 1000
+/* time spent wrapping on each tick of the wrap timer, in ms */
+#define WRAP_SLICE_MS 20
+#define WRAP_TIMER_INTERVAL 10
+
 /*
  * Unsolved problems:
  *
@@ -698,25 +704,75 @@ static void ME_MarkRepaintEnd(ME_DisplayItem *para,
     *repaint_end = para;
 }
 
-BOOL ME_WrapMarkedParagraphs(ME_TextEditor *editor)
+/* Whether a paragraph marked for rewrapping may keep its current rows for
+ * now.  Only paragraphs that have been wrapped before qualify, since they
+ * still have a consistent (if stale) set of rows that can serve as an
+ * estimate until the background wrapper gets to them.  Table paragraphs
+ * are laid out together with the rest of their row, and the paragraphs
+ * holding the selection are always needed right away. */
+static BOOL ME_CanDeferWrap(ME_TextEditor *editor, ME_DisplayItem *para)
+{
+  if (!para->member.para.nRows)
+    return FALSE;
+  if (para->member.para.pCell || para->member.para.nFlags & (MEPF_ROWSTART|MEPF_ROWEND))
+    return FALSE;
+  return para != editor->pCursors[0].pPara && para != editor->pCursors[1].pPara;
+}
+
+static BOOL ME_WrapParagraphs(ME_TextEditor *editor, BOOL background)
 {
   ME_DisplayItem *item;
   ME_Context c;
-  int totalWidth = 0;
+  int totalWidth = 0, nDeferred = 0, nWrapped = 0;
+  int view_top = 0, view_bottom = 0;
+  DWORD deadline = 0;
+  BOOL defer = FALSE, out_of_time = FALSE;
   ME_DisplayItem *repaint_start = NULL, *repaint_end = NULL;
 
   ME_InitContext(&c, editor, ITextHost_TxGetDC(editor->texthost));
+
+  /* In large documents only the paragraphs around the visible area are
+   * wrapped right away, the rest is done on a timer in small slices. */
+  if (editor->nParagraphs >= WRAP_DEFER_MIN_PARAGRAPHS)
+  {
+    int height = c.rcView.bottom - c.rcView.top;
+
+    view_top = editor->vert_si.nPos - height;
+    view_bottom = editor->vert_si.nPos + 2 * height;
+    if (background)
+      deadline = GetTickCount() + WRAP_SLICE_MS;
+    defer = TRUE;
+  }
+
   c.pt.x = 0;
   item = editor->pBuffer->pFirst->next;
   while(item != editor->pBuffer->pLast) {
     BOOL bRedraw = FALSE;
 
     assert(item->type == diParagraph);
+    if (defer && item->member.para.nFlags & MEPF_REWRAP &&
+        (c.pt.y > view_bottom || c.pt.y + item->member.para.nHeight < view_top) &&
+        (!background || out_of_time) && ME_CanDeferWrap(editor, item))
+    {
+      /* keep the current rows and height as an estimate */
+      if (item->member.para.pt.y != c.pt.y)
+        ME_MarkRepaintEnd(item, &repaint_start, &repaint_end);
+      item->member.para.pt = c.pt;
+      c.pt.y += item->member.para.nHeight;
+      totalWidth = max(totalWidth, item->member.para.nWidth);
+      nDeferred++;
+      item = item->member.para.next_para;
+      continue;
+    }
+
     if ((item->member.para.nFlags & MEPF_REWRAP)
      || (item->member.para.pt.y != c.pt.y))
       bRedraw = TRUE;
     item->member.para.pt = c.pt;
 
+    if (item->member.para.nFlags & MEPF_REWRAP && background &&
+        !(++nWrapped % 16) && GetTickCount() >= deadline)
+      out_of_time = TRUE;
     ME_WrapTextParagraph(&c, item);
 
     if (bRedraw)
@@ -842,11 +898,40 @@ BOOL ME_WrapMarkedParagraphs(ME_TextEditor *editor)
 
   ME_DestroyContext(&c);
 
+  if (nDeferred)
+  {
+    TRACE("deferred wrapping %d paragraphs\n", nDeferred);
+    if (!editor->bWrapTimer)
+    {
+      editor->bWrapTimer = ITextHost_TxSetTimer(editor->texthost, ME_WRAP_TIMER_ID, WRAP_TIMER_INTERVAL);
+      if (!editor->bWrapTimer)
+        WARN("failed to set wrap timer, paragraphs are wrapped as they become visible\n");
+    }
+  }
+  else if (editor->bWrapTimer)
+  {
+    ITextHost_TxKillTimer(editor->texthost, ME_WRAP_TIMER_ID);
+    editor->bWrapTimer = FALSE;
+  }
+
   if (repaint_start || editor->nTotalLength < editor->nLastTotalLength)
     ME_InvalidateParagraphRange(editor, repaint_start, repaint_end);
   return !!repaint_start;
 }
 
+BOOL ME_WrapMarkedParagraphs(ME_TextEditor *editor)
+{
+  return ME_WrapParagraphs(editor, FALSE);
+}
+
+/* Called on the wrap timer; wraps the next slice of deferred paragraphs and
+ * updates the scrollbars to the improved estimate of the document size. */
+void ME_WrapInBackground(ME_TextEditor *editor)
+{
+  ME_WrapParagraphs(editor, TRUE);
+  ME_UpdateScrollBar(editor);
+}
+
 void ME_InvalidateParagraphRange(ME_TextEditor *editor,
                                  ME_DisplayItem *start_para,
                                  ME_DisplayItem *last_para)
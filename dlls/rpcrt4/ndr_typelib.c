@@ -0,0 +1,781 @@
+/*
+ * Type library proxy/stub implementation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ *
+ * The proxies and stubs built here are driven by NdrClientCall2 and
+ * NdrStubCall2 from -Oicf format strings generated out of the type
+ * information. Only simple signatures are described: base types, BSTRs
+ * and interface pointers, passed by value or through a single level of
+ * [in], [out] or [in, out] pointer, with an HRESULT return value. Any
+ * other interface makes the functions fail with E_NOTIMPL, so that the
+ * caller can fall back to its own marshaler.
+ */
+
+#include <stdarg.h>
+#include <string.h>
+
+#define COBJMACROS
+#define NONAMELESSUNION
+
+#include "windef.h"
+#include "winbase.h"
+#include "winerror.h"
+
+#include "objbase.h"
+#include "oaidl.h"
+#include "rpcproxy.h"
+
+#include "wine/debug.h"
+#include "wine/rpcfc.h"
+
+#include "cpsf.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(ole);
+
+#define WRITE_CHAR(str, len, val) \
+    do { if ((str)) (str)[(len)] = (val); (len)++; } while (0)
+#define WRITE_SHORT(str, len, val) \
+    do { if ((str)) *((short *)((str) + (len))) = (val); (len) += 2; } while (0)
+#define WRITE_INT(str, len, val) \
+    do { if ((str)) *((int *)((str) + (len))) = (val); (len) += 4; } while (0)
+
+/* the type format string starts with the BSTR description, laid out like
+ * MIDL does it for oaidl.idl; the user marshal routines live in oleaut32 */
+static const unsigned char bstr_tfs[] =
+{
+    NdrFcShort(0x0),
+/* 2 (unsigned short[]) */
+    RPC_FC_CARRAY, 0x1, NdrFcShort(0x2), 0x9, 0x0, NdrFcShort(0xfffc), RPC_FC_SHORT, RPC_FC_END,
+/* 12 (FLAGGED_WORD_BLOB) */
+    RPC_FC_CSTRUCT, 0x3, NdrFcShort(0x8), NdrFcShort(0xfff2), RPC_FC_LONG, RPC_FC_LONG, RPC_FC_PAD, RPC_FC_END,
+/* 22 (wireBSTR) */
+    RPC_FC_UP, 0x0, NdrFcShort(0xfff4),
+/* 26 (BSTR) */
+    RPC_FC_USER_MARSHAL, USER_MARSHAL_UNIQUE | 0x3, NdrFcShort(0x0), NdrFcShort(sizeof(BSTR)),
+    NdrFcShort(0x0), NdrFcShort(0xfff4),
+};
+
+#define BSTR_TFS_OFFSET 26
+
+/* the parameter flags MIDL uses for each kind of parameter */
+#define PF_BASETYPE_IN          (RPC_FC_PROC_PF_IN | RPC_FC_PROC_PF_BASETYPE)
+#define PF_BSTR_IN              (RPC_FC_PROC_PF_MUSTSIZE | RPC_FC_PROC_PF_MUSTFREE | RPC_FC_PROC_PF_IN | \
+                                 RPC_FC_PROC_PF_BYVAL)
+#define PF_IFACE_IN             (RPC_FC_PROC_PF_MUSTSIZE | RPC_FC_PROC_PF_MUSTFREE | RPC_FC_PROC_PF_IN)
+#define PF_RETURN               (RPC_FC_PROC_PF_OUT | RPC_FC_PROC_PF_RETURN | RPC_FC_PROC_PF_BASETYPE)
+#define PF_SRVALLOC(size)       ((((size) + 7) / 8) << 13)  /* ServerAllocSize in 8 byte units */
+
+static unsigned char get_base_type(VARTYPE vt)
+{
+    switch (vt)
+    {
+    case VT_I1:         return RPC_FC_SMALL;
+    case VT_UI1:        return RPC_FC_USMALL;
+    case VT_I2:
+    case VT_BOOL:       return RPC_FC_SHORT;
+    case VT_UI2:        return RPC_FC_USHORT;
+    case VT_I4:
+    case VT_INT:
+    case VT_ERROR:
+    case VT_HRESULT:    return RPC_FC_LONG;
+    case VT_UI4:
+    case VT_UINT:       return RPC_FC_ULONG;
+    case VT_I8:
+    case VT_UI8:        return RPC_FC_HYPER;
+    case VT_R4:         return RPC_FC_FLOAT;
+    case VT_R8:
+    case VT_DATE:       return RPC_FC_DOUBLE;
+    default:            return 0;
+    }
+}
+
+static unsigned int get_base_type_size(unsigned char fc)
+{
+    switch (fc)
+    {
+    case RPC_FC_SMALL:
+    case RPC_FC_USMALL: return 1;
+    case RPC_FC_SHORT:
+    case RPC_FC_USHORT: return 2;
+    case RPC_FC_HYPER:
+    case RPC_FC_DOUBLE: return 8;
+    default:            return 4;
+    }
+}
+
+/* strip pointers and aliases from a type, counting the pointer levels;
+ * interfaces are returned as VT_UNKNOWN with their iid */
+static HRESULT resolve_type(ITypeInfo *typeinfo, const TYPEDESC *desc, unsigned int *ptrs,
+                            VARTYPE *vt, GUID *iid)
+{
+    ITypeInfo *refinfo;
+    TYPEATTR *attr;
+    HRESULT hr;
+
+    while (desc->vt == VT_PTR)
+    {
+        (*ptrs)++;
+        desc = desc->u.lptdesc;
+    }
+
+    switch (desc->vt)
+    {
+    case VT_UNKNOWN:
+        *iid = IID_IUnknown;
+        (*ptrs)++;
+        *vt = VT_UNKNOWN;
+        return S_OK;
+    case VT_DISPATCH:
+        *iid = IID_IDispatch;
+        (*ptrs)++;
+        *vt = VT_UNKNOWN;
+        return S_OK;
+    case VT_USERDEFINED:
+        break;
+    default:
+        *vt = desc->vt;
+        return S_OK;
+    }
+
+    hr = ITypeInfo_GetRefTypeInfo(typeinfo, desc->u.hreftype, &refinfo);
+    if (FAILED(hr)) return hr;
+    hr = ITypeInfo_GetTypeAttr(refinfo, &attr);
+    if (FAILED(hr))
+    {
+        ITypeInfo_Release(refinfo);
+        return hr;
+    }
+
+    switch (attr->typekind)
+    {
+    case TKIND_ALIAS:
+        hr = resolve_type(refinfo, &attr->tdescAlias, ptrs, vt, iid);
+        break;
+    case TKIND_ENUM:
+        *vt = VT_I4;
+        break;
+    case TKIND_INTERFACE:
+    case TKIND_DISPATCH:
+        *iid = attr->guid;
+        *vt = VT_UNKNOWN;
+        break;
+    default:
+        *vt = VT_RECORD;
+        break;
+    }
+
+    ITypeInfo_ReleaseTypeAttr(refinfo, attr);
+    ITypeInfo_Release(refinfo);
+    return hr;
+}
+
+static size_t write_ip_tfs(unsigned char *str, size_t *len, const GUID *iid)
+{
+    size_t off = *len;
+
+    WRITE_CHAR (str, *len, RPC_FC_IP);
+    WRITE_CHAR (str, *len, RPC_FC_CONSTANT_IID);
+    WRITE_INT  (str, *len, iid->Data1);
+    WRITE_SHORT(str, *len, iid->Data2);
+    WRITE_SHORT(str, *len, iid->Data3);
+    if (str) memcpy(str + *len, iid->Data4, sizeof(iid->Data4));
+    *len += sizeof(iid->Data4);
+    return off;
+}
+
+static size_t write_ip_ptr_tfs(unsigned char *str, size_t *len, const GUID *iid, unsigned char attr)
+{
+    size_t ip = write_ip_tfs(str, len, iid), off = *len;
+
+    WRITE_CHAR (str, *len, RPC_FC_RP);
+    WRITE_CHAR (str, *len, attr);
+    WRITE_SHORT(str, *len, ip - *len);
+    return off;
+}
+
+static HRESULT write_param_fs(ITypeInfo *typeinfo, const ELEMDESC *elem, unsigned short stack_offset,
+                              unsigned char *proc, size_t *proclen, unsigned char *type, size_t *typelen,
+                              unsigned int *stack_size, unsigned char *basetype)
+{
+    USHORT paramflags = elem->u.paramdesc.wParamFlags;
+    BOOL in = !!(paramflags & PARAMFLAG_FIN), out = !!(paramflags & PARAMFLAG_FOUT);
+    unsigned short flags;
+    size_t off = 0;
+    unsigned int ptrs = 0;
+    unsigned char fc;
+    VARTYPE vt;
+    GUID iid;
+    HRESULT hr;
+
+    if (!in && !out) in = TRUE;
+
+    hr = resolve_type(typeinfo, &elem->tdesc, &ptrs, &vt, &iid);
+    if (FAILED(hr)) return hr;
+
+    *basetype = 0;
+    *stack_size = sizeof(void *);
+
+    if ((fc = get_base_type(vt)))
+    {
+        if (ptrs == 0 && !out)
+        {
+            flags = PF_BASETYPE_IN;
+            *basetype = fc;
+            if (sizeof(void *) == 4 && get_base_type_size(fc) == 8) *stack_size = 8;
+        }
+        else if (ptrs == 1)
+        {
+            flags = RPC_FC_PROC_PF_BASETYPE | RPC_FC_PROC_PF_SIMPLEREF;
+            if (in) flags |= RPC_FC_PROC_PF_IN;
+            if (out) flags |= RPC_FC_PROC_PF_OUT;
+            if (out && !in) flags |= PF_SRVALLOC(sizeof(void *));
+        }
+        else return E_NOTIMPL;
+
+        WRITE_SHORT(proc, *proclen, flags);
+        WRITE_SHORT(proc, *proclen, stack_offset);
+        WRITE_CHAR (proc, *proclen, fc);
+        WRITE_CHAR (proc, *proclen, 0);
+        return S_OK;
+    }
+
+    if (vt == VT_BSTR)
+    {
+        if (ptrs == 0 && !out) flags = PF_BSTR_IN;
+        else if (ptrs == 1)
+        {
+            flags = RPC_FC_PROC_PF_MUSTSIZE | RPC_FC_PROC_PF_MUSTFREE | RPC_FC_PROC_PF_SIMPLEREF;
+            if (in) flags |= RPC_FC_PROC_PF_IN;
+            if (out) flags |= RPC_FC_PROC_PF_OUT;
+            if (out && !in) flags |= PF_SRVALLOC(sizeof(void *));
+        }
+        else return E_NOTIMPL;
+        off = BSTR_TFS_OFFSET;
+    }
+    else if (vt == VT_UNKNOWN)
+    {
+        if (ptrs == 1 && !out)
+        {
+            flags = PF_IFACE_IN;
+            off = write_ip_tfs(type, typelen, &iid);
+        }
+        else if (ptrs == 2)
+        {
+            /* same as what MIDL (and widl) generate: a reference pointer
+             * dereferenced to the interface pointer, not a simple ref, since
+             * the FC_IP routines take the interface pointer itself; the
+             * server allocates the pointer for [in, out] */
+            flags = RPC_FC_PROC_PF_MUSTSIZE | RPC_FC_PROC_PF_MUSTFREE;
+            if (in) flags |= RPC_FC_PROC_PF_IN;
+            if (out) flags |= RPC_FC_PROC_PF_OUT;
+            if (in && out) flags |= PF_SRVALLOC(sizeof(void *));
+            off = write_ip_ptr_tfs(type, typelen, &iid,
+                                   in ? RPC_FC_P_DEREF : RPC_FC_P_DEREF | RPC_FC_P_ONSTACK);
+        }
+        else return E_NOTIMPL;
+    }
+    else return E_NOTIMPL;
+
+    WRITE_SHORT(proc, *proclen, flags);
+    WRITE_SHORT(proc, *proclen, stack_offset);
+    WRITE_SHORT(proc, *proclen, off);
+    return S_OK;
+}
+
+static HRESULT write_proc_fs(ITypeInfo *typeinfo, const FUNCDESC *desc, WORD proc_num,
+                             unsigned char *proc, size_t *proclen, unsigned char *type, size_t *typelen)
+{
+    unsigned short stack_offset = sizeof(void *), fpu_mask = 0;
+    unsigned short client_size = 0, server_size = 8;
+    unsigned char oi2_flags = 0x44;  /* HasReturn, HasExtensions */
+    size_t size_off, params_off;
+    unsigned int i, stack_size;
+    unsigned char basetype;
+    HRESULT hr;
+
+    if (desc->funckind != FUNC_PUREVIRTUAL && desc->funckind != FUNC_VIRTUAL) return E_NOTIMPL;
+    if (desc->callconv != CC_STDCALL) return E_NOTIMPL;
+    if (desc->elemdescFunc.tdesc.vt != VT_HRESULT) return E_NOTIMPL;
+    if (desc->cParams >= 255) return E_NOTIMPL;
+
+    WRITE_CHAR (proc, *proclen, RPC_FC_AUTO_HANDLE);
+    WRITE_CHAR (proc, *proclen, RPC_FC_PROC_OIF_OBJECT | RPC_FC_PROC_OIF_RPCFLAGS |
+                                RPC_FC_PROC_OIF_OBJ_V2 | RPC_FC_PROC_OIF_NEWINIT);
+    WRITE_INT  (proc, *proclen, 0);             /* rpc flags */
+    WRITE_SHORT(proc, *proclen, proc_num);
+    size_off = *proclen;
+    WRITE_SHORT(proc, *proclen, 0);             /* stack size */
+    WRITE_SHORT(proc, *proclen, 0);             /* client buffer size */
+    WRITE_SHORT(proc, *proclen, 0);             /* server buffer size */
+    WRITE_CHAR (proc, *proclen, 0);             /* Oi2 flags */
+    WRITE_CHAR (proc, *proclen, desc->cParams + 1);
+    WRITE_CHAR (proc, *proclen, sizeof(void *) == 8 ? 10 : 8);
+    WRITE_CHAR (proc, *proclen, 0);             /* extension flags */
+    WRITE_SHORT(proc, *proclen, 0);             /* client correlation hint */
+    WRITE_SHORT(proc, *proclen, 0);             /* server correlation hint */
+    WRITE_SHORT(proc, *proclen, 0);             /* notify index */
+    if (sizeof(void *) == 8) WRITE_SHORT(proc, *proclen, 0);  /* float argument mask */
+    params_off = *proclen;
+
+    for (i = 0; i < desc->cParams; i++)
+    {
+        const unsigned char *param = proc ? proc + *proclen : NULL;
+
+        hr = write_param_fs(typeinfo, &desc->lprgelemdescParam[i], stack_offset,
+                            proc, proclen, type, typelen, &stack_size, &basetype);
+        if (FAILED(hr)) return hr;
+
+        if (param && (*(const unsigned short *)param & RPC_FC_PROC_PF_MUSTSIZE))
+        {
+            if (*(const unsigned short *)param & RPC_FC_PROC_PF_IN) oi2_flags |= 0x02; /* ClientMustSize */
+            if (*(const unsigned short *)param & RPC_FC_PROC_PF_OUT) oi2_flags |= 0x01; /* ServerMustSize */
+        }
+        if (basetype)
+        {
+            unsigned int size = get_base_type_size(basetype);
+            client_size = ((client_size + size - 1) & ~(size - 1)) + size;
+        }
+        if (sizeof(void *) == 8 && stack_offset / 8 < 4)
+        {
+            if (basetype == RPC_FC_FLOAT) fpu_mask |= 1 << (stack_offset / 4);
+            else if (basetype == RPC_FC_DOUBLE) fpu_mask |= 2 << (stack_offset / 4);
+        }
+        stack_offset += stack_size;
+    }
+
+    WRITE_SHORT(proc, *proclen, PF_RETURN);
+    WRITE_SHORT(proc, *proclen, stack_offset);
+    WRITE_CHAR (proc, *proclen, RPC_FC_LONG);
+    WRITE_CHAR (proc, *proclen, 0);
+    stack_offset += sizeof(void *);
+
+    if (proc)
+    {
+        *(unsigned short *)(proc + size_off) = stack_offset;
+        *(unsigned short *)(proc + size_off + 2) = client_size;
+        *(unsigned short *)(proc + size_off + 4) = server_size;
+        proc[size_off + 6] = oi2_flags;
+        if (sizeof(void *) == 8) *(unsigned short *)(proc + params_off - 2) = fpu_mask;
+    }
+    return S_OK;
+}
+
+/* count the methods of an interface, including the inherited ones */
+static HRESULT get_method_count(ITypeInfo *typeinfo, WORD *count)
+{
+    ITypeInfo *parentinfo;
+    TYPEATTR *attr;
+    HREFTYPE reftype;
+    WORD funcs;
+    HRESULT hr;
+
+    hr = ITypeInfo_GetTypeAttr(typeinfo, &attr);
+    if (FAILED(hr)) return hr;
+    funcs = attr->cFuncs;
+    if (IsEqualGUID(&attr->guid, &IID_IUnknown)) funcs = 3;
+    else if (IsEqualGUID(&attr->guid, &IID_IDispatch)) funcs = 7;
+    else if (attr->cImplTypes)
+    {
+        hr = ITypeInfo_GetRefTypeOfImplType(typeinfo, 0, &reftype);
+        if (SUCCEEDED(hr)) hr = ITypeInfo_GetRefTypeInfo(typeinfo, reftype, &parentinfo);
+        if (SUCCEEDED(hr))
+        {
+            WORD parentfuncs;
+
+            hr = get_method_count(parentinfo, &parentfuncs);
+            funcs += parentfuncs;
+            ITypeInfo_Release(parentinfo);
+        }
+    }
+    ITypeInfo_ReleaseTypeAttr(typeinfo, attr);
+    *count = funcs;
+    return hr;
+}
+
+/* get the interface proper (dual dispinterfaces are mapped to their
+ * interface), the number of its own and inherited methods and the iid
+ * of the interface it derives from */
+static HRESULT get_iface_info(ITypeInfo **typeinfo, WORD *funcs, WORD *parentfuncs, GUID *parentiid)
+{
+    ITypeInfo *realinfo, *parentinfo;
+    TYPEATTR *attr;
+    HREFTYPE reftype;
+    TYPEKIND typekind;
+    HRESULT hr;
+
+    hr = ITypeInfo_GetTypeAttr(*typeinfo, &attr);
+    if (FAILED(hr)) return hr;
+    typekind = attr->typekind;
+    ITypeInfo_ReleaseTypeAttr(*typeinfo, attr);
+
+    if (typekind == TKIND_DISPATCH)
+    {
+        /* non-dual dispinterfaces have no interface to describe */
+        if (FAILED(ITypeInfo_GetRefTypeOfImplType(*typeinfo, -1, &reftype))) return E_NOTIMPL;
+        hr = ITypeInfo_GetRefTypeInfo(*typeinfo, reftype, &realinfo);
+        if (FAILED(hr)) return hr;
+        ITypeInfo_Release(*typeinfo);
+        *typeinfo = realinfo;
+    }
+
+    hr = ITypeInfo_GetTypeAttr(*typeinfo, &attr);
+    if (FAILED(hr)) return hr;
+    typekind = attr->typekind;
+    *funcs = attr->cFuncs;
+    ITypeInfo_ReleaseTypeAttr(*typeinfo, attr);
+    if (typekind != TKIND_INTERFACE) return E_NOTIMPL;
+
+    hr = ITypeInfo_GetRefTypeOfImplType(*typeinfo, 0, &reftype);
+    if (FAILED(hr)) return hr;
+    hr = ITypeInfo_GetRefTypeInfo(*typeinfo, reftype, &parentinfo);
+    if (FAILED(hr)) return hr;
+
+    hr = get_method_count(parentinfo, parentfuncs);
+    if (SUCCEEDED(hr)) hr = ITypeInfo_GetTypeAttr(parentinfo, &attr);
+    if (SUCCEEDED(hr))
+    {
+        *parentiid = attr->guid;
+        ITypeInfo_ReleaseTypeAttr(parentinfo, attr);
+    }
+    ITypeInfo_Release(parentinfo);
+    return hr;
+}
+
+/* build the format strings for the methods of the interface itself; the
+ * inherited ones are handled by the parent's proxy and stub */
+static HRESULT build_format_strings(ITypeInfo *typeinfo, WORD funcs, WORD parentfuncs,
+                                    const unsigned char **type_ret, const unsigned char **proc_ret,
+                                    unsigned short **offset_ret)
+{
+    size_t typelen = sizeof(bstr_tfs), proclen = 0, len;
+    unsigned char *type = NULL, *proc = NULL;
+    unsigned short *offset;
+    const FUNCDESC *desc;
+    int pass;
+    WORD i;
+    HRESULT hr = S_OK;
+
+    if (!(offset = HeapAlloc(GetProcessHeap(), 0, (parentfuncs + funcs) * sizeof(*offset))))
+        return E_OUTOFMEMORY;
+    for (i = 0; i < parentfuncs; i++) offset[i] = (unsigned short)-1;
+
+    /* the first pass computes the sizes, the second one writes the strings */
+    for (pass = 0; pass < 2 && SUCCEEDED(hr); pass++)
+    {
+        if (pass)
+        {
+            type = HeapAlloc(GetProcessHeap(), 0, typelen);
+            proc = HeapAlloc(GetProcessHeap(), 0, proclen);
+            if (!type || !proc)
+            {
+                hr = E_OUTOFMEMORY;
+                break;
+            }
+            memcpy(type, bstr_tfs, sizeof(bstr_tfs));
+            typelen = sizeof(bstr_tfs);
+            proclen = 0;
+        }
+
+        for (i = 0; i < funcs && SUCCEEDED(hr); i++)
+        {
+            hr = ITypeInfo_GetFuncDesc(typeinfo, i, (FUNCDESC **)&desc);
+            if (FAILED(hr)) break;
+
+            len = proclen;
+            hr = write_proc_fs(typeinfo, desc, parentfuncs + i, proc, &proclen, type, &typelen);
+            if (FAILED(hr)) TRACE("method %u can't be described, falling back\n", parentfuncs + i);
+            if (proclen > 0xffff || typelen > 0xffff) hr = E_NOTIMPL;
+            offset[parentfuncs + i] = len;
+
+            ITypeInfo_ReleaseFuncDesc(typeinfo, (FUNCDESC *)desc);
+        }
+    }
+
+    if (FAILED(hr))
+    {
+        HeapFree(GetProcessHeap(), 0, type);
+        HeapFree(GetProcessHeap(), 0, proc);
+        HeapFree(GetProcessHeap(), 0, offset);
+        return hr;
+    }
+
+    *type_ret = type;
+    *proc_ret = proc;
+    *offset_ret = offset;
+    return S_OK;
+}
+
+static USER_MARSHAL_ROUTINE_QUADRUPLE bstr_routines[1];
+
+static void init_stub_desc(MIDL_STUB_DESC *desc, const unsigned char *type)
+{
+    if (!bstr_routines[0].pfnFree)
+    {
+        HMODULE oleaut32 = LoadLibraryA("oleaut32.dll");
+
+        bstr_routines[0].pfnBufferSize = (void *)GetProcAddress(oleaut32, "BSTR_UserSize");
+        bstr_routines[0].pfnMarshall = (void *)GetProcAddress(oleaut32, "BSTR_UserMarshal");
+        bstr_routines[0].pfnUnmarshall = (void *)GetProcAddress(oleaut32, "BSTR_UserUnmarshal");
+        bstr_routines[0].pfnFree = (void *)GetProcAddress(oleaut32, "BSTR_UserFree");
+    }
+
+    desc->pfnAllocate = NdrOleAllocate;
+    desc->pfnFree = NdrOleFree;
+    desc->pFormatTypes = type;
+    desc->fCheckBounds = 1;
+    desc->Version = 0x50002;
+    desc->MIDLVersion = 0x50100a4;
+    desc->aUserMarshalQuadruple = bstr_routines;
+    desc->mFlags = 1;
+}
+
+/* holds the format strings and tables of one interface; the standard proxy
+ * and stub buffers keep it alive through their PS factory reference */
+struct typelib_factory
+{
+    IPSFactoryBuffer IPSFactoryBuffer_iface;
+    LONG refcount;
+    IID iid;
+    IID parent_iid;
+    const IID *delegated_iids[1];
+    PCInterfaceName names[1];
+    CInterfaceProxyVtbl *proxy_vtbls[1];
+    const CInterfaceStubVtbl *stub_vtbls[1];
+    ProxyFileInfo file_info;
+    MIDL_STUB_DESC stub_desc;
+    MIDL_STUBLESS_PROXY_INFO proxy_info;
+    MIDL_SERVER_INFO server_info;
+    CInterfaceStubVtbl stub_vtbl;
+    void **proxy_vtbl;  /* stubless proxy info and iid, followed by the vtable */
+    unsigned short *offset_table;
+    PRPC_STUB_FUNCTION *dispatch_table;
+};
+
+static inline struct typelib_factory *impl_from_IPSFactoryBuffer(IPSFactoryBuffer *iface)
+{
+    return CONTAINING_RECORD(iface, struct typelib_factory, IPSFactoryBuffer_iface);
+}
+
+static HRESULT WINAPI typelib_factory_QueryInterface(IPSFactoryBuffer *iface, REFIID iid, void **out)
+{
+    if (IsEqualIID(iid, &IID_IUnknown) || IsEqualIID(iid, &IID_IPSFactoryBuffer))
+    {
+        *out = iface;
+        IPSFactoryBuffer_AddRef(iface);
+        return S_OK;
+    }
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI typelib_factory_AddRef(IPSFactoryBuffer *iface)
+{
+    struct typelib_factory *factory = impl_from_IPSFactoryBuffer(iface);
+    return InterlockedIncrement(&factory->refcount);
+}
+
+static ULONG WINAPI typelib_factory_Release(IPSFactoryBuffer *iface)
+{
+    struct typelib_factory *factory = impl_from_IPSFactoryBuffer(iface);
+    ULONG refcount = InterlockedDecrement(&factory->refcount);
+
+    if (!refcount)
+    {
+        HeapFree(GetProcessHeap(), 0, (void *)factory->stub_desc.pFormatTypes);
+        HeapFree(GetProcessHeap(), 0, (void *)factory->proxy_info.ProcFormatString);
+        HeapFree(GetProcessHeap(), 0, factory->offset_table);
+        HeapFree(GetProcessHeap(), 0, factory->proxy_vtbl);
+        HeapFree(GetProcessHeap(), 0, factory->dispatch_table);
+        HeapFree(GetProcessHeap(), 0, factory);
+    }
+    return refcount;
+}
+
+/* the proxies and stubs are only created through the functions below */
+static HRESULT WINAPI typelib_factory_CreateProxy(IPSFactoryBuffer *iface, IUnknown *outer, REFIID iid,
+                                                  IRpcProxyBuffer **proxy, void **out)
+{
+    return E_NOTIMPL;
+}
+
+static HRESULT WINAPI typelib_factory_CreateStub(IPSFactoryBuffer *iface, REFIID iid, IUnknown *server,
+                                                 IRpcStubBuffer **stub)
+{
+    return E_NOTIMPL;
+}
+
+static const IPSFactoryBufferVtbl typelib_factory_vtbl =
+{
+    typelib_factory_QueryInterface,
+    typelib_factory_AddRef,
+    typelib_factory_Release,
+    typelib_factory_CreateProxy,
+    typelib_factory_CreateStub
+};
+
+static ULONG WINAPI typelib_stub_Release(IRpcStubBuffer *iface)
+{
+    return NdrCStdStubBuffer_Release(iface, ((CStdStubBuffer *)iface)->pPSFactory);
+}
+
+static ULONG WINAPI typelib_stub_delegating_Release(IRpcStubBuffer *iface)
+{
+    return NdrCStdStubBuffer2_Release(iface, ((CStdStubBuffer *)iface)->pPSFactory);
+}
+
+static const char typelib_name[] = "typelib";
+
+/* describe the interface the way a MIDL generated proxy file would */
+static HRESULT create_factory(ITypeInfo *typeinfo, REFIID iid, struct typelib_factory **ret)
+{
+    struct typelib_factory *factory;
+    const unsigned char *type, *proc;
+    unsigned short *offset;
+    WORD funcs, parentfuncs, i;
+    GUID parentiid;
+    HRESULT hr;
+
+    ITypeInfo_AddRef(typeinfo);
+    hr = get_iface_info(&typeinfo, &funcs, &parentfuncs, &parentiid);
+    if (SUCCEEDED(hr))
+        hr = build_format_strings(typeinfo, funcs, parentfuncs, &type, &proc, &offset);
+    ITypeInfo_Release(typeinfo);
+    if (FAILED(hr)) return hr;
+
+    if (!(factory = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*factory))))
+    {
+        HeapFree(GetProcessHeap(), 0, (void *)type);
+        HeapFree(GetProcessHeap(), 0, (void *)proc);
+        HeapFree(GetProcessHeap(), 0, offset);
+        return E_OUTOFMEMORY;
+    }
+
+    factory->IPSFactoryBuffer_iface.lpVtbl = &typelib_factory_vtbl;
+    factory->refcount = 1;
+    factory->iid = *iid;
+    factory->parent_iid = parentiid;
+    init_stub_desc(&factory->stub_desc, type);
+    factory->proxy_info.pStubDesc = &factory->stub_desc;
+    factory->proxy_info.ProcFormatString = proc;
+    factory->proxy_info.FormatStringOffset = offset;
+    factory->server_info.pStubDesc = &factory->stub_desc;
+    factory->server_info.ProcString = proc;
+    factory->server_info.FmtStringOffset = offset;
+    factory->offset_table = offset;
+
+    factory->stub_vtbl.header.piid = &factory->iid;
+    factory->stub_vtbl.header.pServerInfo = &factory->server_info;
+    factory->stub_vtbl.header.DispatchTableCount = parentfuncs + funcs;
+
+    if (!(factory->proxy_vtbl = HeapAlloc(GetProcessHeap(), 0, (parentfuncs + funcs + 2) * sizeof(void *))))
+    {
+        typelib_factory_Release(&factory->IPSFactoryBuffer_iface);
+        return E_OUTOFMEMORY;
+    }
+    /* call_stubless_func expects the stubless proxy info right before the
+     * iid that precedes the vtable; the inherited methods are left to the
+     * delegating thunks */
+    factory->proxy_vtbl[0] = &factory->proxy_info;
+    factory->proxy_vtbl[1] = &factory->iid;
+    factory->proxy_vtbl[2] = IUnknown_QueryInterface_Proxy;
+    factory->proxy_vtbl[3] = IUnknown_AddRef_Proxy;
+    factory->proxy_vtbl[4] = IUnknown_Release_Proxy;
+    for (i = 3; i < parentfuncs; i++) factory->proxy_vtbl[2 + i] = NULL;
+    for (; i < parentfuncs + funcs; i++) factory->proxy_vtbl[2 + i] = (void *)-1;
+
+    if (IsEqualGUID(&parentiid, &IID_IUnknown))
+    {
+        factory->stub_vtbl.Vtbl = CStdStubBuffer_Vtbl;
+        factory->stub_vtbl.Vtbl.Release = typelib_stub_Release;
+    }
+    else
+    {
+        factory->dispatch_table = HeapAlloc(GetProcessHeap(), 0,
+                                            (parentfuncs + funcs) * sizeof(*factory->dispatch_table));
+        if (!factory->dispatch_table ||
+            !fill_delegated_proxy_table((IUnknownVtbl *)(factory->proxy_vtbl + 2), parentfuncs + funcs))
+        {
+            typelib_factory_Release(&factory->IPSFactoryBuffer_iface);
+            return E_OUTOFMEMORY;
+        }
+        for (i = 0; i < parentfuncs; i++) factory->dispatch_table[i] = NdrStubForwardingFunction;
+        for (; i < parentfuncs + funcs; i++) factory->dispatch_table[i] = (PRPC_STUB_FUNCTION)NdrStubCall2;
+        factory->stub_vtbl.header.pDispatchTable = factory->dispatch_table;
+        factory->stub_vtbl.Vtbl = CStdStubBuffer_Delegating_Vtbl;
+        factory->stub_vtbl.Vtbl.Release = typelib_stub_delegating_Release;
+        factory->delegated_iids[0] = &factory->parent_iid;
+        factory->file_info.pDelegatedIIDs = factory->delegated_iids;
+    }
+
+    factory->names[0] = typelib_name;
+    factory->proxy_vtbls[0] = (CInterfaceProxyVtbl *)factory->proxy_vtbl;
+    factory->stub_vtbls[0] = &factory->stub_vtbl;
+    factory->file_info.pProxyVtblList = (const PCInterfaceProxyVtblList *)factory->proxy_vtbls;
+    factory->file_info.pStubVtblList = (const PCInterfaceStubVtblList *)factory->stub_vtbls;
+    factory->file_info.pNamesArray = factory->names;
+    factory->file_info.TableSize = 1;
+    factory->file_info.TableVersion = 2;
+
+    *ret = factory;
+    return S_OK;
+}
+
+/***********************************************************************
+ *           CreateProxyFromTypeInfo [RPCRT4.@]
+ */
+HRESULT WINAPI CreateProxyFromTypeInfo(ITypeInfo *typeinfo, IUnknown *outer, REFIID iid,
+                                       IRpcProxyBuffer **proxy_buffer, void **out)
+{
+    struct typelib_factory *factory;
+    HRESULT hr;
+
+    TRACE("typeinfo %p, outer %p, iid %s, proxy_buffer %p, out %p\n",
+          typeinfo, outer, debugstr_guid(iid), proxy_buffer, out);
+
+    hr = create_factory(typeinfo, iid, &factory);
+    if (FAILED(hr)) return hr;
+
+    hr = StdProxy_Construct(iid, outer, &factory->file_info, 0, &factory->IPSFactoryBuffer_iface,
+                            proxy_buffer, out);
+    typelib_factory_Release(&factory->IPSFactoryBuffer_iface);
+    return hr;
+}
+
+/***********************************************************************
+ *           CreateStubFromTypeInfo [RPCRT4.@]
+ */
+HRESULT WINAPI CreateStubFromTypeInfo(ITypeInfo *typeinfo, REFIID iid, IUnknown *server,
+                                      IRpcStubBuffer **stub_buffer)
+{
+    struct typelib_factory *factory;
+    HRESULT hr;
+
+    TRACE("typeinfo %p, iid %s, server %p, stub_buffer %p\n",
+          typeinfo, debugstr_guid(iid), server, stub_buffer);
+
+    hr = create_factory(typeinfo, iid, &factory);
+    if (FAILED(hr)) return hr;
+
+    if (factory->file_info.pDelegatedIIDs)
+        hr = CStdStubBuffer_Delegating_Construct(iid, server, typelib_name, &factory->stub_vtbl,
+                                                 &factory->parent_iid, &factory->IPSFactoryBuffer_iface,
+                                                 stub_buffer);
+    else
+        hr = CStdStubBuffer_Construct(iid, server, typelib_name, &factory->stub_vtbl,
+                                      &factory->IPSFactoryBuffer_iface, stub_buffer);
+    typelib_factory_Release(&factory->IPSFactoryBuffer_iface);
+    return hr;
+}
@@ -92,6 +92,7 @@ typedef struct _RpcConnection
   USHORT NextCallId;
   struct _RpcConnection* Next;
   struct _RpcBinding *server_binding;
+  struct list ready_entry; /* entry in the list of connections waiting for a worker thread */
 } RpcConnection;
 
 struct connection_ops {
@@ -114,6 +115,9 @@ struct connection_ops {
   RPC_STATUS (*impersonate_client)(RpcConnection *conn);
   RPC_STATUS (*revert_to_self)(RpcConnection *conn);
   RPC_STATUS (*inquire_auth_client)(RpcConnection *, RPC_AUTHZ_HANDLE *, RPC_WSTR *, ULONG *, ULONG *, ULONG *, ULONG);
+  /* server-only: returns immediately and calls RPCRT4_client_ready once the
+   * next packet can be read from the connection */
+  RPC_STATUS (*wait_for_packet)(RpcConnection *conn);
 };
 
 /* don't know what MS's structure looks like */
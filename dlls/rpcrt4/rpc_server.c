@@ -48,15 +48,6 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(rpc);
 
-typedef struct _RpcPacket
-{
-  struct _RpcConnection* conn;
-  RpcPktHdr* hdr;
-  RPC_MESSAGE* msg;
-  unsigned char *auth_data;
-  ULONG auth_length;
-} RpcPacket;
-
 typedef struct _RpcObjTypeMap
 {
   /* FIXME: a hash table would be better. */
@@ -110,6 +101,29 @@ static HANDLE listen_done_event;
 
 static UUID uuid_nil;
 
+/* connections with a packet waiting to be read by a worker thread */
+static struct list ready_connections = LIST_INIT(ready_connections);
+static unsigned int ready_count;
+/* number of worker threads, and how many of them are waiting for work */
+static unsigned int worker_count, idle_worker_count;
+/* maximum number of packets handled at the same time, as passed to the
+ * RpcServerListen call of the current listening session */
+static UINT listen_max_calls = RPC_C_LISTEN_MAX_CALLS_DEFAULT;
+/* released once for every queued connection */
+static HANDLE worker_semaphore;
+
+/* how long an idle worker thread waits for more packets before exiting */
+#define WORKER_IDLE_TIMEOUT 10000
+
+static CRITICAL_SECTION worker_cs;
+static CRITICAL_SECTION_DEBUG worker_cs_debug =
+{
+    0, 0, &worker_cs,
+    { &worker_cs_debug.ProcessLocksList, &worker_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": worker_cs") }
+};
+static CRITICAL_SECTION worker_cs = { &worker_cs_debug, -1, 0, 0, 0, 0 };
+
 static inline RpcObjTypeMap *LookupObjTypeMap(UUID *ObjUuid)
 {
   RpcObjTypeMap *rslt = RpcObjTypeMaps;
@@ -535,112 +549,168 @@ static void RPCRT4_process_packet(RpcConnection* conn, RpcPktHdr* hdr,
   HeapFree(GetProcessHeap(), 0, auth_data);
 }
 
-static DWORD CALLBACK RPCRT4_worker_thread(LPVOID the_arg)
+/* hands the connection back to its transport, which calls RPCRT4_client_ready
+ * once the next packet can be read */
+static void RPCRT4_wait_for_packet(RpcConnection *conn)
 {
-  RpcPacket *pkt = the_arg;
-  RPCRT4_process_packet(pkt->conn, pkt->hdr, pkt->msg, pkt->auth_data,
-                        pkt->auth_length);
-  RPCRT4_ReleaseConnection(pkt->conn);
-  HeapFree(GetProcessHeap(), 0, pkt);
-  return 0;
+  RPC_STATUS status;
+
+  if (!conn->ops->wait_for_packet) {
+    FIXME("server connections not supported for %s\n", conn->ops->name);
+    RPCRT4_ReleaseConnection(conn);
+    return;
+  }
+
+  status = conn->ops->wait_for_packet(conn);
+  if (status != RPC_S_OK) {
+    ERR("couldn't wait for the next packet, error %u\n", status);
+    RPCRT4_ReleaseConnection(conn);
+  }
 }
 
-static DWORD CALLBACK RPCRT4_io_thread(LPVOID the_arg)
+static void RPCRT4_receive_packet(RpcConnection *conn)
 {
-  RpcConnection* conn = the_arg;
   RpcPktHdr *hdr;
   RPC_MESSAGE *msg;
   RPC_STATUS status;
-  RpcPacket *packet;
   unsigned char *auth_data;
   ULONG auth_length;
 
   TRACE("(%p)\n", conn);
 
-  for (;;) {
-    msg = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(RPC_MESSAGE));
-    if (!msg) break;
+  msg = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(RPC_MESSAGE));
+  if (!msg) goto fail;
 
-    status = RPCRT4_ReceiveWithAuth(conn, &hdr, msg, &auth_data, &auth_length);
-    if (status != RPC_S_OK) {
-      WARN("receive failed with error %x\n", status);
-      HeapFree(GetProcessHeap(), 0, msg);
-      break;
-    }
+  status = RPCRT4_ReceiveWithAuth(conn, &hdr, msg, &auth_data, &auth_length);
+  if (status != RPC_S_OK) {
+    WARN("receive failed with error %x\n", status);
+    HeapFree(GetProcessHeap(), 0, msg);
+    goto fail;
+  }
 
-    switch (hdr->common.ptype) {
-    case PKT_BIND:
-      TRACE("got bind packet\n");
+  switch (hdr->common.ptype) {
+  case PKT_BIND:
+    TRACE("got bind packet\n");
 
-      status = process_bind_packet(conn, &hdr->bind, msg, auth_data,
-                                   auth_length);
-      break;
+    status = process_bind_packet(conn, &hdr->bind, msg, auth_data,
+                                 auth_length);
+    break;
 
-    case PKT_REQUEST:
-      TRACE("got request packet\n");
+  case PKT_REQUEST:
+    TRACE("got request packet\n");
 
-      packet = HeapAlloc(GetProcessHeap(), 0, sizeof(RpcPacket));
-      if (!packet) {
-        I_RpcFree(msg->Buffer);
-        RPCRT4_FreeHeader(hdr);
-        HeapFree(GetProcessHeap(), 0, msg);
-        HeapFree(GetProcessHeap(), 0, auth_data);
-        goto exit;
-      }
-      packet->conn = RPCRT4_GrabConnection( conn );
-      packet->hdr = hdr;
-      packet->msg = msg;
-      packet->auth_data = auth_data;
-      packet->auth_length = auth_length;
-      if (!QueueUserWorkItem(RPCRT4_worker_thread, packet, WT_EXECUTELONGFUNCTION)) {
-        ERR("couldn't queue work item for worker thread, error was %d\n", GetLastError());
-        HeapFree(GetProcessHeap(), 0, packet);
-        status = RPC_S_OUT_OF_RESOURCES;
-      } else {
-        continue;
-      }
-      break;
+    /* the next packet can arrive while this request is being processed */
+    RPCRT4_wait_for_packet(RPCRT4_GrabConnection(conn));
+    RPCRT4_process_packet(conn, hdr, msg, auth_data, auth_length);
+    RPCRT4_ReleaseConnection(conn);
+    return;
 
-    case PKT_AUTH3:
-      TRACE("got auth3 packet\n");
+  case PKT_AUTH3:
+    TRACE("got auth3 packet\n");
 
-      status = process_auth3_packet(conn, &hdr->common, msg, auth_data,
-                                    auth_length);
-      break;
-    default:
-      FIXME("unhandled packet type %u\n", hdr->common.ptype);
-      break;
-    }
+    status = process_auth3_packet(conn, &hdr->common, msg, auth_data,
+                                  auth_length);
+    break;
+  default:
+    FIXME("unhandled packet type %u\n", hdr->common.ptype);
+    break;
+  }
 
-    I_RpcFree(msg->Buffer);
-    RPCRT4_FreeHeader(hdr);
-    HeapFree(GetProcessHeap(), 0, msg);
-    HeapFree(GetProcessHeap(), 0, auth_data);
+  I_RpcFree(msg->Buffer);
+  RPCRT4_FreeHeader(hdr);
+  HeapFree(GetProcessHeap(), 0, msg);
+  HeapFree(GetProcessHeap(), 0, auth_data);
 
-    if (status != RPC_S_OK) {
-      WARN("processing packet failed with error %u\n", status);
-      break;
-    }
+  if (status != RPC_S_OK) {
+    WARN("processing packet failed with error %u\n", status);
+    goto fail;
   }
-exit:
+
+  RPCRT4_wait_for_packet(conn);
+  return;
+
+fail:
   RPCRT4_ReleaseConnection(conn);
-  return 0;
 }
 
-void RPCRT4_new_client(RpcConnection* conn)
+/* Connections don't have a thread of their own: their transport waits for
+ * packets on all of them together, and each packet is then read and handled
+ * by one of a shared set of worker threads. Worker threads are only created
+ * while there are more ready connections than idle workers and fewer than
+ * listen_max_calls workers, and exit after being idle for a while. */
+static DWORD CALLBACK RPCRT4_worker_thread(LPVOID the_arg)
+{
+  struct list *ptr;
+  DWORD res;
+
+  for (;;) {
+    EnterCriticalSection(&worker_cs);
+    if ((ptr = list_head(&ready_connections))) {
+      list_remove(ptr);
+      ready_count--;
+      LeaveCriticalSection(&worker_cs);
+
+      RPCRT4_receive_packet(LIST_ENTRY(ptr, RpcConnection, ready_entry));
+      continue;
+    }
+    idle_worker_count++;
+    LeaveCriticalSection(&worker_cs);
+
+    res = WaitForSingleObject(worker_semaphore, WORKER_IDLE_TIMEOUT);
+
+    EnterCriticalSection(&worker_cs);
+    idle_worker_count--;
+    if (res != WAIT_OBJECT_0 && list_empty(&ready_connections)) {
+      worker_count--;
+      LeaveCriticalSection(&worker_cs);
+      TRACE("idle worker thread exiting\n");
+      return 0;
+    }
+    LeaveCriticalSection(&worker_cs);
+  }
+}
+
+/* called by the transport when the next packet can be read from the
+ * connection, queues it for the worker threads */
+void RPCRT4_client_ready(RpcConnection* conn)
 {
-  HANDLE thread = CreateThread(NULL, 0, RPCRT4_io_thread, conn, 0, NULL);
-  if (!thread) {
-    DWORD err = GetLastError();
-    ERR("failed to create thread, error=%08x\n", err);
+  HANDLE thread;
+
+  EnterCriticalSection(&worker_cs);
+
+  if (!worker_semaphore &&
+      !(worker_semaphore = CreateSemaphoreW(NULL, 0, MAXLONG, NULL))) {
+    LeaveCriticalSection(&worker_cs);
+    ERR("couldn't create worker semaphore, error was %d\n", GetLastError());
     RPCRT4_ReleaseConnection(conn);
+    return;
+  }
+
+  list_add_tail(&ready_connections, &conn->ready_entry);
+  ready_count++;
+
+  if (ready_count > idle_worker_count && worker_count < listen_max_calls) {
+    if ((thread = CreateThread(NULL, 0, RPCRT4_worker_thread, NULL, 0, NULL))) {
+      worker_count++;
+      CloseHandle(thread);
+    } else if (!worker_count) {
+      ERR("couldn't create worker thread, error was %d\n", GetLastError());
+      list_remove(&conn->ready_entry);
+      ready_count--;
+      LeaveCriticalSection(&worker_cs);
+      RPCRT4_ReleaseConnection(conn);
+      return;
+    }
   }
-  /* we could set conn->thread, but then we'd have to make the io_thread wait
-   * for that, otherwise the thread might finish, destroy the connection, and
-   * free the memory we'd write to before we did, causing crashes and stuff -
-   * so let's implement that later, when we really need conn->thread */
 
-  CloseHandle( thread );
+  LeaveCriticalSection(&worker_cs);
+
+  ReleaseSemaphore(worker_semaphore, 1, NULL);
+}
+
+void RPCRT4_new_client(RpcConnection* conn)
+{
+  RPCRT4_wait_for_packet(conn);
 }
 
 static DWORD CALLBACK RPCRT4_server_thread(LPVOID the_arg)
@@ -727,7 +797,7 @@ done:
   return status;
 }
 
-static RPC_STATUS RPCRT4_start_listen(BOOL auto_listen)
+static RPC_STATUS RPCRT4_start_listen(BOOL auto_listen, UINT max_calls)
 {
   RPC_STATUS status = RPC_S_ALREADY_LISTENING;
   RpcServerProtseq *cps;
@@ -738,6 +808,12 @@ static RPC_STATUS RPCRT4_start_listen(BOOL auto_listen)
   if (auto_listen || (manual_listen_count++ == 0))
   {
     status = RPC_S_OK;
+    if (!auto_listen && max_calls)
+    {
+      EnterCriticalSection(&worker_cs);
+      listen_max_calls = max_calls;
+      LeaveCriticalSection(&worker_cs);
+    }
     if (++listen_count == 1)
       std_listen = TRUE;
   }
@@ -767,6 +843,12 @@ static void RPCRT4_stop_listen(BOOL auto_listen)
   EnterCriticalSection(&listen_cs);
   if (auto_listen || (--manual_listen_count == 0))
   {
+    if (!auto_listen)
+    {
+      EnterCriticalSection(&worker_cs);
+      listen_max_calls = RPC_C_LISTEN_MAX_CALLS_DEFAULT;
+      LeaveCriticalSection(&worker_cs);
+    }
     if (listen_count != 0 && --listen_count == 0) {
       RpcServerProtseq *cps;
 
@@ -1152,7 +1234,7 @@ RPC_STATUS WINAPI RpcServerRegisterIf2( RPC_IF_HANDLE IfSpec, UUID* MgrTypeUuid,
   LeaveCriticalSection(&server_cs);
 
   if (sif->Flags & RPC_IF_AUTOLISTEN)
-      RPCRT4_start_listen(TRUE);
+      RPCRT4_start_listen(TRUE, 0);
 
   return RPC_S_OK;
 }
@@ -1509,7 +1591,7 @@ RPC_STATUS WINAPI RpcServerListen( UINT MinimumCallThreads, UINT MaxCalls, UINT
   if (list_empty(&protseqs))
     return RPC_S_NO_PROTSEQS_REGISTERED;
 
-  status = RPCRT4_start_listen(FALSE);
+  status = RPCRT4_start_listen(FALSE, MaxCalls);
 
   if (DontWait || (status != RPC_S_OK)) return status;
 
@@ -77,6 +77,7 @@ typedef struct _RpcServerInterface
 } RpcServerInterface;
 
 void RPCRT4_new_client(RpcConnection* conn) DECLSPEC_HIDDEN;
+void RPCRT4_client_ready(RpcConnection* conn) DECLSPEC_HIDDEN;
 const struct protseq_ops *rpcrt4_get_protseq_ops(const char *protseq) DECLSPEC_HIDDEN;
 
 void RPCRT4_destroy_all_protseqs(void) DECLSPEC_HIDDEN;
@@ -113,8 +113,14 @@ typedef struct _RpcConnection_np
 {
   RpcConnection common;
   HANDLE pipe;
-  HANDLE listen_thread;
+  HANDLE event; /* for synchronous reads and writes on the overlapped pipe */
+  OVERLAPPED listen_ovl;
   BOOL listening;
+  BOOL connected; /* a client connected before we started listening */
+  /* server-only: start of the next packet, read by the I/O thread */
+  OVERLAPPED read_ovl;
+  char read_ahead[sizeof(RpcPktCommonHdr)];
+  unsigned int read_ahead_pos, read_ahead_len;
 } RpcConnection_np;
 
 static RpcConnection *rpcrt4_conn_np_alloc(void)
@@ -123,47 +129,81 @@ static RpcConnection *rpcrt4_conn_np_alloc(void)
   return &npc->common;
 }
 
-static DWORD CALLBACK listen_thread(void *arg)
+static HANDLE get_np_event(RpcConnection_np *npc)
 {
-  RpcConnection_np *npc = arg;
+  HANDLE event = InterlockedExchangePointer(&npc->event, NULL);
+  return event ? event : CreateEventW(NULL, TRUE, FALSE, NULL);
+}
+
+static void release_np_event(RpcConnection_np *npc, HANDLE event)
+{
+  event = InterlockedExchangePointer(&npc->event, event);
+  if (event)
+    CloseHandle(event);
+}
+
+/* starts an overlapped wait for a client, event is set when one connects */
+static RPC_STATUS rpcrt4_conn_listen_pipe(RpcConnection_np *npc, HANDLE event)
+{
+  if (npc->listening)
+    return RPC_S_OK;
+
   for (;;)
   {
-      if (ConnectNamedPipe(npc->pipe, NULL))
-          return RPC_S_OK;
+      memset(&npc->listen_ovl, 0, sizeof(npc->listen_ovl));
+      npc->listen_ovl.hEvent = event;
+      if (ConnectNamedPipe(npc->pipe, &npc->listen_ovl))
+          break;
 
       switch(GetLastError())
       {
-      case ERROR_PIPE_CONNECTED:
+      case ERROR_IO_PENDING:
+          npc->listening = TRUE;
           return RPC_S_OK;
-      case ERROR_HANDLES_CLOSED:
-          /* connection closed during listen */
-          return RPC_S_NO_CONTEXT_AVAILABLE;
+      case ERROR_PIPE_CONNECTED:
+          goto connected;
       case ERROR_NO_DATA_DETECTED:
           /* client has disconnected, retry */
           DisconnectNamedPipe( npc->pipe );
           break;
       default:
-          npc->listening = FALSE;
           WARN("Couldn't ConnectNamedPipe (error was %d)\n", GetLastError());
           return RPC_S_OUT_OF_RESOURCES;
       }
   }
+
+connected:
+  npc->listening = TRUE;
+  npc->connected = TRUE;
+  SetEvent(event);
+  return RPC_S_OK;
 }
 
-static RPC_STATUS rpcrt4_conn_listen_pipe(RpcConnection_np *npc)
+/* checks whether a client connected to a listening pipe */
+static BOOL rpcrt4_conn_pipe_connected(RpcConnection_np *npc)
 {
-  if (npc->listening)
-    return RPC_S_OK;
+  DWORD size;
 
-  npc->listening = TRUE;
-  npc->listen_thread = CreateThread(NULL, 0, listen_thread, npc, 0, NULL);
-  if (!npc->listen_thread)
+  if (!npc->listening)
+    return FALSE;
+  if (!npc->connected && !GetOverlappedResult(npc->pipe, &npc->listen_ovl, &size, FALSE))
   {
+      switch (GetLastError())
+      {
+      case ERROR_IO_INCOMPLETE:
+          return FALSE;
+      case ERROR_NO_DATA_DETECTED:
+          /* client has disconnected, listen again */
+          DisconnectNamedPipe( npc->pipe );
+          break;
+      default:
+          WARN("Couldn't ConnectNamedPipe (error was %d)\n", GetLastError());
+          break;
+      }
       npc->listening = FALSE;
-      ERR("Couldn't create listen thread (error was %d)\n", GetLastError());
-      return RPC_S_OUT_OF_RESOURCES;
+      return FALSE;
   }
-  return RPC_S_OK;
+  return TRUE;
 }
 
 static RPC_STATUS rpcrt4_conn_create_pipe(RpcConnection *Connection, LPCSTR pname)
@@ -171,7 +211,7 @@ static RPC_STATUS rpcrt4_conn_create_pipe(RpcConnection *Connection, LPCSTR pnam
   RpcConnection_np *npc = (RpcConnection_np *) Connection;
   TRACE("listening on %s\n", pname);
 
-  npc->pipe = CreateNamedPipeA(pname, PIPE_ACCESS_DUPLEX,
+  npc->pipe = CreateNamedPipeA(pname, PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
                                PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE,
                                PIPE_UNLIMITED_INSTANCES,
                                RPC_MAX_PACKET_SIZE, RPC_MAX_PACKET_SIZE, 5000, NULL);
@@ -184,7 +224,7 @@ static RPC_STATUS rpcrt4_conn_create_pipe(RpcConnection *Connection, LPCSTR pnam
   }
 
   /* Note: we don't call ConnectNamedPipe here because it must be done in the
-   * server thread as the thread must be alertable */
+   * server thread, which owns the overlapped wait */
   return RPC_S_OK;
 }
 
@@ -368,10 +408,9 @@ static void rpcrt4_conn_np_handoff(RpcConnection_np *old_npc, RpcConnection_np *
    * to the child, then reopen the server binding to continue listening */
 
   new_npc->pipe = old_npc->pipe;
-  new_npc->listen_thread = old_npc->listen_thread;
   old_npc->pipe = 0;
-  old_npc->listen_thread = 0;
   old_npc->listening = FALSE;
+  old_npc->connected = FALSE;
 }
 
 static RPC_STATUS rpcrt4_ncacn_np_handoff(RpcConnection *old_conn, RpcConnection *new_conn)
@@ -415,11 +454,32 @@ static int rpcrt4_conn_np_read(RpcConnection *Connection,
   char *buf = buffer;
   BOOL ret = TRUE;
   unsigned int bytes_left = count;
+  OVERLAPPED ovl;
+  HANDLE event;
+
+  /* start with what the I/O thread has already read */
+  if (npc->read_ahead_pos < npc->read_ahead_len)
+  {
+    unsigned int len = min(bytes_left, npc->read_ahead_len - npc->read_ahead_pos);
+    memcpy(buf, npc->read_ahead + npc->read_ahead_pos, len);
+    npc->read_ahead_pos += len;
+    bytes_left -= len;
+    buf += len;
+  }
+  if (!bytes_left)
+    return count;
+
+  if (!(event = get_np_event(npc)))
+    return -1;
 
   while (bytes_left)
   {
     DWORD bytes_read;
-    ret = ReadFile(npc->pipe, buf, bytes_left, &bytes_read, NULL);
+    memset(&ovl, 0, sizeof(ovl));
+    ovl.hEvent = event;
+    ret = ReadFile(npc->pipe, buf, bytes_left, NULL, &ovl);
+    if (ret || GetLastError() == ERROR_IO_PENDING || GetLastError() == ERROR_MORE_DATA)
+      ret = GetOverlappedResult(npc->pipe, &ovl, &bytes_read, TRUE);
     if (!ret && GetLastError() == ERROR_MORE_DATA)
         ret = TRUE;
     if (!ret || !bytes_read)
@@ -427,6 +487,7 @@ static int rpcrt4_conn_np_read(RpcConnection *Connection,
     bytes_left -= bytes_read;
     buf += bytes_read;
   }
+  release_np_event(npc, event);
   return ret ? count : -1;
 }
 
@@ -437,16 +498,26 @@ static int rpcrt4_conn_np_write(RpcConnection *Connection,
   const char *buf = buffer;
   BOOL ret = TRUE;
   unsigned int bytes_left = count;
+  OVERLAPPED ovl;
+  HANDLE event;
+
+  if (!(event = get_np_event(npc)))
+    return -1;
 
   while (bytes_left)
   {
     DWORD bytes_written;
-    ret = WriteFile(npc->pipe, buf, bytes_left, &bytes_written, NULL);
+    memset(&ovl, 0, sizeof(ovl));
+    ovl.hEvent = event;
+    ret = WriteFile(npc->pipe, buf, bytes_left, NULL, &ovl);
+    if (ret || GetLastError() == ERROR_IO_PENDING)
+      ret = GetOverlappedResult(npc->pipe, &ovl, &bytes_written, TRUE);
     if (!ret || !bytes_written)
         break;
     bytes_left -= bytes_written;
     buf += bytes_written;
   }
+  release_np_event(npc, event);
   return ret ? count : -1;
 }
 
@@ -458,13 +529,76 @@ static int rpcrt4_conn_np_close(RpcConnection *Connection)
     CloseHandle(npc->pipe);
     npc->pipe = 0;
   }
-  if (npc->listen_thread) {
-    CloseHandle(npc->listen_thread);
-    npc->listen_thread = 0;
+  npc->listening = FALSE;
+  npc->connected = FALSE;
+  if (npc->event) {
+    CloseHandle(npc->event);
+    npc->event = 0;
   }
   return 0;
 }
 
+/* Server connections don't have a thread of their own waiting for packets:
+ * the header reads of all of them are started from, and completed in, a
+ * single alertable I/O thread. */
+static HANDLE np_io_thread;
+
+static CRITICAL_SECTION np_io_cs;
+static CRITICAL_SECTION_DEBUG np_io_cs_debug =
+{
+    0, 0, &np_io_cs,
+    { &np_io_cs_debug.ProcessLocksList, &np_io_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": np_io_cs") }
+};
+static CRITICAL_SECTION np_io_cs = { &np_io_cs_debug, -1, 0, 0, 0, 0 };
+
+static DWORD CALLBACK rpcrt4_np_io_thread(void *arg)
+{
+  for (;;)
+    SleepEx(INFINITE, TRUE);
+  return 0;
+}
+
+static void CALLBACK rpcrt4_np_read_done(DWORD error, DWORD size, OVERLAPPED *ovl)
+{
+  RpcConnection_np *npc = CONTAINING_RECORD(ovl, RpcConnection_np, read_ovl);
+
+  /* errors are reported by the following read on the pipe */
+  if (!error || error == ERROR_MORE_DATA)
+    npc->read_ahead_len = size;
+  RPCRT4_client_ready(&npc->common);
+}
+
+static void CALLBACK rpcrt4_np_start_read(ULONG_PTR arg)
+{
+  RpcConnection_np *npc = (RpcConnection_np *)arg;
+
+  npc->read_ahead_pos = npc->read_ahead_len = 0;
+  memset(&npc->read_ovl, 0, sizeof(npc->read_ovl));
+  if (!ReadFileEx(npc->pipe, npc->read_ahead, sizeof(npc->read_ahead), &npc->read_ovl,
+                  rpcrt4_np_read_done))
+  {
+    WARN("ReadFileEx failed with error %d\n", GetLastError());
+    RPCRT4_client_ready(&npc->common);
+  }
+}
+
+static RPC_STATUS rpcrt4_conn_np_wait_for_packet(RpcConnection *Connection)
+{
+  EnterCriticalSection(&np_io_cs);
+  if (!np_io_thread && !(np_io_thread = CreateThread(NULL, 0, rpcrt4_np_io_thread, NULL, 0, NULL)))
+  {
+    LeaveCriticalSection(&np_io_cs);
+    ERR("Couldn't create I/O thread (error was %d)\n", GetLastError());
+    return RPC_S_OUT_OF_RESOURCES;
+  }
+  LeaveCriticalSection(&np_io_cs);
+
+  if (!QueueUserAPC(rpcrt4_np_start_read, np_io_thread, (ULONG_PTR)Connection))
+    return RPC_S_OUT_OF_RESOURCES;
+  return RPC_S_OK;
+}
+
 static void rpcrt4_conn_np_cancel_call(RpcConnection *Connection)
 {
     /* FIXME: implement when named pipe writes use overlapped I/O */
@@ -635,13 +769,17 @@ typedef struct _RpcServerProtseq_np
 {
     RpcServerProtseq common;
     HANDLE mgr_event;
+    HANDLE listen_event; /* set when a client connects to any of the pipes */
 } RpcServerProtseq_np;
 
 static RpcServerProtseq *rpcrt4_protseq_np_alloc(void)
 {
     RpcServerProtseq_np *ps = HeapAlloc(GetProcessHeap(), 0, sizeof(*ps));
     if (ps)
+    {
         ps->mgr_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+        ps->listen_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    }
     return &ps->common;
 }
 
@@ -659,21 +797,16 @@ static void *rpcrt4_protseq_np_get_wait_array(RpcServerProtseq *protseq, void *p
     
     EnterCriticalSection(&protseq->cs);
     
-    /* open and count connections */
-    *count = 1;
+    /* open connections, all of them share the listen event so the number of
+     * pipes isn't limited by the number of objects we can wait on */
     conn = CONTAINING_RECORD(protseq->conn, RpcConnection_np, common);
     while (conn) {
-        rpcrt4_conn_listen_pipe(conn);
-        if (conn->listen_thread)
-            (*count)++;
+        rpcrt4_conn_listen_pipe(conn, npps->listen_event);
         conn = CONTAINING_RECORD(conn->common.Next, RpcConnection_np, common);
     }
     
-    /* make array of connections */
-    if (objs)
-        objs = HeapReAlloc(GetProcessHeap(), 0, objs, *count*sizeof(HANDLE));
-    else
-        objs = HeapAlloc(GetProcessHeap(), 0, *count*sizeof(HANDLE));
+    if (!objs)
+        objs = HeapAlloc(GetProcessHeap(), 0, 2*sizeof(HANDLE));
     if (!objs)
     {
         ERR("couldn't allocate objs\n");
@@ -682,13 +815,8 @@ static void *rpcrt4_protseq_np_get_wait_array(RpcServerProtseq *protseq, void *p
     }
     
     objs[0] = npps->mgr_event;
-    *count = 1;
-    conn = CONTAINING_RECORD(protseq->conn, RpcConnection_np, common);
-    while (conn) {
-        if ((objs[*count] = conn->listen_thread))
-            (*count)++;
-        conn = CONTAINING_RECORD(conn->common.Next, RpcConnection_np, common);
-    }
+    objs[1] = npps->listen_event;
+    *count = 2;
     LeaveCriticalSection(&protseq->cs);
     return objs;
 }
@@ -700,7 +828,6 @@ static void rpcrt4_protseq_np_free_wait_array(RpcServerProtseq *protseq, void *a
 
 static int rpcrt4_protseq_np_wait_for_new_connection(RpcServerProtseq *protseq, unsigned int count, void *wait_array)
 {
-    HANDLE b_handle;
     HANDLE *objs = wait_array;
     DWORD res;
     RpcConnection *cconn;
@@ -727,32 +854,21 @@ static int rpcrt4_protseq_np_wait_for_new_connection(RpcServerProtseq *protseq,
     }
     else
     {
-        b_handle = objs[res - WAIT_OBJECT_0];
-        /* find which connection got a RPC */
+        /* find which connections got a client */
         EnterCriticalSection(&protseq->cs);
         conn = CONTAINING_RECORD(protseq->conn, RpcConnection_np, common);
         while (conn) {
-            if (b_handle == conn->listen_thread) break;
-            conn = CONTAINING_RECORD(conn->common.Next, RpcConnection_np, common);
-        }
-        cconn = NULL;
-        if (conn)
-        {
-            DWORD exit_code;
-            if (GetExitCodeThread(conn->listen_thread, &exit_code) && exit_code == RPC_S_OK)
+            if (rpcrt4_conn_pipe_connected(conn))
+            {
+                cconn = NULL;
                 RPCRT4_SpawnConnection(&cconn, &conn->common);
-            CloseHandle(conn->listen_thread);
-            conn->listen_thread = 0;
+                if (cconn)
+                    RPCRT4_new_client(cconn);
+            }
+            conn = CONTAINING_RECORD(conn->common.Next, RpcConnection_np, common);
         }
-        else
-            ERR("failed to locate connection for handle %p\n", b_handle);
         LeaveCriticalSection(&protseq->cs);
-        if (cconn)
-        {
-            RPCRT4_new_client(cconn);
-            return 1;
-        }
-        else return -1;
+        return 1;
     }
 }
 
@@ -1024,6 +1140,7 @@ typedef struct _RpcConnection_tcp
   int sock;
 #ifdef HAVE_SOCKETPAIR
   int cancel_fds[2];
+  struct list io_entry; /* entry in tcp_io_conns */
 #else
   HANDLE sock_event;
   HANDLE cancel_event;
@@ -1532,6 +1649,154 @@ static int rpcrt4_conn_tcp_wait_for_incoming_data(RpcConnection *Connection)
     return 0;
 }
 
+#ifdef HAVE_SOCKETPAIR
+
+/* Server connections don't have a thread of their own waiting for packets:
+ * a single I/O thread polls all of them. */
+static struct list tcp_io_conns = LIST_INIT(tcp_io_conns);
+static int tcp_io_fds[2] = { -1, -1 };
+static BOOL tcp_io_thread_running;
+
+static CRITICAL_SECTION tcp_io_cs;
+static CRITICAL_SECTION_DEBUG tcp_io_cs_debug =
+{
+    0, 0, &tcp_io_cs,
+    { &tcp_io_cs_debug.ProcessLocksList, &tcp_io_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": tcp_io_cs") }
+};
+static CRITICAL_SECTION tcp_io_cs = { &tcp_io_cs_debug, -1, 0, 0, 0, 0 };
+
+static DWORD CALLBACK rpcrt4_tcp_io_thread(void *arg)
+{
+  struct pollfd *pfds = NULL, *new_pfds;
+  RpcConnection_tcp **conns = NULL, **new_conns;
+  RpcConnection_tcp *tcpc;
+  unsigned int count, size = 0, i;
+  char dummy[16];
+
+  for (;;)
+  {
+    EnterCriticalSection(&tcp_io_cs);
+    count = list_count(&tcp_io_conns) + 1;
+    if (count > size)
+    {
+      if (pfds)
+        new_pfds = HeapReAlloc(GetProcessHeap(), 0, pfds, count * sizeof(*pfds));
+      else
+        new_pfds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*pfds));
+      if (new_pfds) pfds = new_pfds;
+      if (conns)
+        new_conns = HeapReAlloc(GetProcessHeap(), 0, conns, count * sizeof(*conns));
+      else
+        new_conns = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*conns));
+      if (new_conns) conns = new_conns;
+      if (new_pfds && new_conns)
+        size = count;
+      else
+      {
+        /* poll what fits, the others are picked up as connections get ready */
+        ERR("couldn't allocate poll array\n");
+        count = size;
+      }
+    }
+    if (!count)
+    {
+      LeaveCriticalSection(&tcp_io_cs);
+      Sleep(100);
+      continue;
+    }
+    pfds[0].fd = tcp_io_fds[0];
+    pfds[0].events = POLLIN;
+    i = 1;
+    LIST_FOR_EACH_ENTRY(tcpc, &tcp_io_conns, RpcConnection_tcp, io_entry)
+    {
+      if (i == count) break;
+      pfds[i].fd = tcpc->sock;
+      pfds[i].events = POLLIN;
+      conns[i++] = tcpc;
+    }
+    LeaveCriticalSection(&tcp_io_cs);
+
+    if (poll(pfds, count, -1) == -1)
+    {
+      if (errno != EINTR)
+        ERR("poll() failed: %s\n", strerror(errno));
+      continue;
+    }
+
+    if (pfds[0].revents & POLLIN)
+      while (read(tcp_io_fds[0], dummy, sizeof(dummy)) > 0);
+
+    for (i = 1; i < count; i++)
+    {
+      if (!pfds[i].revents) continue;
+      EnterCriticalSection(&tcp_io_cs);
+      list_remove(&conns[i]->io_entry);
+      LeaveCriticalSection(&tcp_io_cs);
+      RPCRT4_client_ready(&conns[i]->common);
+    }
+  }
+  return 0;
+}
+
+static RPC_STATUS rpcrt4_conn_tcp_wait_for_packet(RpcConnection *Connection)
+{
+  RpcConnection_tcp *tcpc = (RpcConnection_tcp *) Connection;
+  HANDLE thread;
+  char dummy = 1;
+
+  EnterCriticalSection(&tcp_io_cs);
+  if (!tcp_io_thread_running)
+  {
+    if (tcp_io_fds[0] == -1)
+    {
+      if (socketpair(PF_UNIX, SOCK_STREAM, 0, tcp_io_fds) < 0)
+      {
+        LeaveCriticalSection(&tcp_io_cs);
+        ERR("socketpair() failed: %s\n", strerror(errno));
+        return RPC_S_OUT_OF_RESOURCES;
+      }
+      fcntl(tcp_io_fds[0], F_SETFL, O_NONBLOCK);
+      fcntl(tcp_io_fds[1], F_SETFL, O_NONBLOCK);
+    }
+    if (!(thread = CreateThread(NULL, 0, rpcrt4_tcp_io_thread, NULL, 0, NULL)))
+    {
+      LeaveCriticalSection(&tcp_io_cs);
+      ERR("Couldn't create I/O thread (error was %d)\n", GetLastError());
+      return RPC_S_OUT_OF_RESOURCES;
+    }
+    CloseHandle(thread);
+    tcp_io_thread_running = TRUE;
+  }
+  list_add_tail(&tcp_io_conns, &tcpc->io_entry);
+  LeaveCriticalSection(&tcp_io_cs);
+
+  /* make the I/O thread poll the connection */
+  write(tcp_io_fds[1], &dummy, sizeof(dummy));
+  return RPC_S_OK;
+}
+
+#else /* HAVE_SOCKETPAIR */
+
+static DWORD CALLBACK rpcrt4_tcp_wait_thread(void *arg)
+{
+  RpcConnection_tcp *tcpc = arg;
+
+  rpcrt4_sock_wait_for_recv(tcpc);
+  RPCRT4_client_ready(&tcpc->common);
+  return 0;
+}
+
+static RPC_STATUS rpcrt4_conn_tcp_wait_for_packet(RpcConnection *Connection)
+{
+  /* FIXME: this still ties up a thread pool thread for each idle connection */
+  if (!QueueUserWorkItem(rpcrt4_tcp_wait_thread, Connection, WT_EXECUTELONGFUNCTION))
+    return RPC_S_OUT_OF_RESOURCES;
+  return RPC_S_OK;
+}
+
+#endif /* HAVE_SOCKETPAIR */
+
 static size_t rpcrt4_ncacn_ip_tcp_get_top_of_tower(unsigned char *tower_data,
                                                    const char *networkaddr,
                                                    const char *endpoint)
@@ -3297,6 +3562,7 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_impersonate_client,
     rpcrt4_conn_np_revert_to_self,
     RPCRT4_default_inquire_auth_client,
+    rpcrt4_conn_np_wait_for_packet,
   },
   { "ncalrpc",
     { EPM_PROTOCOL_NCALRPC, EPM_PROTOCOL_PIPE },
@@ -3317,6 +3583,7 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_impersonate_client,
     rpcrt4_conn_np_revert_to_self,
     rpcrt4_ncalrpc_inquire_auth_client,
+    rpcrt4_conn_np_wait_for_packet,
   },
   { "ncacn_ip_tcp",
     { EPM_PROTOCOL_NCACN, EPM_PROTOCOL_TCP },
@@ -3337,6 +3604,7 @@ static const struct connection_ops conn_protseq_list[] = {
     RPCRT4_default_impersonate_client,
     RPCRT4_default_revert_to_self,
     RPCRT4_default_inquire_auth_client,
+    rpcrt4_conn_tcp_wait_for_packet,
   },
   { "ncacn_http",
     { EPM_PROTOCOL_NCACN, EPM_PROTOCOL_HTTP },
@@ -3357,6 +3625,7 @@ static const struct connection_ops conn_protseq_list[] = {
     RPCRT4_default_impersonate_client,
     RPCRT4_default_revert_to_self,
     RPCRT4_default_inquire_auth_client,
+    NULL,
   },
 };
 
@@ -1448,6 +1448,70 @@ void __cdecl s_authinfo_test(unsigned int protseq, int secure)
     }
 }
 
+static DWORD WINAPI
+many_clients_thread(void *arg)
+{
+  unsigned int i, calls = *(unsigned int *)arg;
+  DWORD failures = 0;
+
+  for (i = 0; i < calls; i++)
+    if (square(i) != i * i) failures++;
+  return failures;
+}
+
+static void
+many_clients_test(void)
+{
+  HANDLE threads[32];
+  unsigned int i, count, calls;
+  DWORD start, failures;
+
+  count = winetest_interactive ? sizeof(threads) / sizeof(threads[0]) : 4;
+  calls = winetest_interactive ? 1000 : 10;
+
+  start = GetTickCount();
+  for (i = 0; i < count; i++)
+  {
+    threads[i] = CreateThread(NULL, 0, many_clients_thread, &calls, 0, NULL);
+    ok(threads[i] != NULL, "CreateThread failed with error %u\n", GetLastError());
+  }
+  for (i = 0; i < count; i++)
+  {
+    ok(!WaitForSingleObject(threads[i], 60000), "wait timed out\n");
+    ok(GetExitCodeThread(threads[i], &failures), "GetExitCodeThread\n");
+    ok(!failures, "client %u got %u wrong results\n", i, failures);
+    CloseHandle(threads[i]);
+  }
+  if (winetest_interactive)
+    trace("%u clients making %u calls each took %u ms\n", count, calls, GetTickCount() - start);
+}
+
+/* clients going away while the server waits for their next packet must
+ * not affect the other clients */
+static void
+np_disconnect_test(void)
+{
+  static const char partial_header[] = { 5, 0, 11, 3 };  /* version 5.0, bind, first and last frag */
+  HANDLE pipe;
+  DWORD written;
+
+  /* disconnect without sending anything */
+  ok(WaitNamedPipeA("\\\\." PIPE, 5000), "WaitNamedPipe failed with error %u\n", GetLastError());
+  pipe = CreateFileA("\\\\." PIPE, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+  ok(pipe != INVALID_HANDLE_VALUE, "CreateFile failed with error %u\n", GetLastError());
+  CloseHandle(pipe);
+
+  /* disconnect in the middle of a packet header */
+  ok(WaitNamedPipeA("\\\\." PIPE, 5000), "WaitNamedPipe failed with error %u\n", GetLastError());
+  pipe = CreateFileA("\\\\." PIPE, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+  ok(pipe != INVALID_HANDLE_VALUE, "CreateFile failed with error %u\n", GetLastError());
+  ok(WriteFile(pipe, partial_header, sizeof(partial_header), &written, NULL),
+     "WriteFile failed with error %u\n", GetLastError());
+  CloseHandle(pipe);
+
+  ok(square(5) == 25, "RPC square\n");
+}
+
 static void
 run_tests(void)
 {
@@ -1498,6 +1562,7 @@ client(const char *test)
 
     run_tests();
     authinfo_test(RPC_PROTSEQ_TCP, 0);
+    many_clients_test();
 
     ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
     ok(RPC_S_OK == RpcBindingFree(&IServer_IfHandle), "RpcBindingFree\n");
@@ -1520,6 +1585,7 @@ client(const char *test)
 
     run_tests(); /* can cause RPC_X_BAD_STUB_DATA exception */
     authinfo_test(RPC_PROTSEQ_LRPC, 0);
+    many_clients_test();
 
     ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
     ok(RPC_S_OK == RpcBindingFree(&IServer_IfHandle), "RpcBindingFree\n");
@@ -1542,6 +1608,8 @@ client(const char *test)
 
     run_tests();
     authinfo_test(RPC_PROTSEQ_NMP, 0);
+    many_clients_test();
+    np_disconnect_test();
     stop();
 
     ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
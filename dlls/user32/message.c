@@ -56,6 +56,9 @@ WINE_DECLARE_DEBUG_CHANNEL(key);
 
 #define MAX_PACK_COUNT 4
 
+/* packed message data larger than this is passed to other processes through a section */
+#define MSG_SECTION_THRESHOLD (64 * 1024)
+
 /* the various structures that can be sent in messages, in platform-independent layout */
 struct packed_CREATESTRUCTW
 {
@@ -451,6 +454,41 @@ static inline void push_string( struct packed_message *data, LPCWSTR str )
     push_data( data, str, (strlenW(str) + 1) * sizeof(WCHAR) );
 }
 
+/* check whether the data of a given message can be unpacked in place in a mapped section */
+static inline BOOL is_section_message( UINT message )
+{
+    switch (message)
+    {
+    case WM_COPYDATA:
+    case WM_SETTEXT:
+    case WM_WININICHANGE:
+    case WM_DEVMODECHANGE:
+    case EM_REPLACESEL:
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* copy the packed message data to a section that the receiver can map directly */
+static HANDLE create_message_section( const struct packed_message *data, size_t size )
+{
+    HANDLE section;
+    char *view, *ptr;
+    int i;
+
+    if (!(section = CreateFileMappingW( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size, NULL )))
+        return 0;
+    if (!(view = MapViewOfFile( section, FILE_MAP_WRITE, 0, 0, size )))
+    {
+        CloseHandle( section );
+        return 0;
+    }
+    for (i = 0, ptr = view; i < data->count; ptr += data->size[i], i++)
+        memcpy( ptr, data->data[i], data->size[i] );
+    UnmapViewOfFile( view );
+    return section;
+}
+
 /* make sure that the buffer contains a valid null-terminated Unicode string */
 static inline BOOL check_string( LPCWSTR str, size_t size )
 {
@@ -2733,7 +2771,7 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
     struct user_thread_info *thread_info = get_user_thread_info();
     struct received_message_info info, *old_info;
     unsigned int hw_id = 0;  /* id of previous hardware message */
-    void *buffer;
+    void *buffer, *view = NULL;
     size_t buffer_size = 256;
 
     if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size ))) return FALSE;
@@ -2744,7 +2782,8 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
     for (;;)
     {
         NTSTATUS res;
-        size_t size = 0;
+        size_t size = 0, section_size = 0;
+        HANDLE section = 0;
         const message_data_t *msg_data = buffer;
 
         SERVER_START_REQ( get_message )
@@ -2770,11 +2809,22 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
                 info.msg.pt.y    = 0;
                 hw_id            = 0;
                 thread_info->active_hooks = reply->active_hooks;
+                section          = wine_server_ptr_handle( reply->section );
+                section_size     = reply->section_size;
             }
             else buffer_size = reply->total;
         }
         SERVER_END_REQ;
 
+        if (section)
+        {
+            /* map the data privately, unpacking modifies it in place */
+            if (info.type == MSG_OTHER_PROCESS && is_section_message( info.msg.message ))
+                view = MapViewOfFile( section, FILE_MAP_COPY, 0, 0, section_size );
+            if (!view) TRACE( "failed to map data of msg %x, error %u\n", info.msg.message, GetLastError() );
+            CloseHandle( section );
+        }
+
         if (res)
         {
             HeapFree( GetProcessHeap(), 0, buffer );
@@ -2879,10 +2929,12 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
         case MSG_OTHER_PROCESS:
             info.flags = ISMEX_SEND;
             if (!unpack_message( info.msg.hwnd, info.msg.message, &info.msg.wParam,
-                                 &info.msg.lParam, &buffer, size ))
+                                 &info.msg.lParam, view ? &view : &buffer, view ? section_size : size ))
             {
                 /* ignore it */
                 reply_message( &info, 0, TRUE );
+                if (view) UnmapViewOfFile( view );
+                view = NULL;
                 continue;
             }
             break;
@@ -2950,6 +3002,8 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
                                    WMCHAR_MAP_RECVMESSAGE );
         reply_message( &info, result, TRUE );
         thread_info->receive_info = old_info;
+        if (view) UnmapViewOfFile( view );
+        view = NULL;
 
         /* if some PM_QS* flags were specified, only handle sent messages from now on */
         if (HIWORD(flags) && !changed_mask) flags = PM_QS_SENDMESSAGE | LOWORD(flags);
@@ -3042,6 +3096,8 @@ static BOOL put_message_in_queue( const struct send_message_info *info, size_t *
     unsigned int res;
     int i;
     timeout_t timeout = TIMEOUT_INFINITE;
+    HANDLE section = 0;
+    size_t total = 0;
 
     /* Check for INFINITE timeout for compatibility with Win9x,
      * although Windows >= NT does not do so
@@ -3065,6 +3121,11 @@ static BOOL put_message_in_queue( const struct send_message_info *info, size_t *
             WARN( "cannot pack message %x\n", info->msg );
             return FALSE;
         }
+        if (is_section_message( info->msg ))
+        {
+            for (i = 0; i < data.count; i++) total += data.size[i];
+            if (total >= MSG_SECTION_THRESHOLD) section = create_message_section( &data, total );
+        }
     }
     else if (info->type == MSG_CALLBACK)
     {
@@ -3092,7 +3153,12 @@ static BOOL put_message_in_queue( const struct send_message_info *info, size_t *
         req->timeout = timeout;
 
         if (info->flags & SMTO_ABORTIFHUNG) req->flags |= SEND_MSG_ABORT_IF_HUNG;
-        for (i = 0; i < data.count; i++) wine_server_add_data( req, data.data[i], data.size[i] );
+        if (section)
+        {
+            req->section      = wine_server_obj_handle( section );
+            req->section_size = total;
+        }
+        else for (i = 0; i < data.count; i++) wine_server_add_data( req, data.data[i], data.size[i] );
         if ((res = wine_server_call( req )))
         {
             if (res == STATUS_INVALID_PARAMETER)
@@ -3103,6 +3169,7 @@ static BOOL put_message_in_queue( const struct send_message_info *info, size_t *
         }
     }
     SERVER_END_REQ;
+    if (section) CloseHandle( section );
     return !res;
 }
 
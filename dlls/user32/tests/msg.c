@@ -13186,6 +13186,89 @@ static DWORD CALLBACK wait_idle_thread( void *arg )
     return 0;
 }
 
+static LRESULT CALLBACK copydata_proc( HWND hwnd, UINT msg, WPARAM wp, LPARAM lp )
+{
+    if (msg == WM_COPYDATA)
+    {
+        const COPYDATASTRUCT *cds = (const COPYDATASTRUCT *)lp;
+        const BYTE *data = cds->lpData;
+        DWORD i;
+
+        if (cds->dwData != cds->cbData) return 0;
+        if (!cds->cbData) return !data ? 1 : 0;
+        for (i = 0; i < cds->cbData; i++) if (data[i] != (BYTE)(i * 7)) return 0;
+        return 1;
+    }
+    return DefWindowProcA( hwnd, msg, wp, lp );
+}
+
+static void do_copydata_child( HWND hwnd )
+{
+    static const DWORD sizes[] = { 0, 16, 64 * 1024 - 1, 64 * 1024, 1024 * 1024 };
+    COPYDATASTRUCT cds;
+    BYTE *data;
+    DWORD i, start, elapsed, count = 0, failures = 0;
+    LRESULT res;
+
+    data = HeapAlloc( GetProcessHeap(), 0, 1024 * 1024 );
+    for (i = 0; i < 1024 * 1024; i++) data[i] = i * 7;
+
+    for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++)
+    {
+        cds.dwData = sizes[i];
+        cds.cbData = sizes[i];
+        cds.lpData = sizes[i] ? data : NULL;
+        res = SendMessageA( hwnd, WM_COPYDATA, 0, (LPARAM)&cds );
+        ok( res == 1, "%u: wrong result %lx\n", sizes[i], res );
+    }
+
+    if (winetest_interactive)
+    {
+        cds.dwData = cds.cbData = 1024 * 1024;
+        cds.lpData = data;
+        start = GetTickCount();
+        do
+        {
+            if (SendMessageA( hwnd, WM_COPYDATA, 0, (LPARAM)&cds ) != 1) failures++;
+            count++;
+        } while ((elapsed = GetTickCount() - start) < 1000);
+        ok( !failures, "%u/%u messages failed\n", failures, count );
+        trace( "sent %u 1MB WM_COPYDATA messages in %u ms (%u MB/s)\n",
+               count, elapsed, count * 1000 / max( elapsed, 1 ));
+    }
+
+    HeapFree( GetProcessHeap(), 0, data );
+}
+
+static void test_copydata_messages( char *argv0 )
+{
+    char path[MAX_PATH];
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA startup;
+    HWND hwnd;
+    MSG msg;
+    BOOL ret;
+
+    hwnd = CreateWindowExA( 0, "static", NULL, WS_POPUP, 0, 0, 10, 10, 0, 0, 0, NULL );
+    ok( hwnd != 0, "CreateWindowExA failed, error %u\n", GetLastError() );
+    SetWindowLongPtrA( hwnd, GWLP_WNDPROC, (LONG_PTR)copydata_proc );
+
+    memset( &startup, 0, sizeof(startup) );
+    startup.cb = sizeof(startup);
+    sprintf( path, "%s msg copydata %p", argv0, hwnd );
+    ret = CreateProcessA( NULL, path, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &pi );
+    ok( ret, "CreateProcess '%s' failed err %u.\n", path, GetLastError() );
+    if (ret)
+    {
+        while (MsgWaitForMultipleObjects( 1, &pi.hProcess, FALSE, 30000, QS_ALLINPUT ) == WAIT_OBJECT_0 + 1)
+            while (PeekMessageA( &msg, 0, 0, 0, PM_REMOVE )) DispatchMessageA( &msg );
+        winetest_wait_child_process( pi.hProcess );
+        CloseHandle( pi.hThread );
+        CloseHandle( pi.hProcess );
+    }
+    DestroyWindow( hwnd );
+}
+
 static void test_WaitForInputIdle( char *argv0 )
 {
     char path[MAX_PATH];
@@ -14281,6 +14364,13 @@ START_TEST(msg)
     init_funcs();
 
     argc = winetest_get_mainargs( &test_argv );
+    if (argc >= 4 && !strcmp( test_argv[2], "copydata" ))
+    {
+        HWND hwnd;
+        sscanf( test_argv[3], "%p", &hwnd );
+        do_copydata_child( hwnd );
+        return;
+    }
     if (argc >= 3)
     {
         unsigned int arg;
@@ -14355,6 +14445,7 @@ START_TEST(msg)
     test_wmime_keydown_message();
     test_paint_messages();
     test_interthread_messages();
+    test_copydata_messages( test_argv[0] );
     test_message_conversion();
     test_accelerators();
     test_timers();
@@ -7180,6 +7180,68 @@ todo_wine
     ok(ret, "UnregisterClass(my_window) failed\n");
 }
 
+static void test_window_from_point_many_children(void)
+{
+    /* the large number of children is only used as a benchmark */
+    const int grid = winetest_interactive ? 64 : 12, moves = winetest_interactive ? 1000 : 100;
+    enum { CELL = 8 };
+    HWND parent, hwnd, *children;
+    POINT pt, origin = { 0, 0 };
+    DWORD start, elapsed;
+    int i, x, y;
+
+    parent = CreateWindowExA(WS_EX_TOPMOST, "MainWindowClass", NULL, WS_POPUP | WS_VISIBLE,
+                             100, 100, grid * CELL, grid * CELL, 0, 0, GetModuleHandleA(NULL), NULL);
+    ok(parent != 0, "CreateWindowEx failed\n");
+    ClientToScreen(parent, &origin);
+
+    children = HeapAlloc(GetProcessHeap(), 0, grid * grid * sizeof(*children));
+    for (i = 0; i < grid * grid; i++)
+    {
+        children[i] = CreateWindowExA(0, "static", NULL, WS_CHILD | WS_VISIBLE | SS_NOTIFY,
+                                      (i % grid) * CELL, (i / grid) * CELL, CELL, CELL,
+                                      parent, 0, GetModuleHandleA(NULL), NULL);
+        if (!children[i]) break;
+    }
+    ok(i == grid * grid, "failed to create child %d, error %u\n", i, GetLastError());
+    if (i < grid * grid) goto done;
+    flush_events( TRUE );
+
+    for (i = 0; i < grid * grid; i += grid + 1)
+    {
+        pt.x = origin.x + (i % grid) * CELL + CELL / 2;
+        pt.y = origin.y + (i / grid) * CELL + CELL / 2;
+        hwnd = WindowFromPoint(pt);
+        ok(hwnd == children[i], "%d: expected %p, got %p\n", i, children[i], hwnd);
+    }
+
+    /* move a child on top of its siblings and check that the hit-testing follows */
+    start = GetTickCount();
+    for (i = 0; i < moves; i++)
+    {
+        x = (i * 7) % grid;
+        y = (i * 13) % grid;
+        SetWindowPos(children[0], HWND_TOP, x * CELL + CELL / 2, y * CELL + CELL / 2, 0, 0,
+                     SWP_NOSIZE | SWP_NOACTIVATE);
+        pt.x = origin.x + x * CELL + CELL - 1;
+        pt.y = origin.y + y * CELL + CELL - 1;
+        hwnd = WindowFromPoint(pt);
+        ok(hwnd == children[0], "%d: expected %p, got %p\n", i, children[0], hwnd);
+        if (hwnd != children[0]) break;
+        pt.x = origin.x + x * CELL;
+        pt.y = origin.y + y * CELL;
+        hwnd = WindowFromPoint(pt);
+        if (x || y) ok(hwnd == children[y * grid + x], "%d: expected %p, got %p\n", i, children[y * grid + x], hwnd);
+    }
+    elapsed = GetTickCount() - start;
+    if (winetest_interactive)
+        trace("moved a window %d times among %d siblings in %u ms\n", i, grid * grid, elapsed);
+
+done:
+    DestroyWindow(parent);
+    HeapFree(GetProcessHeap(), 0, children);
+}
+
 static void test_map_points(void)
 {
     BOOL ret;
@@ -7469,10 +7531,111 @@ todo_wine
     DestroyWindow(parent);
 }
 
+static void test_other_process_window_info( char **argv )
+{
+    HWND hwnd, child;
+    RECT window, client, child_rect, rect;
+    DWORD style, ex_style, id;
+    int visible, child_visible;
+
+    sscanf( argv[3], "%p", &hwnd );
+    sscanf( argv[4], "%p", &child );
+    sscanf( argv[5], "%d,%d,%d,%d", &window.left, &window.top, &window.right, &window.bottom );
+    sscanf( argv[6], "%d,%d,%d,%d", &client.left, &client.top, &client.right, &client.bottom );
+    sscanf( argv[7], "%d,%d,%d,%d", &child_rect.left, &child_rect.top, &child_rect.right, &child_rect.bottom );
+    sscanf( argv[8], "%x", &style );
+    sscanf( argv[9], "%x", &ex_style );
+    sscanf( argv[10], "%u", &id );
+    sscanf( argv[11], "%d", &visible );
+    sscanf( argv[12], "%d", &child_visible );
+
+    ok( GetWindowThreadProcessId( hwnd, NULL ) != GetCurrentThreadId(), "window belongs to this thread\n" );
+
+    GetWindowRect( hwnd, &rect );
+    ok( EqualRect( &rect, &window ), "wrong window rect %d,%d-%d,%d\n",
+        rect.left, rect.top, rect.right, rect.bottom );
+    GetClientRect( hwnd, &rect );
+    ok( EqualRect( &rect, &client ), "wrong client rect %d,%d-%d,%d\n",
+        rect.left, rect.top, rect.right, rect.bottom );
+    GetWindowRect( child, &rect );
+    ok( EqualRect( &rect, &child_rect ), "wrong child rect %d,%d-%d,%d\n",
+        rect.left, rect.top, rect.right, rect.bottom );
+    ok( GetWindowLongA( hwnd, GWL_STYLE ) == style, "wrong style %08x, expected %08x\n",
+        GetWindowLongA( hwnd, GWL_STYLE ), style );
+    ok( GetWindowLongA( hwnd, GWL_EXSTYLE ) == ex_style, "wrong ex style %08x, expected %08x\n",
+        GetWindowLongA( hwnd, GWL_EXSTYLE ), ex_style );
+    ok( GetWindowLongA( child, GWLP_ID ) == id, "wrong id %u, expected %u\n",
+        GetWindowLongA( child, GWLP_ID ), id );
+    ok( IsWindowVisible( hwnd ) == visible, "wrong visibility %d, expected %d\n",
+        IsWindowVisible( hwnd ), visible );
+    ok( IsWindowVisible( child ) == child_visible, "wrong child visibility %d, expected %d\n",
+        IsWindowVisible( child ), child_visible );
+}
+
+static void check_other_process_window_info( HWND hwnd, HWND child )
+{
+    char **argv, cmdline[MAX_PATH * 2];
+    STARTUPINFOA startup;
+    PROCESS_INFORMATION info;
+    RECT window, client, child_rect;
+
+    GetWindowRect( hwnd, &window );
+    GetClientRect( hwnd, &client );
+    GetWindowRect( child, &child_rect );
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "%s win window_info %p %p %d,%d,%d,%d %d,%d,%d,%d %d,%d,%d,%d %x %x %u %d %d",
+             argv[0], hwnd, child,
+             window.left, window.top, window.right, window.bottom,
+             client.left, client.top, client.right, client.bottom,
+             child_rect.left, child_rect.top, child_rect.right, child_rect.bottom,
+             GetWindowLongA( hwnd, GWL_STYLE ), GetWindowLongA( hwnd, GWL_EXSTYLE ),
+             GetWindowLongA( child, GWLP_ID ), IsWindowVisible( hwnd ), IsWindowVisible( child ));
+
+    memset( &startup, 0, sizeof(startup) );
+    startup.cb = sizeof(startup);
+    ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info ),
+        "CreateProcess failed err %u\n", GetLastError() );
+    winetest_wait_child_process( info.hProcess );
+    CloseHandle( info.hProcess );
+    CloseHandle( info.hThread );
+}
+
+/* the state of windows of other processes is read from the server, or from a
+ * snapshot in shared memory that must follow the changes made after creation */
+static void test_other_process_window(void)
+{
+    HWND hwnd, child;
+
+    hwnd = CreateWindowExA( 0, "MainWindowClass", "info", WS_POPUP,
+                            100, 100, 200, 200, 0, 0, GetModuleHandleA(NULL), NULL );
+    ok( hwnd != 0, "CreateWindowEx failed\n" );
+    child = CreateWindowExA( 0, "static", "child", WS_CHILD | WS_VISIBLE,
+                             10, 10, 50, 50, hwnd, (HMENU)1, GetModuleHandleA(NULL), NULL );
+    ok( child != 0, "CreateWindowEx failed\n" );
+    check_other_process_window_info( hwnd, child );
+
+    SetWindowLongA( hwnd, GWL_STYLE, GetWindowLongA( hwnd, GWL_STYLE ) | WS_BORDER );
+    SetWindowLongA( hwnd, GWL_EXSTYLE, GetWindowLongA( hwnd, GWL_EXSTYLE ) | WS_EX_TOOLWINDOW );
+    SetWindowPos( hwnd, 0, 50, 60, 300, 200, SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED | SWP_SHOWWINDOW );
+    SetWindowLongPtrA( child, GWLP_ID, 1234 );
+    MoveWindow( child, 20, 30, 40, 50, TRUE );
+    check_other_process_window_info( hwnd, child );
+
+    ShowWindow( child, SW_HIDE );
+    MoveWindow( hwnd, 70, 80, 150, 100, TRUE );
+    check_other_process_window_info( hwnd, child );
+
+    DestroyWindow( hwnd );
+}
+
 START_TEST(win)
 {
     HMODULE user32 = GetModuleHandleA( "user32.dll" );
     HMODULE gdi32 = GetModuleHandleA("gdi32.dll");
+    char **argv;
+    int argc;
+
     pGetAncestor = (void *)GetProcAddress( user32, "GetAncestor" );
     pGetWindowInfo = (void *)GetProcAddress( user32, "GetWindowInfo" );
     pGetWindowModuleFileNameA = (void *)GetProcAddress( user32, "GetWindowModuleFileNameA" );
@@ -7491,6 +7654,13 @@ START_TEST(win)
     pSetLayout = (void *)GetProcAddress( gdi32, "SetLayout" );
     pMirrorRgn = (void *)GetProcAddress( gdi32, "MirrorRgn" );
 
+    argc = winetest_get_mainargs( &argv );
+    if (argc == 13 && !lstrcmpA( argv[2], "window_info" ))
+    {
+        test_other_process_window_info( argv );
+        return;
+    }
+
     if (!RegisterWindowClasses()) assert(0);
 
     SetLastError(0xdeafbeef);
@@ -7521,6 +7691,7 @@ START_TEST(win)
 
     /* Add the tests below this line */
     test_child_window_from_point();
+    test_window_from_point_many_children();
     test_thick_child_size(hwndMain);
     test_fullscreen();
     test_hwnd_message();
@@ -7579,6 +7750,7 @@ START_TEST(win)
     test_winregion();
     test_map_points();
     test_update_region();
+    test_other_process_window();
 
     /* add the tests above this line */
     if (hhook) UnhookWindowsHookEx(hhook);
@@ -101,6 +101,8 @@ static inline void set_win_data( void *ptr, LONG_PTR val, UINT size )
 
 
 static void *user_handles[NB_USER_HANDLES];
+static const window_shm_t *window_shm;
+static BOOL window_shm_failed;
 
 /***********************************************************************
  *           alloc_user_handle
@@ -626,6 +628,148 @@ WND *WIN_GetPtr( HWND hwnd )
 }
 
 
+/***********************************************************************
+ *           get_window_shm
+ *
+ * Map the read-only window state snapshot published by the server.
+ */
+static const volatile window_shm_t *get_window_shm(void)
+{
+    HANDLE mapping = 0;
+    SIZE_T size = 0;
+    void *ptr = NULL;
+
+    if (window_shm || window_shm_failed) return window_shm;
+
+    SERVER_START_REQ( get_window_shared_memory )
+    {
+        if (!wine_server_call( req ))
+        {
+            mapping = wine_server_ptr_handle( reply->handle );
+            size = reply->size;
+        }
+    }
+    SERVER_END_REQ;
+
+    if (mapping)
+    {
+        ptr = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, size );
+        CloseHandle( mapping );
+    }
+    if (!ptr)
+    {
+        WARN( "window shared memory not available, using server requests\n" );
+        window_shm_failed = TRUE;
+        return NULL;
+    }
+    if (InterlockedCompareExchangePointer( (void **)&window_shm, ptr, NULL ))
+        UnmapViewOfFile( ptr );  /* another thread got there first */
+    return window_shm;
+}
+
+
+/* order the shared memory reads with respect to the sequence counter */
+static inline void window_shm_read_barrier(void)
+{
+#ifdef __GNUC__
+# if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__( "" ::: "memory" );  /* loads are not reordered with other loads on x86 */
+# else
+    __sync_synchronize();
+# endif
+#endif
+}
+
+
+/***********************************************************************
+ *           get_shared_window_info
+ *
+ * Retrieve a consistent copy of the server-side state of a window from
+ * shared memory, avoiding a server round trip.
+ */
+static BOOL get_shared_window_info( HWND hwnd, window_shm_t *info )
+{
+    const volatile window_shm_t *shm;
+    UINT index = USER_HANDLE_TO_INDEX( hwnd ), seq, retry;
+    WORD generation = HIWORD( hwnd );
+
+    if (index >= NB_USER_HANDLES || !(shm = get_window_shm())) return FALSE;
+    shm += index;
+
+    for (retry = 0; retry < 64; retry++)
+    {
+        if ((seq = shm->seq) & 1) continue;  /* server is updating the entry */
+        window_shm_read_barrier();
+        *info = *(const window_shm_t *)shm;
+        window_shm_read_barrier();
+        if (shm->seq != seq) continue;
+
+        if (!info->handle || LOWORD(info->handle) != LOWORD(hwnd)) return FALSE;
+        if (generation && generation != 0xffff && generation != HIWORD(info->handle)) return FALSE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+
+/***********************************************************************
+ *           get_shared_window_rectangles
+ *
+ * Same as the get_window_rectangles server request, using the shared memory.
+ */
+static BOOL get_shared_window_rectangles( HWND hwnd, enum coords_relative relative,
+                                          RECT *rectWindow, RECT *rectClient )
+{
+    window_shm_t info, parent;
+    RECT window_rect, client_rect, rect;
+
+    if (!get_shared_window_info( hwnd, &info )) return FALSE;
+
+    SetRect( &window_rect, info.window.left, info.window.top, info.window.right, info.window.bottom );
+    SetRect( &client_rect, info.client.left, info.client.top, info.client.right, info.client.bottom );
+
+    switch (relative)
+    {
+    case COORDS_CLIENT:
+        rect = client_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &window_rect );
+        break;
+    case COORDS_WINDOW:
+        rect = window_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &client_rect );
+        break;
+    case COORDS_PARENT:
+        if (!info.parent) break;
+        if (!get_shared_window_info( wine_server_ptr_handle( info.parent ), &parent )) return FALSE;
+        if (parent.ex_style & WS_EX_LAYOUTRTL)
+        {
+            SetRect( &rect, parent.client.left, parent.client.top, parent.client.right, parent.client.bottom );
+            mirror_rect( &rect, &window_rect );
+            mirror_rect( &rect, &client_rect );
+        }
+        break;
+    case COORDS_SCREEN:
+        while (info.parent)
+        {
+            if (!get_shared_window_info( wine_server_ptr_handle( info.parent ), &info )) return FALSE;
+            if (!info.parent) break;  /* desktop window */
+            OffsetRect( &window_rect, info.client.left, info.client.top );
+            OffsetRect( &client_rect, info.client.left, info.client.top );
+        }
+        break;
+    default:
+        return FALSE;
+    }
+    if (rectWindow) *rectWindow = window_rect;
+    if (rectClient) *rectClient = client_rect;
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           WIN_IsCurrentProcess
  *
@@ -898,6 +1042,8 @@ BOOL WIN_GetRectangles( HWND hwnd, enum coords_relative relative, RECT *rectWind
     }
 
 other_process:
+    if (get_shared_window_rectangles( hwnd, relative, rectWindow, rectClient )) return TRUE;
+
     SERVER_START_REQ( get_window_rectangles )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2206,11 +2352,20 @@ static LONG_PTR WIN_GetWindowLong( HWND hwnd, INT offset, UINT size, BOOL unicod
 
     if (wndPtr == WND_OTHER_PROCESS || wndPtr == WND_DESKTOP)
     {
+        window_shm_t info;
+
         if (offset == GWLP_WNDPROC)
         {
             SetLastError( ERROR_ACCESS_DENIED );
             return 0;
         }
+        if ((offset == GWL_STYLE || offset == GWL_EXSTYLE || offset == GWLP_ID) &&
+            get_shared_window_info( hwnd, &info ))
+        {
+            if (offset == GWL_STYLE) return info.style;
+            if (offset == GWL_EXSTYLE) return info.ex_style;
+            return info.id;
+        }
         SERVER_START_REQ( set_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -3055,6 +3210,31 @@ BOOL WINAPI IsChild( HWND parent, HWND child )
 }
 
 
+/***********************************************************************
+ *           is_shared_window_visible
+ *
+ * Check the visibility of a window and its parents using the shared memory.
+ */
+static BOOL is_shared_window_visible( HWND hwnd, BOOL *visible )
+{
+    window_shm_t info;
+
+    if (!get_shared_window_info( hwnd, &info )) return FALSE;
+    while (info.parent)
+    {
+        if (!(info.style & WS_VISIBLE))
+        {
+            *visible = FALSE;
+            return TRUE;
+        }
+        if (!get_shared_window_info( wine_server_ptr_handle( info.parent ), &info )) return FALSE;
+    }
+    /* top message window isn't visible */
+    *visible = (wine_server_ptr_handle( info.handle ) == GetDesktopWindow());
+    return TRUE;
+}
+
+
 /***********************************************************************
  *		IsWindowVisible (USER32.@)
  */
@@ -3064,6 +3244,8 @@ BOOL WINAPI IsWindowVisible( HWND hwnd )
     BOOL retval = TRUE;
     int i;
 
+    if (!WIN_IsCurrentProcess( hwnd ) && is_shared_window_visible( hwnd, &retval )) return retval;
+
     if (!(GetWindowLongW( hwnd, GWL_STYLE ) & WS_VISIBLE)) return FALSE;
     if (!(list = list_window_parents( hwnd ))) return TRUE;
     if (list[0])
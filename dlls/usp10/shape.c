@@ -611,6 +611,17 @@ static OPENTYPE_TAG get_opentype_script(HDC hdc, SCRIPT_ANALYSIS *psa, ScriptCac
 static LoadedFeature* load_OT_feature(HDC hdc, SCRIPT_ANALYSIS *psa, ScriptCache *psc, char tableType, const char* feat)
 {
     LoadedFeature *feature = NULL;
+    OPENTYPE_TAG tag = MS_MAKE_TAG(feat[0],feat[1],feat[2],feat[3]);
+    CachedFeature *cached;
+
+    /* The lookup below only depends on the font, the script and the user
+     * requested script/language, so remember the result per font. */
+    cached = &psc->features[(tag ^ (tag >> 13) ^ psa->eScript * 31 ^ tableType * 7 ^
+                             psc->userScript ^ psc->userLang) % FEATURE_CACHE_SIZE];
+    if (cached->valid && cached->tag == tag && cached->eScript == psa->eScript &&
+        cached->tableType == tableType && cached->userScript == psc->userScript &&
+        cached->userLang == psc->userLang)
+        return cached->feature;
 
     if (psc->GSUB_Table || psc->GPOS_Table)
     {
@@ -629,16 +640,28 @@ static LoadedFeature* load_OT_feature(HDC hdc, SCRIPT_ANALYSIS *psa, ScriptCache
                 language = MS_MAKE_TAG('d','f','l','t');
             attempt--;
 
-            OpenType_GetFontFeatureTags(psc, script, language, FALSE, MS_MAKE_TAG(feat[0],feat[1],feat[2],feat[3]), tableType, 1, &tags, &cTags, &feature);
+            OpenType_GetFontFeatureTags(psc, script, language, FALSE, tag, tableType, 1, &tags, &cTags, &feature);
 
         } while(attempt && !feature);
 
         /* try in the default (latin) table */
         if (!feature && !script)
-            OpenType_GetFontFeatureTags(psc, MS_MAKE_TAG('l','a','t','n'), MS_MAKE_TAG('d','f','l','t'), FALSE, MS_MAKE_TAG(feat[0],feat[1],feat[2],feat[3]), tableType, 1, &tags, &cTags, &feature);
+            OpenType_GetFontFeatureTags(psc, MS_MAKE_TAG('l','a','t','n'), MS_MAKE_TAG('d','f','l','t'), FALSE, tag, tableType, 1, &tags, &cTags, &feature);
     }
 
     TRACE("Feature %s located at %p\n",debugstr_an(feat,4),feature);
+
+    /* the tables may not have been loaded yet */
+    if (!psc->GSUB_Table && !psc->GPOS_Table)
+        return feature;
+
+    cached->tag = tag;
+    cached->userScript = psc->userScript;
+    cached->userLang = psc->userLang;
+    cached->eScript = psa->eScript;
+    cached->tableType = tableType;
+    cached->feature = feature;
+    cached->valid = TRUE;
     return feature;
 }
 
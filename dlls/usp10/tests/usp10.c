@@ -1456,6 +1456,63 @@ static void test_ScriptShape(HDC hdc)
     ScriptFreeCache(&sc);
 }
 
+static void test_ScriptShape_repeated(HDC hdc)
+{
+    static const WCHAR latin[] = {'T','h','e',' ','q','u','i','c','k',' ','b','r','o','w','n',' ','f','o','x',0};
+    static const WCHAR arabic[] = {0x0633,0x0644,0x0627,0x0645,' ',0x0639,0x0644,0x064a,0x0643,0x0645,0};
+    static const WCHAR devanagari[] = {0x0928,0x092e,0x0938,0x094d,0x0924,0x0947,' ',0x0915,0x094d,0x0937,0};
+    static const WCHAR *strings[] = {latin, arabic, devanagari};
+    static const char *names[] = {"latin", "arabic", "devanagari"};
+    unsigned int i, j;
+
+    for (i = 0; i < sizeof(strings) / sizeof(strings[0]); i++)
+    {
+        WORD glyphs[64], glyphs2[64], logclust[64], logclust2[64];
+        SCRIPT_VISATTR attrs[64], attrs2[64];
+        SCRIPT_CACHE sc = NULL;
+        SCRIPT_ITEM items[16];
+        int len = lstrlenW(strings[i]);
+        int nb, nb2, nitems;
+        DWORD start;
+        HRESULT hr;
+
+        hr = ScriptItemize(strings[i], len, 16, NULL, NULL, items, &nitems);
+        ok(hr == S_OK, "%s: ScriptItemize failed: %08x\n", names[i], hr);
+        len = items[1].iCharPos;
+
+        hr = ScriptShape(hdc, &sc, strings[i], len, 64, &items[0].a, glyphs, logclust, attrs, &nb);
+        if (hr == USP_E_SCRIPT_NOT_IN_FONT)
+        {
+            skip("%s: script not supported by the font\n", names[i]);
+            ScriptFreeCache(&sc);
+            continue;
+        }
+        ok(hr == S_OK, "%s: ScriptShape failed: %08x\n", names[i], hr);
+
+        /* shaping the same run again must give the same result, even without a DC */
+        memset(glyphs2, 0xcc, sizeof(glyphs2));
+        memset(logclust2, 0xcc, sizeof(logclust2));
+        memset(attrs2, 0xcc, sizeof(attrs2));
+        hr = ScriptShape(NULL, &sc, strings[i], len, 64, &items[0].a, glyphs2, logclust2, attrs2, &nb2);
+        ok(hr == S_OK, "%s: ScriptShape failed: %08x\n", names[i], hr);
+        ok(nb == nb2, "%s: got %d glyphs, expected %d\n", names[i], nb2, nb);
+        ok(!memcmp(glyphs, glyphs2, nb * sizeof(WORD)), "%s: glyphs differ\n", names[i]);
+        ok(!memcmp(logclust, logclust2, len * sizeof(WORD)), "%s: clusters differ\n", names[i]);
+        for (j = 0; j < nb; j++)
+            ok(!memcmp(&attrs[j], &attrs2[j], sizeof(attrs[j])), "%s: attributes of glyph %u differ\n", names[i], j);
+
+        if (winetest_interactive)
+        {
+            start = GetTickCount();
+            for (j = 0; j < 10000; j++)
+                ScriptShape(hdc, &sc, strings[i], len, 64, &items[0].a, glyphs2, logclust2, attrs2, &nb2);
+            trace("%s: 10000 runs shaped in %u ms\n", names[i], GetTickCount() - start);
+        }
+
+        ScriptFreeCache(&sc);
+    }
+}
+
 static void test_ScriptPlace(HDC hdc)
 {
     static const WCHAR test1[] = {'t', 'e', 's', 't',0};
@@ -3205,6 +3262,7 @@ START_TEST(usp10)
     test_ScriptGetGlyphABCWidth(hdc);
     test_ScriptShape(hdc);
     test_ScriptShapeOpenType(hdc);
+    test_ScriptShape_repeated(hdc);
     test_ScriptPlace(hdc);
 
     test_ScriptGetFontProperties(hdc);
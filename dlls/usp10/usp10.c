@@ -875,6 +875,114 @@ static HRESULT init_script_cache(const HDC hdc, SCRIPT_CACHE *psc)
     return S_OK;
 }
 
+/* Shaped runs are cached per font so that repeatedly laying out the same
+ * text (e.g. on every repaint) doesn't go through cmap lookups and the
+ * GSUB engine each time. */
+static DWORD hash_shaped_run(const SCRIPT_ANALYSIS *psa, OPENTYPE_TAG tagScript,
+                             OPENTYPE_TAG tagLangSys, const WCHAR *chars, int count)
+{
+    const BYTE *data = (const BYTE *)psa;
+    DWORD hash = 2166136261u;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(*psa); i++)
+        hash = (hash ^ data[i]) * 16777619;
+    hash = (hash ^ tagScript) * 16777619;
+    hash = (hash ^ tagLangSys) * 16777619;
+    for (i = 0; i < count; i++)
+        hash = (hash ^ chars[i]) * 16777619;
+    return hash;
+}
+
+static void init_shaped_runs(ScriptCache *sc)
+{
+    unsigned int i;
+
+    if (sc->shaped_lru.next) return;
+    for (i = 0; i < SHAPED_RUN_HASH_SIZE; i++)
+        list_init(&sc->shaped_runs[i]);
+    list_init(&sc->shaped_lru);
+}
+
+static void free_shaped_run(ScriptCache *sc, ShapedRun *run)
+{
+    list_remove(&run->entry);
+    list_remove(&run->lru);
+    sc->shaped_run_count--;
+    heap_free(run);
+}
+
+static void free_shaped_runs(ScriptCache *sc)
+{
+    ShapedRun *run, *next;
+
+    if (!sc->shaped_lru.next) return;
+    LIST_FOR_EACH_ENTRY_SAFE(run, next, &sc->shaped_lru, ShapedRun, lru)
+        free_shaped_run(sc, run);
+}
+
+static ShapedRun *find_shaped_run(ScriptCache *sc, const SCRIPT_ANALYSIS *psa, OPENTYPE_TAG tagScript,
+                                  OPENTYPE_TAG tagLangSys, const WCHAR *chars, int count, DWORD hash)
+{
+    ShapedRun *run;
+
+    LIST_FOR_EACH_ENTRY(run, &sc->shaped_runs[hash % SHAPED_RUN_HASH_SIZE], ShapedRun, entry)
+    {
+        if (run->hash != hash || run->cChars != count) continue;
+        if (run->tagScript != tagScript || run->tagLangSys != tagLangSys) continue;
+        if (memcmp(&run->sa, psa, sizeof(*psa))) continue;
+        if (memcmp(run->chars, chars, count * sizeof(WCHAR))) continue;
+
+        list_remove(&run->lru);
+        list_add_head(&sc->shaped_lru, &run->lru);
+        return run;
+    }
+    return NULL;
+}
+
+static void add_shaped_run(ScriptCache *sc, const SCRIPT_ANALYSIS *psa, OPENTYPE_TAG tagScript,
+                           OPENTYPE_TAG tagLangSys, const WCHAR *chars, int count, DWORD hash,
+                           const WORD *glyphs, int glyph_count, const WORD *logclust,
+                           const SCRIPT_CHARPROP *charprops, const SCRIPT_GLYPHPROP *glyphprops)
+{
+    ShapedRun *run;
+    BYTE *ptr;
+
+    if (sc->shaped_run_count >= SHAPED_RUN_MAX_ENTRIES)
+        free_shaped_run(sc, LIST_ENTRY(list_tail(&sc->shaped_lru), ShapedRun, lru));
+
+    /* glyph properties first so that they stay naturally aligned */
+    if (!(run = heap_alloc(sizeof(*run) + glyph_count * (sizeof(SCRIPT_GLYPHPROP) + sizeof(WORD)) +
+                           count * (sizeof(SCRIPT_CHARPROP) + 2 * sizeof(WORD)))))
+        return;
+    ptr = (BYTE *)(run + 1);
+    run->glyphprops = (SCRIPT_GLYPHPROP *)ptr;
+    ptr += glyph_count * sizeof(SCRIPT_GLYPHPROP);
+    run->glyphs = (WORD *)ptr;
+    ptr += glyph_count * sizeof(WORD);
+    run->logclust = (WORD *)ptr;
+    ptr += count * sizeof(WORD);
+    run->chars = (WCHAR *)ptr;
+    ptr += count * sizeof(WCHAR);
+    run->charprops = (SCRIPT_CHARPROP *)ptr;
+
+    run->hash = hash;
+    run->sa = *psa;
+    run->tagScript = tagScript;
+    run->tagLangSys = tagLangSys;
+    run->cChars = count;
+    run->cGlyphs = glyph_count;
+    memcpy(run->glyphprops, glyphprops, glyph_count * sizeof(SCRIPT_GLYPHPROP));
+    memcpy(run->glyphs, glyphs, glyph_count * sizeof(WORD));
+    memcpy(run->logclust, logclust, count * sizeof(WORD));
+    memcpy(run->chars, chars, count * sizeof(WCHAR));
+    memcpy(run->charprops, charprops, count * sizeof(SCRIPT_CHARPROP));
+
+    list_add_head(&sc->shaped_runs[hash % SHAPED_RUN_HASH_SIZE], &run->entry);
+    list_add_head(&sc->shaped_lru, &run->lru);
+    sc->shaped_run_count++;
+}
+
 static WCHAR mirror_char( WCHAR ch )
 {
     extern const WCHAR wine_mirror_map[];
@@ -1051,6 +1159,7 @@ HRESULT WINAPI ScriptFreeCache(SCRIPT_CACHE *psc)
         }
         heap_free(((ScriptCache *)*psc)->scripts);
         heap_free(((ScriptCache *)*psc)->otm);
+        free_shaped_runs(*psc);
         heap_free(*psc);
         *psc = NULL;
     }
@@ -2898,8 +3007,31 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
 
     if (psa && !psa->fNoGlyphIndex)
     {
+        ScriptCache *sc = *psc;
+        BOOL cacheable = !cRanges && cChars <= SHAPED_RUN_MAX_CHARS;
+        DWORD hash = 0;
         WCHAR *rChars;
-        if ((hr = SHAPE_CheckFontForRequiredFeatures(hdc, (ScriptCache *)*psc, psa)) != S_OK) return hr;
+
+        if (cacheable)
+        {
+            ShapedRun *run;
+
+            init_shaped_runs(sc);
+            hash = hash_shaped_run(psa, tagScript, tagLangSys, pwcChars, cChars);
+            if ((run = find_shaped_run(sc, psa, tagScript, tagLangSys, pwcChars, cChars, hash)) &&
+                run->cGlyphs <= cMaxGlyphs)
+            {
+                TRACE("using cached run %p\n", run);
+                memcpy(pwOutGlyphs, run->glyphs, run->cGlyphs * sizeof(WORD));
+                memcpy(pOutGlyphProps, run->glyphprops, run->cGlyphs * sizeof(SCRIPT_GLYPHPROP));
+                memcpy(pwLogClust, run->logclust, cChars * sizeof(WORD));
+                memcpy(pCharProps, run->charprops, cChars * sizeof(SCRIPT_CHARPROP));
+                *pcGlyphs = run->cGlyphs;
+                return S_OK;
+            }
+        }
+
+        if ((hr = SHAPE_CheckFontForRequiredFeatures(hdc, sc, psa)) != S_OK) return hr;
 
         rChars = heap_alloc(sizeof(WCHAR) * cChars);
         if (!rChars) return E_OUTOFMEMORY;
@@ -2961,6 +3093,11 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
         SHAPE_ApplyDefaultOpentypeFeatures(hdc, (ScriptCache *)*psc, psa, pwOutGlyphs, pcGlyphs, cMaxGlyphs, cChars, pwLogClust);
         SHAPE_CharGlyphProp(hdc, (ScriptCache *)*psc, psa, pwcChars, cChars, pwOutGlyphs, *pcGlyphs, pwLogClust, pCharProps, pOutGlyphProps);
         heap_free(rChars);
+
+        /* a run that filled the whole buffer may have been truncated */
+        if (cacheable && *pcGlyphs < cMaxGlyphs)
+            add_shaped_run(sc, psa, tagScript, tagLangSys, pwcChars, cChars, hash,
+                           pwOutGlyphs, *pcGlyphs, pwLogClust, pCharProps, pOutGlyphProps);
     }
     else
     {
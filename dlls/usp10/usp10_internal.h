@@ -18,6 +18,8 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
  *
  */
+#include "wine/list.h"
+
 #define MS_MAKE_TAG( _x1, _x2, _x3, _x4 ) \
           ( ( (ULONG)_x4 << 24 ) |     \
             ( (ULONG)_x3 << 16 ) |     \
@@ -163,6 +165,38 @@ typedef struct {
     WORD *glyphs[GLYPH_MAX / GLYPH_BLOCK_SIZE];
 } CacheGlyphPage;
 
+#define FEATURE_CACHE_SIZE 64
+
+typedef struct {
+    OPENTYPE_TAG tag;
+    OPENTYPE_TAG userScript;
+    OPENTYPE_TAG userLang;
+    WORD eScript;
+    CHAR tableType;
+    BOOL valid;
+    LoadedFeature *feature;
+} CachedFeature;
+
+#define SHAPED_RUN_HASH_SIZE 64
+#define SHAPED_RUN_MAX_ENTRIES 256
+#define SHAPED_RUN_MAX_CHARS 512
+
+typedef struct _ShapedRun {
+    struct list entry;      /* hash bucket */
+    struct list lru;
+    DWORD hash;
+    SCRIPT_ANALYSIS sa;
+    OPENTYPE_TAG tagScript;
+    OPENTYPE_TAG tagLangSys;
+    INT cChars;
+    INT cGlyphs;
+    WCHAR *chars;
+    WORD *glyphs;
+    WORD *logclust;
+    SCRIPT_CHARPROP *charprops;
+    SCRIPT_GLYPHPROP *glyphprops;
+} ShapedRun;
+
 typedef struct {
     LOGFONTW lf;
     TEXTMETRICW tm;
@@ -182,6 +216,11 @@ typedef struct {
 
     OPENTYPE_TAG userScript;
     OPENTYPE_TAG userLang;
+
+    CachedFeature features[FEATURE_CACHE_SIZE];
+    struct list shaped_runs[SHAPED_RUN_HASH_SIZE];
+    struct list shaped_lru;
+    INT shaped_run_count;
 } ScriptCache;
 
 typedef struct _scriptData
@@ -1210,6 +1210,81 @@ static void resolve_labels(compile_ctx_t *ctx, unsigned off)
     ctx->labels_cnt = 0;
 }
 
+/* Returns the slot of a variable or argument declared in func. Non-negative slots
+ * index function's variables (or global variables declared in the script for global
+ * code), negative slots index its arguments. */
+static BOOL lookup_local_slot(compile_ctx_t *ctx, function_t *func, const WCHAR *name, int *ret)
+{
+    dim_decl_t *dim_decl;
+    unsigned i;
+
+    /* Assignments to function name store the return value, so leave it for run time lookup. */
+    if((func->type == FUNC_FUNCTION || func->type == FUNC_PROPGET || func->type == FUNC_DEFGET)
+       && !strcmpiW(func->name, name))
+        return FALSE;
+
+    for(dim_decl = ctx->dim_decls, i = 0; dim_decl; dim_decl = dim_decl->next, i++) {
+        if(!strcmpiW(dim_decl->name, name)) {
+            *ret = i;
+            return TRUE;
+        }
+    }
+
+    for(i = 0; i < func->arg_cnt; i++) {
+        if(!strcmpiW(func->args[i].name, name)) {
+            *ret = -(int)i-1;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* Variables may be declared after they are used, so identifiers can be bound to slots only
+ * once the whole function is compiled. Everything else is still looked up by name at run time. */
+static void resolve_local_refs(compile_ctx_t *ctx, function_t *func)
+{
+    instr_t *instr;
+    int slot;
+
+    for(instr = ctx->code->instrs+func->code_off; instr < ctx->code->instrs+ctx->instr_cnt; instr++) {
+        switch(instr->op) {
+        case OP_icall:
+            if(!instr->arg2.uint && lookup_local_slot(ctx, func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_local;
+                instr->arg1.lng = slot;
+            }
+            break;
+        case OP_assign_ident:
+            if(!instr->arg2.uint && lookup_local_slot(ctx, func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_assign_local;
+                instr->arg1.lng = slot;
+            }
+            break;
+        case OP_set_ident:
+            if(!instr->arg2.uint && lookup_local_slot(ctx, func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_set_local;
+                instr->arg1.lng = slot;
+            }
+            break;
+        case OP_incc:
+            if(lookup_local_slot(ctx, func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_incc_local;
+                instr->arg1.lng = slot;
+            }
+            break;
+        case OP_step:
+            if(lookup_local_slot(ctx, func, instr->arg2.bstr, &slot)) {
+                instr->op = OP_step_local;
+                instr->arg2.lng = slot;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *func)
 {
     HRESULT hres;
@@ -1262,19 +1337,23 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
         return E_OUTOFMEMORY;
 
     resolve_labels(ctx, func->code_off);
+    resolve_local_refs(ctx, func);
 
     if(func->var_cnt) {
         dim_decl_t *dim_decl;
 
         if(func->type == FUNC_GLOBAL) {
             dynamic_var_t *new_var;
+            unsigned i;
+
+            ctx->code->global_vars = compiler_alloc(ctx->code, func->var_cnt * sizeof(dynamic_var_t));
+            if(!ctx->code->global_vars)
+                return E_OUTOFMEMORY;
 
             func->var_cnt = 0;
 
-            for(dim_decl = ctx->dim_decls; dim_decl; dim_decl = dim_decl->next) {
-                new_var = compiler_alloc(ctx->code, sizeof(*new_var));
-                if(!new_var)
-                    return E_OUTOFMEMORY;
+            for(dim_decl = ctx->dim_decls, i = 0; dim_decl; dim_decl = dim_decl->next, i++) {
+                new_var = ctx->code->global_vars + i;
 
                 new_var->name = compiler_alloc_string(ctx->code, dim_decl->name);
                 if(!new_var->name)
@@ -1664,6 +1743,7 @@ static vbscode_t *alloc_vbscode(compile_ctx_t *ctx, const WCHAR *source)
 
     ret->option_explicit = ctx->parser.option_explicit;
 
+    ret->global_vars = NULL;
     ret->bstr_pool = NULL;
     ret->bstr_pool_size = 0;
     ret->bstr_cnt = 0;
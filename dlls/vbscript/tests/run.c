@@ -1812,16 +1812,12 @@ static void run_from_file(const char *filename)
     ok(hres == S_OK, "parse_script failed: %08x\n", hres);
 }
 
-static void run_from_res(const char *name)
+static BSTR load_res(const char *name)
 {
     const char *data;
     DWORD size, len;
     BSTR str;
     HRSRC src;
-    HRESULT hres;
-
-    strict_dispid_check = FALSE;
-    test_name = name;
 
     src = FindResourceA(NULL, name, (LPCSTR)40);
     ok(src != NULL, "Could not find resource %s\n", name);
@@ -1833,6 +1829,19 @@ static void run_from_res(const char *name)
     str = SysAllocStringLen(NULL, len);
     MultiByteToWideChar(CP_ACP, 0, data, size, str, len);
 
+    return str;
+}
+
+static void run_from_res(const char *name)
+{
+    BSTR str;
+    HRESULT hres;
+
+    strict_dispid_check = FALSE;
+    test_name = name;
+
+    str = load_res(name);
+
     SET_EXPECT(global_success_d);
     SET_EXPECT(global_success_i);
     hres = parse_script(SCRIPTITEM_GLOBALMEMBERS, str, NULL);
@@ -1843,6 +1852,33 @@ static void run_from_res(const char *name)
     SysFreeString(str);
 }
 
+static void run_benchmark(const char *name)
+{
+    ULONG start, end;
+    BSTR str;
+    HRESULT hres;
+
+    strict_dispid_check = FALSE;
+    test_name = name;
+
+    str = load_res(name);
+
+    start = GetTickCount();
+    hres = parse_script(SCRIPTITEM_GLOBALMEMBERS, str, NULL);
+    end = GetTickCount();
+    ok(hres == S_OK, "%s: parse_script failed: %08x\n", name, hres);
+
+    trace("%s ran in %u ms\n", name, end-start);
+    SysFreeString(str);
+}
+
+static void run_benchmarks(void)
+{
+    trace("Running benchmarks...\n");
+
+    run_benchmark("loopbench.vbs");
+}
+
 static void run_tests(void)
 {
     HRESULT hres;
@@ -2020,6 +2056,9 @@ START_TEST(run)
         run_from_file(argv[2]);
     }else {
         run_tests();
+
+        if(winetest_interactive)
+            run_benchmarks();
     }
 
     CoUninitialize();
@@ -67,6 +67,8 @@ struct pixelformatinfo {
     copyfunc copy_function;
 };
 
+struct pixelformat_pair;
+
 typedef struct FormatConverter {
     IWICFormatConverter IWICFormatConverter_iface;
     LONG ref;
@@ -75,6 +77,9 @@ typedef struct FormatConverter {
     WICBitmapDitherType dither;
     double alpha_threshold;
     WICBitmapPaletteType palette_type;
+    const struct pixelformat_pair *pair;
+    BYTE *tile;
+    UINT tile_size;
     CRITICAL_SECTION lock; /* must be held when initialized */
 } FormatConverter;
 
@@ -994,6 +999,283 @@ static HRESULT copypixels_to_24bppRGB(struct FormatConverter *This, const WICRec
     }
 }
 
+/* Direct row kernels for the most common format pairs. These avoid the
+ * full-frame temporary used by the generic copy functions above. */
+typedef void (*convert_row_func)(const BYTE *src, BYTE *dst, UINT width);
+
+struct pixelformat_pair {
+    enum pixelformat src_format;
+    enum pixelformat dst_format;
+    UINT src_bpp;
+    UINT dst_bpp;
+    convert_row_func convert_row;
+};
+
+static void convert_row_8bppGray_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+        dstpixel[x] = 0xff000000 | (src[x] * 0x010101);
+}
+
+static void convert_row_8bppGray_to_24bppBGR(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, dst += 3)
+        dst[0] = dst[1] = dst[2] = src[x];
+}
+
+static void convert_row_16bppBGR555_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    const WORD *srcpixel = (const WORD *)src;
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        DWORD srcval = srcpixel[x];
+        dstpixel[x] = 0xff000000 |
+                      ((srcval << 9) & 0xf80000) | ((srcval << 4) & 0x070000) |
+                      ((srcval << 6) & 0x00f800) | ((srcval << 1) & 0x000700) |
+                      ((srcval << 3) & 0x0000f8) | ((srcval >> 2) & 0x000007);
+    }
+}
+
+static void convert_row_16bppBGR565_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    const WORD *srcpixel = (const WORD *)src;
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        DWORD srcval = srcpixel[x];
+        dstpixel[x] = 0xff000000 |
+                      ((srcval << 8) & 0xf80000) | ((srcval << 3) & 0x070000) |
+                      ((srcval << 5) & 0x00fc00) | ((srcval >> 1) & 0x000300) |
+                      ((srcval << 3) & 0x0000f8) | ((srcval >> 2) & 0x000007);
+    }
+}
+
+static void convert_row_16bppBGRA5551_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    const WORD *srcpixel = (const WORD *)src;
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        DWORD srcval = srcpixel[x];
+        dstpixel[x] = ((srcval & 0x8000) ? 0xff000000 : 0) |
+                      ((srcval << 9) & 0xf80000) | ((srcval << 4) & 0x070000) |
+                      ((srcval << 6) & 0x00f800) | ((srcval << 1) & 0x000700) |
+                      ((srcval << 3) & 0x0000f8) | ((srcval >> 2) & 0x000007);
+    }
+}
+
+static void convert_row_24bppBGR_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 3)
+        dstpixel[x] = 0xff000000 | (src[2] << 16) | (src[1] << 8) | src[0];
+}
+
+static void convert_row_24bppRGB_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 3)
+        dstpixel[x] = 0xff000000 | (src[0] << 16) | (src[1] << 8) | src[2];
+}
+
+static void convert_row_32bppBGRA_to_24bppBGR(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 4, dst += 3)
+    {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+    }
+}
+
+static void convert_row_32bppBGRA_to_24bppRGB(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 4, dst += 3)
+    {
+        dst[0] = src[2];
+        dst[1] = src[1];
+        dst[2] = src[0];
+    }
+}
+
+/* The following kernels run in place on the caller's buffer. */
+static void convert_row_32bppBGR_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+        dstpixel[x] |= 0xff000000;
+}
+
+static void convert_row_32bppBGRA_to_32bppPBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, dst += 4)
+    {
+        BYTE alpha = dst[3];
+        if (alpha != 255)
+        {
+            dst[0] = dst[0] * alpha / 255;
+            dst[1] = dst[1] * alpha / 255;
+            dst[2] = dst[2] * alpha / 255;
+        }
+    }
+}
+
+static void convert_row_32bppPBGRA_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, dst += 4)
+    {
+        BYTE alpha = dst[3];
+        if (alpha != 0 && alpha != 255)
+        {
+            dst[0] = dst[0] * 255 / alpha;
+            dst[1] = dst[1] * 255 / alpha;
+            dst[2] = dst[2] * 255 / alpha;
+        }
+    }
+}
+
+static const struct pixelformat_pair supported_pairs[] = {
+    {format_8bppGray, format_24bppBGR, 8, 24, convert_row_8bppGray_to_24bppBGR},
+    {format_8bppGray, format_32bppBGR, 8, 32, convert_row_8bppGray_to_32bppBGRA},
+    {format_8bppGray, format_32bppBGRA, 8, 32, convert_row_8bppGray_to_32bppBGRA},
+    {format_8bppGray, format_32bppPBGRA, 8, 32, convert_row_8bppGray_to_32bppBGRA},
+    {format_16bppBGR555, format_32bppBGR, 16, 32, convert_row_16bppBGR555_to_32bppBGRA},
+    {format_16bppBGR555, format_32bppBGRA, 16, 32, convert_row_16bppBGR555_to_32bppBGRA},
+    {format_16bppBGR555, format_32bppPBGRA, 16, 32, convert_row_16bppBGR555_to_32bppBGRA},
+    {format_16bppBGR565, format_32bppBGR, 16, 32, convert_row_16bppBGR565_to_32bppBGRA},
+    {format_16bppBGR565, format_32bppBGRA, 16, 32, convert_row_16bppBGR565_to_32bppBGRA},
+    {format_16bppBGR565, format_32bppPBGRA, 16, 32, convert_row_16bppBGR565_to_32bppBGRA},
+    {format_16bppBGRA5551, format_32bppBGR, 16, 32, convert_row_16bppBGRA5551_to_32bppBGRA},
+    {format_16bppBGRA5551, format_32bppBGRA, 16, 32, convert_row_16bppBGRA5551_to_32bppBGRA},
+    {format_24bppBGR, format_32bppBGR, 24, 32, convert_row_24bppBGR_to_32bppBGRA},
+    {format_24bppBGR, format_32bppBGRA, 24, 32, convert_row_24bppBGR_to_32bppBGRA},
+    {format_24bppBGR, format_32bppPBGRA, 24, 32, convert_row_24bppBGR_to_32bppBGRA},
+    {format_24bppRGB, format_32bppBGR, 24, 32, convert_row_24bppRGB_to_32bppBGRA},
+    {format_24bppRGB, format_32bppBGRA, 24, 32, convert_row_24bppRGB_to_32bppBGRA},
+    {format_24bppRGB, format_32bppPBGRA, 24, 32, convert_row_24bppRGB_to_32bppBGRA},
+    {format_32bppBGR, format_24bppBGR, 32, 24, convert_row_32bppBGRA_to_24bppBGR},
+    {format_32bppBGRA, format_24bppBGR, 32, 24, convert_row_32bppBGRA_to_24bppBGR},
+    {format_32bppPBGRA, format_24bppBGR, 32, 24, convert_row_32bppBGRA_to_24bppBGR},
+    {format_32bppBGR, format_24bppRGB, 32, 24, convert_row_32bppBGRA_to_24bppRGB},
+    {format_32bppBGRA, format_24bppRGB, 32, 24, convert_row_32bppBGRA_to_24bppRGB},
+    {format_32bppPBGRA, format_24bppRGB, 32, 24, convert_row_32bppBGRA_to_24bppRGB},
+    {format_32bppBGR, format_32bppBGRA, 32, 32, convert_row_32bppBGR_to_32bppBGRA},
+    {format_32bppBGR, format_32bppPBGRA, 32, 32, convert_row_32bppBGR_to_32bppBGRA},
+    {format_32bppBGRA, format_32bppPBGRA, 32, 32, convert_row_32bppBGRA_to_32bppPBGRA},
+    {format_32bppPBGRA, format_32bppBGRA, 32, 32, convert_row_32bppPBGRA_to_32bppBGRA},
+    {0}
+};
+
+static const struct pixelformat_pair *get_pixelformat_pair(enum pixelformat src, enum pixelformat dst)
+{
+    UINT i;
+
+    for (i=0; supported_pairs[i].convert_row; i++)
+        if (supported_pairs[i].src_format == src && supported_pairs[i].dst_format == dst)
+            return &supported_pairs[i];
+
+    return NULL;
+}
+
+/* Size of the intermediate buffer used to stream source rows through a pair kernel. */
+#define CONVERT_TILE_SIZE 0x10000
+
+static HRESULT copypixels_with_pair(struct FormatConverter *This, const WICRect *prc,
+    UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
+{
+    const struct pixelformat_pair *pair = This->pair;
+    UINT srcstride, dststride, rows, y, tile_rows;
+    HRESULT res;
+    WICRect rc;
+
+    srcstride = (prc->Width * pair->src_bpp + 7) / 8;
+    dststride = (prc->Width * pair->dst_bpp + 7) / 8;
+
+    if (cbStride < dststride || cbBufferSize < dststride ||
+        (cbBufferSize - dststride) / cbStride < prc->Height - 1)
+        return E_INVALIDARG;
+
+    if (pair->src_bpp == pair->dst_bpp)
+    {
+        res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+        if (FAILED(res)) return res;
+
+        for (y = 0; y < prc->Height; y++)
+            pair->convert_row(pbBuffer + cbStride * y, pbBuffer + cbStride * y, prc->Width);
+        return S_OK;
+    }
+
+    tile_rows = max(1, CONVERT_TILE_SIZE / srcstride);
+    tile_rows = min(tile_rows, prc->Height);
+
+    EnterCriticalSection(&This->lock);
+
+    if (This->tile_size < srcstride * tile_rows)
+    {
+        HeapFree(GetProcessHeap(), 0, This->tile);
+        This->tile_size = srcstride * tile_rows;
+        This->tile = HeapAlloc(GetProcessHeap(), 0, This->tile_size);
+        if (!This->tile)
+        {
+            This->tile_size = 0;
+            LeaveCriticalSection(&This->lock);
+            return E_OUTOFMEMORY;
+        }
+    }
+
+    res = S_OK;
+    rc.X = prc->X;
+    rc.Width = prc->Width;
+    for (y = 0; y < prc->Height && SUCCEEDED(res); y += rows)
+    {
+        const BYTE *srcrow;
+        BYTE *dstrow;
+        UINT i;
+
+        rows = min(tile_rows, prc->Height - y);
+        rc.Y = prc->Y + y;
+        rc.Height = rows;
+
+        res = IWICBitmapSource_CopyPixels(This->source, &rc, srcstride, srcstride * rows, This->tile);
+        if (FAILED(res)) break;
+
+        srcrow = This->tile;
+        dstrow = pbBuffer + cbStride * y;
+        for (i = 0; i < rows; i++, srcrow += srcstride, dstrow += cbStride)
+            pair->convert_row(srcrow, dstrow, prc->Width);
+    }
+
+    LeaveCriticalSection(&This->lock);
+
+    return res;
+}
+
 static const struct pixelformatinfo supported_formats[] = {
     {format_1bppIndexed, &GUID_WICPixelFormat1bppIndexed, NULL},
     {format_2bppIndexed, &GUID_WICPixelFormat2bppIndexed, NULL},
@@ -1074,6 +1356,7 @@ static ULONG WINAPI FormatConverter_Release(IWICFormatConverter *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        HeapFree(GetProcessHeap(), 0, This->tile);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -1150,6 +1433,9 @@ static HRESULT WINAPI FormatConverter_CopyPixels(IWICFormatConverter *iface,
             prc = &rc;
         }
 
+        if (This->pair && prc->Width > 0 && prc->Height > 0)
+            return copypixels_with_pair(This, prc, cbStride, cbBufferSize, pbBuffer);
+
         return This->dst_format->copy_function(This, prc, cbStride, cbBufferSize,
             pbBuffer, This->src_format->format);
     }
@@ -1207,6 +1493,7 @@ static HRESULT WINAPI FormatConverter_Initialize(IWICFormatConverter *iface,
         This->dither = dither;
         This->alpha_threshold = alphaThresholdPercent;
         This->palette_type = paletteTranslate;
+        This->pair = get_pixelformat_pair(srcinfo->format, dstinfo->format);
         This->source = pISource;
     }
     else
@@ -1288,6 +1575,9 @@ HRESULT FormatConverter_CreateInstance(IUnknown *pUnkOuter, REFIID iid, void** p
     This->IWICFormatConverter_iface.lpVtbl = &FormatConverter_Vtbl;
     This->ref = 1;
     This->source = NULL;
+    This->pair = NULL;
+    This->tile = NULL;
+    This->tile_size = 0;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": FormatConverter.lock");
 
@@ -62,6 +62,7 @@ WINE_DECLARE_DEBUG_CHANNEL(jpeg);
 static void *libjpeg_handle;
 
 #define MAKE_FUNCPTR(f) static typeof(f) * p##f
+MAKE_FUNCPTR(jpeg_abort_decompress);
 MAKE_FUNCPTR(jpeg_CreateCompress);
 MAKE_FUNCPTR(jpeg_CreateDecompress);
 MAKE_FUNCPTR(jpeg_destroy_compress);
@@ -87,6 +88,7 @@ static void *load_libjpeg(void)
         return NULL; \
     }
 
+        LOAD_FUNCPTR(jpeg_abort_decompress);
         LOAD_FUNCPTR(jpeg_CreateCompress);
         LOAD_FUNCPTR(jpeg_CreateDecompress);
         LOAD_FUNCPTR(jpeg_destroy_compress);
@@ -137,9 +139,14 @@ static void emit_message_fn(j_common_ptr cinfo, int msg_level)
     }
 }
 
+/* Full size images up to this size are kept in memory once decoded, larger
+ * ones are decoded again from the stream when earlier rows are requested. */
+#define MAX_CACHED_IMAGE_SIZE (16 * 1024 * 1024)
+
 typedef struct {
     IWICBitmapDecoder IWICBitmapDecoder_iface;
     IWICBitmapFrameDecode IWICBitmapFrameDecode_iface;
+    IWICBitmapSourceTransform IWICBitmapSourceTransform_iface;
     LONG ref;
     BOOL initialized;
     BOOL cinfo_initialized;
@@ -148,7 +155,12 @@ typedef struct {
     struct jpeg_error_mgr jerr;
     struct jpeg_source_mgr source_mgr;
     BYTE source_buffer[1024];
-    BYTE *image_data;
+    UINT width, height; /* unscaled image size */
+    UINT bpp;
+    UINT scale_denom; /* DCT scaling the decompressor was started with */
+    BYTE *image_data; /* cache of the first cached_rows unscaled rows */
+    UINT cached_rows;
+    BYTE *scanline;
     CRITICAL_SECTION lock;
 } JpegDecoder;
 
@@ -162,6 +174,11 @@ static inline JpegDecoder *impl_from_IWICBitmapFrameDecode(IWICBitmapFrameDecode
     return CONTAINING_RECORD(iface, JpegDecoder, IWICBitmapFrameDecode_iface);
 }
 
+static inline JpegDecoder *impl_from_IWICBitmapSourceTransform(IWICBitmapSourceTransform *iface)
+{
+    return CONTAINING_RECORD(iface, JpegDecoder, IWICBitmapSourceTransform_iface);
+}
+
 static inline JpegDecoder *decoder_from_decompress(j_decompress_ptr decompress)
 {
     return CONTAINING_RECORD(decompress, JpegDecoder, cinfo);
@@ -214,6 +231,7 @@ static ULONG WINAPI JpegDecoder_Release(IWICBitmapDecoder *iface)
         if (This->cinfo_initialized) pjpeg_destroy_decompress(&This->cinfo);
         if (This->stream) IStream_Release(This->stream);
         HeapFree(GetProcessHeap(), 0, This->image_data);
+        HeapFree(GetProcessHeap(), 0, This->scanline);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -284,6 +302,59 @@ static void source_mgr_term_source(j_decompress_ptr cinfo)
 {
 }
 
+/* Must be called with a jmp_buf in client_data, after jpeg_read_header. */
+static BOOL start_decompress(JpegDecoder *This, UINT scale_denom)
+{
+    switch (This->cinfo.jpeg_color_space)
+    {
+    case JCS_GRAYSCALE:
+        This->cinfo.out_color_space = JCS_GRAYSCALE;
+        break;
+    case JCS_RGB:
+    case JCS_YCbCr:
+        This->cinfo.out_color_space = JCS_RGB;
+        break;
+    case JCS_CMYK:
+    case JCS_YCCK:
+        This->cinfo.out_color_space = JCS_CMYK;
+        break;
+    default:
+        ERR("Unknown JPEG color space %i\n", This->cinfo.jpeg_color_space);
+        return FALSE;
+    }
+
+    This->cinfo.scale_num = 1;
+    This->cinfo.scale_denom = scale_denom;
+
+    if (!pjpeg_start_decompress(&This->cinfo))
+    {
+        ERR("jpeg_start_decompress failed\n");
+        return FALSE;
+    }
+
+    This->scale_denom = scale_denom;
+    return TRUE;
+}
+
+/* Rewinds the stream and starts decompressing again from the first row. */
+static BOOL restart_decompress(JpegDecoder *This, UINT scale_denom)
+{
+    LARGE_INTEGER seek;
+
+    TRACE("(%p,%u)\n", This, scale_denom);
+
+    pjpeg_abort_decompress(&This->cinfo);
+
+    seek.QuadPart = 0;
+    IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
+    This->source_mgr.bytes_in_buffer = 0;
+
+    if (pjpeg_read_header(&This->cinfo, TRUE) != JPEG_HEADER_OK)
+        return FALSE;
+
+    return start_decompress(This, scale_denom);
+}
+
 static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *pIStream,
     WICDecodeOptions cacheOptions)
 {
@@ -343,31 +414,17 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
         return E_FAIL;
     }
 
-    switch (This->cinfo.jpeg_color_space)
+    if (!start_decompress(This, 1))
     {
-    case JCS_GRAYSCALE:
-        This->cinfo.out_color_space = JCS_GRAYSCALE;
-        break;
-    case JCS_RGB:
-    case JCS_YCbCr:
-        This->cinfo.out_color_space = JCS_RGB;
-        break;
-    case JCS_CMYK:
-    case JCS_YCCK:
-        This->cinfo.out_color_space = JCS_CMYK;
-        break;
-    default:
-        ERR("Unknown JPEG color space %i\n", This->cinfo.jpeg_color_space);
         LeaveCriticalSection(&This->lock);
         return E_FAIL;
     }
 
-    if (!pjpeg_start_decompress(&This->cinfo))
-    {
-        ERR("jpeg_start_decompress failed\n");
-        LeaveCriticalSection(&This->lock);
-        return E_FAIL;
-    }
+    This->width = This->cinfo.output_width;
+    This->height = This->cinfo.output_height;
+    if (This->cinfo.out_color_space == JCS_GRAYSCALE) This->bpp = 8;
+    else if (This->cinfo.out_color_space == JCS_CMYK) This->bpp = 32;
+    else This->bpp = 24;
 
     This->initialized = TRUE;
 
@@ -495,6 +552,10 @@ static HRESULT WINAPI JpegDecoder_Frame_QueryInterface(IWICBitmapFrameDecode *if
     {
         *ppv = &This->IWICBitmapFrameDecode_iface;
     }
+    else if (IsEqualIID(&IID_IWICBitmapSourceTransform, iid))
+    {
+        *ppv = &This->IWICBitmapSourceTransform_iface;
+    }
     else
     {
         *ppv = NULL;
@@ -521,8 +582,8 @@ static HRESULT WINAPI JpegDecoder_Frame_GetSize(IWICBitmapFrameDecode *iface,
     UINT *puiWidth, UINT *puiHeight)
 {
     JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
-    *puiWidth = This->cinfo.output_width;
-    *puiHeight = This->cinfo.output_height;
+    *puiWidth = This->width;
+    *puiHeight = This->height;
     TRACE("(%p)->(%u,%u)\n", iface, *puiWidth, *puiHeight);
     return S_OK;
 }
@@ -581,103 +642,146 @@ static HRESULT WINAPI JpegDecoder_Frame_CopyPalette(IWICBitmapFrameDecode *iface
     return E_NOTIMPL;
 }
 
-static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
-    const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
+static void convert_scanline(JpegDecoder *This, BYTE *row, UINT width)
 {
-    JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
-    UINT bpp;
-    UINT stride;
-    UINT data_size;
-    UINT max_row_needed;
-    jmp_buf jmpbuf;
-    WICRect rect;
-    TRACE("(%p,%p,%u,%u,%p)\n", iface, prc, cbStride, cbBufferSize, pbBuffer);
+    UINT i;
 
-    if (!prc)
+    if (This->bpp == 24)
     {
-        rect.X = 0;
-        rect.Y = 0;
-        rect.Width = This->cinfo.output_width;
-        rect.Height = This->cinfo.output_height;
-        prc = &rect;
+        /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
+        reverse_bgr8(3, row, width, 1, width * 3);
     }
-    else
+    else if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
     {
-        if (prc->X < 0 || prc->Y < 0 || prc->X+prc->Width > This->cinfo.output_width ||
-            prc->Y+prc->Height > This->cinfo.output_height)
-            return E_INVALIDARG;
+        /* Adobe JPEG's have inverted CMYK data. */
+        for (i=0; i<width*4; i++)
+            row[i] ^= 0xff;
     }
+}
 
-    if (This->cinfo.out_color_space == JCS_GRAYSCALE) bpp = 8;
-    else if (This->cinfo.out_color_space == JCS_CMYK) bpp = 32;
-    else bpp = 24;
-
-    stride = bpp * This->cinfo.output_width;
-    data_size = stride * This->cinfo.output_height;
-
-    max_row_needed = prc->Y + prc->Height;
-    if (max_row_needed > This->cinfo.output_height) return E_INVALIDARG;
-
-    EnterCriticalSection(&This->lock);
+/* Decodes the rows of prc at the given DCT scaling. Only the requested rows
+ * are kept unless the unscaled image is small enough to be cached. Must be
+ * called with the lock held and a jmp_buf in client_data. */
+static HRESULT decode_rows(JpegDecoder *This, UINT scale_denom, UINT width, UINT height,
+    const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
+{
+    UINT stride = (This->bpp * width + 7) / 8;
+    UINT bytesperpixel = This->bpp / 8;
+    UINT last_row = prc->Y + prc->Height;
+    BOOL cache = FALSE;
 
-    if (!This->image_data)
+    if (scale_denom == 1 && (This->image_data || stride * height <= MAX_CACHED_IMAGE_SIZE))
     {
-        This->image_data = HeapAlloc(GetProcessHeap(), 0, data_size);
         if (!This->image_data)
         {
-            LeaveCriticalSection(&This->lock);
-            return E_OUTOFMEMORY;
+            This->image_data = HeapAlloc(GetProcessHeap(), 0, stride * height);
+            This->cached_rows = 0;
         }
+        cache = This->image_data != NULL;
     }
 
-    This->cinfo.client_data = jmpbuf;
+    if (cache && last_row <= This->cached_rows)
+        return copy_pixels(This->bpp, This->image_data, width, height, stride,
+            prc, cbStride, cbBufferSize, pbBuffer);
 
-    if (setjmp(jmpbuf))
+    if (cbStride < prc->Width * bytesperpixel ||
+        cbStride * (prc->Height-1) + prc->Width * bytesperpixel > cbBufferSize)
+        return E_INVALIDARG;
+
+    if (!This->scanline)
     {
-        LeaveCriticalSection(&This->lock);
-        return E_FAIL;
+        /* large enough for any scaled row */
+        This->scanline = HeapAlloc(GetProcessHeap(), 0, (This->bpp * This->width + 7) / 8);
+        if (!This->scanline) return E_OUTOFMEMORY;
     }
 
-    while (max_row_needed > This->cinfo.output_scanline)
+    if (This->scale_denom != scale_denom ||
+        This->cinfo.output_scanline > (cache ? This->cached_rows : prc->Y))
     {
-        UINT first_scanline = This->cinfo.output_scanline;
-        UINT max_rows;
-        JSAMPROW out_rows[4];
-        UINT i;
-        JDIMENSION ret;
+        if (!restart_decompress(This, scale_denom)) return E_FAIL;
+    }
 
-        max_rows = min(This->cinfo.output_height-first_scanline, 4);
-        for (i=0; i<max_rows; i++)
-            out_rows[i] = This->image_data + stride * (first_scanline+i);
+    while (This->cinfo.output_scanline < last_row)
+    {
+        UINT row = This->cinfo.output_scanline;
+        JSAMPROW out_row;
 
-        ret = pjpeg_read_scanlines(&This->cinfo, out_rows, max_rows);
+        if (cache && row >= This->cached_rows)
+            out_row = This->image_data + stride * row;
+        else
+            out_row = This->scanline;
 
-        if (ret == 0)
+        if (pjpeg_read_scanlines(&This->cinfo, &out_row, 1) == 0)
         {
             ERR("read_scanlines failed\n");
-            LeaveCriticalSection(&This->lock);
             return E_FAIL;
         }
 
-        if (bpp == 24)
+        if (out_row != This->scanline)
+        {
+            convert_scanline(This, out_row, width);
+            This->cached_rows = row + 1;
+        }
+        else if (!cache && row >= prc->Y)
         {
-            /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
-            reverse_bgr8(3, This->image_data + stride * first_scanline,
-                This->cinfo.output_width, This->cinfo.output_scanline - first_scanline,
-                stride);
+            convert_scanline(This, out_row, width);
+            memcpy(pbBuffer + cbStride * (row - prc->Y), out_row + prc->X * bytesperpixel,
+                prc->Width * bytesperpixel);
         }
+    }
+
+    if (cache)
+        return copy_pixels(This->bpp, This->image_data, width, height, stride,
+            prc, cbStride, cbBufferSize, pbBuffer);
+
+    return S_OK;
+}
 
-        if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
-            /* Adobe JPEG's have inverted CMYK data. */
-            for (i=0; i<data_size; i++)
-                This->image_data[i] ^= 0xff;
+static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
+    const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
+{
+    JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
+    jmp_buf jmpbuf;
+    WICRect rect;
+    HRESULT hr;
+    TRACE("(%p,%p,%u,%u,%p)\n", iface, prc, cbStride, cbBufferSize, pbBuffer);
+
+    if (!prc)
+    {
+        rect.X = 0;
+        rect.Y = 0;
+        rect.Width = This->width;
+        rect.Height = This->height;
+        prc = &rect;
+    }
+    else
+    {
+        if (prc->X < 0 || prc->Y < 0 || prc->X+prc->Width > This->width ||
+            prc->Y+prc->Height > This->height)
+            return E_INVALIDARG;
+    }
+
+    if (prc->Width <= 0 || prc->Height <= 0)
+        return copy_pixels(This->bpp, NULL, This->width, This->height, 0,
+            prc, cbStride, cbBufferSize, pbBuffer);
+
+    EnterCriticalSection(&This->lock);
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+    {
+        /* the decompressor state is unknown, start over next time */
+        This->scale_denom = 0;
+        LeaveCriticalSection(&This->lock);
+        return E_FAIL;
     }
 
+    hr = decode_rows(This, 1, This->width, This->height, prc, cbStride, cbBufferSize, pbBuffer);
+
     LeaveCriticalSection(&This->lock);
 
-    return copy_pixels(bpp, This->image_data,
-        This->cinfo.output_width, This->cinfo.output_height, stride,
-        prc, cbStride, cbBufferSize, pbBuffer);
+    return hr;
 }
 
 static HRESULT WINAPI JpegDecoder_Frame_GetMetadataQueryReader(IWICBitmapFrameDecode *iface,
@@ -715,6 +819,151 @@ static const IWICBitmapFrameDecodeVtbl JpegDecoder_Frame_Vtbl = {
     JpegDecoder_Frame_GetThumbnail
 };
 
+static HRESULT WINAPI JpegDecoder_Transform_QueryInterface(IWICBitmapSourceTransform *iface,
+    REFIID iid, void **ppv)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapFrameDecode_QueryInterface(&This->IWICBitmapFrameDecode_iface, iid, ppv);
+}
+
+static ULONG WINAPI JpegDecoder_Transform_AddRef(IWICBitmapSourceTransform *iface)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapDecoder_AddRef(&This->IWICBitmapDecoder_iface);
+}
+
+static ULONG WINAPI JpegDecoder_Transform_Release(IWICBitmapSourceTransform *iface)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapDecoder_Release(&This->IWICBitmapDecoder_iface);
+}
+
+/* libjpeg can scale by 1/1, 1/2, 1/4 and 1/8 while decoding the DCT blocks. */
+static UINT get_scaled_size(UINT size, UINT scale_denom)
+{
+    return (size + scale_denom - 1) / scale_denom;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_CopyPixels(IWICBitmapSourceTransform *iface,
+    const WICRect *prc, UINT uiWidth, UINT uiHeight, WICPixelFormatGUID *pguidDstFormat,
+    WICBitmapTransformOptions dstTransform, UINT nStride, UINT cbBufferSize, BYTE *pbBuffer)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    WICPixelFormatGUID format;
+    UINT scale_denom;
+    jmp_buf jmpbuf;
+    WICRect rect;
+    HRESULT hr;
+
+    TRACE("(%p,%p,%u,%u,%s,%u,%u,%u,%p)\n", iface, prc, uiWidth, uiHeight,
+        debugstr_guid(pguidDstFormat), dstTransform, nStride, cbBufferSize, pbBuffer);
+
+    if (!pbBuffer) return E_INVALIDARG;
+
+    if (dstTransform != WICBitmapTransformRotate0)
+    {
+        FIXME("unsupported transform %#x\n", dstTransform);
+        return WINCODEC_ERR_UNSUPPORTEDOPERATION;
+    }
+
+    IWICBitmapFrameDecode_GetPixelFormat(&This->IWICBitmapFrameDecode_iface, &format);
+    if (pguidDstFormat && !IsEqualGUID(pguidDstFormat, &format))
+        return WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT;
+
+    for (scale_denom = 1; scale_denom <= 8; scale_denom *= 2)
+        if (get_scaled_size(This->width, scale_denom) == uiWidth &&
+            get_scaled_size(This->height, scale_denom) == uiHeight)
+            break;
+    if (scale_denom > 8)
+        return E_INVALIDARG;
+
+    if (!prc)
+    {
+        rect.X = 0;
+        rect.Y = 0;
+        rect.Width = uiWidth;
+        rect.Height = uiHeight;
+        prc = &rect;
+    }
+    else if (prc->X < 0 || prc->Y < 0 || prc->Width <= 0 || prc->Height <= 0 ||
+             prc->X+prc->Width > uiWidth || prc->Y+prc->Height > uiHeight)
+        return E_INVALIDARG;
+
+    EnterCriticalSection(&This->lock);
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+    {
+        /* the decompressor state is unknown, start over next time */
+        This->scale_denom = 0;
+        LeaveCriticalSection(&This->lock);
+        return E_FAIL;
+    }
+
+    hr = decode_rows(This, scale_denom, uiWidth, uiHeight, prc, nStride, cbBufferSize, pbBuffer);
+
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_GetClosestSize(IWICBitmapSourceTransform *iface,
+    UINT *puiWidth, UINT *puiHeight)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    UINT scale_denom;
+
+    TRACE("(%p,%p,%p)\n", iface, puiWidth, puiHeight);
+
+    if (!puiWidth || !puiHeight) return E_INVALIDARG;
+
+    /* pick the smallest scaled size that is not smaller than the requested one */
+    for (scale_denom = 8; scale_denom > 1; scale_denom /= 2)
+        if (get_scaled_size(This->width, scale_denom) >= *puiWidth &&
+            get_scaled_size(This->height, scale_denom) >= *puiHeight)
+            break;
+
+    *puiWidth = get_scaled_size(This->width, scale_denom);
+    *puiHeight = get_scaled_size(This->height, scale_denom);
+
+    return S_OK;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_GetClosestPixelFormat(IWICBitmapSourceTransform *iface,
+    WICPixelFormatGUID *pguidDstFormat)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+
+    TRACE("(%p,%p)\n", iface, pguidDstFormat);
+
+    if (!pguidDstFormat) return E_INVALIDARG;
+
+    return IWICBitmapFrameDecode_GetPixelFormat(&This->IWICBitmapFrameDecode_iface, pguidDstFormat);
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_DoesSupportTransform(IWICBitmapSourceTransform *iface,
+    WICBitmapTransformOptions dstTransform, BOOL *pfIsSupported)
+{
+    TRACE("(%p,%u,%p)\n", iface, dstTransform, pfIsSupported);
+
+    if (!pfIsSupported) return E_INVALIDARG;
+
+    *pfIsSupported = (dstTransform == WICBitmapTransformRotate0);
+
+    return S_OK;
+}
+
+static const IWICBitmapSourceTransformVtbl JpegDecoder_Transform_Vtbl = {
+    JpegDecoder_Transform_QueryInterface,
+    JpegDecoder_Transform_AddRef,
+    JpegDecoder_Transform_Release,
+    JpegDecoder_Transform_CopyPixels,
+    JpegDecoder_Transform_GetClosestSize,
+    JpegDecoder_Transform_GetClosestPixelFormat,
+    JpegDecoder_Transform_DoesSupportTransform
+};
+
 HRESULT JpegDecoder_CreateInstance(IUnknown *pUnkOuter, REFIID iid, void** ppv)
 {
     JpegDecoder *This;
@@ -737,11 +986,15 @@ HRESULT JpegDecoder_CreateInstance(IUnknown *pUnkOuter, REFIID iid, void** ppv)
 
     This->IWICBitmapDecoder_iface.lpVtbl = &JpegDecoder_Vtbl;
     This->IWICBitmapFrameDecode_iface.lpVtbl = &JpegDecoder_Frame_Vtbl;
+    This->IWICBitmapSourceTransform_iface.lpVtbl = &JpegDecoder_Transform_Vtbl;
     This->ref = 1;
     This->initialized = FALSE;
     This->cinfo_initialized = FALSE;
     This->stream = NULL;
+    This->scale_denom = 1;
     This->image_data = NULL;
+    This->cached_rows = 0;
+    This->scanline = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": JpegDecoder.lock");
 
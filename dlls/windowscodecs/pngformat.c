@@ -169,6 +169,7 @@ MAKE_FUNCPTR(png_get_error_ptr);
 MAKE_FUNCPTR(png_get_iCCP);
 MAKE_FUNCPTR(png_get_image_height);
 MAKE_FUNCPTR(png_get_image_width);
+MAKE_FUNCPTR(png_get_interlace_type);
 MAKE_FUNCPTR(png_get_io_ptr);
 MAKE_FUNCPTR(png_get_pHYs);
 MAKE_FUNCPTR(png_get_PLTE);
@@ -192,6 +193,7 @@ MAKE_FUNCPTR(png_set_write_fn);
 MAKE_FUNCPTR(png_read_end);
 MAKE_FUNCPTR(png_read_image);
 MAKE_FUNCPTR(png_read_info);
+MAKE_FUNCPTR(png_read_row);
 MAKE_FUNCPTR(png_write_end);
 MAKE_FUNCPTR(png_write_info);
 MAKE_FUNCPTR(png_write_rows);
@@ -218,6 +220,7 @@ static void *load_libpng(void)
         LOAD_FUNCPTR(png_get_iCCP);
         LOAD_FUNCPTR(png_get_image_height);
         LOAD_FUNCPTR(png_get_image_width);
+        LOAD_FUNCPTR(png_get_interlace_type);
         LOAD_FUNCPTR(png_get_io_ptr);
         LOAD_FUNCPTR(png_get_pHYs);
         LOAD_FUNCPTR(png_get_PLTE);
@@ -241,6 +244,7 @@ static void *load_libpng(void)
         LOAD_FUNCPTR(png_read_end);
         LOAD_FUNCPTR(png_read_image);
         LOAD_FUNCPTR(png_read_info);
+        LOAD_FUNCPTR(png_read_row);
         LOAD_FUNCPTR(png_write_end);
         LOAD_FUNCPTR(png_write_info);
         LOAD_FUNCPTR(png_write_rows);
@@ -267,11 +271,17 @@ static void user_warning_fn(png_structp png_ptr, png_const_charp warning_message
     WARN("PNG warning: %s\n", debugstr_a(warning_message));
 }
 
+/* Non-interlaced images up to this size are kept in memory once decoded,
+ * larger ones are decoded again from the stream when earlier rows are
+ * requested. */
+#define MAX_CACHED_IMAGE_SIZE (16 * 1024 * 1024)
+
 typedef struct {
     IWICBitmapDecoder IWICBitmapDecoder_iface;
     IWICBitmapFrameDecode IWICBitmapFrameDecode_iface;
     IWICMetadataBlockReader IWICMetadataBlockReader_iface;
     LONG ref;
+    IStream *stream;
     png_structp png_ptr;
     png_infop info_ptr;
     png_infop end_info;
@@ -280,7 +290,10 @@ typedef struct {
     int width, height;
     UINT stride;
     const WICPixelFormatGUID *format;
-    BYTE *image_bits;
+    BYTE *image_bits; /* cache of the first cached_rows rows */
+    UINT cached_rows;
+    UINT next_row; /* next row libpng will return */
+    BYTE *row_buffer;
     CRITICAL_SECTION lock; /* must be held when png structures are accessed or initialized is set */
 } PngDecoder;
 
@@ -346,7 +359,9 @@ static ULONG WINAPI PngDecoder_Release(IWICBitmapDecoder *iface)
             ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, &This->end_info);
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
+        if (This->stream) IStream_Release(This->stream);
         HeapFree(GetProcessHeap(), 0, This->image_bits);
+        HeapFree(GetProcessHeap(), 0, This->row_buffer);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -384,41 +399,19 @@ static void user_read_data(png_structp png_ptr, png_bytep data, png_size_t lengt
     }
 }
 
-static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *pIStream,
-    WICDecodeOptions cacheOptions)
+static HRESULT create_read_struct(PngDecoder *This)
 {
-    PngDecoder *This = impl_from_IWICBitmapDecoder(iface);
-    LARGE_INTEGER seek;
-    HRESULT hr=S_OK;
-    png_bytep *row_pointers=NULL;
-    UINT image_size;
-    UINT i;
-    int color_type, bit_depth;
-    png_bytep trans;
-    int num_trans;
-    png_uint_32 transparency;
-    png_color_16p trans_values;
-    jmp_buf jmpbuf;
-
-    TRACE("(%p,%p,%x)\n", iface, pIStream, cacheOptions);
-
-    EnterCriticalSection(&This->lock);
-
     /* initialize libpng */
     This->png_ptr = ppng_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     if (!This->png_ptr)
-    {
-        hr = E_FAIL;
-        goto end;
-    }
+        return E_FAIL;
 
     This->info_ptr = ppng_create_info_struct(This->png_ptr);
     if (!This->info_ptr)
     {
         ppng_destroy_read_struct(&This->png_ptr, NULL, NULL);
         This->png_ptr = NULL;
-        hr = E_FAIL;
-        goto end;
+        return E_FAIL;
     }
 
     This->end_info = ppng_create_info_struct(This->png_ptr);
@@ -426,29 +419,31 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
     {
         ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, NULL);
         This->png_ptr = NULL;
-        hr = E_FAIL;
-        goto end;
+        return E_FAIL;
     }
 
-    /* set up setjmp/longjmp error handling */
-    if (setjmp(jmpbuf))
-    {
-        ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, &This->end_info);
-        HeapFree(GetProcessHeap(), 0, row_pointers);
-        This->png_ptr = NULL;
-        hr = E_FAIL;
-        goto end;
-    }
-    ppng_set_error_fn(This->png_ptr, jmpbuf, user_error_fn, user_warning_fn);
-    ppng_set_crc_action(This->png_ptr, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+    return S_OK;
+}
+
+/* Reads the header and sets up the transformations for our pixel format.
+ * Must be called with an error handler set on the png structure. */
+static HRESULT read_info(PngDecoder *This, IStream *stream)
+{
+    int color_type, bit_depth;
+    png_bytep trans;
+    int num_trans;
+    png_uint_32 transparency;
+    png_color_16p trans_values;
+    LARGE_INTEGER seek;
+    HRESULT hr;
 
     /* seek to the start of the stream */
     seek.QuadPart = 0;
-    hr = IStream_Seek(pIStream, seek, STREAM_SEEK_SET, NULL);
-    if (FAILED(hr)) goto end;
+    hr = IStream_Seek(stream, seek, STREAM_SEEK_SET, NULL);
+    if (FAILED(hr)) return hr;
 
     /* set up custom i/o handling */
-    ppng_set_read_fn(This->png_ptr, pIStream, user_read_data);
+    ppng_set_read_fn(This->png_ptr, stream, user_read_data);
 
     /* read the header */
     ppng_read_info(This->png_ptr, This->info_ptr);
@@ -493,8 +488,7 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
         case 16: This->format = &GUID_WICPixelFormat16bppGray; break;
         default:
             ERR("invalid grayscale bit depth: %i\n", bit_depth);
-            hr = E_FAIL;
-            goto end;
+            return E_FAIL;
         }
         break;
     case PNG_COLOR_TYPE_GRAY_ALPHA:
@@ -512,8 +506,7 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
         case 16: This->format = &GUID_WICPixelFormat64bppRGBA; break;
         default:
             ERR("invalid RGBA bit depth: %i\n", bit_depth);
-            hr = E_FAIL;
-            goto end;
+            return E_FAIL;
         }
         break;
     case PNG_COLOR_TYPE_PALETTE:
@@ -526,8 +519,7 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
         case 8: This->format = &GUID_WICPixelFormat8bppIndexed; break;
         default:
             ERR("invalid indexed color bit depth: %i\n", bit_depth);
-            hr = E_FAIL;
-            goto end;
+            return E_FAIL;
         }
         break;
     case PNG_COLOR_TYPE_RGB:
@@ -541,45 +533,104 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
         case 16: This->format = &GUID_WICPixelFormat48bppRGB; break;
         default:
             ERR("invalid RGB color bit depth: %i\n", bit_depth);
-            hr = E_FAIL;
-            goto end;
+            return E_FAIL;
         }
         break;
     default:
         ERR("invalid color type %i\n", color_type);
-        hr = E_FAIL;
-        goto end;
+        return E_FAIL;
     }
 
-    /* read the image data */
     This->width = ppng_get_image_width(This->png_ptr, This->info_ptr);
     This->height = ppng_get_image_height(This->png_ptr, This->info_ptr);
-    This->stride = This->width * This->bpp;
-    image_size = This->stride * This->height;
+    This->stride = (This->width * This->bpp + 7) / 8;
+    This->next_row = 0;
+
+    return S_OK;
+}
+
+static HRESULT restart_decode(PngDecoder *This, jmp_buf *jmpbuf)
+{
+    HRESULT hr;
+
+    TRACE("(%p)\n", This);
+
+    ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, &This->end_info);
+
+    hr = create_read_struct(This);
+    if (FAILED(hr)) return hr;
+
+    ppng_set_error_fn(This->png_ptr, jmpbuf, user_error_fn, user_warning_fn);
+    ppng_set_crc_action(This->png_ptr, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+
+    return read_info(This, This->stream);
+}
+
+static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *pIStream,
+    WICDecodeOptions cacheOptions)
+{
+    PngDecoder *This = impl_from_IWICBitmapDecoder(iface);
+    HRESULT hr=S_OK;
+    png_bytep *row_pointers=NULL;
+    UINT i;
+    jmp_buf jmpbuf;
 
-    This->image_bits = HeapAlloc(GetProcessHeap(), 0, image_size);
-    if (!This->image_bits)
+    TRACE("(%p,%p,%x)\n", iface, pIStream, cacheOptions);
+
+    EnterCriticalSection(&This->lock);
+
+    hr = create_read_struct(This);
+    if (FAILED(hr)) goto end;
+
+    /* set up setjmp/longjmp error handling */
+    if (setjmp(jmpbuf))
     {
-        hr = E_OUTOFMEMORY;
+        ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, &This->end_info);
+        HeapFree(GetProcessHeap(), 0, row_pointers);
+        This->png_ptr = NULL;
+        hr = E_FAIL;
         goto end;
     }
+    ppng_set_error_fn(This->png_ptr, jmpbuf, user_error_fn, user_warning_fn);
+    ppng_set_crc_action(This->png_ptr, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
 
-    row_pointers = HeapAlloc(GetProcessHeap(), 0, sizeof(png_bytep)*This->height);
-    if (!row_pointers)
+    hr = read_info(This, pIStream);
+    if (FAILED(hr)) goto end;
+
+    /* Interlaced images can't be decoded one row at a time, so read them
+     * completely now. Other images are decoded as rows are requested. */
+    if (ppng_get_interlace_type(This->png_ptr, This->info_ptr) != PNG_INTERLACE_NONE)
     {
-        hr = E_OUTOFMEMORY;
-        goto end;
-    }
+        This->image_bits = HeapAlloc(GetProcessHeap(), 0, This->stride * This->height);
+        if (!This->image_bits)
+        {
+            hr = E_OUTOFMEMORY;
+            goto end;
+        }
 
-    for (i=0; i<This->height; i++)
-        row_pointers[i] = This->image_bits + i * This->stride;
+        row_pointers = HeapAlloc(GetProcessHeap(), 0, sizeof(png_bytep)*This->height);
+        if (!row_pointers)
+        {
+            hr = E_OUTOFMEMORY;
+            goto end;
+        }
 
-    ppng_read_image(This->png_ptr, row_pointers);
+        for (i=0; i<This->height; i++)
+            row_pointers[i] = This->image_bits + i * This->stride;
 
-    HeapFree(GetProcessHeap(), 0, row_pointers);
-    row_pointers = NULL;
+        ppng_read_image(This->png_ptr, row_pointers);
 
-    ppng_read_end(This->png_ptr, This->end_info);
+        HeapFree(GetProcessHeap(), 0, row_pointers);
+        row_pointers = NULL;
+
+        ppng_read_end(This->png_ptr, This->end_info);
+
+        This->cached_rows = This->height;
+        This->next_row = This->height;
+    }
+
+    IStream_AddRef(pIStream);
+    This->stream = pIStream;
 
     This->initialized = TRUE;
 
@@ -848,11 +899,119 @@ static HRESULT WINAPI PngDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
     PngDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
+    UINT bytesperrow, last_row;
+    BOOL cache;
+    jmp_buf jmpbuf;
+    WICRect rect;
+    HRESULT hr;
     TRACE("(%p,%p,%u,%u,%p)\n", iface, prc, cbStride, cbBufferSize, pbBuffer);
 
-    return copy_pixels(This->bpp, This->image_bits,
-        This->width, This->height, This->stride,
-        prc, cbStride, cbBufferSize, pbBuffer);
+    if (!prc)
+    {
+        rect.X = 0;
+        rect.Y = 0;
+        rect.Width = This->width;
+        rect.Height = This->height;
+        prc = &rect;
+    }
+    else if (prc->X < 0 || prc->Y < 0 || prc->X+prc->Width > This->width ||
+             prc->Y+prc->Height > This->height)
+        return E_INVALIDARG;
+
+    last_row = prc->Y + prc->Height;
+
+    EnterCriticalSection(&This->lock);
+
+    if (!This->image_bits && This->stride * This->height <= MAX_CACHED_IMAGE_SIZE)
+    {
+        This->image_bits = HeapAlloc(GetProcessHeap(), 0, This->stride * This->height);
+        This->cached_rows = 0;
+    }
+    cache = This->image_bits != NULL;
+
+    if (prc->Width <= 0 || prc->Height <= 0 || (cache && last_row <= This->cached_rows))
+    {
+        hr = copy_pixels(This->bpp, This->image_bits,
+            This->width, This->height, This->stride,
+            prc, cbStride, cbBufferSize, pbBuffer);
+        LeaveCriticalSection(&This->lock);
+        return hr;
+    }
+
+    bytesperrow = (This->bpp * prc->Width + 7) / 8;
+    if (cbStride < bytesperrow || cbStride * (prc->Height-1) + bytesperrow > cbBufferSize)
+    {
+        LeaveCriticalSection(&This->lock);
+        return E_INVALIDARG;
+    }
+
+    if (!cache && (prc->X * This->bpp) % 8)
+    {
+        FIXME("cannot reliably copy bitmap data if bpp < 8\n");
+        LeaveCriticalSection(&This->lock);
+        return E_FAIL;
+    }
+
+    if (!This->row_buffer)
+    {
+        This->row_buffer = HeapAlloc(GetProcessHeap(), 0, This->stride);
+        if (!This->row_buffer)
+        {
+            LeaveCriticalSection(&This->lock);
+            return E_OUTOFMEMORY;
+        }
+    }
+
+    if (setjmp(jmpbuf))
+    {
+        /* the decoder state is unknown, start over next time */
+        This->next_row = ~0u;
+        LeaveCriticalSection(&This->lock);
+        return E_FAIL;
+    }
+    ppng_set_error_fn(This->png_ptr, jmpbuf, user_error_fn, user_warning_fn);
+
+    if (This->next_row > (cache ? This->cached_rows : prc->Y))
+    {
+        hr = restart_decode(This, &jmpbuf);
+        if (FAILED(hr))
+        {
+            This->next_row = ~0u;
+            LeaveCriticalSection(&This->lock);
+            return hr;
+        }
+    }
+
+    while (This->next_row < last_row)
+    {
+        UINT row = This->next_row;
+        BYTE *out_row;
+
+        if (cache && row >= This->cached_rows)
+            out_row = This->image_bits + This->stride * row;
+        else
+            out_row = This->row_buffer;
+
+        ppng_read_row(This->png_ptr, out_row, NULL);
+        This->next_row++;
+
+        if (out_row != This->row_buffer)
+            This->cached_rows = row + 1;
+        else if (!cache && row >= prc->Y)
+            memcpy(pbBuffer + cbStride * (row - prc->Y),
+                   out_row + prc->X * This->bpp / 8, bytesperrow);
+    }
+
+    if (cache)
+        hr = copy_pixels(This->bpp, This->image_bits,
+            This->width, This->height, This->stride,
+            prc, cbStride, cbBufferSize, pbBuffer);
+    else
+        hr = S_OK;
+
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
 }
 
 static HRESULT WINAPI PngDecoder_Frame_GetMetadataQueryReader(IWICBitmapFrameDecode *iface,
@@ -1010,7 +1169,11 @@ HRESULT PngDecoder_CreateInstance(IUnknown *pUnkOuter, REFIID iid, void** ppv)
     This->info_ptr = NULL;
     This->end_info = NULL;
     This->initialized = FALSE;
+    This->stream = NULL;
     This->image_bits = NULL;
+    This->cached_rows = 0;
+    This->next_row = 0;
+    This->row_buffer = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": PngDecoder.lock");
 
@@ -19,6 +19,7 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -33,6 +34,28 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+/* taps of a one-dimensional resampling filter, for each destination pixel */
+struct scaler_filter
+{
+    UINT max_taps;    /* number of weights allocated per destination pixel */
+    UINT *first;      /* first source pixel of each destination pixel */
+    UINT *count;      /* number of source pixels of each destination pixel */
+    INT *weights;     /* weights, in FILTER_WEIGHT_ONE units */
+};
+
+#define FILTER_WEIGHT_SHIFT 14
+#define FILTER_WEIGHT_ONE   (1 << FILTER_WEIGHT_SHIFT)
+
+/* maximum number of filtered rows kept, larger vertical boxes are summed in several passes */
+#define FILTER_MAX_ROWS     64
+
+/* a source row filtered horizontally, kept for the next destination rows */
+struct scaler_row
+{
+    INT src_y;        /* source row, -1 if unused */
+    BYTE *data;       /* filtered pixels, for the whole destination width */
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -43,6 +66,12 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    struct scaler_filter x_filter;  /* horizontal filter, for the interpolating modes */
+    struct scaler_filter y_filter;  /* vertical filter, for the interpolating modes */
+    struct scaler_row *rows;        /* cache of horizontally filtered rows */
+    UINT row_count;                 /* number of cached rows */
+    BYTE *src_bits;                 /* buffer for the source rows */
+    INT *accum;                     /* accumulator for the vertical pass */
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -51,6 +80,35 @@ static inline BitmapScaler *impl_from_IWICBitmapScaler(IWICBitmapScaler *iface)
     return CONTAINING_RECORD(iface, BitmapScaler, IWICBitmapScaler_iface);
 }
 
+static void free_scaler_filter(struct scaler_filter *filter)
+{
+    HeapFree(GetProcessHeap(), 0, filter->first);
+    HeapFree(GetProcessHeap(), 0, filter->count);
+    HeapFree(GetProcessHeap(), 0, filter->weights);
+}
+
+static void free_filter_data(BitmapScaler *This)
+{
+    UINT i;
+
+    free_scaler_filter(&This->x_filter);
+    free_scaler_filter(&This->y_filter);
+    if (This->rows)
+    {
+        for (i=0; i<This->row_count; i++)
+            HeapFree(GetProcessHeap(), 0, This->rows[i].data);
+        HeapFree(GetProcessHeap(), 0, This->rows);
+    }
+    HeapFree(GetProcessHeap(), 0, This->src_bits);
+    HeapFree(GetProcessHeap(), 0, This->accum);
+    memset(&This->x_filter, 0, sizeof(This->x_filter));
+    memset(&This->y_filter, 0, sizeof(This->y_filter));
+    This->rows = NULL;
+    This->row_count = 0;
+    This->src_bits = NULL;
+    This->accum = NULL;
+}
+
 static HRESULT WINAPI BitmapScaler_QueryInterface(IWICBitmapScaler *iface, REFIID iid,
     void **ppv)
 {
@@ -97,6 +155,7 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        free_filter_data(This);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -191,6 +250,257 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+static double filter_kernel(WICBitmapInterpolationMode mode, double x)
+{
+    x = fabs(x);
+
+    if (mode == WICBitmapInterpolationModeCubic)
+    {
+        /* Catmull-Rom spline */
+        if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+        if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+        return 0.0;
+    }
+
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+static HRESULT init_scaler_filter(struct scaler_filter *filter, WICBitmapInterpolationMode mode,
+    UINT src_size, UINT dst_size)
+{
+    double ratio = dst_size ? (double)src_size / dst_size : 1.0, radius, *weights;
+    BOOL box = (mode == WICBitmapInterpolationModeFant && ratio > 1.0);
+    UINT i, j;
+
+    radius = (mode == WICBitmapInterpolationModeCubic) ? 2.0 : 1.0;
+    /* the area average of the Fant mode spans the whole box of source pixels */
+    filter->max_taps = box ? (UINT)ceil(ratio) + 1 : 2 * (UINT)radius + 1;
+    filter->first = HeapAlloc(GetProcessHeap(), 0, sizeof(UINT) * max(dst_size, 1));
+    filter->count = HeapAlloc(GetProcessHeap(), 0, sizeof(UINT) * max(dst_size, 1));
+    filter->weights = HeapAlloc(GetProcessHeap(), 0, sizeof(INT) * filter->max_taps * max(dst_size, 1));
+    weights = HeapAlloc(GetProcessHeap(), 0, sizeof(double) * filter->max_taps);
+    if (!filter->first || !filter->count || !filter->weights || !weights)
+    {
+        HeapFree(GetProcessHeap(), 0, weights);
+        return E_OUTOFMEMORY;
+    }
+
+    for (i=0; i<dst_size; i++)
+    {
+        INT *fixed = filter->weights + i * filter->max_taps;
+        double total = 0.0, partial = 0.0;
+        INT first, last, prev = 0, next;
+
+        if (!src_size)
+        {
+            filter->first[i] = filter->count[i] = 0;
+            continue;
+        }
+
+        if (box)
+        {
+            double left = i * ratio, right = (i + 1) * ratio;
+
+            first = floor(left);
+            last = min((INT)ceil(right) - 1, (INT)src_size - 1);
+            for (j=0; j<=last-first; j++)
+            {
+                weights[j] = min(first + j + 1.0, right) - max(first + j, left);
+                total += weights[j];
+            }
+        }
+        else
+        {
+            double pos = (i + 0.5) * ratio - 0.5;
+            INT start = ceil(pos - radius), end = floor(pos + radius);
+
+            first = max(start, 0);
+            last = min(end, (INT)src_size - 1);
+            if (first > last) first = last = (start < 0) ? 0 : src_size - 1;
+            for (j=0; j<=last-first; j++) weights[j] = 0.0;
+            for (; start <= end; start++)
+            {
+                double weight = filter_kernel(mode, start - pos);
+                INT index = min(max(start, first), last);
+
+                weights[index - first] += weight;
+                total += weight;
+            }
+        }
+
+        filter->first[i] = first;
+        filter->count[i] = last - first + 1;
+
+        if (total == 0.0)
+        {
+            fixed[0] = FILTER_WEIGHT_ONE;
+            filter->count[i] = 1;
+            continue;
+        }
+
+        /* normalize so that the weights add up exactly to one, rounding the running
+         * sum so that the error doesn't pile up on a single weight of large boxes */
+        for (j=0; j<filter->count[i]; j++)
+        {
+            partial += weights[j];
+            next = (j == filter->count[i] - 1) ? FILTER_WEIGHT_ONE :
+                   floor(partial / total * FILTER_WEIGHT_ONE + 0.5);
+            fixed[j] = next - prev;
+            prev = next;
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, weights);
+    return S_OK;
+}
+
+static inline BYTE clamp_filtered(INT value)
+{
+    value = (value + FILTER_WEIGHT_ONE / 2) >> FILTER_WEIGHT_SHIFT;
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static void Filter_ScaleRow(const struct scaler_filter *filter, const BYTE *src,
+    BYTE *dst, UINT dst_width, UINT channels)
+{
+    UINT x, k, c;
+
+    for (x=0; x<dst_width; x++)
+    {
+        const INT *weights = filter->weights + x * filter->max_taps;
+        const BYTE *pixel = src + filter->first[x] * channels;
+        INT sum[4] = {0, 0, 0, 0};
+
+        for (k=0; k<filter->count[x]; k++, pixel += channels)
+            for (c=0; c<channels; c++)
+                sum[c] += pixel[c] * weights[k];
+
+        for (c=0; c<channels; c++)
+            dst[x * channels + c] = clamp_filtered(sum[c]);
+    }
+}
+
+/* make sure the horizontally filtered source rows needed by a destination row are cached */
+static HRESULT Filter_LoadRows(BitmapScaler *This, UINT first, UINT count)
+{
+    UINT channels = This->bpp / 8, src_stride = This->src_width * channels;
+    UINT missing_first = first + count, missing_last = first, y;
+    WICRect rect;
+    HRESULT hr;
+
+    for (y=first; y<first+count; y++)
+    {
+        if (This->rows[y % This->row_count].src_y == y) continue;
+        missing_first = min(missing_first, y);
+        missing_last = y;
+    }
+    if (missing_first > missing_last) return S_OK;
+
+    rect.X = 0;
+    rect.Y = missing_first;
+    rect.Width = This->src_width;
+    rect.Height = missing_last - missing_first + 1;
+
+    hr = IWICBitmapSource_CopyPixels(This->source, &rect, src_stride,
+        src_stride * rect.Height, This->src_bits);
+    if (FAILED(hr)) return hr;
+
+    for (y=missing_first; y<=missing_last; y++)
+    {
+        struct scaler_row *row = &This->rows[y % This->row_count];
+
+        Filter_ScaleRow(&This->x_filter, This->src_bits + (y - missing_first) * src_stride,
+            row->data, This->width, channels);
+        row->src_y = y;
+    }
+
+    return S_OK;
+}
+
+static HRESULT Filter_CopyPixels(BitmapScaler *This, const WICRect *dest_rect,
+    UINT cbStride, BYTE *pbBuffer)
+{
+    UINT channels = This->bpp / 8, width = dest_rect->Width * channels;
+    UINT x, y, k;
+    HRESULT hr;
+
+    for (y=0; y<dest_rect->Height; y++)
+    {
+        UINT dst_y = dest_rect->Y + y;
+        UINT first = This->y_filter.first[dst_y], count = This->y_filter.count[dst_y];
+        const INT *weights = This->y_filter.weights + dst_y * This->y_filter.max_taps;
+        BYTE *dst = pbBuffer + cbStride * y;
+
+        memset(This->accum, 0, sizeof(INT) * width);
+        for (k=0; k<count; k++)
+        {
+            const BYTE *src;
+            INT weight = weights[k];
+
+            /* load the rows by groups, boxes may be taller than the cache */
+            if (!(k % This->row_count))
+            {
+                hr = Filter_LoadRows(This, first + k, min(count - k, This->row_count));
+                if (FAILED(hr)) return hr;
+            }
+
+            src = This->rows[(first + k) % This->row_count].data + dest_rect->X * channels;
+            for (x=0; x<width; x++)
+                This->accum[x] += src[x] * weight;
+        }
+
+        for (x=0; x<width; x++)
+            dst[x] = clamp_filtered(This->accum[x]);
+    }
+
+    return S_OK;
+}
+
+static HRESULT Filter_Initialize(BitmapScaler *This)
+{
+    UINT i, channels = This->bpp / 8;
+    HRESULT hr;
+
+    hr = init_scaler_filter(&This->x_filter, This->mode, This->src_width, This->width);
+    if (SUCCEEDED(hr))
+        hr = init_scaler_filter(&This->y_filter, This->mode, This->src_height, This->height);
+    if (FAILED(hr)) return hr;
+
+    This->row_count = min(This->y_filter.max_taps, FILTER_MAX_ROWS);
+    This->rows = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*This->rows) * This->row_count);
+    This->src_bits = HeapAlloc(GetProcessHeap(), 0, max(This->src_width * channels * This->row_count, 1));
+    This->accum = HeapAlloc(GetProcessHeap(), 0, sizeof(INT) * max(This->width * channels, 1));
+    if (!This->rows || !This->src_bits || !This->accum)
+        return E_OUTOFMEMORY;
+
+    for (i=0; i<This->row_count; i++)
+    {
+        This->rows[i].src_y = -1;
+        if (!(This->rows[i].data = HeapAlloc(GetProcessHeap(), 0, max(This->width * channels, 1))))
+            return E_OUTOFMEMORY;
+    }
+
+    return S_OK;
+}
+
+/* formats whose pixels are made of independent 8-bit channels */
+static BOOL is_filterable_format(const WICPixelFormatGUID *format)
+{
+    static const WICPixelFormatGUID *formats[] = {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat24bppRGB,
+        &GUID_WICPixelFormat32bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+        &GUID_WICPixelFormat32bppPBGRA
+    };
+    UINT i;
+
+    for (i=0; i<sizeof(formats)/sizeof(formats[0]); i++)
+        if (IsEqualGUID(format, formats[i])) return TRUE;
+    return FALSE;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -245,6 +555,13 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         goto end;
     }
 
+    if (This->rows)
+    {
+        /* the interpolating modes keep the filtered source rows between calls */
+        hr = Filter_CopyPixels(This, &dest_rect, cbStride, pbBuffer);
+        goto end;
+    }
+
     /* MSDN recommends calling CopyPixels once for each scanline from top to
      * bottom, and claims codecs optimize for this. Ideally, when called in this
      * way, we should avoid requesting a scanline from the source more than
@@ -332,10 +649,33 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
         hr = get_pixelformat_bpp(&src_pixelformat, &This->bpp);
     }
 
+    if (SUCCEEDED(hr) && (mode == WICBitmapInterpolationModeLinear ||
+        mode == WICBitmapInterpolationModeCubic || mode == WICBitmapInterpolationModeFant) &&
+        !is_filterable_format(&src_pixelformat))
+    {
+        /* the scaler keeps the source pixel format, which the filters don't handle */
+        FIXME("mode %i not supported for format %s, using nearest neighbor\n", mode,
+            debugstr_guid(&src_pixelformat));
+        This->mode = mode = WICBitmapInterpolationModeNearestNeighbor;
+    }
+
     if (SUCCEEDED(hr))
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+            IWICBitmapSource_AddRef(pISource);
+            This->source = pISource;
+            hr = Filter_Initialize(This);
+            if (FAILED(hr))
+            {
+                free_filter_data(This);
+                if (This->source) IWICBitmapSource_Release(This->source);
+                This->source = NULL;
+            }
+            break;
         default:
             FIXME("unsupported mode %i\n", mode);
             /* fall-through */
@@ -391,6 +731,12 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    memset(&This->x_filter, 0, sizeof(This->x_filter));
+    memset(&This->y_filter, 0, sizeof(This->y_filter));
+    This->rows = NULL;
+    This->row_count = 0;
+    This->src_bits = NULL;
+    This->accum = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
@@ -989,6 +989,147 @@ static void test_clipper(void)
     IWICBitmapClipper_Release(clipper);
 }
 
+static void test_bitmap_scaler(void)
+{
+    static const WICBitmapInterpolationMode modes[] = { WICBitmapInterpolationModeNearestNeighbor,
+        WICBitmapInterpolationModeLinear, WICBitmapInterpolationModeCubic, WICBitmapInterpolationModeFant };
+    static const BYTE gray_row[4] = { 0, 100, 200, 255 };
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    WICPixelFormatGUID format;
+    BYTE gray[2], *data, row[256 * 4];
+    DWORD pixels[8 * 8], start, elapsed;
+    UINT i, j, width, height;
+    HRESULT hr;
+
+    /* a solid image stays solid with every mode */
+    for (i = 0; i < 16; i++) pixels[i] = 0xff336699;
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 4, 4, &GUID_WICPixelFormat32bppBGRA,
+        16, sizeof(pixels), (BYTE *)pixels, &bitmap);
+    ok(hr == S_OK, "CreateBitmapFromMemory error %#x\n", hr);
+
+    for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++)
+    {
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "CreateBitmapScaler error %#x\n", hr);
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 8, 8, modes[i]);
+        ok(hr == S_OK, "%u: Initialize error %#x\n", modes[i], hr);
+
+        hr = IWICBitmapScaler_GetSize(scaler, &width, &height);
+        ok(hr == S_OK, "GetSize error %#x\n", hr);
+        ok(width == 8 && height == 8, "got %ux%u\n", width, height);
+        hr = IWICBitmapScaler_GetPixelFormat(scaler, &format);
+        ok(hr == S_OK, "GetPixelFormat error %#x\n", hr);
+        ok(IsEqualGUID(&format, &GUID_WICPixelFormat32bppBGRA), "unexpected pixel format %s\n", debugstr_guid(&format));
+
+        memset(pixels, 0, sizeof(pixels));
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 32, sizeof(pixels), (BYTE *)pixels);
+        ok(hr == S_OK, "%u: CopyPixels error %#x\n", modes[i], hr);
+        for (j = 0; j < 64; j++)
+            if (pixels[j] != 0xff336699) break;
+        ok(j == 64, "%u: pixel %u is %08x\n", modes[i], j, pixels[min(j, 63)]);
+
+        IWICBitmapScaler_Release(scaler);
+    }
+    IWICBitmap_Release(bitmap);
+
+    /* the scaler keeps the pixel format of the source */
+    for (i = 0; i < 4; i++) ((WORD *)pixels)[i] = 0x1234;
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 2, 2, &GUID_WICPixelFormat16bppGray,
+        4, 8, (BYTE *)pixels, &bitmap);
+    ok(hr == S_OK, "CreateBitmapFromMemory error %#x\n", hr);
+
+    for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++)
+    {
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "CreateBitmapScaler error %#x\n", hr);
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 4, 4, modes[i]);
+        ok(hr == S_OK, "%u: Initialize error %#x\n", modes[i], hr);
+
+        hr = IWICBitmapScaler_GetPixelFormat(scaler, &format);
+        ok(hr == S_OK, "GetPixelFormat error %#x\n", hr);
+        ok(IsEqualGUID(&format, &GUID_WICPixelFormat16bppGray), "%u: unexpected pixel format %s\n",
+           modes[i], debugstr_guid(&format));
+
+        memset(pixels, 0, sizeof(pixels));
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 8, 32, (BYTE *)pixels);
+        ok(hr == S_OK, "%u: CopyPixels error %#x\n", modes[i], hr);
+        for (j = 0; j < 16; j++)
+            if (((WORD *)pixels)[j] != 0x1234) break;
+        ok(j == 16, "%u: pixel %u is %04x\n", modes[i], j, ((WORD *)pixels)[min(j, 15)]);
+
+        IWICBitmapScaler_Release(scaler);
+    }
+    IWICBitmap_Release(bitmap);
+
+    /* the Fant mode averages the covered source pixels */
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 4, 1, &GUID_WICPixelFormat8bppGray,
+        4, sizeof(gray_row), (BYTE *)gray_row, &bitmap);
+    ok(hr == S_OK, "CreateBitmapFromMemory error %#x\n", hr);
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "CreateBitmapScaler error %#x\n", hr);
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 2, 1, WICBitmapInterpolationModeFant);
+    ok(hr == S_OK, "Initialize error %#x\n", hr);
+    hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 2, sizeof(gray), gray);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    ok(gray[0] == 50, "got %u\n", gray[0]);
+    ok(gray[1] == 227 || gray[1] == 228, "got %u\n", gray[1]);
+    IWICBitmapScaler_Release(scaler);
+    IWICBitmap_Release(bitmap);
+
+    /* even when a destination pixel covers a large number of source pixels */
+    for (i = 0; i < 256; i++) row[i] = i;
+    for (i = 0; i < 2; i++)
+    {
+        width = i ? 1 : 256;
+        height = i ? 256 : 1;
+        hr = IWICImagingFactory_CreateBitmapFromMemory(factory, width, height, &GUID_WICPixelFormat8bppGray,
+            width, 256, row, &bitmap);
+        ok(hr == S_OK, "CreateBitmapFromMemory error %#x\n", hr);
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "CreateBitmapScaler error %#x\n", hr);
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 1, 1, WICBitmapInterpolationModeFant);
+        ok(hr == S_OK, "Initialize error %#x\n", hr);
+        gray[0] = 0;
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 1, 1, gray);
+        ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+        ok(gray[0] == 127 || gray[0] == 128, "%ux%u: got %u\n", width, height, gray[0]);
+        IWICBitmapScaler_Release(scaler);
+        IWICBitmap_Release(bitmap);
+    }
+
+    if (!winetest_interactive) return;
+
+    /* thumbnail a large image one scanline at a time */
+    data = HeapAlloc(GetProcessHeap(), 0, 4096 * 3072 * 4);
+    for (i = 0; i < 4096 * 3072 * 4; i++) data[i] = i * 7;
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 4096, 3072, &GUID_WICPixelFormat32bppBGRA,
+        4096 * 4, 4096 * 3072 * 4, data, &bitmap);
+    ok(hr == S_OK, "CreateBitmapFromMemory error %#x\n", hr);
+
+    for (i = 1; i < sizeof(modes)/sizeof(modes[0]); i++)
+    {
+        WICRect rect = { 0, 0, 256, 1 };
+
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "CreateBitmapScaler error %#x\n", hr);
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 256, 192, modes[i]);
+        ok(hr == S_OK, "Initialize error %#x\n", hr);
+
+        start = GetTickCount();
+        for (rect.Y = 0; rect.Y < 192 && hr == S_OK; rect.Y++)
+            hr = IWICBitmapScaler_CopyPixels(scaler, &rect, sizeof(row), sizeof(row), row);
+        ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+        elapsed = max(GetTickCount() - start, 1);
+        trace("mode %u: scaled 4096x3072 to 256x192 in %u ms (%u Mpixels/s)\n",
+              modes[i], elapsed, 4096 * 3072 / 1000 / elapsed);
+
+        IWICBitmapScaler_Release(scaler);
+    }
+    IWICBitmap_Release(bitmap);
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
 START_TEST(bitmap)
 {
     HRESULT hr;
@@ -1005,6 +1146,7 @@ START_TEST(bitmap)
     test_CreateBitmapFromHICON();
     test_CreateBitmapFromHBITMAP();
     test_clipper();
+    test_bitmap_scaler();
 
     IWICImagingFactory_Release(factory);
 
@@ -295,6 +295,46 @@ static const BYTE bits_32bppBGRA[] = {
 static const struct bitmap_data testdata_32bppBGRA = {
     &GUID_WICPixelFormat32bppBGRA, 32, bits_32bppBGRA, 4, 2, 96.0, 96.0};
 
+static const BYTE bits_8bppGray[] = {
+    0, 64, 128, 255,
+    32, 96, 160, 224};
+static const struct bitmap_data testdata_8bppGray = {
+    &GUID_WICPixelFormat8bppGray, 8, bits_8bppGray, 4, 2, 96.0, 96.0};
+
+static const BYTE bits_8bppGray_24bppBGR[] = {
+    0,0,0, 64,64,64, 128,128,128, 255,255,255,
+    32,32,32, 96,96,96, 160,160,160, 224,224,224};
+static const struct bitmap_data testdata_8bppGray_24bppBGR = {
+    &GUID_WICPixelFormat24bppBGR, 24, bits_8bppGray_24bppBGR, 4, 2, 96.0, 96.0};
+
+static const BYTE bits_8bppGray_32bppBGRA[] = {
+    0,0,0,255, 64,64,64,255, 128,128,128,255, 255,255,255,255,
+    32,32,32,255, 96,96,96,255, 160,160,160,255, 224,224,224,255};
+static const struct bitmap_data testdata_8bppGray_32bppBGRA = {
+    &GUID_WICPixelFormat32bppBGRA, 32, bits_8bppGray_32bppBGRA, 4, 2, 96.0, 96.0};
+
+static const WORD bits_16bppBGR555[] = {
+    0x7c00, 0x03e0, 0x001f, 0x0000,
+    0x7fff, 0x4210, 0x7c1f, 0x03ff};
+static const struct bitmap_data testdata_16bppBGR555 = {
+    &GUID_WICPixelFormat16bppBGR555, 16, (const BYTE *)bits_16bppBGR555, 4, 2, 96.0, 96.0};
+
+static const BYTE bits_16bppBGR555_32bppBGRA[] = {
+    0,0,255,255, 0,255,0,255, 255,0,0,255, 0,0,0,255,
+    255,255,255,255, 132,132,132,255, 255,0,255,255, 255,255,0,255};
+static const struct bitmap_data testdata_16bppBGR555_32bppBGRA = {
+    &GUID_WICPixelFormat32bppBGRA, 32, bits_16bppBGR555_32bppBGRA, 4, 2, 96.0, 96.0};
+
+static const BYTE bits_32bppBGRA_alpha[] = {
+    255,128,64,128, 10,20,30,0, 1,2,3,255, 200,100,50,51};
+static const struct bitmap_data testdata_32bppBGRA_alpha = {
+    &GUID_WICPixelFormat32bppBGRA, 32, bits_32bppBGRA_alpha, 4, 1, 96.0, 96.0};
+
+static const BYTE bits_32bppPBGRA[] = {
+    128,64,32,128, 0,0,0,0, 1,2,3,255, 40,20,10,51};
+static const struct bitmap_data testdata_32bppPBGRA = {
+    &GUID_WICPixelFormat32bppPBGRA, 32, bits_32bppPBGRA, 4, 1, 96.0, 96.0};
+
 static void test_conversion(const struct bitmap_data *src, const struct bitmap_data *dst, const char *name, BOOL todo)
 {
     BitmapTestSrc *src_obj;
@@ -319,6 +359,69 @@ static void test_conversion(const struct bitmap_data *src, const struct bitmap_d
     DeleteTestBitmap(src_obj);
 }
 
+static void test_large_conversion(void)
+{
+    static const UINT width = 1920, height = 1080;
+    struct bitmap_data src_data;
+    BitmapTestSrc *src_obj;
+    IWICBitmapSource *dst_bitmap;
+    BYTE *src_bits, *dst_bits;
+    UINT x, y, i, stride;
+    DWORD start, elapsed;
+    BOOL equal = TRUE;
+    HRESULT hr;
+
+    src_bits = HeapAlloc(GetProcessHeap(), 0, width * height * 3);
+    stride = width * 4;
+    dst_bits = HeapAlloc(GetProcessHeap(), 0, stride * height);
+    for (i = 0; i < width * height * 3; i++)
+        src_bits[i] = i * 7 + (i / 3);
+
+    src_data.format = &GUID_WICPixelFormat24bppBGR;
+    src_data.bpp = 24;
+    src_data.bits = src_bits;
+    src_data.width = width;
+    src_data.height = height;
+    src_data.xres = 96.0;
+    src_data.yres = 96.0;
+    CreateTestBitmap(&src_data, &src_obj);
+
+    hr = WICConvertBitmapSource(&GUID_WICPixelFormat32bppBGRA, &src_obj->IWICBitmapSource_iface, &dst_bitmap);
+    ok(SUCCEEDED(hr), "WICConvertBitmapSource failed, hr=%x\n", hr);
+
+    hr = IWICBitmapSource_CopyPixels(dst_bitmap, NULL, stride, stride * height, dst_bits);
+    ok(SUCCEEDED(hr), "CopyPixels failed, hr=%x\n", hr);
+
+    for (y = 0; y < height && equal; y++)
+        for (x = 0; x < width; x++)
+        {
+            const BYTE *s = src_bits + (y * width + x) * 3, *d = dst_bits + y * stride + x * 4;
+            if (d[0] != s[0] || d[1] != s[1] || d[2] != s[2] || d[3] != 0xff)
+            {
+                ok(0, "pixel (%u,%u) is %02x%02x%02x%02x\n", x, y, d[3], d[2], d[1], d[0]);
+                equal = FALSE;
+                break;
+            }
+        }
+
+    /* the stride check must not be bypassed by the streaming path */
+    hr = IWICBitmapSource_CopyPixels(dst_bitmap, NULL, stride - 1, stride * height, dst_bits);
+    ok(hr == E_INVALIDARG, "expected E_INVALIDARG, hr=%x\n", hr);
+    hr = IWICBitmapSource_CopyPixels(dst_bitmap, NULL, stride, stride * height - 1, dst_bits);
+    ok(hr == E_INVALIDARG, "expected E_INVALIDARG, hr=%x\n", hr);
+
+    start = GetTickCount();
+    for (i = 0; i < 10; i++)
+        IWICBitmapSource_CopyPixels(dst_bitmap, NULL, stride, stride * height, dst_bits);
+    elapsed = GetTickCount() - start;
+    trace("24bppBGR -> 32bppBGRA: %u frames of %ux%u in %u ms\n", i, width, height, elapsed);
+
+    IWICBitmapSource_Release(dst_bitmap);
+    DeleteTestBitmap(src_obj);
+    HeapFree(GetProcessHeap(), 0, dst_bits);
+    HeapFree(GetProcessHeap(), 0, src_bits);
+}
+
 static void test_invalid_conversion(void)
 {
     BitmapTestSrc *src_obj;
@@ -660,6 +763,12 @@ START_TEST(converter)
     test_conversion(&testdata_32bppBGR, &testdata_24bppRGB, "32bppBGR -> 24bppRGB", FALSE);
     test_conversion(&testdata_24bppRGB, &testdata_32bppBGR, "24bppRGB -> 32bppBGR", FALSE);
 
+    test_conversion(&testdata_8bppGray, &testdata_8bppGray_24bppBGR, "8bppGray -> 24bppBGR", FALSE);
+    test_conversion(&testdata_8bppGray, &testdata_8bppGray_32bppBGRA, "8bppGray -> 32bppBGRA", FALSE);
+    test_conversion(&testdata_16bppBGR555, &testdata_16bppBGR555_32bppBGRA, "16bppBGR555 -> 32bppBGRA", FALSE);
+    test_conversion(&testdata_32bppBGRA_alpha, &testdata_32bppPBGRA, "32bppBGRA -> 32bppPBGRA", FALSE);
+    test_large_conversion();
+
     test_invalid_conversion();
     test_default_converter();
 
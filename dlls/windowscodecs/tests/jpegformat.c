@@ -0,0 +1,370 @@
+/*
+ * Copyright 2012 Dmitry Timoshkov
+ * Copyright 2012 Hans Leidekker for CodeWeavers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COBJMACROS
+
+#include "windef.h"
+#include "winbase.h"
+#include "initguid.h"
+#include "wincodec.h"
+#include "psapi.h"
+#include "wine/test.h"
+
+static IWICImagingFactory *factory;
+
+static BOOL (WINAPI *pK32GetProcessMemoryInfo)(HANDLE,PROCESS_MEMORY_COUNTERS*,DWORD);
+
+static const char *debugstr_guid(const GUID *guid)
+{
+    static char buf[50];
+
+    if (!guid) return "(null)";
+    sprintf(buf, "{%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x}",
+            guid->Data1, guid->Data2, guid->Data3, guid->Data4[0],
+            guid->Data4[1], guid->Data4[2], guid->Data4[3], guid->Data4[4],
+            guid->Data4[5], guid->Data4[6], guid->Data4[7]);
+    return buf;
+}
+
+/* 16x16 blocks of solid colors, so that the compression loss stays small */
+static BYTE get_test_color(UINT x, UINT y, UINT c)
+{
+    static const BYTE colors[4][3] = {{0,0,255}, {0,255,0}, {255,0,0}, {255,255,255}};
+    return colors[(x / 16 + y / 16 * 3) % 4][c];
+}
+
+static IStream *encode_jpeg(UINT width, UINT height)
+{
+    WICPixelFormatGUID format = GUID_WICPixelFormat24bppBGR;
+    IWICBitmapEncoder *encoder;
+    IWICBitmapFrameEncode *frame;
+    IStream *stream;
+    UINT x, y, c, lines, stride = width * 3;
+    BYTE *bits;
+    HRESULT hr;
+
+    hr = IWICImagingFactory_CreateEncoder(factory, &GUID_ContainerFormatJpeg, NULL, &encoder);
+    if (FAILED(hr))
+    {
+        win_skip("JPEG encoder is not available\n");
+        return NULL;
+    }
+
+    /* the image is written in strips of 16 rows, so that large images don't need a full buffer */
+    bits = HeapAlloc(GetProcessHeap(), 0, stride * 16);
+
+    hr = CreateStreamOnHGlobal(NULL, TRUE, &stream);
+    ok(hr == S_OK, "CreateStreamOnHGlobal error %#x\n", hr);
+
+    hr = IWICBitmapEncoder_Initialize(encoder, stream, WICBitmapEncoderNoCache);
+    ok(hr == S_OK, "Initialize error %#x\n", hr);
+    hr = IWICBitmapEncoder_CreateNewFrame(encoder, &frame, NULL);
+    ok(hr == S_OK, "CreateNewFrame error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_Initialize(frame, NULL);
+    ok(hr == S_OK, "Initialize error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_SetSize(frame, width, height);
+    ok(hr == S_OK, "SetSize error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_SetPixelFormat(frame, &format);
+    ok(hr == S_OK, "SetPixelFormat error %#x\n", hr);
+    ok(IsEqualGUID(&format, &GUID_WICPixelFormat24bppBGR), "got wrong format %s\n", debugstr_guid(&format));
+    for (y = 0; y < height && hr == S_OK; y += lines)
+    {
+        lines = min(height - y, 16);
+        for (x = 0; x < width; x++)
+            for (c = 0; c < 3; c++)
+                bits[x * 3 + c] = get_test_color(x, y, c);
+        for (x = 1; x < lines; x++)
+            memcpy(bits + x * stride, bits, stride);
+        hr = IWICBitmapFrameEncode_WritePixels(frame, lines, stride, stride * lines, bits);
+    }
+    ok(hr == S_OK, "WritePixels error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_Commit(frame);
+    ok(hr == S_OK, "Commit error %#x\n", hr);
+    hr = IWICBitmapEncoder_Commit(encoder);
+    ok(hr == S_OK, "Commit error %#x\n", hr);
+
+    IWICBitmapFrameEncode_Release(frame);
+    IWICBitmapEncoder_Release(encoder);
+    HeapFree(GetProcessHeap(), 0, bits);
+
+    return stream;
+}
+
+static void check_pixels(const BYTE *buffer, UINT stride, const WICRect *rc, UINT scale)
+{
+    INT x, y;
+    UINT c;
+
+    /* only check the centers of the color blocks */
+    for (y = 0; y < rc->Height; y++)
+        for (x = 0; x < rc->Width; x++)
+        {
+            UINT src_x = (rc->X + x) * scale, src_y = (rc->Y + y) * scale;
+
+            if (src_x % 16 < 4 || src_x % 16 >= 12 || src_y % 16 < 4 || src_y % 16 >= 12)
+                continue;
+
+            for (c = 0; c < 3; c++)
+            {
+                BYTE expected = get_test_color(src_x, src_y, c), got = buffer[y * stride + x * 3 + c];
+                if (abs(expected - got) > 24)
+                {
+                    ok(0, "pixel (%u,%u) component %u: expected %u, got %u\n", x, y, c, expected, got);
+                    return;
+                }
+            }
+        }
+}
+
+static void test_jpeg_strips(void)
+{
+    static const UINT width = 1024, height = 768;
+    IWICBitmapDecoder *decoder;
+    IWICBitmapFrameDecode *frame;
+    IStream *stream;
+    BYTE *buffer;
+    WICRect rc;
+    HRESULT hr;
+
+    stream = encode_jpeg(width, height);
+    if (!stream) return;
+
+    hr = IWICImagingFactory_CreateDecoderFromStream(factory, stream, NULL, 0, &decoder);
+    ok(hr == S_OK, "CreateDecoderFromStream error %#x\n", hr);
+    hr = IWICBitmapDecoder_GetFrame(decoder, 0, &frame);
+    ok(hr == S_OK, "GetFrame error %#x\n", hr);
+
+    buffer = HeapAlloc(GetProcessHeap(), 0, width * 3 * 32);
+
+    rc.X = 0;
+    rc.Y = 512;
+    rc.Width = width;
+    rc.Height = 32;
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, width * 3, width * 3 * 32, buffer);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    check_pixels(buffer, width * 3, &rc, 1);
+
+    /* rows before the last strip */
+    rc.X = 320;
+    rc.Y = 64;
+    rc.Width = 64;
+    rc.Height = 32;
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, 64 * 3, 64 * 3 * 32, buffer);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    check_pixels(buffer, 64 * 3, &rc, 1);
+
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, 64 * 3 - 1, 64 * 3 * 32, buffer);
+    ok(hr == E_INVALIDARG, "expected E_INVALIDARG, got %#x\n", hr);
+
+    HeapFree(GetProcessHeap(), 0, buffer);
+    IWICBitmapFrameDecode_Release(frame);
+    IWICBitmapDecoder_Release(decoder);
+    IStream_Release(stream);
+}
+
+static void test_jpeg_source_transform(void)
+{
+    static const UINT width = 1024, height = 768;
+    IWICBitmapSourceTransform *transform;
+    IWICBitmapDecoder *decoder;
+    IWICBitmapFrameDecode *frame;
+    WICPixelFormatGUID format;
+    IStream *stream;
+    UINT scaled_width, scaled_height;
+    BYTE *buffer;
+    BOOL supported;
+    DWORD start;
+    WICRect rc;
+    HRESULT hr;
+
+    stream = encode_jpeg(width, height);
+    if (!stream) return;
+
+    hr = IWICImagingFactory_CreateDecoderFromStream(factory, stream, NULL, 0, &decoder);
+    ok(hr == S_OK, "CreateDecoderFromStream error %#x\n", hr);
+    hr = IWICBitmapDecoder_GetFrame(decoder, 0, &frame);
+    ok(hr == S_OK, "GetFrame error %#x\n", hr);
+
+    hr = IWICBitmapFrameDecode_QueryInterface(frame, &IID_IWICBitmapSourceTransform, (void **)&transform);
+    ok(hr == S_OK, "QueryInterface error %#x\n", hr);
+    if (FAILED(hr))
+    {
+        IWICBitmapFrameDecode_Release(frame);
+        IWICBitmapDecoder_Release(decoder);
+        IStream_Release(stream);
+        return;
+    }
+
+    supported = FALSE;
+    hr = IWICBitmapSourceTransform_DoesSupportTransform(transform, WICBitmapTransformRotate0, &supported);
+    ok(hr == S_OK, "DoesSupportTransform error %#x\n", hr);
+    ok(supported, "expected Rotate0 to be supported\n");
+
+    format = GUID_WICPixelFormat32bppBGRA;
+    hr = IWICBitmapSourceTransform_GetClosestPixelFormat(transform, &format);
+    ok(hr == S_OK, "GetClosestPixelFormat error %#x\n", hr);
+    ok(IsEqualGUID(&format, &GUID_WICPixelFormat24bppBGR), "got wrong format %s\n", debugstr_guid(&format));
+
+    scaled_width = width / 8;
+    scaled_height = height / 8;
+    hr = IWICBitmapSourceTransform_GetClosestSize(transform, &scaled_width, &scaled_height);
+    ok(hr == S_OK, "GetClosestSize error %#x\n", hr);
+    ok(scaled_width == width / 8 && scaled_height == height / 8,
+       "got %ux%u\n", scaled_width, scaled_height);
+
+    scaled_width = width / 4;
+    scaled_height = height / 4;
+    hr = IWICBitmapSourceTransform_GetClosestSize(transform, &scaled_width, &scaled_height);
+    ok(hr == S_OK, "GetClosestSize error %#x\n", hr);
+    ok(scaled_width == width / 4 && scaled_height == height / 4,
+       "got %ux%u\n", scaled_width, scaled_height);
+
+    buffer = HeapAlloc(GetProcessHeap(), 0, scaled_width * 3 * scaled_height);
+
+    start = GetTickCount();
+    hr = IWICBitmapSourceTransform_CopyPixels(transform, NULL, scaled_width, scaled_height, &format,
+        WICBitmapTransformRotate0, scaled_width * 3, scaled_width * 3 * scaled_height, buffer);
+    trace("%ux%u preview of a %ux%u image decoded in %u ms\n", scaled_width, scaled_height,
+          width, height, GetTickCount() - start);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    rc.X = 0;
+    rc.Y = 0;
+    rc.Width = scaled_width;
+    rc.Height = scaled_height;
+    check_pixels(buffer, scaled_width * 3, &rc, 4);
+
+    /* a strip of the scaled image */
+    rc.Y = 64;
+    rc.Height = 16;
+    hr = IWICBitmapSourceTransform_CopyPixels(transform, &rc, scaled_width, scaled_height, &format,
+        WICBitmapTransformRotate0, scaled_width * 3, scaled_width * 3 * 16, buffer);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    check_pixels(buffer, scaled_width * 3, &rc, 4);
+
+    /* the frame still returns the full size image */
+    rc.X = 0;
+    rc.Y = 0;
+    rc.Width = 64;
+    rc.Height = 16;
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, 64 * 3, 64 * 3 * 16, buffer);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    check_pixels(buffer, 64 * 3, &rc, 1);
+
+    HeapFree(GetProcessHeap(), 0, buffer);
+    IWICBitmapSourceTransform_Release(transform);
+    IWICBitmapFrameDecode_Release(frame);
+    IWICBitmapDecoder_Release(decoder);
+    IStream_Release(stream);
+}
+
+static SIZE_T get_private_bytes(void)
+{
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (!pK32GetProcessMemoryInfo ||
+        !pK32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PagefileUsage;
+}
+
+/* a 100 megapixel image, decoding a strip or a preview shouldn't need memory for the full image */
+static void test_jpeg_large(void)
+{
+    static const UINT width = 12288, height = 8192;
+    IWICBitmapSourceTransform *transform;
+    IWICBitmapDecoder *decoder;
+    IWICBitmapFrameDecode *frame;
+    WICPixelFormatGUID format = GUID_WICPixelFormat24bppBGR;
+    IStream *stream;
+    SIZE_T base;
+    DWORD start;
+    BYTE *buffer;
+    WICRect rc;
+    HRESULT hr;
+
+    stream = encode_jpeg(width, height);
+    if (!stream) return;
+
+    buffer = HeapAlloc(GetProcessHeap(), 0, width * 3 * 16);
+
+    base = get_private_bytes();
+    start = GetTickCount();
+    hr = IWICImagingFactory_CreateDecoderFromStream(factory, stream, NULL, 0, &decoder);
+    ok(hr == S_OK, "CreateDecoderFromStream error %#x\n", hr);
+    hr = IWICBitmapDecoder_GetFrame(decoder, 0, &frame);
+    ok(hr == S_OK, "GetFrame error %#x\n", hr);
+
+    rc.X = 0;
+    rc.Y = height / 2;
+    rc.Width = width;
+    rc.Height = 16;
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, width * 3, width * 3 * 16, buffer);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    check_pixels(buffer, width * 3, &rc, 1);
+    trace("strip in the middle of a %ux%u image decoded in %u ms, %u KB allocated\n", width, height,
+          GetTickCount() - start, (UINT)((get_private_bytes() - base) / 1024));
+
+    hr = IWICBitmapFrameDecode_QueryInterface(frame, &IID_IWICBitmapSourceTransform, (void **)&transform);
+    ok(hr == S_OK, "QueryInterface error %#x\n", hr);
+    if (SUCCEEDED(hr))
+    {
+        start = GetTickCount();
+        rc.X = 0;
+        rc.Y = 0;
+        rc.Width = width / 8;
+        rc.Height = 16;
+        hr = IWICBitmapSourceTransform_CopyPixels(transform, &rc, width / 8, height / 8, &format,
+            WICBitmapTransformRotate0, width / 8 * 3, width / 8 * 3 * 16, buffer);
+        ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+        check_pixels(buffer, width / 8 * 3, &rc, 8);
+        trace("first strip of a %ux%u preview decoded in %u ms, %u KB allocated\n", width / 8, height / 8,
+              GetTickCount() - start, (UINT)((get_private_bytes() - base) / 1024));
+        IWICBitmapSourceTransform_Release(transform);
+    }
+
+    HeapFree(GetProcessHeap(), 0, buffer);
+    IWICBitmapFrameDecode_Release(frame);
+    IWICBitmapDecoder_Release(decoder);
+    IStream_Release(stream);
+}
+
+START_TEST(jpegformat)
+{
+    HRESULT hr;
+
+    pK32GetProcessMemoryInfo = (void *)GetProcAddress(GetModuleHandleA("kernel32.dll"), "K32GetProcessMemoryInfo");
+
+    CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+    hr = CoCreateInstance(&CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER,
+                          &IID_IWICImagingFactory, (void **)&factory);
+    ok(hr == S_OK, "CoCreateInstance error %#x\n", hr);
+    if (FAILED(hr)) return;
+
+    test_jpeg_strips();
+    test_jpeg_source_transform();
+    if (winetest_interactive)
+        test_jpeg_large();
+
+    IWICImagingFactory_Release(factory);
+    CoUninitialize();
+}
@@ -585,6 +585,117 @@ static void test_png_palette(void)
     IWICBitmapDecoder_Release(decoder);
 }
 
+static IStream *encode_png(const BYTE *bits, UINT width, UINT height, UINT stride)
+{
+    WICPixelFormatGUID format = GUID_WICPixelFormat24bppBGR;
+    IWICBitmapEncoder *encoder;
+    IWICBitmapFrameEncode *frame;
+    IStream *stream;
+    HRESULT hr;
+
+    hr = CreateStreamOnHGlobal(NULL, TRUE, &stream);
+    ok(hr == S_OK, "CreateStreamOnHGlobal error %#x\n", hr);
+
+    hr = IWICImagingFactory_CreateEncoder(factory, &GUID_ContainerFormatPng, NULL, &encoder);
+    ok(hr == S_OK, "CreateEncoder error %#x\n", hr);
+    hr = IWICBitmapEncoder_Initialize(encoder, stream, WICBitmapEncoderNoCache);
+    ok(hr == S_OK, "Initialize error %#x\n", hr);
+    hr = IWICBitmapEncoder_CreateNewFrame(encoder, &frame, NULL);
+    ok(hr == S_OK, "CreateNewFrame error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_Initialize(frame, NULL);
+    ok(hr == S_OK, "Initialize error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_SetSize(frame, width, height);
+    ok(hr == S_OK, "SetSize error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_SetPixelFormat(frame, &format);
+    ok(hr == S_OK, "SetPixelFormat error %#x\n", hr);
+    ok(IsEqualGUID(&format, &GUID_WICPixelFormat24bppBGR), "got wrong format %s\n", debugstr_guid(&format));
+    hr = IWICBitmapFrameEncode_WritePixels(frame, height, stride, stride * height, (BYTE *)bits);
+    ok(hr == S_OK, "WritePixels error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_Commit(frame);
+    ok(hr == S_OK, "Commit error %#x\n", hr);
+    hr = IWICBitmapEncoder_Commit(encoder);
+    ok(hr == S_OK, "Commit error %#x\n", hr);
+
+    IWICBitmapFrameEncode_Release(frame);
+    IWICBitmapEncoder_Release(encoder);
+
+    return stream;
+}
+
+static BOOL compare_rows(const BYTE *bits, UINT stride, const WICRect *rc, const BYTE *buffer, UINT buffer_stride)
+{
+    INT y;
+
+    for (y = 0; y < rc->Height; y++)
+        if (memcmp(bits + (rc->Y + y) * stride + rc->X * 3, buffer + y * buffer_stride, rc->Width * 3))
+            return FALSE;
+
+    return TRUE;
+}
+
+static void test_png_strips(void)
+{
+    /* large enough to be decoded on demand instead of being cached */
+    static const UINT width = 2048, height = 3072;
+    IWICBitmapDecoder *decoder;
+    IWICBitmapFrameDecode *frame;
+    IStream *stream;
+    BYTE *bits, *buffer;
+    UINT x, y, stride = width * 3;
+    DWORD start;
+    WICRect rc;
+    HRESULT hr;
+
+    bits = HeapAlloc(GetProcessHeap(), 0, stride * height);
+    buffer = HeapAlloc(GetProcessHeap(), 0, stride * 64);
+    for (y = 0; y < height; y++)
+        for (x = 0; x < stride; x++)
+            bits[y * stride + x] = (x / 3 + y) ^ (x % 3 * 0x55);
+
+    stream = encode_png(bits, width, height, stride);
+
+    hr = IWICImagingFactory_CreateDecoderFromStream(factory, stream, NULL, 0, &decoder);
+    ok(hr == S_OK, "CreateDecoderFromStream error %#x\n", hr);
+    hr = IWICBitmapDecoder_GetFrame(decoder, 0, &frame);
+    ok(hr == S_OK, "GetFrame error %#x\n", hr);
+
+    rc.X = 0;
+    rc.Y = 2000;
+    rc.Width = width;
+    rc.Height = 64;
+    start = GetTickCount();
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, stride, stride * 64, buffer);
+    trace("first strip of a %ux%u image decoded in %u ms\n", width, height, GetTickCount() - start);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    ok(compare_rows(bits, stride, &rc, buffer, stride), "unexpected pixel data\n");
+
+    /* rows after the last strip */
+    rc.Y = 2064;
+    rc.X = 100;
+    rc.Width = 50;
+    rc.Height = 10;
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, 150, 1500, buffer);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    ok(compare_rows(bits, stride, &rc, buffer, 150), "unexpected pixel data\n");
+
+    /* rows before the last strip */
+    rc.Y = 10;
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, 150, 1500, buffer);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    ok(compare_rows(bits, stride, &rc, buffer, 150), "unexpected pixel data\n");
+
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, 149, 1500, buffer);
+    ok(hr == E_INVALIDARG, "expected E_INVALIDARG, got %#x\n", hr);
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, 150, 1499, buffer);
+    ok(hr == E_INVALIDARG, "expected E_INVALIDARG, got %#x\n", hr);
+
+    IWICBitmapFrameDecode_Release(frame);
+    IWICBitmapDecoder_Release(decoder);
+    IStream_Release(stream);
+    HeapFree(GetProcessHeap(), 0, buffer);
+    HeapFree(GetProcessHeap(), 0, bits);
+}
+
 START_TEST(pngformat)
 {
     HRESULT hr;
@@ -597,6 +708,7 @@ START_TEST(pngformat)
 
     test_color_contexts();
     test_png_palette();
+    test_png_strips();
 
     IWICImagingFactory_Release(factory);
     CoUninitialize();
@@ -194,6 +194,8 @@ typedef struct
     ISequentialStream *stream;
     input_buffer *buffer;
     unsigned int pending : 1;
+    /* last stream read returned less than requested */
+    unsigned int exhausted : 1;
 } xmlreaderinput;
 
 static const struct IUnknownVtbl xmlreaderinputvtbl;
@@ -522,8 +524,24 @@ static void reader_pop_element(xmlreader *reader)
     }
 }
 
-/* Always make a copy, cause strings are supposed to be null terminated. Null pointer for 'value'
-   means node value is to be determined. */
+/* Makes a null-terminated copy of a value that still points to input buffer data */
+static HRESULT reader_alloc_strvalue(xmlreader *reader, strval *v)
+{
+    WCHAR *ptr;
+
+    if (v->str) return S_OK;
+
+    ptr = reader_alloc(reader, (v->len+1)*sizeof(WCHAR));
+    if (!ptr) return E_OUTOFMEMORY;
+    memcpy(ptr, reader_get_ptr2(reader, v->start), v->len*sizeof(WCHAR));
+    ptr[v->len] = 0;
+    v->str = ptr;
+    return S_OK;
+}
+
+/* Values that point to input buffer are copied only when requested, strings that
+   already have storage are always copied. Null pointer for 'value' means node value
+   is to be determined. */
 static void reader_set_strvalue(xmlreader *reader, XmlReaderStringValue type, const strval *value)
 {
     strval *v = &reader->strvalues[type];
@@ -537,24 +555,22 @@ static void reader_set_strvalue(xmlreader *reader, XmlReaderStringValue type, co
         return;
     }
 
-    if (value->str == strval_empty.str)
-        *v = *value;
+    if (value->str == strval_empty.str || !value->len)
+        *v = strval_empty;
+    else if (!value->str)
+    {
+        /* defer allocation until string is requested */
+        v->str = NULL;
+        v->start = value->start;
+        v->len = value->len;
+    }
     else
     {
-        if (type == StringValue_Value)
-        {
-            /* defer allocation for value string */
-            v->str = NULL;
-            v->start = value->start;
-            v->len = value->len;
-        }
-        else
-        {
-            v->str = reader_alloc(reader, (value->len + 1)*sizeof(WCHAR));
-            memcpy(v->str, reader_get_strptr(reader, value), value->len*sizeof(WCHAR));
-            v->str[value->len] = 0;
-            v->len = value->len;
-        }
+        v->str = reader_alloc(reader, (value->len + 1)*sizeof(WCHAR));
+        memcpy(v->str, value->str, value->len*sizeof(WCHAR));
+        v->str[value->len] = 0;
+        v->start = 0;
+        v->len = value->len;
     }
 }
 
@@ -706,6 +722,7 @@ static HRESULT readerinput_growraw(xmlreaderinput *readerinput)
     hr = ISequentialStream_Read(readerinput->stream, buffer->data + buffer->written, len, &read);
     TRACE("written=%d, alloc=%d, requested=%d, read=%d, ret=0x%08x\n", buffer->written, buffer->allocated, len, read, hr);
     readerinput->pending = hr == E_PENDING;
+    readerinput->exhausted = FAILED(hr) || read < len;
     if (FAILED(hr)) return hr;
     buffer->written += read;
 
@@ -788,16 +805,28 @@ static HRESULT readerinput_detectencoding(xmlreaderinput *readerinput, xml_encod
 static int readerinput_get_utf8_convlen(xmlreaderinput *readerinput)
 {
     encoded_buffer *buffer = &readerinput->buffer->encoded;
-    int len = buffer->written;
+    unsigned char *data = (unsigned char*)buffer->data;
+    int len = buffer->written, start, seqlen;
 
     /* complete single byte char */
-    if (!(buffer->data[len-1] & 0x80)) return len;
-
-    /* find start byte of multibyte char */
-    while (--len && !(buffer->data[len] & 0xc0))
-        ;
+    if (len == buffer->cur || !(data[len-1] & 0x80)) return len;
+
+    /* find start byte of last multibyte char */
+    start = len - 1;
+    while (start > buffer->cur && len - start < 4 && (data[start] & 0xc0) == 0x80)
+        start--;
+
+    if ((data[start] & 0xe0) == 0xc0)
+        seqlen = 2;
+    else if ((data[start] & 0xf0) == 0xe0)
+        seqlen = 3;
+    else if ((data[start] & 0xf8) == 0xf0)
+        seqlen = 4;
+    else
+        seqlen = 1;
 
-    return len;
+    /* keep incomplete sequence for next chunk */
+    return start + seqlen > len ? start : len;
 }
 
 /* Returns byte length of complete char sequence for buffer code page,
@@ -811,23 +840,20 @@ static int readerinput_get_convlen(xmlreaderinput *readerinput)
     if (readerinput->buffer->code_page == CP_UTF8)
         len = readerinput_get_utf8_convlen(readerinput);
     else
-        len = buffer->written;
+        len = buffer->written & ~1;
 
     TRACE("%d\n", len - buffer->cur);
     return len - buffer->cur;
 }
 
 /* It's possible that raw buffer has some leftovers from last conversion - some char
-   sequence that doesn't represent a full code point. Length argument should be calculated with
-   readerinput_get_convlen(), if it's -1 it will be calculated here. */
+   sequence that doesn't represent a full code point. Length argument is a number of
+   converted bytes as returned by readerinput_get_convlen(), everything after that is kept. */
 static void readerinput_shrinkraw(xmlreaderinput *readerinput, int len)
 {
     encoded_buffer *buffer = &readerinput->buffer->encoded;
 
-    if (len == -1)
-        len = readerinput_get_convlen(readerinput);
-
-    memmove(buffer->data, buffer->data + buffer->cur + (buffer->written - len), len);
+    memmove(buffer->data, buffer->data + buffer->cur + len, buffer->written - buffer->cur - len);
     /* everything below cur is lost too */
     buffer->written -= len + buffer->cur;
     /* after this point we don't need cur offset really,
@@ -835,15 +861,47 @@ static void readerinput_shrinkraw(xmlreaderinput *readerinput, int len)
     buffer->cur = 0;
 }
 
-/* note that raw buffer content is kept */
-static void readerinput_switchencoding(xmlreaderinput *readerinput, xml_encoding enc)
+/* Appends 'len' bytes of raw data to UTF-16 buffer. Leading ASCII run, which is
+   the common case for markup, is widened directly without a code page conversion. */
+static void readerinput_decode(xmlreaderinput *readerinput, int len)
 {
     encoded_buffer *src = &readerinput->buffer->encoded;
     encoded_buffer *dest = &readerinput->buffer->utf16;
-    int len, dest_len;
-    HRESULT hr;
+    UINT cp = readerinput->buffer->code_page;
+    const unsigned char *data;
+    int dest_len;
     WCHAR *ptr;
+
+    /* just copy for UTF-16 case */
+    if (cp == ~0)
+    {
+        readerinput_grow(readerinput, len / sizeof(WCHAR));
+        memcpy(dest->data + dest->written, src->data + src->cur, len);
+        dest->written += len;
+        *(WCHAR*)(dest->data + dest->written) = 0;
+        return;
+    }
+
+    /* decoded length never exceeds number of bytes for supported code pages */
+    readerinput_grow(readerinput, len);
+    data = (const unsigned char*)src->data + src->cur;
+    ptr = (WCHAR*)(dest->data + dest->written);
+
+    for (dest_len = 0; dest_len < len && data[dest_len] < 0x80; dest_len++)
+        ptr[dest_len] = data[dest_len];
+
+    if (dest_len < len)
+        dest_len += MultiByteToWideChar(cp, 0, (const char*)data + dest_len, len - dest_len,
+                                        ptr + dest_len, len - dest_len);
+    ptr[dest_len] = 0;
+    dest->written += dest_len*sizeof(WCHAR);
+}
+
+static void readerinput_switchencoding(xmlreaderinput *readerinput, xml_encoding enc)
+{
+    HRESULT hr;
     UINT cp;
+    int len;
 
     hr = get_code_page(enc, &cp);
     if (FAILED(hr)) return;
@@ -853,21 +911,8 @@ static void readerinput_switchencoding(xmlreaderinput *readerinput, xml_encoding
 
     TRACE("switching to cp %d\n", cp);
 
-    /* just copy in this case */
-    if (enc == XmlEncoding_UTF16)
-    {
-        readerinput_grow(readerinput, len);
-        memcpy(dest->data, src->data + src->cur, len);
-        dest->written += len*sizeof(WCHAR);
-        return;
-    }
-
-    dest_len = MultiByteToWideChar(cp, 0, src->data + src->cur, len, NULL, 0);
-    readerinput_grow(readerinput, dest_len);
-    ptr = (WCHAR*)dest->data;
-    MultiByteToWideChar(cp, 0, src->data + src->cur, len, ptr, dest_len);
-    ptr[dest_len] = 0;
-    dest->written += dest_len*sizeof(WCHAR);
+    readerinput_decode(readerinput, len);
+    readerinput_shrinkraw(readerinput, len);
 }
 
 /* shrinks parsed data a buffer begins with */
@@ -878,6 +923,17 @@ static void reader_shrink(xmlreader *reader)
     /* avoid to move too often using threshold shrink length */
     if (buffer->cur*sizeof(WCHAR) > buffer->written / 2)
     {
+        static const XmlReaderStringValue names[] =
+            { StringValue_Prefix, StringValue_LocalName, StringValue_QualifiedName };
+        int i;
+
+        /* names of current node are still reported until new node is parsed */
+        for (i = 0; i < sizeof(names)/sizeof(names[0]); i++)
+        {
+            strval *v = &reader->strvalues[names[i]];
+            if (!v->str && v->len && FAILED(reader_alloc_strvalue(reader, v))) return;
+        }
+
         buffer->written -= buffer->cur*sizeof(WCHAR);
         memmove(buffer->data, (WCHAR*)buffer->data + buffer->cur, buffer->written);
         buffer->cur = 0;
@@ -890,32 +946,13 @@ static void reader_shrink(xmlreader *reader)
 static HRESULT reader_more(xmlreader *reader)
 {
     xmlreaderinput *readerinput = reader->input;
-    encoded_buffer *src = &readerinput->buffer->encoded;
-    encoded_buffer *dest = &readerinput->buffer->utf16;
-    UINT cp = readerinput->buffer->code_page;
-    int len, dest_len;
     HRESULT hr;
-    WCHAR *ptr;
+    int len;
 
     /* get some raw data from stream first */
     hr = readerinput_growraw(readerinput);
     len = readerinput_get_convlen(readerinput);
-
-    /* just copy for UTF-16 case */
-    if (cp == ~0)
-    {
-        readerinput_grow(readerinput, len);
-        memcpy(dest->data + dest->written, src->data + src->cur, len);
-        dest->written += len*sizeof(WCHAR);
-        return hr;
-    }
-
-    dest_len = MultiByteToWideChar(cp, 0, src->data + src->cur, len, NULL, 0);
-    readerinput_grow(readerinput, dest_len);
-    ptr = (WCHAR*)(dest->data + dest->written);
-    MultiByteToWideChar(cp, 0, src->data + src->cur, len, ptr, dest_len);
-    ptr[dest_len] = 0;
-    dest->written += dest_len*sizeof(WCHAR);
+    readerinput_decode(readerinput, len);
     /* get rid of processed data */
     readerinput_shrinkraw(readerinput, len);
 
@@ -935,10 +972,29 @@ static inline WCHAR *reader_get_ptr(xmlreader *reader)
     return (WCHAR*)buffer->data + buffer->cur;
 }
 
+/* Returns pointer to current position with at least 'count' chars available after it,
+   as long as stream fills our read requests completely. Unlike reader_get_ptr() it won't
+   attempt to read from a stream that returned short or failed last time. */
+static WCHAR *reader_get_ptr_ahead(xmlreader *reader, UINT count)
+{
+    encoded_buffer *buffer = &reader->input->buffer->utf16;
+
+    while (buffer->written/sizeof(WCHAR) - buffer->cur < count && !reader->input->exhausted)
+    {
+        if (FAILED(reader_more(reader))) break;
+    }
+
+    return (WCHAR*)buffer->data + buffer->cur;
+}
+
 static int reader_cmp(xmlreader *reader, const WCHAR *str)
 {
-    const WCHAR *ptr = reader_get_ptr(reader);
-    return strncmpW(str, ptr, strlenW(str));
+    int len = strlenW(str);
+    const WCHAR *ptr;
+
+    reader_get_ptr(reader);
+    ptr = reader_get_ptr_ahead(reader, len);
+    return strncmpW(str, ptr, len);
 }
 
 /* moves cursor n WCHARs forward */
@@ -1224,7 +1280,7 @@ static HRESULT reader_parse_comment(xmlreader *reader)
         /* skip '<!--' */
         reader_skipn(reader, 4);
         reader_shrink(reader);
-        ptr = reader_get_ptr(reader);
+        ptr = reader_get_ptr_ahead(reader, 3);
         start = reader_get_cur(reader);
         reader->nodetype = XmlNodeType_Comment;
         reader->resume[XmlReadResume_Body] = start;
@@ -1265,7 +1321,7 @@ static HRESULT reader_parse_comment(xmlreader *reader)
         }
 
         reader_skipn(reader, 1);
-        ptr++;
+        ptr = reader_get_ptr_ahead(reader, 3);
     }
 
     return S_OK;
@@ -1482,7 +1538,7 @@ static HRESULT reader_parse_pi(xmlreader *reader)
         }
 
         reader_skipn(reader, 1);
-        ptr = reader_get_ptr(reader);
+        ptr = reader_get_ptr_ahead(reader, 2);
     }
 
     return S_OK;
@@ -2208,7 +2264,7 @@ static HRESULT reader_parse_cdata(xmlreader *reader)
         /* skip markup '<![CDATA[' */
         reader_skipn(reader, 9);
         reader_shrink(reader);
-        ptr = reader_get_ptr(reader);
+        ptr = reader_get_ptr_ahead(reader, 3);
         start = reader_get_cur(reader);
         reader->nodetype = XmlNodeType_CDATA;
         reader->resume[XmlReadResume_Body] = start;
@@ -2246,7 +2302,7 @@ static HRESULT reader_parse_cdata(xmlreader *reader)
             */
             if (*ptr == '\r') *ptr = '\n';
             reader_skipn(reader, 1);
-            ptr++;
+            ptr = reader_get_ptr_ahead(reader, 3);
         }
     }
 
@@ -2267,7 +2323,7 @@ static HRESULT reader_parse_chardata(xmlreader *reader)
     else
     {
         reader_shrink(reader);
-        ptr = reader_get_ptr(reader);
+        ptr = reader_get_ptr_ahead(reader, 3);
         start = reader_get_cur(reader);
         /* There's no text */
         if (!*ptr || *ptr == '<') return S_OK;
@@ -2301,7 +2357,7 @@ static HRESULT reader_parse_chardata(xmlreader *reader)
 
         /* this covers a case when text has leading whitespace chars */
         if (!is_wchar_space(*ptr)) reader->nodetype = XmlNodeType_Text;
-        ptr++;
+        ptr = reader_get_ptr_ahead(reader, 3);
     }
 
     return S_OK;
@@ -2388,7 +2444,6 @@ static HRESULT reader_parse_nextnode(xmlreader *reader)
                 hr = reader_parse_xmldecl(reader);
                 if (FAILED(hr)) return hr;
 
-                readerinput_shrinkraw(reader->input, -1);
                 reader->instate = XmlReadInState_Misc_DTD;
                 if (hr == S_OK) return hr;
             }
@@ -2705,10 +2760,14 @@ static HRESULT WINAPI xmlreader_MoveToElement(IXmlReader* iface)
 static HRESULT WINAPI xmlreader_GetQualifiedName(IXmlReader* iface, LPCWSTR *name, UINT *len)
 {
     xmlreader *This = impl_from_IXmlReader(iface);
+    strval *val = &This->strvalues[StringValue_QualifiedName];
+    HRESULT hr;
 
     TRACE("(%p)->(%p %p)\n", This, name, len);
-    *name = This->strvalues[StringValue_QualifiedName].str;
-    *len  = This->strvalues[StringValue_QualifiedName].len;
+
+    if (!val->str && val->len && FAILED(hr = reader_alloc_strvalue(This, val))) return hr;
+    *name = val->str;
+    *len  = val->len;
     return S_OK;
 }
 
@@ -2723,20 +2782,28 @@ static HRESULT WINAPI xmlreader_GetNamespaceUri(IXmlReader* iface,
 static HRESULT WINAPI xmlreader_GetLocalName(IXmlReader* iface, LPCWSTR *name, UINT *len)
 {
     xmlreader *This = impl_from_IXmlReader(iface);
+    strval *val = &This->strvalues[StringValue_LocalName];
+    HRESULT hr;
 
     TRACE("(%p)->(%p %p)\n", This, name, len);
-    *name = This->strvalues[StringValue_LocalName].str;
-    if (len) *len = This->strvalues[StringValue_LocalName].len;
+
+    if (!val->str && val->len && FAILED(hr = reader_alloc_strvalue(This, val))) return hr;
+    *name = val->str;
+    if (len) *len = val->len;
     return S_OK;
 }
 
 static HRESULT WINAPI xmlreader_GetPrefix(IXmlReader* iface, LPCWSTR *prefix, UINT *len)
 {
     xmlreader *This = impl_from_IXmlReader(iface);
+    strval *val = &This->strvalues[StringValue_Prefix];
+    HRESULT hr;
 
     TRACE("(%p)->(%p %p)\n", This, prefix, len);
-    *prefix = This->strvalues[StringValue_Prefix].str;
-    if (len) *len = This->strvalues[StringValue_Prefix].len;
+
+    if (!val->str && val->len && FAILED(hr = reader_alloc_strvalue(This, val))) return hr;
+    *prefix = val->str;
+    if (len) *len = val->len;
     return S_OK;
 }
 
@@ -2763,11 +2830,8 @@ static HRESULT WINAPI xmlreader_GetValue(IXmlReader* iface, const WCHAR **value,
 
     if (!val->str)
     {
-        WCHAR *ptr = reader_alloc(reader, (val->len+1)*sizeof(WCHAR));
-        if (!ptr) return E_OUTOFMEMORY;
-        memcpy(ptr, reader_get_strptr(reader, val), val->len*sizeof(WCHAR));
-        ptr[val->len] = 0;
-        val->str = ptr;
+        HRESULT hr = reader_alloc_strvalue(reader, val);
+        if (FAILED(hr)) return hr;
     }
 
     *value = val->str;
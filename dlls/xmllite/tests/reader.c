@@ -1157,8 +1157,23 @@ static void test_read_element(void)
             ok(len == strlen(test->name), "got %u\n", len);
             str_exp = a2w(test->name);
             ok(!lstrcmpW(str, str_exp), "got %s\n", wine_dbgstr_w(str));
+
+            len = 0;
+            str = NULL;
+            hr = IXmlReader_GetLocalName(reader, &str, &len);
+            ok(hr == S_OK, "got 0x%08x\n", hr);
+            ok(len == strlen(test->name), "got %u\n", len);
+            ok(str != NULL && !lstrcmpW(str, str_exp), "got %s\n", wine_dbgstr_w(str));
             free_str(str_exp);
 
+            /* no prefix, still an empty string */
+            len = 1;
+            str = NULL;
+            hr = IXmlReader_GetPrefix(reader, &str, &len);
+            ok(hr == S_OK, "got 0x%08x\n", hr);
+            ok(len == 0, "got %u\n", len);
+            ok(str != NULL && *str == 0, "got %s\n", wine_dbgstr_w(str));
+
             /* value */
             len = 1;
             str = NULL;
@@ -1250,6 +1265,143 @@ todo_wine
 
 static ISequentialStream teststream = { &teststreamvtbl };
 
+/* generates large document made of repeated records, every read request is filled completely */
+static const char genstream_head[] = "<a>";
+static const char genstream_record[] = "<b x=\"1\">\xc3\xa9t\xc3\xa9<!-- c --></b>";
+static const char genstream_tail[] = "</a>";
+static ULONG genstream_records, genstream_pos;
+
+static HRESULT WINAPI genstream_Read(ISequentialStream *iface, void *pv, ULONG cb, ULONG *pread)
+{
+    ULONG head_len = sizeof(genstream_head) - 1, record_len = sizeof(genstream_record) - 1;
+    ULONG body_len = genstream_records * record_len, tail_len = sizeof(genstream_tail) - 1;
+    char *dest = pv;
+    ULONG done = 0;
+
+    while (done < cb && genstream_pos < head_len + body_len + tail_len)
+    {
+        const char *src;
+        ULONG offset, len;
+
+        if (genstream_pos < head_len)
+        {
+            src = genstream_head;
+            offset = genstream_pos;
+            len = head_len;
+        }
+        else if (genstream_pos < head_len + body_len)
+        {
+            src = genstream_record;
+            offset = (genstream_pos - head_len) % record_len;
+            len = record_len;
+        }
+        else
+        {
+            src = genstream_tail;
+            offset = genstream_pos - head_len - body_len;
+            len = tail_len;
+        }
+
+        len = min(len - offset, cb - done);
+        memcpy(dest + done, src + offset, len);
+        done += len;
+        genstream_pos += len;
+    }
+
+    *pread = done;
+    return S_OK;
+}
+
+static const ISequentialStreamVtbl genstreamvtbl =
+{
+    teststream_QueryInterface,
+    teststream_AddRef,
+    teststream_Release,
+    genstream_Read,
+    teststream_Write
+};
+
+static ISequentialStream genstream = { &genstreamvtbl };
+
+static void test_read_large(void)
+{
+    static const XmlNodeType record_types[] =
+        { XmlNodeType_Element, XmlNodeType_Text, XmlNodeType_Comment, XmlNodeType_EndElement };
+    static const WCHAR textW[] = {0xe9,'t',0xe9,0};
+    static const WCHAR bW[] = {'b',0};
+    const ULONG records = 200000;
+    ULONG nodes, expected, ticks;
+    const WCHAR *str;
+    IXmlReader *reader;
+    XmlNodeType type;
+    HRESULT hr;
+    UINT len;
+
+    hr = pCreateXmlReader(&IID_IXmlReader, (void**)&reader, NULL);
+    ok(hr == S_OK, "S_OK, got %08x\n", hr);
+
+    genstream_records = records;
+    genstream_pos = 0;
+    hr = IXmlReader_SetInput(reader, (IUnknown*)&genstream);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    ticks = GetTickCount();
+
+    type = XmlNodeType_None;
+    hr = IXmlReader_Read(reader, &type);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(type == XmlNodeType_Element, "got %d\n", type);
+
+    /* records span chunk boundaries, including multibyte UTF-8 sequences */
+    expected = records * sizeof(record_types)/sizeof(record_types[0]);
+    for (nodes = 0; nodes < expected; nodes++)
+    {
+        XmlNodeType expected_type = record_types[nodes % (sizeof(record_types)/sizeof(record_types[0]))];
+
+        type = XmlNodeType_None;
+        hr = IXmlReader_Read(reader, &type);
+        if (hr != S_OK || type != expected_type)
+        {
+            ok(0, "node %u: got 0x%08x, type %d, expected %d\n", nodes, hr, type, expected_type);
+            break;
+        }
+
+        if (type == XmlNodeType_Element)
+        {
+            str = NULL;
+            len = 0;
+            hr = IXmlReader_GetLocalName(reader, &str, &len);
+            if (hr != S_OK || len != 1 || lstrcmpW(str, bW))
+            {
+                ok(0, "node %u: got 0x%08x, name %s\n", nodes, hr, wine_dbgstr_wn(str, len));
+                break;
+            }
+        }
+        else if (type == XmlNodeType_Text)
+        {
+            str = NULL;
+            len = 0;
+            hr = IXmlReader_GetValue(reader, &str, &len);
+            if (hr != S_OK || len != 3 || lstrcmpW(str, textW))
+            {
+                ok(0, "node %u: got 0x%08x, value %s\n", nodes, hr, wine_dbgstr_wn(str, len));
+                break;
+            }
+        }
+    }
+    ok(nodes == expected, "got %u nodes, expected %u\n", nodes, expected);
+
+    type = XmlNodeType_None;
+    hr = IXmlReader_Read(reader, &type);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(type == XmlNodeType_EndElement, "got %d\n", type);
+
+    ticks = GetTickCount() - ticks;
+    trace("read %u bytes in %u ms\n", genstream_pos, ticks);
+
+    IXmlReader_Release(reader);
+}
+
 static void test_read_pending(void)
 {
     IXmlReader *reader;
@@ -1708,6 +1860,7 @@ START_TEST(reader)
     test_read_pending();
     test_readvaluechunk();
     test_read_xmldeclaration();
+    test_read_large();
 
     CoUninitialize();
 }
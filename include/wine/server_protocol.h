@@ -260,6 +260,19 @@ typedef struct
 } rectangle_t;
 
 
+typedef struct
+{
+    unsigned int   seq;
+    user_handle_t  handle;
+    user_handle_t  parent;
+    unsigned int   style;
+    unsigned int   ex_style;
+    unsigned int   id;
+    rectangle_t    window;
+    rectangle_t    client;
+} window_shm_t;
+
+
 typedef struct
 {
     obj_handle_t    handle;
@@ -2871,6 +2884,8 @@ struct send_message_request
     lparam_t        wparam;
     lparam_t        lparam;
     timeout_t       timeout;
+    obj_handle_t    section;
+    data_size_t     section_size;
     /* VARARG(data,message_data); */
 };
 struct send_message_reply
@@ -2950,6 +2965,8 @@ struct get_message_reply
     unsigned int    time;
     unsigned int    active_hooks;
     data_size_t     total;
+    obj_handle_t    section;
+    data_size_t     section_size;
     /* VARARG(data,message_data); */
 };
 
@@ -3455,6 +3472,21 @@ enum coords_relative
 
 
 
+struct get_window_shared_memory_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_window_shared_memory_reply
+{
+    struct reply_header __header;
+    obj_handle_t   handle;
+    char __pad_12[4];
+    mem_size_t     size;
+};
+
+
+
 struct get_window_text_request
 {
     struct request_header __header;
@@ -5230,6 +5262,7 @@ enum request
     REQ_get_window_tree,
     REQ_set_window_pos,
     REQ_get_window_rectangles,
+    REQ_get_window_shared_memory,
     REQ_get_window_text,
     REQ_set_window_text,
     REQ_get_windows_offset,
@@ -5491,6 +5524,7 @@ union generic_request
     struct get_window_tree_request get_window_tree_request;
     struct set_window_pos_request set_window_pos_request;
     struct get_window_rectangles_request get_window_rectangles_request;
+    struct get_window_shared_memory_request get_window_shared_memory_request;
     struct get_window_text_request get_window_text_request;
     struct set_window_text_request set_window_text_request;
     struct get_windows_offset_request get_windows_offset_request;
@@ -5750,6 +5784,7 @@ union generic_reply
     struct get_window_tree_reply get_window_tree_reply;
     struct set_window_pos_reply set_window_pos_reply;
     struct get_window_rectangles_reply get_window_rectangles_reply;
+    struct get_window_shared_memory_reply get_window_shared_memory_reply;
     struct get_window_text_reply get_window_text_reply;
     struct set_window_text_reply set_window_text_reply;
     struct get_windows_offset_reply get_windows_offset_reply;
@@ -5848,6 +5883,6 @@ union generic_reply
     struct set_suspend_context_reply set_suspend_context_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 453
+#define SERVER_PROTOCOL_VERSION 455
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
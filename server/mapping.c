@@ -573,6 +573,30 @@ static struct object *create_mapping( struct directory *root, const struct unico
     return NULL;
 }
 
+/* create an anonymous mapping that is also mapped read-write into the server address space */
+struct object *create_shared_mapping( mem_size_t size, void **ptr )
+{
+    struct mapping *mapping;
+    int unix_fd;
+    void *base;
+
+    if (!(mapping = (struct mapping *)create_mapping( NULL, NULL, 0, size,
+                                                      VPROT_READ | VPROT_WRITE | VPROT_COMMITTED, 0, NULL )))
+        return NULL;
+    if ((unix_fd = get_unix_fd( mapping->fd )) == -1) goto error;
+    if ((base = mmap( NULL, mapping->size, PROT_READ | PROT_WRITE, MAP_SHARED, unix_fd, 0 )) == MAP_FAILED)
+    {
+        file_set_error();
+        goto error;
+    }
+    *ptr = base;
+    return &mapping->obj;
+
+ error:
+    release_object( mapping );
+    return NULL;
+}
+
 struct mapping *get_mapping_obj( struct process *process, obj_handle_t handle, unsigned int access )
 {
     return (struct mapping *)get_handle_obj( process, handle, access, &mapping_ops );
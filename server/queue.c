@@ -77,6 +77,8 @@ struct message
     unsigned int           time;      /* message time */
     void                  *data;      /* message data for sent messages */
     unsigned int           data_size; /* size of message data */
+    struct mapping        *section;   /* section holding large message data */
+    data_size_t            section_size; /* size of the data in the section */
     unsigned int           unique_id; /* unique id for nested hw message waits */
     struct message_result *result;    /* result in sender queue */
 };
@@ -351,6 +353,7 @@ static void set_cursor_pos( struct desktop *desktop, int x, int y )
     msg->lparam    = 0;
     msg->time      = get_tick_count();
     msg->result    = NULL;
+    msg->section   = NULL;
     msg->data      = msg_data;
     msg->data_size = sizeof(*msg_data);
     msg_data->x    = x;
@@ -592,6 +595,7 @@ static void free_message( struct message *msg )
         result->receiver = NULL;
         store_message_result( result, 0, STATUS_ACCESS_DENIED /*FIXME*/ );
     }
+    if (msg->section) release_object( msg->section );
     free( msg->data );
     free( msg );
 }
@@ -672,6 +676,7 @@ static struct message_result *alloc_message_result( struct msg_queue *send_queue
             callback_msg->lparam    = 0;
             callback_msg->time      = get_tick_count();
             callback_msg->result    = NULL;
+            callback_msg->section   = NULL;
             /* steal the data from the original message */
             callback_msg->data      = msg->data;
             callback_msg->data_size = msg->data_size;
@@ -709,6 +714,13 @@ static void receive_message( struct msg_queue *queue, struct message *msg,
     reply->time   = msg->time;
 
     if (msg->data) set_reply_data_ptr( msg->data, msg->data_size );
+    if (msg->section)
+    {
+        /* the receiver maps the data directly instead of getting a copy */
+        reply->section = alloc_handle( current->process, msg->section, SECTION_MAP_READ | SECTION_QUERY, 0 );
+        reply->section_size = msg->section_size;
+        release_object( msg->section );
+    }
 
     list_remove( &msg->entry );
     /* put the result on the receiver result stack */
@@ -1529,6 +1541,7 @@ static int send_hook_ll_message( struct desktop *desktop, struct message *hardwa
     msg->time      = hardware_msg->time;
     msg->data_size = hardware_msg->data_size;
     msg->result    = NULL;
+    msg->section   = NULL;
 
     if (input->type == INPUT_KEYBOARD)
     {
@@ -1623,6 +1636,7 @@ static int queue_mouse_message( struct desktop *desktop, user_handle_t win, cons
         msg->data      = msg_data;
         msg->data_size = sizeof(*msg_data);
         msg->result    = NULL;
+        msg->section   = NULL;
 
         msg_data->info                = input->mouse.info;
         msg_data->flags               = flags;
@@ -1655,6 +1669,7 @@ static int queue_mouse_message( struct desktop *desktop, user_handle_t win, cons
         msg->lparam    = 0;
         msg->time      = time;
         msg->result    = NULL;
+        msg->section   = NULL;
         msg->data      = msg_data;
         msg->data_size = sizeof(*msg_data);
         msg_data->x    = x;
@@ -1769,6 +1784,7 @@ static int queue_keyboard_message( struct desktop *desktop, user_handle_t win, c
         msg->data      = msg_data;
         msg->data_size = sizeof(*msg_data);
         msg->result    = NULL;
+        msg->section   = NULL;
 
         msg_data->info                 = input->kbd.info;
         msg_data->flags                = input->kbd.flags;
@@ -1794,6 +1810,7 @@ static int queue_keyboard_message( struct desktop *desktop, user_handle_t win, c
     msg->lparam    = (input->kbd.scan << 16) | 1u; /* repeat count */
     msg->time      = time;
     msg->result    = NULL;
+    msg->section   = NULL;
     msg->data      = msg_data;
     msg->data_size = sizeof(*msg_data);
     msg_data->info = input->kbd.info;
@@ -1844,6 +1861,7 @@ static void queue_custom_hardware_message( struct desktop *desktop, user_handle_
     msg->lparam    = input->hw.lparam;
     msg->time      = get_tick_count();
     msg->result    = NULL;
+    msg->section   = NULL;
     msg->data      = msg_data;
     msg->data_size = sizeof(*msg_data);
 
@@ -2061,6 +2079,7 @@ void post_message( user_handle_t win, unsigned int message, lparam_t wparam, lpa
         msg->lparam    = lparam;
         msg->time      = get_tick_count();
         msg->result    = NULL;
+        msg->section   = NULL;
         msg->data      = NULL;
         msg->data_size = 0;
 
@@ -2095,6 +2114,7 @@ void post_win_event( struct thread *thread, unsigned int event,
         msg->lparam    = child_id;
         msg->time      = get_tick_count();
         msg->result    = NULL;
+        msg->section   = NULL;
 
         if ((data = malloc( sizeof(*data) + module_size )))
         {
@@ -2250,8 +2270,10 @@ DECL_HANDLER(send_message)
         msg->lparam    = req->lparam;
         msg->time      = get_tick_count();
         msg->result    = NULL;
+        msg->section   = NULL;
         msg->data      = NULL;
         msg->data_size = get_req_data_size();
+        msg->section_size = req->section_size;
 
         if (msg->data_size && !(msg->data = memdup( get_req_data(), msg->data_size )))
         {
@@ -2259,6 +2281,20 @@ DECL_HANDLER(send_message)
             release_object( thread );
             return;
         }
+        if (req->section)
+        {
+            if (msg->type != MSG_OTHER_PROCESS)
+                set_error( STATUS_INVALID_PARAMETER );
+            else
+                msg->section = get_mapping_obj( current->process, req->section, SECTION_MAP_READ );
+            if (!msg->section)
+            {
+                free( msg->data );
+                free( msg );
+                release_object( thread );
+                return;
+            }
+        }
 
         switch(msg->type)
         {
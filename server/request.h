@@ -264,6 +264,7 @@ DECL_HANDLER(get_window_children_from_point);
 DECL_HANDLER(get_window_tree);
 DECL_HANDLER(set_window_pos);
 DECL_HANDLER(get_window_rectangles);
+DECL_HANDLER(get_window_shared_memory);
 DECL_HANDLER(get_window_text);
 DECL_HANDLER(set_window_text);
 DECL_HANDLER(get_windows_offset);
@@ -524,6 +525,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_window_tree,
     (req_handler)req_set_window_pos,
     (req_handler)req_get_window_rectangles,
+    (req_handler)req_get_window_shared_memory,
     (req_handler)req_get_window_text,
     (req_handler)req_set_window_text,
     (req_handler)req_get_windows_offset,
@@ -1415,7 +1417,9 @@ C_ASSERT( FIELD_OFFSET(struct send_message_request, msg) == 28 );
 C_ASSERT( FIELD_OFFSET(struct send_message_request, wparam) == 32 );
 C_ASSERT( FIELD_OFFSET(struct send_message_request, lparam) == 40 );
 C_ASSERT( FIELD_OFFSET(struct send_message_request, timeout) == 48 );
-C_ASSERT( sizeof(struct send_message_request) == 56 );
+C_ASSERT( FIELD_OFFSET(struct send_message_request, section) == 56 );
+C_ASSERT( FIELD_OFFSET(struct send_message_request, section_size) == 60 );
+C_ASSERT( sizeof(struct send_message_request) == 64 );
 C_ASSERT( FIELD_OFFSET(struct post_quit_message_request, exit_code) == 12 );
 C_ASSERT( sizeof(struct post_quit_message_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct send_hardware_message_request, win) == 12 );
@@ -1444,7 +1448,9 @@ C_ASSERT( FIELD_OFFSET(struct get_message_reply, type) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, time) == 36 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, active_hooks) == 40 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, total) == 44 );
-C_ASSERT( sizeof(struct get_message_reply) == 48 );
+C_ASSERT( FIELD_OFFSET(struct get_message_reply, section) == 48 );
+C_ASSERT( FIELD_OFFSET(struct get_message_reply, section_size) == 52 );
+C_ASSERT( sizeof(struct get_message_reply) == 56 );
 C_ASSERT( FIELD_OFFSET(struct reply_message_request, remove) == 12 );
 C_ASSERT( FIELD_OFFSET(struct reply_message_request, result) == 16 );
 C_ASSERT( sizeof(struct reply_message_request) == 24 );
@@ -1638,6 +1644,10 @@ C_ASSERT( FIELD_OFFSET(struct get_window_rectangles_reply, window) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_window_rectangles_reply, visible) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_window_rectangles_reply, client) == 40 );
 C_ASSERT( sizeof(struct get_window_rectangles_reply) == 56 );
+C_ASSERT( sizeof(struct get_window_shared_memory_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_window_shared_memory_reply, handle) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_window_shared_memory_reply, size) == 16 );
+C_ASSERT( sizeof(struct get_window_shared_memory_reply) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_window_text_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_window_text_request) == 16 );
 C_ASSERT( sizeof(struct get_window_text_reply) == 8 );
@@ -2570,6 +2570,8 @@ static void dump_send_message_request( const struct send_message_request *req )
     dump_uint64( ", wparam=", &req->wparam );
     dump_uint64( ", lparam=", &req->lparam );
     dump_timeout( ", timeout=", &req->timeout );
+    fprintf( stderr, ", section=%04x", req->section );
+    fprintf( stderr, ", section_size=%u", req->section_size );
     dump_varargs_message_data( ", data=", cur_size );
 }
 
@@ -2616,6 +2618,8 @@ static void dump_get_message_reply( const struct get_message_reply *req )
     fprintf( stderr, ", time=%08x", req->time );
     fprintf( stderr, ", active_hooks=%08x", req->active_hooks );
     fprintf( stderr, ", total=%u", req->total );
+    fprintf( stderr, ", section=%04x", req->section );
+    fprintf( stderr, ", section_size=%u", req->section_size );
     dump_varargs_message_data( ", data=", cur_size );
 }
 
@@ -2965,6 +2969,16 @@ static void dump_get_window_rectangles_reply( const struct get_window_rectangles
     dump_rectangle( ", client=", &req->client );
 }
 
+static void dump_get_window_shared_memory_request( const struct get_window_shared_memory_request *req )
+{
+}
+
+static void dump_get_window_shared_memory_reply( const struct get_window_shared_memory_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    dump_uint64( ", size=", &req->size );
+}
+
 static void dump_get_window_text_request( const struct get_window_text_request *req )
 {
     fprintf( stderr, " handle=%08x", req->handle );
@@ -4243,6 +4257,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_window_tree_request,
     (dump_func)dump_set_window_pos_request,
     (dump_func)dump_get_window_rectangles_request,
+    (dump_func)dump_get_window_shared_memory_request,
     (dump_func)dump_get_window_text_request,
     (dump_func)dump_set_window_text_request,
     (dump_func)dump_get_windows_offset_request,
@@ -4500,6 +4515,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_window_tree_reply,
     (dump_func)dump_set_window_pos_reply,
     (dump_func)dump_get_window_rectangles_reply,
+    (dump_func)dump_get_window_shared_memory_reply,
     (dump_func)dump_get_window_text_reply,
     NULL,
     (dump_func)dump_get_windows_offset_reply,
@@ -4757,6 +4773,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_window_tree",
     "set_window_pos",
     "get_window_rectangles",
+    "get_window_shared_memory",
     "get_window_text",
     "set_window_text",
     "get_windows_offset",
@@ -33,6 +33,8 @@
 #include "winternl.h"
 
 #include "object.h"
+#include "file.h"
+#include "handle.h"
 #include "request.h"
 #include "thread.h"
 #include "process.h"
@@ -54,6 +56,43 @@ enum property_type
     PROP_TYPE_ATOM    /* plain atom */
 };
 
+/* a cell of the children spatial index */
+struct child_index_cell
+{
+    struct window **wins;    /* children overlapping the cell, sorted by Z-order rank */
+    unsigned int    count;   /* number of children in the cell */
+    unsigned int    size;    /* allocated size of the array */
+};
+
+/* grid of the children of a window, to avoid walking all siblings for hit-testing */
+struct child_index
+{
+    rectangle_t              bounds;       /* bounding rectangle of the grid */
+    int                      cols;         /* number of grid columns */
+    int                      rows;         /* number of grid rows */
+    int                      cell_width;   /* width of a grid cell */
+    int                      cell_height;  /* height of a grid cell */
+    unsigned int             count;        /* number of indexed children */
+    unsigned int             nb_outside;   /* number of indexed children not fully inside the grid */
+    struct child_index_cell *cells;        /* grid cells */
+    struct child_index_cell  large;        /* children spanning too many cells or outside the grid */
+};
+
+#define CHILD_INDEX_MIN_CHILDREN  64       /* don't bother indexing fewer children than this */
+#define CHILD_INDEX_MAX_CELLS     4096     /* maximum number of grid cells */
+#define CHILD_INDEX_LARGE_CELLS   16       /* children covering more cells go to the large list */
+#define CHILD_ZORDER_STEP         0x10000  /* spacing of the Z-order ranks when renumbering */
+
+/* iterator over the children that may contain a given point */
+struct child_iter
+{
+    const struct child_index *index;      /* index being used, NULL when walking the Z-order */
+    struct window * const    *cell;       /* next entry of the grid cell */
+    struct window * const    *cell_end;   /* end of the grid cell entries */
+    struct window * const    *large;      /* next entry of the large children list */
+    struct window * const    *large_end;  /* end of the large children list */
+};
+
 
 struct window
 {
@@ -62,6 +101,7 @@ struct window
     struct list      children;        /* list of children in Z-order */
     struct list      unlinked;        /* list of children not linked in the Z-order list */
     struct list      entry;           /* entry in parent's children list */
+    struct child_index *child_index;  /* spatial index of the children, built on demand */
     user_handle_t    handle;          /* full handle for this window */
     struct thread   *thread;          /* thread owning the window */
     struct desktop  *desktop;         /* desktop that the window belongs to */
@@ -80,6 +120,8 @@ struct window
     unsigned int     is_unicode : 1;  /* ANSI or unicode */
     unsigned int     is_linked : 1;   /* is it linked into the parent z-order list? */
     unsigned int     is_layered : 1;  /* has layered info been set? */
+    unsigned int     is_indexed : 1;  /* is it in the spatial index of the parent? */
+    unsigned int     zorder;          /* Z-order rank among siblings, valid while the parent is indexed */
     unsigned int     color_key;       /* color key for a layered window */
     unsigned int     alpha;           /* alpha value for a layered window */
     unsigned int     layered_flags;   /* flags for a layered window */
@@ -118,6 +160,11 @@ static struct window *shell_listview;
 static struct window *progman_window;
 static struct window *taskman_window;
 
+/* read-only snapshot of the window state shared with the clients, indexed by user handle */
+#define NB_WINDOW_SHM_ENTRIES ((LAST_USER_HANDLE - FIRST_USER_HANDLE + 1) >> 1)
+static struct object *window_shm_mapping;
+static window_shm_t *window_shm;
+
 /* magic HWND_TOP etc. pointers */
 #define WINPTR_TOP       ((struct window *)1L)
 #define WINPTR_BOTTOM    ((struct window *)2L)
@@ -152,6 +199,171 @@ static inline struct window *get_prev_window( struct window *win )
     return ptr ? LIST_ENTRY( ptr, struct window, entry ) : NULL;
 }
 
+/* free the spatial index of the children of a window, it will be rebuilt on the next lookup */
+static void free_child_index( struct window *win )
+{
+    struct child_index *index = win->child_index;
+    struct window *child;
+    int i;
+
+    if (!index) return;
+    LIST_FOR_EACH_ENTRY( child, &win->children, struct window, entry ) child->is_indexed = 0;
+    for (i = 0; i < index->cols * index->rows; i++) free( index->cells[i].wins );
+    free( index->cells );
+    free( index->large.wins );
+    free( index );
+    win->child_index = NULL;
+}
+
+/* check if a rectangle lies entirely inside the grid */
+static inline int is_inside_child_index( const struct child_index *index, const rectangle_t *rect )
+{
+    return (rect->left >= index->bounds.left && rect->right <= index->bounds.right &&
+            rect->top >= index->bounds.top && rect->bottom <= index->bounds.bottom);
+}
+
+/* get the range of grid cells covered by a rectangle; return 0 if it goes to the large list */
+static int get_child_index_cells( const struct child_index *index, const rectangle_t *rect,
+                                  int *left, int *top, int *right, int *bottom )
+{
+    int covered;
+
+    if (!is_inside_child_index( index, rect )) return 0;
+    *left   = (rect->left - index->bounds.left) / index->cell_width;
+    *top    = (rect->top - index->bounds.top) / index->cell_height;
+    *right  = (rect->right - 1 - index->bounds.left) / index->cell_width;
+    *bottom = (rect->bottom - 1 - index->bounds.top) / index->cell_height;
+    covered = (*right - *left + 1) * (*bottom - *top + 1);
+    return covered <= CHILD_INDEX_LARGE_CELLS ? covered : 0;
+}
+
+/* find the position of a window in a cell, or where it should be inserted */
+static unsigned int find_child_in_cell( const struct child_index_cell *cell, const struct window *win )
+{
+    unsigned int min = 0, max = cell->count, pos;
+
+    while (min < max)
+    {
+        pos = (min + max) / 2;
+        if (cell->wins[pos]->zorder < win->zorder) min = pos + 1;
+        else max = pos;
+    }
+    return min;
+}
+
+/* insert a window in a cell, keeping the Z-order */
+static int add_child_to_cell( struct child_index_cell *cell, struct window *win )
+{
+    unsigned int pos;
+
+    if (cell->count == cell->size)
+    {
+        unsigned int new_size = max( 4, cell->size * 2 );
+        struct window **new_wins = realloc( cell->wins, new_size * sizeof(*new_wins) );
+
+        if (!new_wins) return 0;
+        cell->wins = new_wins;
+        cell->size = new_size;
+    }
+    pos = find_child_in_cell( cell, win );
+    memmove( cell->wins + pos + 1, cell->wins + pos, (cell->count - pos) * sizeof(*cell->wins) );
+    cell->wins[pos] = win;
+    cell->count++;
+    return 1;
+}
+
+/* remove a window from a cell */
+static void remove_child_from_cell( struct child_index_cell *cell, struct window *win )
+{
+    unsigned int pos = find_child_in_cell( cell, win );
+
+    assert( pos < cell->count && cell->wins[pos] == win );
+    cell->count--;
+    memmove( cell->wins + pos, cell->wins + pos + 1, (cell->count - pos) * sizeof(*cell->wins) );
+}
+
+/* add a window to the spatial index of its parent, using its current rectangle and Z-order rank */
+static void add_child_to_index( struct window *win )
+{
+    struct window *parent = win->parent;
+    struct child_index *index;
+    const rectangle_t *rect = &win->visible_rect;
+    int left, top, right, bottom, x, y;
+
+    if (win->is_indexed || !parent || !(index = parent->child_index)) return;
+    if (rect->left >= rect->right || rect->top >= rect->bottom) return;  /* can't contain any point */
+
+    if (get_child_index_cells( index, rect, &left, &top, &right, &bottom ))
+    {
+        for (y = top; y <= bottom; y++)
+            for (x = left; x <= right; x++)
+                if (!add_child_to_cell( &index->cells[y * index->cols + x], win )) goto failed;
+    }
+    else if (!add_child_to_cell( &index->large, win )) goto failed;
+
+    win->is_indexed = 1;
+    index->count++;
+    if (!is_inside_child_index( index, rect ) && ++index->nb_outside > index->count / 4)
+        free_child_index( parent );  /* too many children moved away, rebuild it with new bounds */
+    return;
+
+failed:
+    free_child_index( parent );
+}
+
+/* remove a window from the spatial index of its parent, before changing its rectangle or Z-order */
+static void remove_child_from_index( struct window *win )
+{
+    struct child_index *index;
+    const rectangle_t *rect = &win->visible_rect;
+    int left, top, right, bottom, x, y;
+
+    if (!win->is_indexed) return;
+    index = win->parent->child_index;
+
+    if (get_child_index_cells( index, rect, &left, &top, &right, &bottom ))
+    {
+        for (y = top; y <= bottom; y++)
+            for (x = left; x <= right; x++)
+                remove_child_from_cell( &index->cells[y * index->cols + x], win );
+    }
+    else remove_child_from_cell( &index->large, win );
+
+    if (!is_inside_child_index( index, rect )) index->nb_outside--;
+    index->count--;
+    win->is_indexed = 0;
+}
+
+/* spread the Z-order ranks of the children of an indexed window */
+/* the relative order doesn't change, so the cells remain sorted */
+static void renumber_children( struct window *parent )
+{
+    struct window *ptr;
+    unsigned int count = 0, step, zorder = 0;
+
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry ) count++;
+    step = min( CHILD_ZORDER_STEP, ~0u / (count + 1) );
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry ) ptr->zorder = (zorder += step);
+}
+
+/* give a Z-order rank to a window that has just been moved in the Z-order of an indexed parent */
+static void update_child_zorder( struct window *win )
+{
+    struct window *prev, *next;
+    unsigned int low, high;
+
+    if (!win->parent->child_index) return;
+    prev = get_prev_window( win );
+    next = get_next_window( win );
+    low  = prev ? prev->zorder : 0;
+    high = next ? next->zorder : ~0u;
+
+    if (high - low < 2) renumber_children( win->parent );  /* no room left between the neighbours */
+    else if (!next) win->zorder = low + min( (high - low) / 2, CHILD_ZORDER_STEP );
+    else if (!prev) win->zorder = high - min( (high - low) / 2, CHILD_ZORDER_STEP );
+    else win->zorder = low + (high - low) / 2;
+}
+
 /* get first child in Z-order list */
 static inline struct window *get_first_child( struct window *win )
 {
@@ -166,6 +378,43 @@ static inline struct window *get_last_child( struct window *win )
     return ptr ? LIST_ENTRY( ptr, struct window, entry ) : NULL;
 }
 
+/* get the shared memory entry of a window */
+static inline window_shm_t *get_window_shm_entry( user_handle_t handle )
+{
+    return &window_shm[((handle & 0xffff) - FIRST_USER_HANDLE) >> 1];
+}
+
+/* publish the current window state in shared memory */
+/* the sequence counter is odd while the entry is being modified so that readers can retry */
+static void update_window_shm( struct window *win )
+{
+    window_shm_t *shm;
+
+    if (!window_shm) return;
+    shm = get_window_shm_entry( win->handle );
+    interlocked_xchg_add( (int *)&shm->seq, 1 );
+    shm->handle   = win->handle;
+    shm->parent   = win->parent ? win->parent->handle : 0;
+    shm->style    = win->style;
+    shm->ex_style = win->ex_style;
+    shm->id       = win->id;
+    shm->window   = win->window_rect;
+    shm->client   = win->client_rect;
+    interlocked_xchg_add( (int *)&shm->seq, 1 );
+}
+
+/* remove a destroyed window from the shared memory */
+static void clear_window_shm( struct window *win )
+{
+    window_shm_t *shm;
+
+    if (!window_shm) return;
+    shm = get_window_shm_entry( win->handle );
+    interlocked_xchg_add( (int *)&shm->seq, 1 );
+    shm->handle = 0;
+    interlocked_xchg_add( (int *)&shm->seq, 1 );
+}
+
 /* set the PAINT_PIXEL_FORMAT_CHILD flag on all the parents */
 /* note: we never reset the flag, it's just a heuristic */
 static inline void update_pixel_format_flags( struct window *win )
@@ -184,6 +433,7 @@ static void link_window( struct window *win, struct window *previous )
         previous = WINPTR_TOP;  /* fallback to the HWND_TOP case */
     }
 
+    remove_child_from_index( win );
     list_remove( &win->entry );  /* unlink it from the previous location */
 
     if (previous == WINPTR_BOTTOM)
@@ -227,6 +477,9 @@ static void link_window( struct window *win, struct window *previous )
     }
 
     win->is_linked = 1;
+    update_child_zorder( win );
+    add_child_to_index( win );
+    update_window_shm( win );
 }
 
 /* change the parent of a window (or unlink the window if the new parent is NULL) */
@@ -244,6 +497,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         }
     }
 
+    remove_child_from_index( win );
     if (parent)
     {
         win->parent = parent;
@@ -263,6 +517,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         list_add_head( &win->parent->unlinked, &win->entry );
         win->is_linked = 0;
     }
+    update_window_shm( win );
     return 1;
 }
 
@@ -494,6 +749,9 @@ static struct window *create_window( struct window *parent, struct window *owner
     win->nb_extra_bytes = extra_bytes;
     win->window_rect = win->visible_rect = win->client_rect = empty_rect;
     memset( win->extra_bytes, 0, extra_bytes );
+    win->child_index    = NULL;
+    win->is_indexed     = 0;
+    win->zorder         = 0;
     list_init( &win->children );
     list_init( &win->unlinked );
 
@@ -527,6 +785,7 @@ static struct window *create_window( struct window *parent, struct window *owner
     }
 
     current->desktop_users++;
+    update_window_shm( win );
     return win;
 
 failed:
@@ -679,12 +938,110 @@ static unsigned int get_children_windows( struct window *parent, atom_t atom, th
     return count;
 }
 
+/* get the spatial index of the children of a window, building it if needed; return NULL if not worth it */
+static struct child_index *get_child_index( struct window *parent )
+{
+    struct child_index *index;
+    struct window *ptr;
+    rectangle_t bounds = { 0, 0, 0, 0 };
+    unsigned int count = 0, nb_cells;
+
+    if (parent->child_index) return parent->child_index;
+
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    {
+        const rectangle_t *rect = &ptr->visible_rect;
+
+        if (rect->left >= rect->right || rect->top >= rect->bottom) continue;
+        if (!count++) bounds = *rect;
+        else
+        {
+            bounds.left   = min( bounds.left, rect->left );
+            bounds.top    = min( bounds.top, rect->top );
+            bounds.right  = max( bounds.right, rect->right );
+            bounds.bottom = max( bounds.bottom, rect->bottom );
+        }
+    }
+    if (count < CHILD_INDEX_MIN_CHILDREN) return NULL;
+
+    if (!(index = malloc( sizeof(*index) ))) return NULL;
+    nb_cells = min( count / 4, CHILD_INDEX_MAX_CELLS );
+    for (index->cols = 1; (index->cols + 1) * (index->cols + 1) <= nb_cells; index->cols++) ;
+    index->rows        = index->cols;
+    index->bounds      = bounds;
+    index->cell_width  = (bounds.right - bounds.left + index->cols - 1) / index->cols;
+    index->cell_height = (bounds.bottom - bounds.top + index->rows - 1) / index->rows;
+    index->count       = 0;
+    index->nb_outside  = 0;
+    memset( &index->large, 0, sizeof(index->large) );
+    if (!(index->cells = calloc( index->cols * index->rows, sizeof(*index->cells) )))
+    {
+        free( index );
+        return NULL;
+    }
+
+    /* from now on the index is updated as children are moved */
+
+    parent->child_index = index;
+    renumber_children( parent );
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    {
+        add_child_to_index( ptr );
+        if (!parent->child_index) return NULL;  /* out of memory */
+    }
+    return index;
+}
+
+/* get the next child that may contain the point of the iterator */
+static struct window *next_child_from_point( struct child_iter *iter, struct window *prev )
+{
+    if (!iter->index) return get_next_window( prev );
+
+    if (iter->cell < iter->cell_end &&
+        (iter->large == iter->large_end || (*iter->cell)->zorder < (*iter->large)->zorder))
+        return *iter->cell++;
+    if (iter->large < iter->large_end) return *iter->large++;
+    return NULL;
+}
+
+/* get the first child of 'parent' that may contain the given point (in parent-relative coords) */
+static struct window *first_child_from_point( struct window *parent, int x, int y,
+                                              struct child_iter *iter )
+{
+    const struct child_index *index = get_child_index( parent );
+    struct list *ptr;
+
+    if (!(iter->index = index))
+    {
+        if (!(ptr = list_head( &parent->children ))) return NULL;
+        return LIST_ENTRY( ptr, struct window, entry );
+    }
+    iter->large     = index->large.wins;
+    iter->large_end = index->large.wins + index->large.count;
+    if (x < index->bounds.left || x >= index->bounds.right ||
+        y < index->bounds.top || y >= index->bounds.bottom)
+    {
+        iter->cell = iter->cell_end = NULL;  /* only the large list can contain it */
+    }
+    else
+    {
+        const struct child_index_cell *cell;
+
+        cell = &index->cells[(y - index->bounds.top) / index->cell_height * index->cols +
+                             (x - index->bounds.left) / index->cell_width];
+        iter->cell     = cell->wins;
+        iter->cell_end = cell->wins + cell->count;
+    }
+    return next_child_from_point( iter, NULL );
+}
+
 /* find child of 'parent' that contains the given point (in parent-relative coords) */
 static struct window *child_window_from_point( struct window *parent, int x, int y )
 {
+    struct child_iter iter;
     struct window *ptr;
 
-    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    for (ptr = first_child_from_point( parent, x, y, &iter ); ptr; ptr = next_child_from_point( &iter, ptr ))
     {
         if (!is_point_in_window( ptr, x, y )) continue;  /* skip it */
 
@@ -705,9 +1062,10 @@ static struct window *child_window_from_point( struct window *parent, int x, int
 static int get_window_children_from_point( struct window *parent, int x, int y,
                                            struct user_handle_array *array )
 {
+    struct child_iter iter;
     struct window *ptr;
 
-    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    for (ptr = first_child_from_point( parent, x, y, &iter ); ptr; ptr = next_child_from_point( &iter, ptr ))
     {
         if (!is_point_in_window( ptr, x, y )) continue;  /* skip it */
 
@@ -886,19 +1244,35 @@ static inline void map_win_region_to_screen( struct window *win, struct region *
 }
 
 
+/* offset the coordinates of a rectangle */
+static inline void offset_rect( rectangle_t *rect, int offset_x, int offset_y )
+{
+    rect->left   += offset_x;
+    rect->top    += offset_y;
+    rect->right  += offset_x;
+    rect->bottom += offset_y;
+}
+
+
 /* clip all children of a given window out of the visible region */
 static struct region *clip_children( struct window *parent, struct window *last,
                                      struct region *region, int offset_x, int offset_y )
 {
     struct window *ptr;
     struct region *tmp = create_empty_region();
+    rectangle_t extents, rect;
 
     if (!tmp) return NULL;
+    get_region_extents( region, &extents );
     LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
     {
         if (ptr == last) break;
         if (!(ptr->style & WS_VISIBLE)) continue;
         if (ptr->ex_style & WS_EX_TRANSPARENT) continue;
+        /* skip the region operations for siblings that can't overlap it */
+        rect = ptr->visible_rect;
+        offset_rect( &rect, offset_x, offset_y );
+        if (!intersect_rect( &rect, &rect, &extents )) continue;
         set_region_rect( tmp, &ptr->visible_rect );
         if (ptr->win_region && !intersect_window_region( tmp, ptr ))
         {
@@ -908,22 +1282,13 @@ static struct region *clip_children( struct window *parent, struct window *last,
         offset_region( tmp, offset_x, offset_y );
         if (!(region = subtract_region( region, region, tmp ))) break;
         if (is_region_empty( region )) break;
+        get_region_extents( region, &extents );
     }
     free_region( tmp );
     return region;
 }
 
 
-/* offset the coordinates of a rectangle */
-static inline void offset_rect( rectangle_t *rect, int offset_x, int offset_y )
-{
-    rect->left   += offset_x;
-    rect->top    += offset_y;
-    rect->right  += offset_x;
-    rect->bottom += offset_y;
-}
-
-
 /* set the region to the client rect clipped by the window rect, in parent-relative coordinates */
 static void set_region_client_rect( struct region *region, struct window *win )
 {
@@ -1627,12 +1992,15 @@ static void set_window_pos( struct window *win, struct window *previous,
 
     /* set the new window info before invalidating anything */
 
+    remove_child_from_index( win );
     win->window_rect  = *window_rect;
     win->visible_rect = *visible_rect;
     win->client_rect  = *client_rect;
     if (!(swp_flags & SWP_NOZORDER) && win->parent) link_window( win, previous );
+    add_child_to_index( win );
     if (swp_flags & SWP_SHOWWINDOW) win->style |= WS_VISIBLE;
     else if (swp_flags & SWP_HIDEWINDOW) win->style &= ~WS_VISIBLE;
+    update_window_shm( win );
 
     /* keep children at the same position relative to top right corner when the parent is mirrored */
     if (win->ex_style & WS_EX_LAYOUTRTL)
@@ -1641,11 +2009,17 @@ static void set_window_pos( struct window *win, struct window *previous,
         int old_size = old_client_rect.right - old_client_rect.left;
         int new_size = win->client_rect.right - win->client_rect.left;
 
-        if (old_size != new_size) LIST_FOR_EACH_ENTRY( child, &win->children, struct window, entry )
+        if (old_size != new_size)
         {
-            offset_rect( &child->window_rect, new_size - old_size, 0 );
-            offset_rect( &child->visible_rect, new_size - old_size, 0 );
-            offset_rect( &child->client_rect, new_size - old_size, 0 );
+            LIST_FOR_EACH_ENTRY( child, &win->children, struct window, entry )
+            {
+                offset_rect( &child->window_rect, new_size - old_size, 0 );
+                offset_rect( &child->visible_rect, new_size - old_size, 0 );
+                offset_rect( &child->client_rect, new_size - old_size, 0 );
+                update_window_shm( child );
+            }
+            /* the grid moves along with the children */
+            if (win->child_index) offset_rect( &win->child_index->bounds, new_size - old_size, 0 );
         }
     }
 
@@ -1809,6 +2183,7 @@ void destroy_window( struct window *win )
     {
         struct region *vis_rgn = get_visible_region( win, DCX_WINDOW );
         win->style &= ~WS_VISIBLE;
+        update_window_shm( win );
         if (vis_rgn)
         {
             struct region *exposed_rgn = expose_window( win, &win->window_rect, vis_rgn );
@@ -1831,9 +2206,12 @@ void destroy_window( struct window *win )
     if (win == progman_window) progman_window = NULL;
     if (win == taskman_window) taskman_window = NULL;
     free_hotkeys( win->desktop, win->handle );
+    clear_window_shm( win );
     free_user_handle( win->handle );
     destroy_properties( win );
+    remove_child_from_index( win );
     list_remove( &win->entry );
+    free_child_index( win );
     if (is_desktop_window(win))
     {
         struct desktop *desktop = win->desktop;
@@ -1933,6 +2311,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->top_window );
             desktop->top_window->style  = WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_window_shm( desktop->top_window );
         }
     }
 
@@ -1945,6 +2324,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->msg_window );
             desktop->msg_window->style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_window_shm( desktop->msg_window );
         }
     }
 
@@ -2053,6 +2433,8 @@ DECL_HANDLER(set_window_info)
     if (req->flags & SET_WIN_EXTRA) memcpy( win->extra_bytes + req->extra_offset,
                                             &req->extra_value, req->extra_size );
 
+    if (req->flags & (SET_WIN_STYLE | SET_WIN_EXSTYLE | SET_WIN_ID)) update_window_shm( win );
+
     /* changing window style triggers a non-client paint */
     if (req->flags & SET_WIN_STYLE) win->paint_flags |= PAINT_NONCLIENT;
 }
@@ -2325,6 +2707,27 @@ DECL_HANDLER(get_window_rectangles)
 }
 
 
+/* get the shared memory mapping holding the window state snapshots */
+DECL_HANDLER(get_window_shared_memory)
+{
+    if (!window_shm_mapping)
+    {
+        user_handle_t handle = 0;
+        struct window *win;
+        void *ptr;
+
+        if (!(window_shm_mapping = create_shared_mapping( NB_WINDOW_SHM_ENTRIES * sizeof(*window_shm), &ptr )))
+            return;
+        make_object_static( window_shm_mapping );
+        window_shm = ptr;
+        /* publish the windows created so far */
+        while ((win = next_user_handle( &handle, USER_WINDOW ))) update_window_shm( win );
+    }
+    reply->handle = alloc_handle( current->process, window_shm_mapping, SECTION_MAP_READ | SECTION_QUERY, 0 );
+    reply->size   = NB_WINDOW_SHM_ENTRIES * sizeof(*window_shm);
+}
+
+
 /* get the window text */
 DECL_HANDLER(get_window_text)
 {
@@ -2604,8 +3007,11 @@ DECL_HANDLER(update_window_zorder)
         /* making sure to not violate the topmost rule */
         if (!(ptr->ex_style & WS_EX_TOPMOST) || (win->ex_style & WS_EX_TOPMOST))
         {
+            remove_child_from_index( win );
             list_remove( &win->entry );
             list_add_before( &ptr->entry, &win->entry );
+            update_child_zorder( win );
+            add_child_to_index( win );
         }
         break;
     }